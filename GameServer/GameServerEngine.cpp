@@ -38,7 +38,8 @@ namespace RiftForged {
             m_gameLogicThreadPool(numThreadPoolThreads), // Initialized directly here
             m_isSimulatingThread(false),
             m_tickIntervalMs(tickInterval),
-            m_timerResolutionWasSet(false) {
+            m_timerResolutionWasSet(false),
+            m_clientReplicationBytesPerSec(DEFAULT_CLIENT_REPLICATION_BYTES_PER_SEC) {
             RF_CORE_INFO("GameServerEngine: Constructed. Tick Interval: {}ms", m_tickIntervalMs.count());
         }
 
@@ -253,16 +254,15 @@ namespace RiftForged {
             const RiftForged::Networking::NetworkEndpoint& newEndpoint,
             const std::string& characterIdToLoad) {
 
-            std::string endpointKey = newEndpoint.ToString();
-            RF_CORE_INFO("GameServerEngine: Client joining from endpoint [%s]. Character to load: '%s'", endpointKey.c_str(), characterIdToLoad.empty() ? "New/Default" : characterIdToLoad.c_str());
+            RF_CORE_INFO("GameServerEngine: Client joining from endpoint [%s]. Character to load: '%s'", newEndpoint.ToString().c_str(), characterIdToLoad.empty() ? "New/Default" : characterIdToLoad.c_str());
 
             uint64_t existingPlayerId = 0;
             {
                 std::lock_guard<std::mutex> lock(m_sessionMapsMutex);
-                auto it = m_endpointKeyToPlayerIdMap.find(endpointKey);
-                if (it != m_endpointKeyToPlayerIdMap.end()) {
+                auto it = m_endpointToPlayerIdMap.find(newEndpoint);
+                if (it != m_endpointToPlayerIdMap.end()) {
                     existingPlayerId = it->second;
-                    RF_CORE_WARN("GameServerEngine: Endpoint [%s] already associated with PlayerId %llu. Client attempting to re-join.", endpointKey.c_str(), existingPlayerId);
+                    RF_CORE_WARN("GameServerEngine: Endpoint [%s] already associated with PlayerId %llu. Client attempting to re-join.", newEndpoint.ToString().c_str(), existingPlayerId);
                     // If an endpoint is trying to re-join and is already mapped,
                     // we return the existing ID. The JoinRequestMessageHandler will then
                     // interpret this as an "already logged in" scenario and send a JoinFailed.
@@ -289,14 +289,14 @@ namespace RiftForged {
             }
             {
                 std::lock_guard<std::mutex> lock(m_sessionMapsMutex);
-                m_endpointKeyToPlayerIdMap[endpointKey] = newPlayerId;
+                m_endpointToPlayerIdMap[newEndpoint] = newPlayerId;
                 m_playerIdToEndpointMap[newPlayerId] = newEndpoint;
             }
 
             // Initialize the newly created player within the GameplayEngine
             m_gameplayEngine.InitializePlayerInWorld(player, spawnPos, spawnOrient);
 
-            RF_CORE_INFO("GameServerEngine: Player %llu successfully created and initialized for endpoint [%s].", newPlayerId, endpointKey.c_str());
+            RF_CORE_INFO("GameServerEngine: Player %llu successfully created and initialized for endpoint [%s].", newPlayerId, newEndpoint.ToString().c_str());
 
             // IMPORTANT: Removed direct sending of JoinSuccess/Failed messages from here.
             // This responsibility is now solely handled by JoinRequestMessageHandler
@@ -323,20 +323,19 @@ namespace RiftForged {
 
 
         void GameServerEngine::OnClientDisconnected(const RiftForged::Networking::NetworkEndpoint& endpoint) {
-            std::string endpointKey = endpoint.ToString();
-            RF_CORE_INFO("GameServerEngine: Client disconnected from endpoint [{}]", endpointKey);
+            RF_CORE_INFO("GameServerEngine: Client disconnected from endpoint [{}]", endpoint.ToString());
 
             uint64_t playerIdToDisconnect = 0;
             {
                 std::lock_guard<std::mutex> lock(m_sessionMapsMutex);
-                auto it = m_endpointKeyToPlayerIdMap.find(endpointKey);
-                if (it != m_endpointKeyToPlayerIdMap.end()) {
+                auto it = m_endpointToPlayerIdMap.find(endpoint);
+                if (it != m_endpointToPlayerIdMap.end()) {
                     playerIdToDisconnect = it->second;
-                    m_endpointKeyToPlayerIdMap.erase(it);
+                    m_endpointToPlayerIdMap.erase(it);
                     m_playerIdToEndpointMap.erase(playerIdToDisconnect);
                 }
                 else {
-                    RF_CORE_WARN("GameServerEngine: Received disconnect for unknown or already removed endpoint [{}].", endpointKey);
+                    RF_CORE_WARN("GameServerEngine: Received disconnect for unknown or already removed endpoint [{}].", endpoint.ToString());
                     return;
                 }
             }
@@ -351,10 +350,9 @@ namespace RiftForged {
         }
 
         uint64_t GameServerEngine::GetPlayerIdForEndpoint(const RiftForged::Networking::NetworkEndpoint& endpoint) const {
-            std::string endpointKey = endpoint.ToString();
             std::lock_guard<std::mutex> lock(m_sessionMapsMutex);
-            auto it = m_endpointKeyToPlayerIdMap.find(endpointKey);
-            if (it != m_endpointKeyToPlayerIdMap.end()) {
+            auto it = m_endpointToPlayerIdMap.find(endpoint);
+            if (it != m_endpointToPlayerIdMap.end()) {
                 return it->second;
             }
             return 0;
@@ -629,6 +627,130 @@ namespace RiftForged {
             }
         }
 
+        void GameServerEngine::SetClientReplicationBudget(size_t bytesPerSecond) {
+            m_clientReplicationBytesPerSec.store(bytesPerSecond, std::memory_order_relaxed);
+            RF_CORE_INFO("GameServerEngine: Client replication budget set to {} bytes/sec.", bytesPerSecond);
+        }
+
+        // Changes when a player's health or status effects change, so the prioritizer can treat it as an event.
+        static uint64_t ReplicationEventKey(const GameLogic::ActivePlayer& player) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(player.currentHealth)) << 32) |
+                static_cast<uint32_t>(player.activeStatusEffects.size());
+        }
+
+        flatbuffers::DetachedBuffer GameServerEngine::BuildEntityStateUpdate(const GameLogic::ActivePlayer& player) const {
+            flatbuffers::FlatBufferBuilder builder(1024); // Increased default size a bit
+
+            // S2C_EntityStateUpdateMsg construction:
+            RiftForged::Networking::Shared::Vec3 pos_val(player.position.x(), player.position.y(), player.position.z());
+            RiftForged::Networking::Shared::Quaternion orient_val(player.orientation.x(), player.orientation.y(), player.orientation.z(), player.orientation.w());
+
+            flatbuffers::Offset<flatbuffers::Vector<uint32_t>> active_effects_fb_vector_offset;
+            if (!player.activeStatusEffects.empty()) {
+                std::vector<uint32_t> effects_as_uints;
+                effects_as_uints.reserve(player.activeStatusEffects.size());
+                for (const auto& effect_enum : player.activeStatusEffects) {
+                    effects_as_uints.push_back(static_cast<uint32_t>(effect_enum));
+                }
+                active_effects_fb_vector_offset = builder.CreateVector(effects_as_uints);
+            }
+
+            uint64_t server_timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+            auto state_payload_offset = Networking::UDP::S2C::CreateS2C_EntityStateUpdateMsg(
+                builder, player.playerId, &pos_val, &orient_val,
+                player.currentHealth, player.maxHealth, player.currentWill, player.maxWill,
+                server_timestamp_ms,
+                player.animationStateId, active_effects_fb_vector_offset);
+
+            Networking::UDP::S2C::Root_S2C_UDP_MessageBuilder root_builder(builder);
+            root_builder.add_payload_type(Networking::UDP::S2C::S2C_UDP_Payload_EntityStateUpdate);
+            root_builder.add_payload(state_payload_offset.Union());
+            auto root_offset = root_builder.Finish();
+            builder.Finish(root_offset);
+            return builder.Release();
+        }
+
+        // Sends each client the entity state updates the prioritizer picks for it this tick. Every player is
+        // an entity every client may receive; an update is serialized at most once per tick and the same
+        // bytes are queued for each client that gets it.
+        void GameServerEngine::ReplicateEntityStates(const std::vector<const GameLogic::ActivePlayer*>& players) {
+            m_replicationPrioritizer.BeginTick();
+            if (m_replicationPrioritizer.GetDeferredUpdateCountLastTick() > 0) {
+                RF_ENGINE_TRACE("SIM_TICK: {} entity updates deferred by client replication budgets last tick.",
+                    m_replicationPrioritizer.GetDeferredUpdateCountLastTick());
+            }
+            m_replicationPlayers.clear();
+            m_replicationUpdates.clear();
+            for (const GameLogic::ActivePlayer* player_const : players) {
+                if (!player_const || player_const->playerId == 0) {
+                    continue;
+                }
+                const bool changed = player_const->isDirty.load(std::memory_order_acquire);
+                if (changed) {
+                    RF_ENGINE_DEBUG("SIM_TICK: Player {} is dirty. Pos: ({:.1f},{:.1f},{:.1f}).",
+                        player_const->playerId, player_const->position.x(), player_const->position.y(), player_const->position.z());
+                    // Safely cast away const to modify atomic isDirty flag. The prioritizer now tracks the change per client.
+                    const_cast<GameLogic::ActivePlayer*>(player_const)->isDirty.store(false, std::memory_order_release);
+                }
+                m_replicationPrioritizer.UpdateEntity(player_const->playerId, player_const->position, changed, ReplicationEventKey(*player_const));
+                m_replicationPlayers[player_const->playerId] = player_const;
+            }
+
+            m_replicationSessions.clear();
+            {
+                std::lock_guard<std::mutex> lock(m_sessionMapsMutex);
+                m_replicationSessions.assign(m_playerIdToEndpointMap.begin(), m_playerIdToEndpointMap.end());
+            }
+            if (m_replicationSessions.empty()) {
+                return;
+            }
+            if (!m_packetHandlerPtr) {
+                RF_NETWORK_ERROR("GameServerEngine: m_packetHandlerPtr is null. Cannot send S2C_EntityStateUpdate to {} clients.", m_replicationSessions.size());
+                return;
+            }
+
+            const size_t tickBudget = static_cast<size_t>(
+                m_clientReplicationBytesPerSec.load(std::memory_order_relaxed) * static_cast<uint64_t>(m_tickIntervalMs.count()) / 1000);
+            const float tickSeconds = std::chrono::duration<float>(m_tickIntervalMs).count();
+
+            for (const auto& session : m_replicationSessions) {
+                auto clientPlayerIt = m_replicationPlayers.find(session.first);
+                if (clientPlayerIt == m_replicationPlayers.end()) {
+                    continue; // Not spawned yet
+                }
+                const Networking::NetworkEndpoint& playerEndpoint = session.second;
+
+                // Never budget above what the connection's congestion control lets through.
+                size_t clientBudget = tickBudget;
+                Networking::ConnectionTransferStats transferStats;
+                if (m_packetHandlerPtr->GetConnectionTransferStats(playerEndpoint, transferStats) && transferStats.pacingRateBytesPerSec > 0.0f) {
+                    clientBudget = std::min(clientBudget, static_cast<size_t>(transferStats.pacingRateBytesPerSec * tickSeconds));
+                }
+
+                m_replicationSelection.clear();
+                m_replicationPrioritizer.SelectForClient(session.first, session.first, clientPlayerIt->second->position,
+                    clientBudget, m_replicationSelection);
+
+                for (uint64_t entityId : m_replicationSelection) {
+                    auto updateIt = m_replicationUpdates.find(entityId);
+                    if (updateIt == m_replicationUpdates.end()) {
+                        updateIt = m_replicationUpdates.emplace(entityId, BuildEntityStateUpdate(*m_replicationPlayers.at(entityId))).first;
+                        m_replicationPrioritizer.SetEntityUpdateSize(entityId,
+                            updateIt->second.size() + Networking::GetAggregatedMessageHeaderSize());
+                    }
+                    if (!m_packetHandlerPtr->SendUnreliablePacket(
+                        playerEndpoint,
+                        RiftForged::Networking::UDP::S2C::S2C_UDP_Payload::S2C_UDP_Payload_EntityStateUpdate,
+                        updateIt->second)) {
+                        RF_NETWORK_ERROR("GameServerEngine: SendUnreliablePacket failed for S2C_EntityStateUpdate for Player {} to {}",
+                            entityId, playerEndpoint.ToString());
+                    }
+                }
+            }
+        }
+
         void GameServerEngine::SimulationTick() {
             // (Timer setup logic for thread ID and last_tick_time)
             std::stringstream ss_thread_id; ss_thread_id << std::this_thread::get_id();
@@ -649,6 +771,11 @@ namespace RiftForged {
                 }
                 last_tick_time = current_tick_start_time;
 
+                // Everything this thread sends during the tick is queued and flushed as one batch after step 5.
+                if (m_packetHandlerPtr) {
+                    m_packetHandlerPtr->BeginOutboundBatch();
+                }
+
                 // --- 0. Process Connection Management --- // New conceptual step
                 ProcessJoinRequests();
                 ProcessDisconnectRequests(); // Add this when implemented
@@ -695,71 +822,11 @@ namespace RiftForged {
                 if (!active_players_for_sync_const.empty()) {
                     RF_ENGINE_TRACE("SIM_TICK: Checking %zu active players for state sync.", active_players_for_sync_const.size());
                 }
+                ReplicateEntityStates(active_players_for_sync_const);
 
-                for (const GameLogic::ActivePlayer* player_const : active_players_for_sync_const) { // Renamed to avoid conflict
-                    if (player_const && player_const->isDirty.load(std::memory_order_acquire)) {
-                        std::optional<Networking::NetworkEndpoint> endpointOpt = GetEndpointForPlayerId(player_const->playerId);
-                        if (endpointOpt) {
-                            const Networking::NetworkEndpoint& playerEndpoint = endpointOpt.value();
-                            RF_ENGINE_DEBUG("SIM_TICK: Player {} is dirty. Pos: ({:.1f},{:.1f},{:.1f}). Prepping S2C_EntityStateUpdate for endpoint [{}].",
-                                player_const->playerId, player_const->position.x(), player_const->position.y(), player_const->position.z(), playerEndpoint.ToString());
-
-                            flatbuffers::FlatBufferBuilder builder(1024); // Increased default size a bit
-
-                            // S2C_EntityStateUpdateMsg construction:
-                            RiftForged::Networking::Shared::Vec3 pos_val(player_const->position.x(), player_const->position.y(), player_const->position.z());
-                            RiftForged::Networking::Shared::Quaternion orient_val(player_const->orientation.x(), player_const->orientation.y(), player_const->orientation.z(), player_const->orientation.w());
-
-                            flatbuffers::Offset<flatbuffers::Vector<uint32_t>> active_effects_fb_vector_offset;
-                            if (!player_const->activeStatusEffects.empty()) {
-                                std::vector<uint32_t> effects_as_uints;
-                                effects_as_uints.reserve(player_const->activeStatusEffects.size());
-                                for (const auto& effect_enum : player_const->activeStatusEffects) {
-                                    effects_as_uints.push_back(static_cast<uint32_t>(effect_enum));
-                                }
-                                active_effects_fb_vector_offset = builder.CreateVector(effects_as_uints);
-                            }
-
-                            uint64_t server_timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                std::chrono::system_clock::now().time_since_epoch()).count();
-
-                            auto state_payload_offset = Networking::UDP::S2C::CreateS2C_EntityStateUpdateMsg(
-                                builder, player_const->playerId, &pos_val, &orient_val,
-                                player_const->currentHealth, player_const->maxHealth, player_const->currentWill, player_const->maxWill,
-                                server_timestamp_ms,
-                                player_const->animationStateId, active_effects_fb_vector_offset);
-
-                            Networking::UDP::S2C::Root_S2C_UDP_MessageBuilder root_builder(builder);
-                            root_builder.add_payload_type(Networking::UDP::S2C::S2C_UDP_Payload_EntityStateUpdate);
-                            root_builder.add_payload(state_payload_offset.Union());
-                            auto root_offset = root_builder.Finish();
-                            builder.Finish(root_offset);
-
-                            std::vector<uint8_t> payloadBytes(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
-
-                            if (m_packetHandlerPtr) { // Check if the pointer is valid
-                                // This assumes 'builder' is the flatbuffers::FlatBufferBuilder used to create the message
-                                // and that builder.Finish() has already been called for the 'S2C_EntityStateUpdate' message.
-                                if (!m_packetHandlerPtr->SendUnreliablePacket( // Use the pointer
-                                    playerEndpoint,
-                                    RiftForged::Networking::UDP::S2C::S2C_UDP_Payload::S2C_UDP_Payload_EntityStateUpdate, // The new FlatBuffer payload type enum
-                                    builder.Release())) { // Directly pass the DetachedBuffer, transferring ownership of the serialized data
-                                    RF_NETWORK_ERROR("GameServerEngine: SendUnreliablePacket failed for S2C_EntityStateUpdate for Player %llu to %s",
-                                        player_const->playerId, playerEndpoint.ToString().c_str()); // Updated formatting for logger
-                                }
-                            }
-                            else {
-                                RF_NETWORK_ERROR("GameServerEngine: m_packetHandlerPtr is null. Cannot send S2C_EntityStateUpdate for Player {} to {}.",
-                                    player_const->playerId, playerEndpoint.ToString());
-                            }
-                            // Safely cast away const to modify atomic isDirty flag. This is generally okay if this is the designated point for reset.
-                            const_cast<GameLogic::ActivePlayer*>(player_const)->isDirty.store(false, std::memory_order_release);
-                        }
-                        else {
-                            RF_CORE_WARN("GameServerEngine: No endpoint for dirty player {}, cannot sync. Resetting dirty flag.", player_const->playerId);
-                            const_cast<GameLogic::ActivePlayer*>(player_const)->isDirty.store(false, std::memory_order_release);
-                        }
-                    }
+                // --- 5b. Flush this tick's outbound datagrams (sendmmsg/GSO where available) ---
+                if (m_packetHandlerPtr) {
+                    m_packetHandlerPtr->FlushOutboundBatch();
                 }
 
                 // --- 6. Control Tick Rate ---
@@ -768,6 +835,11 @@ namespace RiftForged {
                 auto tick_processing_duration = current_tick_end_time - current_tick_start_time;
                 auto sleep_for = m_tickIntervalMs - tick_processing_duration;
 
+                // Overruns and the receive queue drive the handler's overload detector, which sheds low-value input.
+                if (m_packetHandlerPtr) {
+                    m_packetHandlerPtr->ReportSimulationTick(tick_processing_duration, m_tickIntervalMs);
+                }
+
                 if (m_isSimulatingThread.load(std::memory_order_relaxed)) {
                     if (sleep_for > std::chrono::milliseconds(0)) {
                         std::unique_lock<std::mutex> lock(m_shutdownThreadMutex);
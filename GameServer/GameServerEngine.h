@@ -13,6 +13,7 @@
 #include <any>       // For storing various command types
 #include <deque>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <optional>  // For GetEndpointForPlayerId
 
@@ -25,6 +26,7 @@
 // Networking
 #include "../NetworkEngine/UDPPacketHandler.h"
 #include "../NetworkEngine/NetworkEndpoint.h"
+#include "ReplicationPrioritizer.h"
 
 // FlatBuffer Declarations (C2S for command types, S2C for sending, Common for shared types)
 #include "../FlatBuffers/V0.0.4/riftforged_common_types_generated.h"
@@ -99,9 +101,18 @@ namespace RiftForged {
              */
             uint16_t GetServerTickRateHz() const;
 
+            /**
+             * @brief Sets the S2C entity state replication budget per client, in bytes per second.
+             * Each tick a client receives its highest-priority updates within this rate times the tick
+             * interval (lower if its connection's congestion control paces slower); the rest wait.
+             */
+            void SetClientReplicationBudget(size_t bytesPerSecond);
+
         private:
             void SimulationTick();
             void ProcessPlayerCommands();
+            void ReplicateEntityStates(const std::vector<const GameLogic::ActivePlayer*>& players);
+            flatbuffers::DetachedBuffer BuildEntityStateUpdate(const GameLogic::ActivePlayer& player) const;
 
             struct ClientJoinRequest {
                 Networking::NetworkEndpoint endpoint;
@@ -135,8 +146,17 @@ namespace RiftForged {
             std::mutex m_shutdownThreadMutex;
             std::condition_variable m_shutdownThreadCv;
 
+            // --- S2C Replication (simulation thread only, except the budget) ---
+            ReplicationPrioritizer m_replicationPrioritizer;
+            std::atomic<size_t> m_clientReplicationBytesPerSec;
+            // Per-tick scratch, kept to reuse its capacity.
+            std::vector<std::pair<uint64_t, Networking::NetworkEndpoint>> m_replicationSessions;
+            std::unordered_map<uint64_t, const GameLogic::ActivePlayer*> m_replicationPlayers;
+            std::unordered_map<uint64_t, flatbuffers::DetachedBuffer> m_replicationUpdates;
+            std::vector<uint64_t> m_replicationSelection;
+
             // --- Session Mapping ---
-            std::map<std::string, uint64_t> m_endpointKeyToPlayerIdMap;
+            std::unordered_map<RiftForged::Networking::NetworkEndpoint, uint64_t> m_endpointToPlayerIdMap; // Keyed by the packed endpoint; no string building per lookup
             std::map<uint64_t, RiftForged::Networking::NetworkEndpoint> m_playerIdToEndpointMap;
             mutable std::mutex m_sessionMapsMutex;
 
@@ -0,0 +1,156 @@
+﻿// File: GameServer/ReplicationPrioritizer.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2025-2028 RiftForged Game Development Team
+
+#include "ReplicationPrioritizer.h"
+#include "../Utils/MathUtil.h"
+
+#include <algorithm>
+
+namespace RiftForged {
+    namespace Server {
+
+        ReplicationPrioritizer::ReplicationPrioritizer()
+            : m_currentTick(0),
+            m_deferredUpdatesThisTick(0),
+            m_deferredUpdatesLastTick(0) {
+        }
+
+        void ReplicationPrioritizer::BeginTick() {
+            // Forget entities that were not declared last tick, and their pairs.
+            bool entityRemoved = false;
+            for (auto it = m_entities.begin(); it != m_entities.end(); ) {
+                if (it->second.lastUpdatedTick != m_currentTick) {
+                    it = m_entities.erase(it);
+                    entityRemoved = true;
+                }
+                else {
+                    ++it;
+                }
+            }
+            // Forget clients that were not served last tick (disconnected).
+            for (auto it = m_clients.begin(); it != m_clients.end(); ) {
+                if (it->second.lastSelectedTick != m_currentTick) {
+                    it = m_clients.erase(it);
+                    continue;
+                }
+                if (entityRemoved) {
+                    std::unordered_map<uint64_t, PairState>& pairs = it->second.entities;
+                    for (auto pairIt = pairs.begin(); pairIt != pairs.end(); ) {
+                        if (m_entities.find(pairIt->first) == m_entities.end()) {
+                            pairIt = pairs.erase(pairIt);
+                        }
+                        else {
+                            ++pairIt;
+                        }
+                    }
+                }
+                ++it;
+            }
+
+            m_deferredUpdatesLastTick = m_deferredUpdatesThisTick;
+            m_deferredUpdatesThisTick = 0;
+            ++m_currentTick;
+        }
+
+        void ReplicationPrioritizer::UpdateEntity(uint64_t entityId, const Networking::Shared::Vec3& position, bool changed, uint64_t eventKey) {
+            auto insertResult = m_entities.try_emplace(entityId);
+            EntityRecord& entity = insertResult.first->second;
+            if (insertResult.second) {
+                entity.eventKey = eventKey;
+                changed = true;
+            }
+            else if (entity.eventKey != eventKey) {
+                entity.eventKey = eventKey;
+                entity.lastEventTick = m_currentTick;
+                changed = true;
+            }
+            entity.position = position;
+            entity.lastUpdatedTick = m_currentTick;
+            if (changed) {
+                entity.lastChangedTick = m_currentTick;
+            }
+        }
+
+        void ReplicationPrioritizer::SetEntityUpdateSize(uint64_t entityId, size_t updateSizeBytes) {
+            auto it = m_entities.find(entityId);
+            if (it != m_entities.end() && updateSizeBytes > 0) {
+                it->second.updateSizeBytes = updateSizeBytes;
+            }
+        }
+
+        float ReplicationPrioritizer::DistanceWeight(const Networking::Shared::Vec3& a, const Networking::Shared::Vec3& b) {
+            const float distance = Utilities::Math::Distance(a, b);
+            return std::max(1.0f / (1.0f + distance / REPLICATION_REFERENCE_DISTANCE), REPLICATION_MIN_DISTANCE_WEIGHT);
+        }
+
+        void ReplicationPrioritizer::SelectForClient(uint64_t clientId, uint64_t clientEntityId, const Networking::Shared::Vec3& clientPosition,
+            size_t byteBudget, std::vector<uint64_t>& outEntityIds) {
+            ClientState& client = m_clients[clientId];
+            client.lastSelectedTick = m_currentTick;
+
+            m_candidates.clear();
+            for (const auto& entityPair : m_entities) {
+                const uint64_t entityId = entityPair.first;
+                const EntityRecord& entity = entityPair.second;
+
+                auto insertResult = client.entities.try_emplace(entityId);
+                PairState& pair = insertResult.first->second;
+                if (insertResult.second) {
+                    pair.pendingSinceTick = m_currentTick; // New client or new entity: send its full state
+                }
+                else if (pair.pendingSinceTick == 0 && entity.lastChangedTick > pair.lastSentTick) {
+                    pair.pendingSinceTick = entity.lastChangedTick;
+                }
+                if (pair.pendingSinceTick == 0) {
+                    continue;
+                }
+                if (entity.lastEventTick > pair.lastSentTick) {
+                    pair.pendingEvent = true;
+                }
+
+                float importance = REPLICATION_IMPORTANCE_DEFAULT;
+                if (entityId == clientEntityId) {
+                    importance = REPLICATION_IMPORTANCE_SELF;
+                }
+                else if (pair.pendingEvent) {
+                    importance = REPLICATION_IMPORTANCE_EVENT;
+                }
+                ++pair.ticksWaiting;
+                pair.accumulatedPriority += importance * DistanceWeight(clientPosition, entity.position) *
+                    (1.0f + REPLICATION_STALENESS_GAIN * static_cast<float>(pair.ticksWaiting));
+
+                m_candidates.push_back({ pair.accumulatedPriority, entityId, entity.updateSizeBytes, &pair });
+            }
+
+            std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return a.priority > b.priority;
+                });
+
+            const int64_t budget = static_cast<int64_t>(byteBudget);
+            int64_t remaining = budget + client.budgetCarryBytes;
+            bool anySelected = false;
+            for (const Candidate& candidate : m_candidates) {
+                const int64_t size = static_cast<int64_t>(candidate.updateSizeBytes);
+                const bool fits = size <= remaining;
+                const bool overdrawForTop = !anySelected && client.budgetCarryBytes >= 0 && remaining > 0;
+                if (!fits && !overdrawForTop) {
+                    ++m_deferredUpdatesThisTick;
+                    continue;
+                }
+                remaining -= size;
+                anySelected = true;
+                outEntityIds.push_back(candidate.entityId);
+
+                PairState& pair = *candidate.pair;
+                pair.accumulatedPriority = 0.0f;
+                pair.ticksWaiting = 0;
+                pair.lastSentTick = m_currentTick;
+                pair.pendingSinceTick = 0;
+                pair.pendingEvent = false;
+            }
+            client.budgetCarryBytes = std::min(remaining, budget);
+        }
+
+    } // namespace Server
+} // namespace RiftForged
@@ -0,0 +1,111 @@
+﻿// File: GameServer/ReplicationPrioritizer.h
+// RiftForged Game Development Team
+// Copyright (c) 2025-2028 RiftForged Game Development Team
+// Description: Chooses which entity state updates each client receives per simulation tick.
+// Every (client, entity) pair with an unsent change keeps a priority accumulator that grows each
+// tick it waits, faster for nearby entities, the client's own entity and entities with a recent
+// gameplay event. Each tick the highest-priority updates are sent until the client's byte budget
+// is spent; the rest keep accumulating, so more entities lower the update rate instead of
+// overflowing the client's link.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../FlatBuffers/V0.0.4/riftforged_common_types_generated.h" // For Vec3
+
+namespace RiftForged {
+    namespace Server {
+
+        // Default S2C replication budget per client. The per-tick budget is this times the tick interval.
+        const size_t DEFAULT_CLIENT_REPLICATION_BYTES_PER_SEC = 64 * 1024;
+
+        // Size assumed for an entity's update until one has been serialized (header included).
+        const size_t DEFAULT_ENTITY_UPDATE_SIZE_ESTIMATE = 128;
+
+        // Accumulator growth per tick = importance * distance weight * (1 + staleness * ticks waited).
+        const float REPLICATION_IMPORTANCE_DEFAULT = 1.0f;
+        const float REPLICATION_IMPORTANCE_SELF = 8.0f;    // The client's own entity
+        const float REPLICATION_IMPORTANCE_EVENT = 4.0f;   // Health or status effects changed since last sent
+        const float REPLICATION_STALENESS_GAIN = 0.25f;
+        // Distance weight is 1 / (1 + distance / REPLICATION_REFERENCE_DISTANCE), never below the floor,
+        // so far entities update less often but are never starved.
+        const float REPLICATION_REFERENCE_DISTANCE = 20.0f;
+        const float REPLICATION_MIN_DISTANCE_WEIGHT = 0.05f;
+
+        // Used by the simulation thread only; not thread-safe.
+        class ReplicationPrioritizer {
+        public:
+            ReplicationPrioritizer();
+
+            // Starts a tick. Entities not passed to UpdateEntity and clients not passed to SelectForClient
+            // since the previous BeginTick are forgotten.
+            void BeginTick();
+
+            // Declares an entity for this tick. 'changed' marks a new state for every client. 'eventKey'
+            // summarizes event-worthy state (e.g. health and status effects); a new value raises the
+            // entity's importance until each client has received it.
+            void UpdateEntity(uint64_t entityId, const Networking::Shared::Vec3& position, bool changed, uint64_t eventKey);
+
+            // Records the serialized size of an entity's update, used to budget later ticks.
+            void SetEntityUpdateSize(uint64_t entityId, size_t updateSizeBytes);
+
+            // Accumulates priority for every entity with an unsent change for this client, then appends to
+            // outEntityIds, highest priority first, the updates that fit in byteBudget plus any unused or
+            // overdrawn budget carried from the last tick. If the top update alone exceeds the budget it is
+            // still sent once the carry is not negative, and later ticks repay the overdraft. The selected
+            // pairs count as sent. A client seen for the first time receives every entity.
+            void SelectForClient(uint64_t clientId, uint64_t clientEntityId, const Networking::Shared::Vec3& clientPosition,
+                size_t byteBudget, std::vector<uint64_t>& outEntityIds);
+
+            size_t GetTrackedClientCount() const { return m_clients.size(); }
+            // Updates that were pending but did not fit in a client's budget during the last tick.
+            size_t GetDeferredUpdateCountLastTick() const { return m_deferredUpdatesLastTick; }
+
+        private:
+            struct EntityRecord {
+                Networking::Shared::Vec3 position;
+                uint64_t eventKey = 0;
+                uint64_t lastUpdatedTick = 0;
+                uint64_t lastChangedTick = 0;
+                uint64_t lastEventTick = 0;
+                size_t updateSizeBytes = DEFAULT_ENTITY_UPDATE_SIZE_ESTIMATE;
+            };
+
+            struct PairState {
+                float accumulatedPriority = 0.0f;
+                uint32_t ticksWaiting = 0;
+                uint64_t lastSentTick = 0;      // 0: never sent
+                uint64_t pendingSinceTick = 0;  // Tick of the oldest unsent change; 0: nothing pending
+                bool pendingEvent = false;
+            };
+
+            struct ClientState {
+                std::unordered_map<uint64_t, PairState> entities;
+                int64_t budgetCarryBytes = 0;
+                uint64_t lastSelectedTick = 0;
+            };
+
+            static float DistanceWeight(const Networking::Shared::Vec3& a, const Networking::Shared::Vec3& b);
+
+            std::unordered_map<uint64_t, EntityRecord> m_entities;
+            std::unordered_map<uint64_t, ClientState> m_clients;
+            uint64_t m_currentTick;
+            size_t m_deferredUpdatesThisTick;
+            size_t m_deferredUpdatesLastTick;
+
+            // Reused across calls so selection does not allocate in steady state.
+            struct Candidate {
+                float priority;
+                uint64_t entityId;
+                size_t updateSizeBytes;
+                PairState* pair;
+            };
+            std::vector<Candidate> m_candidates;
+        };
+
+    } // namespace Server
+} // namespace RiftForged
@@ -0,0 +1,79 @@
+﻿// File: CongestionController.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements the AIMD congestion controller and the controller factory.
+
+#include "CongestionController.h"
+#include "../Utils/Logger.h"     // For RF_NETWORK_... macros
+
+#include <limits>                // For std::numeric_limits
+
+namespace RiftForged {
+    namespace Networking {
+
+        namespace {
+            // Pacing gain over cwnd/SRTT: ahead of the window while probing, just above it afterwards
+            // so ACK clocking still fills the window.
+            const float AIMD_SLOW_START_PACING_GAIN = 2.0f;
+            const float AIMD_CONGESTION_AVOIDANCE_PACING_GAIN = 1.25f;
+        }
+
+        void AimdCongestionController::Reset() {
+            m_congestionWindow = INITIAL_CONGESTION_WINDOW_BYTES;
+            m_slowStartThreshold = std::numeric_limits<size_t>::max();
+            m_bytesAckedInWindow = 0;
+            m_smoothedRTT_ms = 0.0f;
+            m_lastReductionTime = std::chrono::steady_clock::time_point::min();
+        }
+
+        void AimdCongestionController::OnPacketSent(size_t, size_t, std::chrono::steady_clock::time_point) {
+            // AIMD reacts to ACKs and losses only.
+        }
+
+        void AimdCongestionController::OnPacketAcked(size_t bytes, float smoothedRTT_ms, float, std::chrono::steady_clock::time_point) {
+            m_smoothedRTT_ms = smoothedRTT_ms;
+            if (InSlowStart()) {
+                m_congestionWindow += bytes;
+            }
+            else {
+                m_bytesAckedInWindow += bytes;
+                if (m_bytesAckedInWindow >= m_congestionWindow) {
+                    m_bytesAckedInWindow -= m_congestionWindow;
+                    m_congestionWindow += DEFAULT_MAX_DATAGRAM_SIZE;
+                }
+            }
+            m_congestionWindow = std::min(m_congestionWindow, MAX_CONGESTION_WINDOW_BYTES);
+        }
+
+        void AimdCongestionController::OnPacketLost(size_t, bool isTimeout, std::chrono::steady_clock::time_point now) {
+            const bool sameLossEvent = m_lastReductionTime != std::chrono::steady_clock::time_point::min() &&
+                now - m_lastReductionTime < std::chrono::duration<float, std::milli>(m_smoothedRTT_ms);
+            if (sameLossEvent) {
+                if (isTimeout) {
+                    m_congestionWindow = MIN_CONGESTION_WINDOW_BYTES;
+                }
+                return;
+            }
+            m_slowStartThreshold = std::max(m_congestionWindow / 2, MIN_CONGESTION_WINDOW_BYTES);
+            m_congestionWindow = isTimeout ? MIN_CONGESTION_WINDOW_BYTES : m_slowStartThreshold;
+            m_bytesAckedInWindow = 0;
+            m_lastReductionTime = now;
+            RF_NETWORK_DEBUG("AIMD: {} loss. cwnd={} ssthresh={}", isTimeout ? "Timeout" : "Fast retransmit",
+                m_congestionWindow, m_slowStartThreshold);
+        }
+
+        float AimdCongestionController::GetPacingRateBytesPerSec(float smoothedRTT_ms) const {
+            const float gain = InSlowStart() ? AIMD_SLOW_START_PACING_GAIN : AIMD_CONGESTION_AVOIDANCE_PACING_GAIN;
+            return gain * static_cast<float>(m_congestionWindow) * 1000.0f / std::max(smoothedRTT_ms, 1.0f);
+        }
+
+        std::unique_ptr<ICongestionController> CreateCongestionController(CongestionControlAlgorithm algorithm) {
+            switch (algorithm) {
+            case CongestionControlAlgorithm::AIMD:
+            default:
+                return std::make_unique<AimdCongestionController>();
+            }
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
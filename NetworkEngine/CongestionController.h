@@ -0,0 +1,164 @@
+﻿// File: CongestionController.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Per-connection congestion control. A congestion controller turns ACK and loss events
+// (plus the connection's SRTT) into a congestion window and a pacing rate; a token-bucket pacer
+// applies the rate on the send path. Algorithms plug in behind ICongestionController.
+
+#pragma once
+
+#include <algorithm>        // For std::min, std::max
+#include <chrono>           // For std::chrono::steady_clock
+#include <cstddef>          // For size_t
+#include <cstdint>          // For uint8_t
+#include <memory>           // For std::unique_ptr
+
+#include "GamePacketHeader.h"  // For DEFAULT_MAX_DATAGRAM_SIZE
+#include "SentPacketWindow.h"  // For SENT_PACKET_WINDOW_SIZE
+
+namespace RiftForged {
+    namespace Networking {
+
+        // Window bounds, in bytes. The window never needs to exceed what the send window can hold.
+        const size_t INITIAL_CONGESTION_WINDOW_BYTES = 10 * DEFAULT_MAX_DATAGRAM_SIZE;
+        const size_t MIN_CONGESTION_WINDOW_BYTES = 2 * DEFAULT_MAX_DATAGRAM_SIZE;
+        const size_t MAX_CONGESTION_WINDOW_BYTES = SENT_PACKET_WINDOW_SIZE * DEFAULT_MAX_DATAGRAM_SIZE;
+
+        // The pacer lets a connection send up to this many milliseconds' worth of its pacing rate at
+        // once, so one server tick's datagrams are not spread across the next tick.
+        const float PACER_BURST_MS = 40.0f;
+
+        enum class CongestionControlAlgorithm : uint8_t {
+            AIMD = 0        // Slow start, then additive increase / multiplicative decrease on loss
+        };
+
+        // Congestion control algorithm for one connection. Called with the connection's
+        // ReliableConnectionState::internalStateMutex held, so implementations need no locking.
+        class ICongestionController {
+        public:
+            virtual ~ICongestionController() = default;
+
+            virtual const char* GetName() const = 0;
+            virtual void Reset() = 0;
+
+            // A reliable packet of 'bytes' was sent; bytesInFlight includes it.
+            virtual void OnPacketSent(size_t bytes, size_t bytesInFlight, std::chrono::steady_clock::time_point now) = 0;
+            // A reliable packet of 'bytes' was acknowledged. smoothedRTT_ms already includes its RTT sample, if any.
+            virtual void OnPacketAcked(size_t bytes, float smoothedRTT_ms, float rttVariance_ms, std::chrono::steady_clock::time_point now) = 0;
+            // A reliable packet was taken as lost: by fast retransmit, or because its RTO expired (isTimeout).
+            virtual void OnPacketLost(size_t bytes, bool isTimeout, std::chrono::steady_clock::time_point now) = 0;
+
+            virtual size_t GetCongestionWindowBytes() const = 0;
+            virtual float GetPacingRateBytesPerSec(float smoothedRTT_ms) const = 0;
+        };
+
+        // Reno-style AIMD: the window grows by the bytes acknowledged until the first loss (slow start),
+        // then by one datagram per window's worth of ACKs. A loss halves it, an RTO collapses it to the
+        // minimum; losses within one SRTT of a reduction belong to the same event and are not counted again.
+        class AimdCongestionController : public ICongestionController {
+        public:
+            AimdCongestionController() { Reset(); }
+
+            const char* GetName() const override { return "AIMD"; }
+            void Reset() override;
+
+            void OnPacketSent(size_t bytes, size_t bytesInFlight, std::chrono::steady_clock::time_point now) override;
+            void OnPacketAcked(size_t bytes, float smoothedRTT_ms, float rttVariance_ms, std::chrono::steady_clock::time_point now) override;
+            void OnPacketLost(size_t bytes, bool isTimeout, std::chrono::steady_clock::time_point now) override;
+
+            size_t GetCongestionWindowBytes() const override { return m_congestionWindow; }
+            float GetPacingRateBytesPerSec(float smoothedRTT_ms) const override;
+
+        private:
+            bool InSlowStart() const { return m_congestionWindow < m_slowStartThreshold; }
+
+            size_t m_congestionWindow;
+            size_t m_slowStartThreshold;
+            size_t m_bytesAckedInWindow;     // Congestion avoidance: ACKed bytes toward the next increase
+            float m_smoothedRTT_ms;          // Last SRTT seen, to group losses into one reduction
+            std::chrono::steady_clock::time_point m_lastReductionTime;
+        };
+
+        std::unique_ptr<ICongestionController> CreateCongestionController(CongestionControlAlgorithm algorithm);
+
+        // Token bucket in whatever unit the caller charges: bytes for a connection's send pacer, messages for
+        // its ingress rate limits (see ReliableConnectionState::AdmitIngressMessage). Tokens accrue at the
+        // given rate up to the burst; a reset bucket is full once the first Refill clamps it to the burst.
+        // When pacing, datagrams that can be dropped (unreliable) must fit the available tokens; reliable ones
+        // are always charged and may overdraw the bucket, which then holds back droppable traffic and
+        // retransmissions until repaid.
+        class TokenBucketPacer {
+        public:
+            TokenBucketPacer() { Reset(); }
+
+            void Reset() {
+                m_tokens = static_cast<double>(INITIAL_CONGESTION_WINDOW_BYTES);
+                m_lastRefillTime = std::chrono::steady_clock::time_point::min();
+            }
+
+            void Refill(float unitsPerSec, size_t burstUnits, std::chrono::steady_clock::time_point now) {
+                if (m_lastRefillTime != std::chrono::steady_clock::time_point::min() && now > m_lastRefillTime) {
+                    const double elapsedSec = std::chrono::duration<double>(now - m_lastRefillTime).count();
+                    m_tokens += elapsedSec * unitsPerSec;
+                }
+                m_tokens = std::min(m_tokens, static_cast<double>(burstUnits));
+                if (m_lastRefillTime == std::chrono::steady_clock::time_point::min() || now > m_lastRefillTime) {
+                    m_lastRefillTime = now;
+                }
+            }
+
+            bool TryConsume(size_t units) {
+                if (m_tokens < static_cast<double>(units)) {
+                    return false;
+                }
+                m_tokens -= static_cast<double>(units);
+                return true;
+            }
+
+            void ForceConsume(size_t units) { m_tokens -= static_cast<double>(units); }
+
+            bool InDebt() const { return m_tokens < 0.0; }
+
+            // Time until the bucket is out of debt at the given rate.
+            std::chrono::steady_clock::duration TimeUntilRepaid(float unitsPerSec) const {
+                if (m_tokens >= 0.0 || unitsPerSec <= 0.0f) {
+                    return std::chrono::steady_clock::duration::zero();
+                }
+                return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(-m_tokens / unitsPerSec));
+            }
+
+            double GetTokens() const { return m_tokens; }
+
+        private:
+            double m_tokens;
+            std::chrono::steady_clock::time_point m_lastRefillTime;
+        };
+
+        // Per-connection transfer counters and the current congestion state, for monitoring.
+        struct ConnectionTransferStats {
+            uint64_t datagramsSent = 0;
+            uint64_t bytesSent = 0;              // Every datagram, retransmissions included
+            uint64_t bytesRetransmitted = 0;
+            uint64_t bytesAcknowledged = 0;      // Reliable bytes the peer confirmed, each packet counted once
+            uint64_t unreliableBytesShed = 0;    // Unreliable datagrams held back by the pacer or window
+            uint64_t packetsLost = 0;            // Fast retransmits and RTO expiries
+            float lossRate = 0.0f;               // Smoothed fraction of reliable packets taken as lost
+            bool fecActive = false;              // Unreliable datagrams are currently FEC-protected
+            uint64_t fecParityBytesSent = 0;
+            uint64_t fecDatagramsRecovered = 0;  // Lost unreliable datagrams from the peer rebuilt from parity
+            bool compactHeaders = false;         // Datagrams to the peer use the compact (v5) header
+            uint64_t headerBytesSaved = 0;       // Left off bytesSent on the wire by compact headers
+            size_t maxDatagramSize = 0;          // Current datagram size limit, raised by path MTU discovery
+            bool encrypted = false;              // Datagrams in both directions are AEAD-sealed
+            uint64_t datagramsRejected = 0;      // Received datagrams that failed authentication or were replays
+            uint64_t messagesRateLimited = 0;    // Received messages dropped by the ingress rate limit, unverified (movement thinned under overload included)
+            float goodputBytesPerSec = 0.0f;     // Smoothed rate of bytesAcknowledged
+            size_t congestionWindowBytes = 0;
+            size_t bytesInFlight = 0;
+            float pacingRateBytesPerSec = 0.0f;
+            const char* congestionControlAlgorithm = "";
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
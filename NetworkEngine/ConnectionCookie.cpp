@@ -0,0 +1,127 @@
+﻿// File: ConnectionCookie.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements stateless connection cookies.
+
+#include "ConnectionCookie.h"
+
+#include <cstddef>               // For offsetof
+#include <cstring>               // For std::memcpy
+#include <stdexcept>             // For std::runtime_error
+
+namespace RiftForged {
+    namespace Networking {
+
+        namespace {
+            // Wraps a cookie message in an unreliable IS_HEARTBEAT datagram with a v4 header.
+            template <typename Message>
+            PacketBuffer PrepareCookieDatagram(const Message& message) {
+                const size_t datagramSize = GetGamePacketHeaderSize() + sizeof(Message);
+                PacketBuffer datagram = PacketBuffer::Allocate(datagramSize);
+                if (datagram.Capacity() < datagramSize) {
+                    return PacketBuffer();
+                }
+                const GamePacketHeader header(static_cast<uint8_t>(GamePacketFlag::IS_HEARTBEAT));
+                std::memcpy(datagram.MutableData(), &header, GetGamePacketHeaderSize());
+                std::memcpy(datagram.MutableData() + GetGamePacketHeaderSize(), &message, sizeof(Message));
+                datagram.SetSize(datagramSize);
+                return datagram;
+            }
+
+            // The cookie message kind of a v4 IS_HEARTBEAT datagram, or 0 if it is anything else.
+            uint8_t CookieMessageKind(const uint8_t* data, size_t size) {
+                if (!data || size <= GetGamePacketHeaderSize()) {
+                    return 0;
+                }
+                GamePacketHeader header;
+                std::memcpy(&header, data, GetGamePacketHeaderSize());
+                if (header.protocolId != CURRENT_PROTOCOL_ID_VERSION || !HasFlag(header.flags, GamePacketFlag::IS_HEARTBEAT)) {
+                    return 0;
+                }
+                return data[GetGamePacketHeaderSize()];
+            }
+        }
+
+        ConnectionCookieIssuer::ConnectionCookieIssuer()
+            : m_epoch(std::chrono::steady_clock::now()) {
+            if (sodium_init() < 0) {
+                throw std::runtime_error("ConnectionCookieIssuer: libsodium failed to initialize.");
+            }
+            randombytes_buf(m_secret, sizeof(m_secret));
+        }
+
+        void ConnectionCookieIssuer::ComputeMac(const NetworkEndpoint& endpoint, uint64_t issuedAtMs,
+            uint8_t (&outMac)[CONNECTION_COOKIE_MAC_SIZE]) const {
+            uint8_t input[sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint64_t)];
+            const uint32_t address = endpoint.GetAddressV4();
+            const uint16_t port = endpoint.GetPort();
+            std::memcpy(input, &address, sizeof(address));
+            std::memcpy(input + sizeof(address), &port, sizeof(port));
+            std::memcpy(input + sizeof(address) + sizeof(port), &issuedAtMs, sizeof(issuedAtMs));
+
+            unsigned char mac[crypto_auth_BYTES];
+            crypto_auth(mac, input, sizeof(input), m_secret);
+            std::memcpy(outMac, mac, CONNECTION_COOKIE_MAC_SIZE);
+        }
+
+        ConnectionCookieResult ConnectionCookieIssuer::Process(const NetworkEndpoint& sender, const uint8_t* data, size_t size,
+            std::chrono::steady_clock::time_point now, PacketBuffer& outChallenge, uint8_t& outCapabilities) const {
+            const uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_epoch).count());
+
+            if (CookieMessageKind(data, size) == static_cast<uint8_t>(ConnectionCookieKind::ECHO) &&
+                size >= GetGamePacketHeaderSize() + sizeof(ConnectionCookieEcho)) {
+                ConnectionCookieEcho echo;
+                std::memcpy(&echo, data + GetGamePacketHeaderSize(), sizeof(echo));
+                if (echo.cookie.issuedAtMs <= nowMs && nowMs - echo.cookie.issuedAtMs <= CONNECTION_COOKIE_LIFETIME_MS) {
+                    uint8_t expectedMac[CONNECTION_COOKIE_MAC_SIZE];
+                    ComputeMac(sender, echo.cookie.issuedAtMs, expectedMac);
+                    if (sodium_memcmp(expectedMac, echo.cookie.mac, CONNECTION_COOKIE_MAC_SIZE) == 0) {
+                        outCapabilities = echo.capabilities;
+                        return ConnectionCookieResult::Verified;
+                    }
+                }
+                // A stale or forged echo is no smaller than a challenge, so it may be answered with a fresh one.
+            }
+
+            // Anything smaller than the challenge could turn this server into an amplifier; so could
+            // anything that is not a protocol datagram at all.
+            if (size < GetGamePacketHeaderSize() + sizeof(ConnectionCookieChallenge)) {
+                return ConnectionCookieResult::Dropped;
+            }
+            uint32_t protocolId = 0;
+            std::memcpy(&protocolId, data + offsetof(GamePacketHeader, protocolId), sizeof(protocolId));
+            if (protocolId != CURRENT_PROTOCOL_ID_VERSION) {
+                return ConnectionCookieResult::Dropped;
+            }
+
+            ConnectionCookieChallenge challenge;
+            challenge.kind = static_cast<uint8_t>(ConnectionCookieKind::CHALLENGE);
+            challenge.cookie.issuedAtMs = nowMs;
+            ComputeMac(sender, nowMs, challenge.cookie.mac);
+            outChallenge = PrepareCookieDatagram(challenge);
+            return outChallenge.Empty() ? ConnectionCookieResult::Dropped : ConnectionCookieResult::Challenged;
+        }
+
+        PacketBuffer PrepareConnectionCookieRequest() {
+            ConnectionCookieRequest request = {};
+            request.kind = static_cast<uint8_t>(ConnectionCookieKind::REQUEST);
+            return PrepareCookieDatagram(request);
+        }
+
+        bool PrepareConnectionCookieEcho(const uint8_t* data, size_t size, PacketBuffer& outEcho, uint8_t capabilities) {
+            if (CookieMessageKind(data, size) != static_cast<uint8_t>(ConnectionCookieKind::CHALLENGE) ||
+                size < GetGamePacketHeaderSize() + sizeof(ConnectionCookieChallenge)) {
+                return false;
+            }
+            ConnectionCookieChallenge challenge;
+            std::memcpy(&challenge, data + GetGamePacketHeaderSize(), sizeof(challenge));
+            ConnectionCookieEcho echo;
+            echo.kind = static_cast<uint8_t>(ConnectionCookieKind::ECHO);
+            echo.cookie = challenge.cookie;
+            echo.capabilities = capabilities;
+            outEcho = PrepareCookieDatagram(echo);
+            return !outEcho.Empty();
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,57 @@
+﻿// File: ConnectionCookie.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Stateless connection cookies (see GamePacketHeader.h). The server answers a sender it has
+// no connection for with a challenge and only creates the connection once the sender echoes a valid
+// cookie, so spoofed or junk datagrams cost one HMAC rather than an allocation and a table insert.
+
+#pragma once
+
+#include <chrono>           // For std::chrono::steady_clock
+#include <cstddef>          // For size_t
+#include <cstdint>          // For uint8_t, uint64_t
+
+#include "sodium.h"         // For crypto_auth_KEYBYTES
+#include "GamePacketHeader.h"
+#include "NetworkEndpoint.h"
+#include "PacketBufferPool.h" // For PacketBuffer
+
+namespace RiftForged {
+    namespace Networking {
+
+        enum class ConnectionCookieResult : uint8_t {
+            Verified,   // The datagram echoes a valid cookie: the sender may have a connection
+            Challenged, // The sender must echo the challenge returned with this result
+            Dropped     // Not worth answering: malformed, or smaller than the challenge would be
+        };
+
+        // Issues and checks cookies on the server. Holds no per-sender state; the cookie's timestamp
+        // bounds its lifetime. Process is const and may be called from any number of receive threads.
+        class ConnectionCookieIssuer {
+        public:
+            ConnectionCookieIssuer(); // Draws a random secret
+
+            ConnectionCookieIssuer(const ConnectionCookieIssuer&) = delete;
+            ConnectionCookieIssuer& operator=(const ConnectionCookieIssuer&) = delete;
+
+            // Handles a datagram from a sender that has no connection. outChallenge is set for Challenged,
+            // outCapabilities (the ConnectionCapability bits the echo asks for) for Verified.
+            ConnectionCookieResult Process(const NetworkEndpoint& sender, const uint8_t* data, size_t size,
+                std::chrono::steady_clock::time_point now, PacketBuffer& outChallenge, uint8_t& outCapabilities) const;
+
+        private:
+            void ComputeMac(const NetworkEndpoint& endpoint, uint64_t issuedAtMs, uint8_t (&outMac)[CONNECTION_COOKIE_MAC_SIZE]) const;
+
+            unsigned char m_secret[crypto_auth_KEYBYTES];
+            std::chrono::steady_clock::time_point m_epoch; // Cookie timestamps count milliseconds from here
+        };
+
+        // Client side: the padded ConnectionCookieRequest a client opens with (and repeats until challenged).
+        PacketBuffer PrepareConnectionCookieRequest();
+
+        // Client side: if 'data' is a received ConnectionCookieChallenge datagram, prepares its echo, asking
+        // for 'capabilities' (ConnectionCapability bits), into outEcho and returns true.
+        bool PrepareConnectionCookieEcho(const uint8_t* data, size_t size, PacketBuffer& outEcho, uint8_t capabilities = 0);
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,164 @@
+﻿// File: ConnectionTable.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements the open-addressing connection table used by UDPPacketHandler.
+
+#include "ConnectionTable.h"
+#include "../Utils/Logger.h"     // For RF_NETWORK_... macros
+
+#include <new>                   // For std::bad_alloc
+
+namespace RiftForged {
+    namespace Networking {
+
+        ConnectionTable::ConnectionTable(uint32_t maxConnections)
+            : m_maxConnections(maxConnections > 0 ? maxConnections : 1),
+            m_indexMask(0),
+            m_nextUnusedSlot(0),
+            m_size(0)
+        {
+            // Keep the load factor at or below 0.5 so probe chains stay short and an empty bucket always exists.
+            size_t indexCapacity = 1;
+            while (indexCapacity < static_cast<size_t>(m_maxConnections) * 2) {
+                indexCapacity <<= 1;
+            }
+            m_index.assign(indexCapacity, IndexEntry{});
+            m_indexMask = indexCapacity - 1;
+
+            const uint32_t chunkCount = (m_maxConnections + CONNECTION_TABLE_CHUNK_SIZE - 1) / CONNECTION_TABLE_CHUNK_SIZE;
+            m_chunks = std::make_unique<std::unique_ptr<Connection[]>[]>(chunkCount);
+        }
+
+        size_t ConnectionTable::FindPositionUnlocked(const NetworkEndpoint& endpoint) const {
+            const uint64_t hash = endpoint.GetHash();
+            size_t pos = static_cast<size_t>(hash) & m_indexMask;
+            while (true) {
+                const IndexEntry& entry = m_index[pos];
+                if (entry.slot == INVALID_SLOT) {
+                    return npos;
+                }
+                if (entry.hash == hash && SlotAt(entry.slot).endpoint == endpoint) {
+                    return pos;
+                }
+                pos = (pos + 1) & m_indexMask;
+            }
+        }
+
+        ConnectionTable::Connection* ConnectionTable::Find(const NetworkEndpoint& endpoint) const {
+            std::shared_lock<std::shared_mutex> lock(m_mutex);
+            const size_t pos = FindPositionUnlocked(endpoint);
+            return pos == npos ? nullptr : &SlotAt(m_index[pos].slot);
+        }
+
+        uint32_t ConnectionTable::AllocateSlotUnlocked() {
+            if (!m_freeSlots.empty()) {
+                const uint32_t slot = m_freeSlots.front();
+                m_freeSlots.pop_front();
+                return slot;
+            }
+            if (m_nextUnusedSlot >= m_maxConnections) {
+                return INVALID_SLOT;
+            }
+            const uint32_t slot = m_nextUnusedSlot;
+            std::unique_ptr<Connection[]>& chunk = m_chunks[slot / CONNECTION_TABLE_CHUNK_SIZE];
+            if (!chunk) {
+                chunk.reset(new Connection[CONNECTION_TABLE_CHUNK_SIZE]); // May throw std::bad_alloc
+            }
+            ++m_nextUnusedSlot;
+            return slot;
+        }
+
+        ConnectionTable::Connection* ConnectionTable::FindOrCreate(const NetworkEndpoint& endpoint, bool* outCreated) {
+            if (outCreated) {
+                *outCreated = false;
+            }
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                const size_t pos = FindPositionUnlocked(endpoint);
+                if (pos != npos) {
+                    return &SlotAt(m_index[pos].slot);
+                }
+            }
+
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            const size_t existingPos = FindPositionUnlocked(endpoint); // Another thread may have inserted it meanwhile.
+            if (existingPos != npos) {
+                return &SlotAt(m_index[existingPos].slot);
+            }
+
+            uint32_t slot = INVALID_SLOT;
+            try {
+                slot = AllocateSlotUnlocked();
+            }
+            catch (const std::bad_alloc& e) {
+                RF_NETWORK_CRITICAL("ConnectionTable: Failed to allocate connection chunk for {}: {}", endpoint.ToString(), e.what());
+                return nullptr;
+            }
+            if (slot == INVALID_SLOT) {
+                RF_NETWORK_WARN("ConnectionTable: Table full ({} connections). Rejecting {}.", m_maxConnections, endpoint.ToString());
+                return nullptr;
+            }
+
+            Connection& connection = SlotAt(slot);
+            connection.state.Reset(); // Recycled slots carry the previous endpoint's state.
+            connection.endpoint = endpoint;
+            ++connection.generation;
+            connection.ackTimerArmed.store(false, std::memory_order_relaxed);
+            connection.aggregateQueued.store(false, std::memory_order_relaxed);
+
+            size_t pos = static_cast<size_t>(endpoint.GetHash()) & m_indexMask;
+            while (m_index[pos].slot != INVALID_SLOT) {
+                pos = (pos + 1) & m_indexMask;
+            }
+            m_index[pos].hash = endpoint.GetHash();
+            m_index[pos].slot = slot;
+            m_size.fetch_add(1, std::memory_order_relaxed);
+
+            if (outCreated) {
+                *outCreated = true;
+            }
+            return &connection;
+        }
+
+        bool ConnectionTable::Remove(const NetworkEndpoint& endpoint) {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            size_t hole = FindPositionUnlocked(endpoint);
+            if (hole == npos) {
+                return false;
+            }
+            m_freeSlots.push_back(m_index[hole].slot);
+
+            // Backward-shift deletion: pull later entries of the probe chain into the hole when
+            // their home bucket is at or before it, so lookups never need tombstones.
+            size_t next = (hole + 1) & m_indexMask;
+            while (m_index[next].slot != INVALID_SLOT) {
+                const size_t home = static_cast<size_t>(m_index[next].hash) & m_indexMask;
+                if (((next - home) & m_indexMask) >= ((next - hole) & m_indexMask)) {
+                    m_index[hole] = m_index[next];
+                    hole = next;
+                }
+                next = (next + 1) & m_indexMask;
+            }
+            m_index[hole] = IndexEntry{};
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void ConnectionTable::Clear() {
+            std::unique_lock<std::shared_mutex> lock(m_mutex);
+            for (IndexEntry& entry : m_index) {
+                if (entry.slot != INVALID_SLOT) {
+                    SlotAt(entry.slot).state.Reset();
+                    entry = IndexEntry{};
+                }
+            }
+            // Every allocated slot becomes free again; chunks stay allocated so old pointers remain valid.
+            m_freeSlots.clear();
+            for (uint32_t slot = 0; slot < m_nextUnusedSlot; ++slot) {
+                m_freeSlots.push_back(slot);
+            }
+            m_size.store(0, std::memory_order_relaxed);
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
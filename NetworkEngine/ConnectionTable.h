@@ -0,0 +1,131 @@
+﻿// File: ConnectionTable.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Open-addressing table of per-endpoint reliability state used by UDPPacketHandler.
+// Connections live in fixed chunks that are never moved or freed, so pointers stay valid
+// without reference counting and the table's memory is bounded by its configured capacity.
+
+#pragma once
+
+#include <atomic>           // For std::atomic
+#include <cstdint>          // For uint32_t, uint64_t
+#include <deque>            // For std::deque (free slot FIFO)
+#include <memory>           // For std::unique_ptr
+#include <mutex>            // For std::unique_lock
+#include <shared_mutex>     // For std::shared_mutex, std::shared_lock
+#include <vector>           // For std::vector
+
+#include "NetworkEndpoint.h"
+#include "ReliableConnectionState.h"
+
+// Default upper bound on simultaneous connections. The index (a 16-byte entry per bucket, 2 buckets per
+// connection, ~4 MB) is allocated up front; connections, roughly 1.7 KB each, a chunk at a time as the
+// table grows, so a full table takes ~230 MB. Connections with reliable packets in flight additionally
+// hold a ~5 KB SentPacketWindow, and reassembly, channel backlog and FEC buffers are allocated on use.
+const uint32_t DEFAULT_MAX_CONNECTIONS = 131072;
+const uint32_t CONNECTION_TABLE_CHUNK_SIZE = 1024; // Connections allocated together when the table grows
+
+namespace RiftForged {
+    namespace Networking {
+
+        // ConnectionTable maps NetworkEndpoint -> Connection with linear probing over a power-of-two
+        // index sized to twice the capacity, so lookups almost always resolve in one probe using the
+        // endpoint's precomputed hash. The index never rehashes; removals use backward-shift deletion
+        // so no tombstones build up.
+        //
+        // Lookups take a shared lock, so receive threads, the simulation thread and the reliability
+        // thread read concurrently; only inserting and removing a connection take the exclusive lock.
+        // A Connection pointer stays valid for the lifetime of the table. After Remove() the slot goes
+        // to the back of a FIFO free list and is reset before reuse, so a caller still holding a removed
+        // connection only ever sees a fresh, empty state, never freed memory.
+        class ConnectionTable {
+        public:
+            struct Connection {
+                NetworkEndpoint endpoint;             // Written only while the slot is not indexed
+                ReliableConnectionState state;        // Guarded by state.internalStateMutex
+                uint32_t generation = 0;              // Bumped each time the slot is (re)used; lets timers detect a recycled slot
+                std::atomic<bool> ackTimerArmed{ false }; // A delayed-ACK timer is pending for this connection
+                std::atomic<bool> aggregateQueued{ false }; // An outbound batch will seal this connection's pending aggregate
+            };
+
+            explicit ConnectionTable(uint32_t maxConnections = DEFAULT_MAX_CONNECTIONS);
+
+            ConnectionTable(const ConnectionTable&) = delete;
+            ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+            /**
+             * @brief Finds the connection for an endpoint.
+             * @return The connection, or nullptr if the endpoint has none.
+             */
+            Connection* Find(const NetworkEndpoint& endpoint) const;
+
+            /**
+             * @brief Finds the connection for an endpoint, creating it if needed.
+             * @param outCreated Optional; set to true if a new connection was created.
+             * @return The connection, or nullptr if the table is full or allocation failed.
+             */
+            Connection* FindOrCreate(const NetworkEndpoint& endpoint, bool* outCreated = nullptr);
+
+            /**
+             * @brief Removes an endpoint's connection and recycles its slot.
+             * @return True if a connection was removed.
+             */
+            bool Remove(const NetworkEndpoint& endpoint);
+
+            /**
+             * @brief Removes every connection. Allocated chunks are kept for reuse.
+             */
+            void Clear();
+
+            /**
+             * @brief Calls fn(Connection&) for every live connection under the shared lock.
+             * fn must not insert into or remove from this table.
+             */
+            template <typename Fn>
+            void ForEach(Fn&& fn) {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                for (const IndexEntry& entry : m_index) {
+                    if (entry.slot != INVALID_SLOT) {
+                        fn(SlotAt(entry.slot));
+                    }
+                }
+            }
+
+            size_t Size() const { return m_size.load(std::memory_order_relaxed); }
+            uint32_t Capacity() const { return m_maxConnections; }
+
+        private:
+            static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+            struct IndexEntry {
+                uint64_t hash = 0;
+                uint32_t slot = INVALID_SLOT;
+            };
+
+            Connection& SlotAt(uint32_t slot) const {
+                return m_chunks[slot / CONNECTION_TABLE_CHUNK_SIZE][slot % CONNECTION_TABLE_CHUNK_SIZE];
+            }
+
+            // Returns the index position holding the endpoint, or npos. Caller holds m_mutex (either mode).
+            size_t FindPositionUnlocked(const NetworkEndpoint& endpoint) const;
+
+            // Takes a slot from the free list or the next unused slot, allocating a chunk if needed.
+            // Returns INVALID_SLOT when full. Caller holds m_mutex exclusively.
+            uint32_t AllocateSlotUnlocked();
+
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            const uint32_t m_maxConnections;
+            size_t m_indexMask;
+            std::vector<IndexEntry> m_index;
+
+            std::unique_ptr<std::unique_ptr<Connection[]>[]> m_chunks; // One pointer per possible chunk; filled on demand
+            uint32_t m_nextUnusedSlot;
+            std::deque<uint32_t> m_freeSlots;  // FIFO so a removed slot is reused as late as possible
+
+            std::atomic<size_t> m_size;
+            mutable std::shared_mutex m_mutex;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -26,8 +26,10 @@ namespace RiftForged {
             IS_ACK_ONLY = 1 << 1,   // This packet contains only ACK information, no application payload
             IS_HEARTBEAT = 1 << 2,  // This is a keep-alive packet
             IS_DISCONNECT = 1 << 3, // This packet signals a disconnection
-            IS_FRAGMENT_START = 1 << 4, // For future fragmentation implementation (indicates first fragment)
-            IS_FRAGMENT_END = 1 << 5,   // For future fragmentation implementation (indicates last fragment)
+            IS_FRAGMENT_START = 1 << 4, // First fragment of a fragmented message (both START and END: a middle fragment)
+            IS_FRAGMENT_END = 1 << 5,   // Last fragment of a fragmented message (payload starts with a FragmentHeader)
+            IS_AGGREGATE = 1 << 6,      // Payload is a sequence of messages, each prefixed by an AggregatedMessageHeader
+            HAS_ACK_RANGES = 1 << 7,    // Payload starts with an AckRangesHeader and its AckRange/NACK entries
             // Additional flags can be added here as needed for transport-layer concerns.
         };
 
@@ -77,5 +79,290 @@ namespace RiftForged {
             return sizeof(GamePacketHeader);
         }
 
+        // --- Compact header (protocol v5) ---
+        // On the wire a connection may use a variable-length header instead of GamePacketHeader:
+        //   1 byte   COMPACT_HEADER_MARKER | CompactHeaderField bits (which fields follow)
+        //   1 byte   flags (GamePacketFlag)
+        //   2 bytes  sequenceNumber, low 16 bits (HAS_SEQUENCE), or 4 bytes (also WIDE_SEQUENCE)
+        //   2+4 bytes ackNumber (low 16 bits) and ackBitfield (HAS_ACK)
+        // all little-endian. Reliable sequences are sent as 16 bits and widened against the newest one
+        // received, which is safe because the send window is far smaller than 2^15; FEC tags are sent
+        // whole, and a sequence of 0 is left out. The ACK fields are left out of an unreliable datagram
+        // when they repeat the last ones sent; the receiver then reuses the last ones it got.
+        // A v4 header starts with the low byte of CURRENT_PROTOCOL_ID_VERSION, never with the marker, so
+        // both forms can arrive on one socket. A client opts in by asking for COMPACT_HEADERS in its
+        // cookie echo (see ConnectionCapability) and then sending its join request (and all its datagrams)
+        // compact; the server answers a connection compact once it has received a compact datagram from
+        // it, and v4 peers keep receiving GamePacketHeader. A compact header carries no protocol ID, so
+        // one from a sender with no connection, or on a connection that did not ask for it, is dropped.
+        // The reliability layer always works on GamePacketHeader: datagrams are converted on their way
+        // to and from the socket (see PrepareOutgoingDatagramForWire and DecodeIncomingPacketHeader).
+
+        const uint8_t COMPACT_HEADER_VERSION = 5;
+        const uint8_t COMPACT_HEADER_MARKER = COMPACT_HEADER_VERSION << 4;
+        const uint8_t COMPACT_HEADER_MARKER_MASK = 0xF0;
+
+        enum class CompactHeaderField : uint8_t {
+            HAS_SEQUENCE = 1 << 0,
+            WIDE_SEQUENCE = 1 << 1,    // The sequence field is 32 bits
+            HAS_ACK = 1 << 2,
+        };
+
+        const size_t MIN_COMPACT_HEADER_SIZE = 2;
+        const size_t MAX_COMPACT_HEADER_SIZE = 12;
+
+        inline bool IsCompactPacketHeader(const uint8_t* data, size_t size) {
+            return size >= MIN_COMPACT_HEADER_SIZE && (data[0] & COMPACT_HEADER_MARKER_MASK) == COMPACT_HEADER_MARKER;
+        }
+
+        // Size of the compact header starting at data, or 0 if it is malformed or longer than 'size'.
+        inline size_t GetCompactPacketHeaderSize(const uint8_t* data, size_t size) {
+            if (!IsCompactPacketHeader(data, size)) return 0;
+            const uint8_t fields = data[0] & static_cast<uint8_t>(~COMPACT_HEADER_MARKER_MASK);
+            const uint8_t known = static_cast<uint8_t>(CompactHeaderField::HAS_SEQUENCE) |
+                static_cast<uint8_t>(CompactHeaderField::WIDE_SEQUENCE) | static_cast<uint8_t>(CompactHeaderField::HAS_ACK);
+            const bool hasSequence = (fields & static_cast<uint8_t>(CompactHeaderField::HAS_SEQUENCE)) != 0;
+            const bool wideSequence = (fields & static_cast<uint8_t>(CompactHeaderField::WIDE_SEQUENCE)) != 0;
+            if ((fields & ~known) != 0 || (wideSequence && !hasSequence)) return 0;
+            size_t headerSize = MIN_COMPACT_HEADER_SIZE;
+            if (hasSequence) headerSize += wideSequence ? 4 : 2;
+            if ((fields & static_cast<uint8_t>(CompactHeaderField::HAS_ACK)) != 0) headerSize += 6;
+            return headerSize <= size ? headerSize : 0;
+        }
+
+        // --- Fragmentation ---
+        // A message too large for one datagram is sent as fragmentCount reliable packets with consecutive
+        // sequence numbers, so fragment i of a message always has sequence (first fragment's sequence + i).
+        // Each fragment's payload starts with a FragmentHeader. Every fragment except the last carries
+        // 'stride' bytes of the message, where stride = ceil(messageSize / fragmentCount).
+
+        // Largest datagram (GamePacketHeader included) we send without fragmenting. Chosen to stay below
+        // the IPv6 minimum MTU minus IP/UDP headers and common tunnel overhead, so the IP layer never fragments.
+        const size_t DEFAULT_MAX_DATAGRAM_SIZE = 1200;
+        // Bounded by the 32-bit receivedFragmentMask, and well inside the receive history, so a lost first
+        // fragment can always still be repaired.
+        const uint8_t MAX_FRAGMENTS_PER_MESSAGE = 32;
+
+#pragma pack(push, 1)
+
+        struct FragmentHeader {
+            uint8_t fragmentIndex;   // 0-based position of this fragment in the message
+            uint8_t fragmentCount;   // Total fragments in the message (2..MAX_FRAGMENTS_PER_MESSAGE)
+            uint32_t messageSize;    // Size of the reassembled message in bytes
+        };
+
+#pragma pack(pop)
+
+        constexpr size_t GetFragmentHeaderSize() {
+            return sizeof(FragmentHeader);
+        }
+
+        inline bool IsFragment(uint8_t headerFlags) {
+            return (headerFlags & (static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_START) | static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_END))) != 0;
+        }
+
+        // Flags carried by fragment 'index' of 'count': START on the first, END on the last, both in between.
+        inline uint8_t FragmentFlagsFor(uint8_t index, uint8_t count) {
+            if (index == 0) return static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_START);
+            if (index + 1 == count) return static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_END);
+            return static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_START) | static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_END);
+        }
+
+        // --- Aggregation and channels ---
+        // Messages sent to one connection during a tick are packed into shared IS_AGGREGATE datagrams
+        // instead of one datagram each. Each message is prefixed by an AggregatedMessageHeader naming
+        // its channel. The datagram is reliable if any message in it is on a reliable channel; when it is
+        // retransmitted, its unreliable messages are left out, so only reliable messages are ever resent.
+
+        // Delivery semantics of a message. Ordering and staleness are tracked per channel, so a lost
+        // message on one channel never holds back another.
+        enum class NetworkChannel : uint8_t {
+            RELIABLE_UNORDERED = 0,   // Delivered exactly once, as soon as it arrives
+            RELIABLE_ORDERED = 1,     // Delivered exactly once, in send order within the channel
+            UNRELIABLE = 2,           // May be lost
+            UNRELIABLE_SEQUENCED = 3, // May be lost; dropped if older than the newest one delivered on the channel
+            COUNT
+        };
+        const size_t NETWORK_CHANNEL_COUNT = static_cast<size_t>(NetworkChannel::COUNT);
+
+        inline bool IsReliableChannel(NetworkChannel channel) {
+            return channel == NetworkChannel::RELIABLE_UNORDERED || channel == NetworkChannel::RELIABLE_ORDERED;
+        }
+
+#pragma pack(push, 1)
+
+        struct AggregatedMessageHeader {
+            uint16_t messageSize;      // Bytes of message data following this header
+            uint8_t channel;           // A NetworkChannel value
+            uint16_t channelSequence;  // Per-channel send order (RELIABLE_ORDERED and UNRELIABLE_SEQUENCED; 0 otherwise)
+        };
+
+#pragma pack(pop)
+
+        constexpr size_t GetAggregatedMessageHeaderSize() {
+            return sizeof(AggregatedMessageHeader);
+        }
+
+        // --- Extended selective ACKs ---
+        // ackNumber/ackBitfield only cover the newest 33 sequences. When the receiver holds packets older
+        // than that which the sender may still count as in flight (a burst with a loss in it, or a
+        // retransmission of something we already had), its ACK-only packet carries HAS_ACK_RANGES: the
+        // payload lists runs of received sequences further back, so they are not retransmitted needlessly.
+        // The same block can carry NACKs: runs of sequences the receiver has seen later packets overtake,
+        // which the sender resends at once instead of waiting for their retransmission timeout.
+
+        // Entries of each kind carried by one ACK-only packet; runs beyond this are reported by later ACKs.
+        const uint8_t MAX_ACK_RANGES_PER_PACKET = 16;
+
+#pragma pack(push, 1)
+
+        struct AckRangesHeader {
+            uint8_t rangeCount;        // Acknowledged AckRange entries that follow (0..MAX_ACK_RANGES_PER_PACKET)
+            uint8_t nackCount;         // Missing AckRange entries after those (0..MAX_ACK_RANGES_PER_PACKET)
+        };
+
+        // A run of sequences (ackNumber - offset - length + 1) .. (ackNumber - offset), newest first.
+        struct AckRange {
+            uint16_t offset;           // Distance of the run's newest sequence behind ackNumber (> 32 if acknowledged)
+            uint16_t length;           // Sequences in the run (>= 1)
+        };
+
+#pragma pack(pop)
+
+        constexpr size_t GetAckRangesHeaderSize() {
+            return sizeof(AckRangesHeader);
+        }
+
+        constexpr size_t GetAckRangeSize() {
+            return sizeof(AckRange);
+        }
+
+        // --- Forward error correction (FEC) for unreliable datagrams ---
+        // With FEC on, a connection's unreliable datagrams are protected in groups. Each carries an FEC tag
+        // in its sequenceNumber (otherwise 0 for unreliable packets), and after every FEC_GROUP_SIZE of them
+        // the sender adds a parity datagram: the XOR of the group's units, each unit being the datagram's
+        // flags, payload length (little-endian) and payload, zero-padded to the longest. A receiver missing
+        // exactly one datagram of a group rebuilds it from the others and the parity, without a round trip.
+        // Parity datagrams are flagged IS_ACK_ONLY without IS_RELIABLE, so a peer that does not decode FEC
+        // only reads their ACK fields.
+
+        const uint8_t FEC_GROUP_SIZE = 4;           // Protected datagrams per parity datagram
+        const uint8_t FEC_MAX_GROUP_SIZE = 32;      // Largest group a receiver accepts (one bit per datagram)
+        const size_t FEC_UNIT_PREFIX_SIZE = 3;      // Flags and payload length in front of each unit's payload
+        const uint32_t FEC_GROUP_MASK = 0x00FFFFFF; // Group numbers are 24 bits and skip 0
+
+        // Group number in the upper 24 bits, then the datagram's index in its group (for a parity datagram,
+        // the number of datagrams it covers). A tag of 0 means the datagram is not protected.
+        inline SequenceNumber MakeFecTag(uint32_t group, uint8_t index) {
+            return static_cast<SequenceNumber>(((group & FEC_GROUP_MASK) << 8) | index);
+        }
+        inline uint32_t FecGroupOf(SequenceNumber tag) { return (tag >> 8) & FEC_GROUP_MASK; }
+        inline uint8_t FecIndexOf(SequenceNumber tag) { return static_cast<uint8_t>(tag & 0xFF); }
+
+        // True if group a was started after group b, allowing for the 24-bit wrap.
+        inline bool IsFecGroupNewer(uint32_t a, uint32_t b) {
+            const uint32_t distance = (a - b) & FEC_GROUP_MASK;
+            return distance != 0 && distance < (FEC_GROUP_MASK + 1) / 2;
+        }
+
+        // --- Path MTU discovery ---
+        // The server searches each compact-header connection's path for the largest datagram it carries
+        // unfragmented, and raises the connection's maxDatagramSize to it. Sockets send with Don't Fragment
+        // set, so a datagram too large for a link is dropped on the way instead of being split by IP.
+        // A probe is an unreliable IS_HEARTBEAT datagram, always in the full (v4) header form, whose payload
+        // is a PathMtuProbe zero-padded to the size under test; the peer answers every probe with a
+        // PathMtuProbeAck. A binary search runs between the largest confirmed size and the smallest one
+        // that went unanswered PMTU_PROBE_ATTEMPTS times. IS_HEARTBEAT datagrams never reach the application.
+
+        const size_t PMTU_PROBE_MAX_DATAGRAM_SIZE = 1472;    // Ethernet MTU minus the IPv4 and UDP headers
+        const size_t PMTU_SEARCH_PRECISION = 16;             // The search ends once its bounds are this close
+        const uint8_t PMTU_PROBE_ATTEMPTS = 3;               // Unanswered probes before a size counts as too large
+        const uint32_t PMTU_FIRST_PROBE_DELAY_MS = 1000;     // After the connection is created
+        const uint32_t PMTU_RESEARCH_INTERVAL_MS = 600000;   // Paths change; search again this long after the last
+        // A reliable datagram above DEFAULT_MAX_DATAGRAM_SIZE that has timed out this often suggests the path
+        // shrank (an ICMP black hole); the connection falls back to DEFAULT_MAX_DATAGRAM_SIZE.
+        const int PMTU_BLACK_HOLE_RETRIES = 2;
+
+        enum class PathMtuMessageKind : uint8_t {
+            PROBE = 1,
+            PROBE_ACK = 2
+        };
+
+#pragma pack(push, 1)
+
+        struct PathMtuProbe {
+            uint8_t kind;              // PathMtuMessageKind::PROBE
+            uint16_t probeId;          // Echoed by the PathMtuProbeAck
+        };
+
+        struct PathMtuProbeAck {
+            uint8_t kind;              // PathMtuMessageKind::PROBE_ACK
+            uint16_t probeId;
+            uint16_t receivedSize;     // Size of the probe datagram as it arrived
+        };
+
+#pragma pack(pop)
+
+        // --- Connection cookies ---
+        // The server creates no state for a sender until it has proved it receives at its address. Any
+        // datagram from an unknown sender is answered with a ConnectionCookieChallenge carrying a cookie,
+        // an HMAC over the sender's endpoint and the time it was issued; the sender echoes the cookie in a
+        // ConnectionCookieEcho, and only a valid echo creates its connection. A client opens with a
+        // ConnectionCookieRequest, padded so the challenge is never larger than what prompted it (no
+        // amplification), and sends its join request once it has echoed. All three are unreliable
+        // IS_HEARTBEAT datagrams in the full (v4) header form, like path MTU probes, whose kinds they follow.
+        // The echo also carries the ConnectionCapability bits the client wants on its connection.
+
+        const size_t CONNECTION_COOKIE_MAC_SIZE = 16;         // Truncated HMAC-SHA-512-256
+        const uint32_t CONNECTION_COOKIE_LIFETIME_MS = 10000; // An echo must arrive this soon after the challenge
+
+        enum class ConnectionCookieKind : uint8_t {
+            REQUEST = 3,
+            CHALLENGE = 4,
+            ECHO = 5
+        };
+
+        // Optional protocol features a client asks for in its ConnectionCookieEcho.
+        enum class ConnectionCapability : uint8_t {
+            COMPACT_HEADERS = 1 << 0   // The client may send compact (v5) headers
+        };
+
+#pragma pack(push, 1)
+
+        struct ConnectionCookie {
+            uint64_t issuedAtMs;       // Server clock; opaque to the client
+            uint8_t mac[CONNECTION_COOKIE_MAC_SIZE];
+        };
+
+        struct ConnectionCookieChallenge {
+            uint8_t kind;              // ConnectionCookieKind::CHALLENGE
+            ConnectionCookie cookie;
+        };
+
+        struct ConnectionCookieEcho {
+            uint8_t kind;              // ConnectionCookieKind::ECHO
+            ConnectionCookie cookie;   // As received in the challenge
+            uint8_t capabilities;      // ConnectionCapability bits
+        };
+
+        struct ConnectionCookieRequest {
+            uint8_t kind;              // ConnectionCookieKind::REQUEST
+            uint8_t padding[sizeof(ConnectionCookieChallenge) - 1];
+        };
+
+#pragma pack(pop)
+
+        // --- Encryption ---
+        // Once a connection has session keys (see EnablePacketEncryption) every datagram in either direction
+        // is sealed with an AEAD (AES-256-GCM or ChaCha20-Poly1305). The header, in whichever form, stays in
+        // clear, followed by a 64-bit little-endian counter that makes the nonce; both are authenticated as
+        // associated data. The payload is encrypted in place and the tag follows it. Counters are accepted
+        // once each, within a window of the newest AEAD_REPLAY_WINDOW, so a replayed datagram is dropped.
+
+        const size_t AEAD_COUNTER_SIZE = 8;
+        const size_t AEAD_TAG_SIZE = 16;
+        const size_t AEAD_DATAGRAM_OVERHEAD = AEAD_COUNTER_SIZE + AEAD_TAG_SIZE;
+        const uint32_t AEAD_REPLAY_WINDOW = 64;
+
     } // namespace Networking
 } // namespace RiftForged
\ No newline at end of file
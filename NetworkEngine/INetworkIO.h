@@ -2,7 +2,7 @@
 #pragma once
 
 #include "NetworkEndpoint.h"
-#include "OverlappedIOContext.h" // If methods need to expose this for advanced context management
+#include "PacketBufferPool.h" // For PacketBuffer
 #include <string>
 #include <cstdint>
 #include <vector>
@@ -11,6 +11,17 @@ namespace RiftForged {
     namespace Networking {
 
         class INetworkIOEvents; // Forward declaration
+        struct OverlappedIOContext; // Only defined by the Winsock/IOCP backend (OverlappedIOContext.h)
+
+        // A non-owning view of one datagram in an outbound batch (see INetworkIO::SendBatch).
+        // When 'packet' is set, data/size describe its bytes and a backend that completes sends
+        // asynchronously may keep a reference to it instead of copying the datagram.
+        struct OutgoingDatagram {
+            const NetworkEndpoint* recipient;
+            const uint8_t* data;
+            uint32_t size;
+            const PacketBuffer* packet = nullptr;
+        };
 
         class INetworkIO {
         public:
@@ -45,12 +56,57 @@ namespace RiftForged {
              */
             virtual bool SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) = 0;
 
+            /**
+             * @brief Sends a refcounted packet buffer. Backends with asynchronous completion override this
+             * to hold a reference until the send completes instead of copying; the default calls SendData.
+             * @return True if the send operation was successfully queued/initiated, false otherwise.
+             */
+            virtual bool SendPacket(const NetworkEndpoint& recipient, const PacketBuffer& packet) {
+                return SendData(recipient, packet.Data(), static_cast<uint32_t>(packet.Size()));
+            }
+
+            /**
+             * @brief Sends several datagrams in one call. Backends that can coalesce syscalls
+             * (sendmmsg, UDP GSO, batched SQEs) override this; the default simply loops over SendPacket/SendData.
+             * The data pointed to only needs to stay valid for the duration of the call.
+             * @param datagrams Array of datagram views.
+             * @param count Number of entries in the array.
+             * @return The number of datagrams successfully handed to the OS.
+             */
+            virtual size_t SendBatch(const OutgoingDatagram* datagrams, size_t count) {
+                size_t sent = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    const bool queued = datagrams[i].packet
+                        ? SendPacket(*datagrams[i].recipient, *datagrams[i].packet)
+                        : SendData(*datagrams[i].recipient, datagrams[i].data, datagrams[i].size);
+                    if (queued) {
+                        ++sent;
+                    }
+                }
+                return sent;
+            }
+
             /**
              * @brief Checks if the network IO layer is currently running.
              * @return True if running, false otherwise.
              */
             virtual bool IsRunning() const = 0;
 
+            /**
+             * @brief Reports whether datagrams leave with Don't Fragment set, so one too large for the path is
+             * dropped on the way instead of fragmented by IP. Path MTU discovery depends on it.
+             * @return True if DF is set on the socket(s); the default is false.
+             */
+            virtual bool SupportsPathMtuProbing() const { return false; }
+
+            /**
+             * @brief Reports how full the OS receive queue is, from 0 (empty) to 1 (further datagrams are dropped);
+             * with several sockets, the fullest one. A queue that stays full means datagrams arrive faster than
+             * OnRawDataReceived handles them. Cheap enough to call once per simulation tick.
+             * @return The fill fraction; the default is 0, for backends that can't tell.
+             */
+            virtual float GetReceiveQueueFill() const { return 0.0f; }
+
 
             // These context management methods are for more advanced scenarios where the PacketHandler
             // might want to control the receive context lifecycle. For the initial refactor,
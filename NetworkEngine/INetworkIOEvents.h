@@ -2,13 +2,15 @@
 #pragma once
 
 #include "NetworkEndpoint.h" // Assuming this defines your NetworkEndpoint struct/class
-#include "OverlappedIOContext.h" // UDPSocketAsync uses this, so events might pass it
 #include <cstdint>
 #include <string>
 
 namespace RiftForged {
     namespace Networking {
 
+        // Only the IOCP backend (UDPSocketAsync) has per-operation contexts; other backends pass nullptr.
+        struct OverlappedIOContext;
+
         class INetworkIOEvents {
         public:
             virtual ~INetworkIOEvents() = default;
@@ -18,7 +20,8 @@ namespace RiftForged {
              * @param sender The network endpoint from which the data was received.
              * @param data Pointer to the buffer containing the received data.
              * @param size The size of the received data in bytes.
-             * @param context The OverlappedIOContext used for this receive operation.
+             * @param context The OverlappedIOContext used for this receive operation, or nullptr for
+             * backends that receive in batches without per-operation contexts (e.g., UDPSocketEpoll).
              * The INetworkIO layer is responsible for managing (e.g., re-posting or returning to pool)
              * this context after this callback returns, unless specified otherwise by a return value.
              */
@@ -29,6 +32,7 @@ namespace RiftForged {
 
             /**
              * @brief Called by the INetworkIO layer when an asynchronous send operation completes.
+             * Backends whose sends complete synchronously inside SendData (e.g., UDPSocketEpoll) do not call this.
              * @param context The OverlappedIOContext associated with this send operation.
              * This context typically contains the recipient information and the buffer.
              * @param success True if the send operation reported success, false otherwise.
@@ -0,0 +1,69 @@
+﻿// File: NetworkEndpoint.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: String conversion for NetworkEndpoint. Only used for configuration and logging;
+// the packet path works on the packed address directly.
+
+#include "NetworkEndpoint.h"
+
+#include <cstring>      // For std::memcpy
+
+namespace RiftForged {
+    namespace Networking {
+
+        namespace {
+            // Parses "a.b.c.d" into the four address bytes (in wire order). Returns false on malformed input.
+            bool ParseDottedQuad(const std::string& ip, uint8_t (&outBytes)[4]) {
+                size_t pos = 0;
+                for (int octet = 0; octet < 4; ++octet) {
+                    if (octet > 0) {
+                        if (pos >= ip.size() || ip[pos] != '.') {
+                            return false;
+                        }
+                        ++pos;
+                    }
+                    unsigned value = 0;
+                    size_t digits = 0;
+                    while (pos < ip.size() && ip[pos] >= '0' && ip[pos] <= '9' && digits < 3) {
+                        value = value * 10 + static_cast<unsigned>(ip[pos] - '0');
+                        ++pos;
+                        ++digits;
+                    }
+                    if (digits == 0 || value > 255) {
+                        return false;
+                    }
+                    outBytes[octet] = static_cast<uint8_t>(value);
+                }
+                return pos == ip.size();
+            }
+        }
+
+        NetworkEndpoint::NetworkEndpoint(const std::string& ip, uint16_t p)
+            : m_addressV4(0), m_port(p), m_hash(0) {
+            uint8_t bytes[4] = { 0, 0, 0, 0 };
+            if (ParseDottedQuad(ip, bytes)) {
+                std::memcpy(&m_addressV4, bytes, sizeof(m_addressV4));
+            }
+            m_hash = ComputeHash(m_addressV4, m_port);
+        }
+
+        std::string NetworkEndpoint::GetIpString() const {
+            uint8_t bytes[4];
+            std::memcpy(bytes, &m_addressV4, sizeof(bytes));
+            std::string result;
+            result.reserve(15);
+            for (int i = 0; i < 4; ++i) {
+                if (i > 0) {
+                    result.push_back('.');
+                }
+                result += std::to_string(bytes[i]);
+            }
+            return result;
+        }
+
+        std::string NetworkEndpoint::ToString() const {
+            return GetIpString() + ":" + std::to_string(m_port);
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -1,45 +1,91 @@
 ﻿#pragma once
 #include <string>
-#include <cstdint> // For uint16_t
+#include <cstdint> // For uint16_t, uint32_t, uint64_t
+#include <cstddef> // For size_t
+#include <functional> // For std::hash
 
-// Forward declare a system-specific address structure if needed, or use general fields
-// For Winsock, this would eventually wrap something like sockaddr_in.
-// For simplicity here, we'll store IP as string and port.
+// A remote UDP address kept in its raw, packed form: the IPv4 address bytes exactly as they
+// appear in sockaddr_in::sin_addr, the port in host byte order, and a 64-bit hash computed once
+// at construction. Endpoints are built straight from the received sockaddr, compared and hashed
+// without touching strings, and converted back to a sockaddr for sends.
+// ToString() formats the address and is meant for logging only.
 
 namespace RiftForged {
     namespace Networking {
 
         struct NetworkEndpoint {
-            std::string ipAddress;
-            uint16_t port;
-            // You might also store a unique ID for this endpoint if assigned by ClientManager
-
-            NetworkEndpoint(const std::string& ip = "", uint16_t p = 0)
-                : ipAddress(ip), port(p) {
+        public:
+            NetworkEndpoint()
+                : m_addressV4(0), m_port(0), m_hash(ComputeHash(0, 0)) {
             }
 
-            // For logging or map keys
-            std::string ToString() const {
-                return ipAddress + ":" + std::to_string(port);
+            /**
+             * @brief Builds an endpoint from the raw fields of a sockaddr_in.
+             * @param addressV4NetworkOrder sin_addr.s_addr, unchanged (network byte order).
+             * @param portHostOrder ntohs(sin_port).
+             */
+            NetworkEndpoint(uint32_t addressV4NetworkOrder, uint16_t portHostOrder)
+                : m_addressV4(addressV4NetworkOrder), m_port(portHostOrder), m_hash(ComputeHash(addressV4NetworkOrder, portHostOrder)) {
             }
 
+            /**
+             * @brief Parses a dotted-quad IPv4 string (e.g. from config or tools, not the packet path).
+             * An unparsable string yields address 0.0.0.0, which IsValid() rejects.
+             */
+            NetworkEndpoint(const std::string& ip, uint16_t p);
+
+            uint32_t GetAddressV4() const { return m_addressV4; } // Network byte order, ready for sin_addr.s_addr
+            uint16_t GetPort() const { return m_port; }           // Host byte order
+            uint64_t GetHash() const { return m_hash; }
+
+            // False for a default-constructed (or unparsable) endpoint; such endpoints are never sent to.
+            bool IsValid() const { return m_addressV4 != 0 && m_port != 0; }
+
+            // Dotted-quad IP only. For logging.
+            std::string GetIpString() const;
+
+            // "ip:port". For logging.
+            std::string ToString() const;
+
             bool operator<(const NetworkEndpoint& other) const {
-                if (ipAddress < other.ipAddress) {
-                    return true;
-                }
-                if (ipAddress > other.ipAddress) {
-                    return false;
+                if (m_addressV4 != other.m_addressV4) {
+                    return m_addressV4 < other.m_addressV4;
                 }
-                // IP addresses are equal, compare ports
-                return port < other.port;
+                return m_port < other.m_port;
             }
 
-            // Equality for comparisons, map keys etc.
             bool operator==(const NetworkEndpoint& other) const {
-                return ipAddress == other.ipAddress && port == other.port;
+                return m_addressV4 == other.m_addressV4 && m_port == other.m_port;
             }
-            // Add operator< if used as a key in std::map without a custom comparator
+
+            bool operator!=(const NetworkEndpoint& other) const {
+                return !(*this == other);
+            }
+
+        private:
+            // splitmix64 finalizer over (address, port): cheap and well mixed in every bit,
+            // so both power-of-two tables and std::unordered_map can use it directly.
+            static uint64_t ComputeHash(uint32_t addressV4, uint16_t port) {
+                uint64_t x = (static_cast<uint64_t>(addressV4) << 16) | port;
+                x += 0x9E3779B97F4A7C15ULL;
+                x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+                return x ^ (x >> 31);
+            }
+
+            uint32_t m_addressV4;
+            uint16_t m_port;
+            uint64_t m_hash;
         };
 
     } // namespace Networking
-} // namespace RiftForged
\ No newline at end of file
+} // namespace RiftForged
+
+namespace std {
+    template <>
+    struct hash<RiftForged::Networking::NetworkEndpoint> {
+        size_t operator()(const RiftForged::Networking::NetworkEndpoint& endpoint) const noexcept {
+            return static_cast<size_t>(endpoint.GetHash());
+        }
+    };
+}
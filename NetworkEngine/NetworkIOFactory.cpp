@@ -0,0 +1,81 @@
+﻿// File: NetworkIOFactory.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Creates the INetworkIO backend selected at startup.
+
+#include "NetworkIOFactory.h"
+#include "../Utils/Logger.h"
+
+#include <algorithm>        // For std::transform
+#include <cctype>           // For std::tolower
+
+#ifdef _WIN32
+#include "UDPSocketAsync.h"
+#endif
+#if defined(__linux__)
+#include "UDPSocketEpoll.h"
+#include "UDPSocketIoUring.h"
+#endif
+
+namespace RiftForged {
+    namespace Networking {
+
+        NetworkIOBackend GetDefaultNetworkIOBackend() {
+#ifdef _WIN32
+            return NetworkIOBackend::IOCP;
+#else
+            return NetworkIOBackend::Epoll;
+#endif
+        }
+
+        bool ParseNetworkIOBackend(const std::string& name, NetworkIOBackend& outBackend) {
+            std::string lowered = name;
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            if (lowered == "iocp") { outBackend = NetworkIOBackend::IOCP; return true; }
+            if (lowered == "epoll") { outBackend = NetworkIOBackend::Epoll; return true; }
+            if (lowered == "iouring" || lowered == "io_uring") { outBackend = NetworkIOBackend::IoUring; return true; }
+            return false;
+        }
+
+        const char* NetworkIOBackendToString(NetworkIOBackend backend) {
+            switch (backend) {
+            case NetworkIOBackend::IOCP:    return "iocp";
+            case NetworkIOBackend::Epoll:   return "epoll";
+            case NetworkIOBackend::IoUring: return "io_uring";
+            }
+            return "unknown";
+        }
+
+        std::unique_ptr<INetworkIO> CreateNetworkIO(NetworkIOBackend backend, size_t receiveShards) {
+            if (receiveShards > 1 && backend != NetworkIOBackend::Epoll) {
+                RF_NETWORK_WARN("NetworkIOFactory: Receive sharding is only supported by the epoll backend; '{}' uses a single socket.",
+                    NetworkIOBackendToString(backend));
+            }
+            switch (backend) {
+            case NetworkIOBackend::IOCP:
+#ifdef _WIN32
+                return std::make_unique<UDPSocketAsync>();
+#else
+                break;
+#endif
+            case NetworkIOBackend::Epoll:
+#if defined(__linux__)
+                return std::make_unique<UDPSocketEpoll>(receiveShards);
+#else
+                break;
+#endif
+            case NetworkIOBackend::IoUring:
+#if defined(RF_HAS_IO_URING)
+                return std::make_unique<UDPSocketIoUring>();
+#else
+                break;
+#endif
+            }
+            RF_NETWORK_ERROR("NetworkIOFactory: Backend '{}' is not available in this build.", NetworkIOBackendToString(backend));
+            return nullptr;
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,45 @@
+﻿// File: NetworkIOFactory.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Startup selection of the INetworkIO backend (IOCP, epoll or io_uring).
+
+#pragma once
+
+#include <memory>           // For std::unique_ptr
+#include <string>           // For std::string
+
+#include "INetworkIO.h"
+
+namespace RiftForged {
+    namespace Networking {
+
+        enum class NetworkIOBackend {
+            IOCP,       // UDPSocketAsync (Windows)
+            Epoll,      // UDPSocketEpoll (Linux)
+            IoUring     // UDPSocketIoUring (Linux, requires liburing)
+        };
+
+        /**
+         * @brief Returns the preferred backend for the platform this binary was built for.
+         * Windows uses IOCP; Linux uses epoll (io_uring is opt-in until it has seen more load testing).
+         */
+        NetworkIOBackend GetDefaultNetworkIOBackend();
+
+        /**
+         * @brief Parses a backend name ("iocp", "epoll", "iouring"/"io_uring"), case-insensitive.
+         * @return True if the name was recognised; outBackend is left unchanged otherwise.
+         */
+        bool ParseNetworkIOBackend(const std::string& name, NetworkIOBackend& outBackend);
+
+        const char* NetworkIOBackendToString(NetworkIOBackend backend);
+
+        /**
+         * @brief Creates the requested INetworkIO implementation.
+         * @param receiveShards Number of SO_REUSEPORT sockets/receive threads (epoll only; others ignore it).
+         * @return The backend instance, or nullptr if it was not compiled into this build.
+         * Init() and Start() are left to the caller, exactly as with direct construction.
+         */
+        std::unique_ptr<INetworkIO> CreateNetworkIO(NetworkIOBackend backend, size_t receiveShards = 1);
+
+    } // namespace Networking
+} // namespace RiftForged
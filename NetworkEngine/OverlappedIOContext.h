@@ -6,8 +6,11 @@
 #define NOMINMAX
 #endif
 #include <Winsock2.h> // For OVERLAPPED, WSABUF, sockaddr_in
-#include <vector>     // For std::vector
+#include <cstdint>    // For uint32_t
 #include <cstring>    // For ZeroMemory
+#include <memory>     // For std::unique_ptr
+
+#include "PacketBufferPool.h" // For PacketBuffer
 
 // It's good practice to define constants used by these types here,
 // or make them configurable if they are not globally fixed.
@@ -22,29 +25,64 @@ namespace RiftForged {
             Send
         };
 
+        // Sentinel poolIndex for contexts allocated outside of an OverlappedIOContextPool.
+        const uint32_t OVERLAPPED_CONTEXT_NOT_POOLED = 0xFFFFFFFFu;
+
         struct OverlappedIOContext {
             OVERLAPPED      overlapped;
             IOOperationType operationType;
             WSABUF          wsaBuf;
-            std::vector<char> buffer; // char is fine for raw buffer
+            char*           buffer;          // Non-owning view into a pool slab, or into ownedBuffer
+            size_t          bufferCapacity;
             sockaddr_in     remoteAddrNative;
             int             remoteAddrNativeLen;
+            uint32_t        poolIndex;       // Slot in the owning pool, or OVERLAPPED_CONTEXT_NOT_POOLED
+            std::unique_ptr<char[]> ownedBuffer; // Only set for unpooled (heap fallback) contexts
+            PacketBuffer    packet;          // Send only: referenced instead of copied into 'buffer' until completion
 
+            // Pooled context: the buffer is carved out of the pool's contiguous slab.
+            OverlappedIOContext(IOOperationType opType, char* slabBuffer, size_t bufferSize, uint32_t index)
+                : operationType(opType), buffer(slabBuffer), bufferCapacity(bufferSize),
+                remoteAddrNativeLen(sizeof(sockaddr_in)), poolIndex(index) {
+                ZeroMemory(&overlapped, sizeof(OVERLAPPED));
+                ZeroMemory(&remoteAddrNative, sizeof(sockaddr_in));
+                wsaBuf.buf = buffer;
+                wsaBuf.len = static_cast<ULONG>(bufferCapacity);
+            }
+
+            // Unpooled context that owns its buffer (fallback when a pool is exhausted or the datagram is oversized).
             OverlappedIOContext(IOOperationType opType, size_t bufferSize = DEFAULT_IOCP_UDP_BUFFER_SIZE)
-                : operationType(opType), buffer(bufferSize), remoteAddrNativeLen(sizeof(sockaddr_in)) {
+                : operationType(opType), buffer(nullptr), bufferCapacity(bufferSize),
+                remoteAddrNativeLen(sizeof(sockaddr_in)), poolIndex(OVERLAPPED_CONTEXT_NOT_POOLED),
+                ownedBuffer(new char[bufferSize > 0 ? bufferSize : 1]) {
+                buffer = ownedBuffer.get();
                 ZeroMemory(&overlapped, sizeof(OVERLAPPED));
                 ZeroMemory(&remoteAddrNative, sizeof(sockaddr_in));
-                wsaBuf.buf = buffer.data();
-                wsaBuf.len = static_cast<ULONG>(buffer.size());
+                wsaBuf.buf = buffer;
+                wsaBuf.len = static_cast<ULONG>(bufferCapacity);
             }
 
+            OverlappedIOContext(const OverlappedIOContext&) = delete;
+            OverlappedIOContext& operator=(const OverlappedIOContext&) = delete;
+
+            bool IsPooled() const { return poolIndex != OVERLAPPED_CONTEXT_NOT_POOLED; }
+
             void ResetForReceive() {
                 ZeroMemory(&overlapped, sizeof(OVERLAPPED));
                 ZeroMemory(&remoteAddrNative, sizeof(sockaddr_in));
                 operationType = IOOperationType::Recv;
                 remoteAddrNativeLen = sizeof(sockaddr_in);
-                wsaBuf.buf = buffer.data();
-                wsaBuf.len = static_cast<ULONG>(buffer.size());
+                wsaBuf.buf = buffer;
+                wsaBuf.len = static_cast<ULONG>(bufferCapacity);
+            }
+
+            void ResetForSend() {
+                ZeroMemory(&overlapped, sizeof(OVERLAPPED));
+                ZeroMemory(&remoteAddrNative, sizeof(sockaddr_in));
+                operationType = IOOperationType::Send;
+                remoteAddrNativeLen = sizeof(sockaddr_in);
+                wsaBuf.buf = buffer;
+                wsaBuf.len = 0;
             }
         };
 
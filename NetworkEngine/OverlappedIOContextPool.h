@@ -0,0 +1,112 @@
+﻿// File: OverlappedIOContextPool.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Fixed-size, lock-free pool of OverlappedIOContext objects for the IOCP backend.
+// All context buffers are carved out of one contiguous slab allocated up front.
+
+#pragma once
+
+#include <atomic>           // For std::atomic
+#include <cstdint>          // For uint32_t, uint64_t
+#include <memory>           // For std::unique_ptr
+#include <vector>           // For std::vector
+
+#include "OverlappedIOContext.h"
+
+namespace RiftForged {
+    namespace Networking {
+
+        // A Treiber stack of context indices. The head packs {ABA tag : 32, index : 32} into one
+        // 64-bit word so Acquire/Release are a single CAS each and never take a lock or touch the heap.
+        // Contexts never move after Init(), which OVERLAPPED requires while an operation is pending.
+        class OverlappedIOContextPool {
+        public:
+            OverlappedIOContextPool() : m_head(PackHead(0, EMPTY_INDEX)), m_capacity(0) {}
+
+            OverlappedIOContextPool(const OverlappedIOContextPool&) = delete;
+            OverlappedIOContextPool& operator=(const OverlappedIOContextPool&) = delete;
+
+            /**
+             * @brief Allocates the slab and all contexts. Not thread-safe; call before any I/O is posted.
+             * @throws std::bad_alloc if the slab or contexts cannot be allocated.
+             */
+            void Init(uint32_t contextCount, size_t bufferSizePerContext, IOOperationType opType) {
+                Clear();
+                m_slab.reset(new char[static_cast<size_t>(contextCount) * bufferSizePerContext]);
+                m_contexts.reserve(contextCount);
+                m_next = std::make_unique<std::atomic<uint32_t>[]>(contextCount);
+                for (uint32_t i = 0; i < contextCount; ++i) {
+                    m_contexts.emplace_back(std::make_unique<OverlappedIOContext>(
+                        opType, m_slab.get() + static_cast<size_t>(i) * bufferSizePerContext, bufferSizePerContext, i));
+                    m_next[i].store(i + 1 < contextCount ? i + 1 : EMPTY_INDEX, std::memory_order_relaxed);
+                }
+                m_capacity = contextCount;
+                m_head.store(PackHead(0, contextCount > 0 ? 0 : EMPTY_INDEX), std::memory_order_release);
+            }
+
+            /**
+             * @brief Releases every context and the slab. Not thread-safe; no operations may be pending.
+             */
+            void Clear() {
+                m_head.store(PackHead(0, EMPTY_INDEX), std::memory_order_release);
+                m_contexts.clear();
+                m_next.reset();
+                m_slab.reset();
+                m_capacity = 0;
+            }
+
+            /**
+             * @brief Pops a free context.
+             * @return A context, or nullptr if the pool is exhausted.
+             */
+            OverlappedIOContext* Acquire() {
+                uint64_t head = m_head.load(std::memory_order_acquire);
+                for (;;) {
+                    const uint32_t index = HeadIndex(head);
+                    if (index == EMPTY_INDEX) {
+                        return nullptr;
+                    }
+                    const uint32_t next = m_next[index].load(std::memory_order_relaxed);
+                    if (m_head.compare_exchange_weak(head, PackHead(HeadTag(head) + 1, next),
+                        std::memory_order_acq_rel, std::memory_order_acquire)) {
+                        return m_contexts[index].get();
+                    }
+                }
+            }
+
+            /**
+             * @brief Pushes a context back. Only contexts obtained from this pool may be released here.
+             */
+            void Release(OverlappedIOContext* pContext) {
+                if (!pContext || pContext->poolIndex >= m_capacity) {
+                    return;
+                }
+                const uint32_t index = pContext->poolIndex;
+                uint64_t head = m_head.load(std::memory_order_relaxed);
+                for (;;) {
+                    m_next[index].store(HeadIndex(head), std::memory_order_relaxed);
+                    if (m_head.compare_exchange_weak(head, PackHead(HeadTag(head) + 1, index),
+                        std::memory_order_release, std::memory_order_relaxed)) {
+                        return;
+                    }
+                }
+            }
+
+            uint32_t Capacity() const { return m_capacity; }
+
+        private:
+            static constexpr uint32_t EMPTY_INDEX = 0xFFFFFFFFu;
+
+            static uint64_t PackHead(uint32_t tag, uint32_t index) { return (static_cast<uint64_t>(tag) << 32) | index; }
+            static uint32_t HeadIndex(uint64_t head) { return static_cast<uint32_t>(head); }
+            static uint32_t HeadTag(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+            std::atomic<uint64_t> m_head;
+            std::unique_ptr<std::atomic<uint32_t>[]> m_next;          // Free-list links, indexed like m_contexts
+            std::vector<std::unique_ptr<OverlappedIOContext>> m_contexts;
+            std::unique_ptr<char[]> m_slab;                          // contextCount * bufferSizePerContext bytes
+            uint32_t m_capacity;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,75 @@
+﻿// File: OverloadDetector.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements the overload detector.
+
+#include "OverloadDetector.h"
+
+namespace RiftForged {
+    namespace Networking {
+
+        OverloadDetector::OverloadDetector()
+            : m_overloaded(false),
+            m_consecutiveOverruns(0),
+            m_overloadedSince(std::chrono::steady_clock::time_point::min()),
+            m_lastTick(std::chrono::steady_clock::time_point::min()) {
+            for (std::atomic<uint64_t>& shed : m_messagesShed) {
+                shed.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        bool OverloadDetector::RecordTick(std::chrono::steady_clock::duration processingTime, std::chrono::steady_clock::duration tickInterval,
+            float receiveQueueFill, std::chrono::steady_clock::time_point now) {
+            const float tickLoad = tickInterval.count() > 0 ?
+                std::chrono::duration<float>(processingTime) / std::chrono::duration<float>(tickInterval) : 0.0f;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const bool wasOverloaded = m_overloaded.load(std::memory_order_relaxed);
+            m_stats.tickLoad = m_stats.ticks == 0 ? tickLoad : m_stats.tickLoad + OVERLOAD_TICK_LOAD_GAIN * (tickLoad - m_stats.tickLoad);
+            m_stats.receiveQueueFill = receiveQueueFill;
+            m_stats.ticks++;
+            if (processingTime > tickInterval) {
+                m_stats.ticksOverrun++;
+                m_consecutiveOverruns++;
+            }
+            else {
+                m_consecutiveOverruns = 0;
+            }
+            if (wasOverloaded && m_lastTick != std::chrono::steady_clock::time_point::min() && now > m_lastTick) {
+                m_stats.overloadedMillis += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastTick).count());
+            }
+            m_lastTick = now;
+
+            bool overloaded = wasOverloaded;
+            if (!wasOverloaded) {
+                overloaded = m_stats.tickLoad >= OVERLOAD_ENTER_TICK_LOAD ||
+                    m_consecutiveOverruns >= OVERLOAD_ENTER_CONSECUTIVE_OVERRUNS ||
+                    receiveQueueFill >= OVERLOAD_ENTER_QUEUE_FILL;
+                if (overloaded) {
+                    m_overloadedSince = now;
+                    m_stats.overloadEpisodes++;
+                }
+            }
+            else if (now - m_overloadedSince >= std::chrono::milliseconds(OVERLOAD_MIN_DURATION_MS) &&
+                m_stats.tickLoad < OVERLOAD_EXIT_TICK_LOAD && m_consecutiveOverruns == 0 && receiveQueueFill < OVERLOAD_EXIT_QUEUE_FILL) {
+                overloaded = false;
+            }
+            m_overloaded.store(overloaded, std::memory_order_relaxed);
+            return overloaded != wasOverloaded;
+        }
+
+        OverloadStats OverloadDetector::GetStats() const {
+            OverloadStats stats;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                stats = m_stats;
+            }
+            stats.overloaded = m_overloaded.load(std::memory_order_relaxed);
+            for (size_t kind = 0; kind < INGRESS_MESSAGE_KINDS; ++kind) {
+                stats.messagesShed[kind] = m_messagesShed[kind].load(std::memory_order_relaxed);
+            }
+            return stats;
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,77 @@
+﻿// File: OverloadDetector.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Decides when the server is overloaded, from how long simulation ticks take against their
+// interval and how full the OS receive queue is. While it is, the packet handler sheds low-value inbound
+// messages so the server degrades predictably instead of falling further behind on every tick.
+
+#pragma once
+
+#include <array>            // For std::array
+#include <atomic>           // For std::atomic
+#include <chrono>           // For std::chrono::steady_clock
+#include <cstddef>          // For size_t
+#include <cstdint>          // For uint64_t
+#include <mutex>            // For std::mutex
+
+#include "ReliableConnectionState.h" // For INGRESS_MESSAGE_KINDS
+
+namespace RiftForged {
+    namespace Networking {
+
+        // Overload is entered when any enter condition holds, and left once every exit condition holds and
+        // it has lasted at least OVERLOAD_MIN_DURATION_MS, so shedding doesn't flap from tick to tick.
+        const float OVERLOAD_TICK_LOAD_GAIN = 0.1f;        // Weight of the newest tick in the smoothed tick load
+        const float OVERLOAD_ENTER_TICK_LOAD = 0.9f;       // Smoothed tick processing time over the tick interval
+        const float OVERLOAD_EXIT_TICK_LOAD = 0.6f;
+        const int OVERLOAD_ENTER_CONSECUTIVE_OVERRUNS = 3; // Ticks in a row that took longer than the interval
+        const float OVERLOAD_ENTER_QUEUE_FILL = 0.5f;      // See INetworkIO::GetReceiveQueueFill
+        const float OVERLOAD_EXIT_QUEUE_FILL = 0.2f;
+        const int OVERLOAD_MIN_DURATION_MS = 1000;
+
+        struct OverloadStats {
+            bool overloaded = false;
+            float tickLoad = 0.0f;              // Smoothed tick processing time as a fraction of the interval
+            float receiveQueueFill = 0.0f;      // At the last tick
+            uint64_t ticks = 0;
+            uint64_t ticksOverrun = 0;
+            uint64_t overloadEpisodes = 0;
+            uint64_t overloadedMillis = 0;      // Time spent overloaded, up to the last tick
+            std::array<uint64_t, INGRESS_MESSAGE_KINDS> messagesShed{}; // Per message kind (C2S payload type)
+        };
+
+        // RecordTick is called by the simulation thread once per tick; IsOverloaded and RecordShed by the
+        // receive threads, on every message, so they only touch atomics.
+        class OverloadDetector {
+        public:
+            OverloadDetector();
+
+            OverloadDetector(const OverloadDetector&) = delete;
+            OverloadDetector& operator=(const OverloadDetector&) = delete;
+
+            // Returns true if the tick entered or left overload.
+            bool RecordTick(std::chrono::steady_clock::duration processingTime, std::chrono::steady_clock::duration tickInterval,
+                float receiveQueueFill, std::chrono::steady_clock::time_point now);
+
+            bool IsOverloaded() const { return m_overloaded.load(std::memory_order_relaxed); }
+
+            // Counts one message of 'kind' dropped because of overload.
+            void RecordShed(size_t kind) {
+                m_messagesShed[kind < INGRESS_MESSAGE_KINDS ? kind : INGRESS_MESSAGE_KINDS - 1].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            OverloadStats GetStats() const;
+
+        private:
+            std::atomic<bool> m_overloaded;
+            std::array<std::atomic<uint64_t>, INGRESS_MESSAGE_KINDS> m_messagesShed;
+
+            mutable std::mutex m_mutex;         // Guards everything below
+            OverloadStats m_stats;              // Except overloaded and messagesShed, filled in by GetStats
+            int m_consecutiveOverruns;
+            std::chrono::steady_clock::time_point m_overloadedSince;
+            std::chrono::steady_clock::time_point m_lastTick;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
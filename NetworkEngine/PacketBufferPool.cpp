@@ -0,0 +1,149 @@
+﻿// File: PacketBufferPool.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements the packet buffer pool and the refcounted PacketBuffer handle.
+
+#include "PacketBufferPool.h"
+#include "../Utils/Logger.h"     // For RF_NETWORK_... macros
+
+#include <cstring>               // For memcpy
+#include <new>                   // For std::nothrow, placement new
+
+namespace RiftForged {
+    namespace Networking {
+
+        namespace {
+            const size_t PACKET_BUFFER_POOLED_BLOCK_BYTES = PACKET_BUFFER_CONTROL_SIZE + PACKET_BUFFER_BLOCK_SIZE;
+        }
+
+        PacketBufferPool& PacketBufferPool::Instance() {
+            static PacketBufferPool s_instance;
+            return s_instance;
+        }
+
+        uint8_t* PacketBufferPool::AcquireBlock() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_freeBlocks.empty()) {
+                std::unique_ptr<uint8_t[]> slab(new (std::nothrow) uint8_t[PACKET_BUFFER_POOLED_BLOCK_BYTES * PACKET_BUFFER_SLAB_BLOCKS]);
+                if (!slab) {
+                    RF_NETWORK_ERROR("PacketBufferPool: Failed to allocate a slab of {} blocks.", PACKET_BUFFER_SLAB_BLOCKS);
+                    return nullptr;
+                }
+                m_freeBlocks.reserve(m_freeBlocks.size() + PACKET_BUFFER_SLAB_BLOCKS);
+                for (size_t i = PACKET_BUFFER_SLAB_BLOCKS; i > 0; --i) {
+                    m_freeBlocks.push_back(slab.get() + (i - 1) * PACKET_BUFFER_POOLED_BLOCK_BYTES);
+                }
+                m_slabs.push_back(std::move(slab));
+                RF_NETWORK_DEBUG("PacketBufferPool: Grew to {} blocks.", m_slabs.size() * PACKET_BUFFER_SLAB_BLOCKS);
+            }
+            uint8_t* block = m_freeBlocks.back();
+            m_freeBlocks.pop_back();
+            return block;
+        }
+
+        void PacketBufferPool::ReleaseBlock(uint8_t* block) {
+            if (!block) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeBlocks.push_back(block);
+        }
+
+        size_t PacketBufferPool::BlocksAllocated() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_slabs.size() * PACKET_BUFFER_SLAB_BLOCKS;
+        }
+
+        size_t PacketBufferPool::BlocksFree() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_freeBlocks.size();
+        }
+
+        PacketBuffer::PacketBuffer(const PacketBuffer& other) : m_control(other.m_control) {
+            if (m_control) {
+                m_control->refCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        PacketBuffer& PacketBuffer::operator=(const PacketBuffer& other) {
+            if (m_control != other.m_control) {
+                if (other.m_control) {
+                    other.m_control->refCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                Reset();
+                m_control = other.m_control;
+            }
+            return *this;
+        }
+
+        PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                m_control = other.m_control;
+                other.m_control = nullptr;
+            }
+            return *this;
+        }
+
+        PacketBuffer PacketBuffer::Allocate(size_t capacity) {
+            PacketBuffer buffer;
+            uint8_t* block = nullptr;
+            bool pooled = false;
+            if (capacity <= PACKET_BUFFER_BLOCK_SIZE) {
+                block = PacketBufferPool::Instance().AcquireBlock();
+                pooled = block != nullptr;
+                capacity = PACKET_BUFFER_BLOCK_SIZE;
+            }
+            else {
+                block = new (std::nothrow) uint8_t[PACKET_BUFFER_CONTROL_SIZE + capacity];
+            }
+            if (!block) {
+                return buffer;
+            }
+            PacketBufferControl* control = new (block) PacketBufferControl;
+            control->refCount.store(1, std::memory_order_relaxed);
+            control->size = 0;
+            control->capacity = static_cast<uint32_t>(capacity);
+            control->pooled = pooled;
+            buffer.m_control = control;
+            return buffer;
+        }
+
+        PacketBuffer PacketBuffer::CopyFrom(const uint8_t* data, size_t size) {
+            if (!data || size == 0) {
+                return PacketBuffer();
+            }
+            PacketBuffer buffer = Allocate(size);
+            if (buffer.m_control) {
+                memcpy(buffer.MutableData(), data, size);
+                buffer.SetSize(size);
+            }
+            return buffer;
+        }
+
+        void PacketBuffer::SetSize(size_t size) {
+            if (m_control) {
+                m_control->size = static_cast<uint32_t>(size < m_control->capacity ? size : m_control->capacity);
+            }
+        }
+
+        void PacketBuffer::Reset() {
+            PacketBufferControl* control = m_control;
+            m_control = nullptr;
+            if (!control || control->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            // Last reference: return the block.
+            const bool pooled = control->pooled;
+            control->~PacketBufferControl();
+            uint8_t* block = reinterpret_cast<uint8_t*>(control);
+            if (pooled) {
+                PacketBufferPool::Instance().ReleaseBlock(block);
+            }
+            else {
+                delete[] block;
+            }
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,120 @@
+﻿// File: PacketBufferPool.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Process-wide pool of fixed-size packet buffers and the refcounted PacketBuffer handle
+// that shares one. A datagram is written into a PacketBuffer once; the send path, the retransmit
+// window and the transport then hold references to the same bytes instead of copying them.
+
+#pragma once
+
+#include <atomic>           // For std::atomic
+#include <cstddef>          // For size_t
+#include <cstdint>          // For uint8_t, uint32_t
+#include <memory>           // For std::unique_ptr
+#include <mutex>            // For std::mutex
+#include <vector>           // For std::vector
+
+// Every pooled block holds one full datagram (matches the transport receive buffers).
+// Larger packets fall back to a plain heap allocation.
+const size_t PACKET_BUFFER_BLOCK_SIZE = 4096;
+const size_t PACKET_BUFFER_SLAB_BLOCKS = 256; // Blocks carved from each slab when the pool grows
+
+namespace RiftForged {
+    namespace Networking {
+
+        // Bookkeeping stored in front of every buffer's bytes.
+        struct PacketBufferControl {
+            std::atomic<uint32_t> refCount;
+            uint32_t size;
+            uint32_t capacity;
+            bool pooled;
+        };
+
+        // Bytes reserved for PacketBufferControl, rounded so the packet data stays 16-byte aligned.
+        constexpr size_t PACKET_BUFFER_CONTROL_SIZE = (sizeof(PacketBufferControl) + 15) & ~static_cast<size_t>(15);
+
+        // PacketBufferPool hands out blocks of PACKET_BUFFER_CONTROL_SIZE + PACKET_BUFFER_BLOCK_SIZE bytes
+        // from slabs that are allocated on demand and never freed, so steady-state sends do no heap
+        // allocation. Acquire/Release take a short mutex.
+        class PacketBufferPool {
+        public:
+            static PacketBufferPool& Instance();
+
+            PacketBufferPool(const PacketBufferPool&) = delete;
+            PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+            /**
+             * @brief Pops a free block, growing the pool by one slab if none is free.
+             * @return A block, or nullptr if the slab allocation failed.
+             */
+            uint8_t* AcquireBlock();
+
+            /**
+             * @brief Returns a block obtained from AcquireBlock().
+             */
+            void ReleaseBlock(uint8_t* block);
+
+            size_t BlocksAllocated() const;
+            size_t BlocksFree() const;
+
+        private:
+            PacketBufferPool() = default;
+
+            mutable std::mutex m_mutex;
+            std::vector<std::unique_ptr<uint8_t[]>> m_slabs; // PACKET_BUFFER_SLAB_BLOCKS blocks each
+            std::vector<uint8_t*> m_freeBlocks;
+        };
+
+        // Shared handle to one packet's bytes. Copying a PacketBuffer adds a reference; the block goes
+        // back to the pool when the last reference is dropped. Small packets live in a pooled block,
+        // oversized ones on the heap.
+        //
+        // The bytes are written by the creator through MutableData()/SetSize() before the buffer is
+        // shared; after that every holder treats them as read-only, so no locking is needed.
+        class PacketBuffer {
+        public:
+            PacketBuffer() : m_control(nullptr) {}
+            ~PacketBuffer() { Reset(); }
+
+            PacketBuffer(const PacketBuffer& other);
+            PacketBuffer& operator=(const PacketBuffer& other);
+            PacketBuffer(PacketBuffer&& other) noexcept : m_control(other.m_control) { other.m_control = nullptr; }
+            PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+
+            /**
+             * @brief Allocates an empty buffer (Size() == 0) able to hold 'capacity' bytes.
+             * @return The buffer, or a null buffer if allocation failed.
+             */
+            static PacketBuffer Allocate(size_t capacity);
+
+            /**
+             * @brief Allocates a buffer and copies 'size' bytes into it.
+             * @return The buffer, or a null buffer if allocation failed.
+             */
+            static PacketBuffer CopyFrom(const uint8_t* data, size_t size);
+
+            const uint8_t* Data() const { return m_control ? BytesOf(m_control) : nullptr; }
+            uint8_t* MutableData() { return m_control ? BytesOf(m_control) : nullptr; }
+            size_t Size() const { return m_control ? m_control->size : 0; }
+            size_t Capacity() const { return m_control ? m_control->capacity : 0; }
+            bool Empty() const { return Size() == 0; }
+            uint32_t UseCount() const { return m_control ? m_control->refCount.load(std::memory_order_relaxed) : 0; }
+
+            // Sets the number of valid bytes (clamped to Capacity()). Only for the writer, before sharing.
+            void SetSize(size_t size);
+
+            std::vector<uint8_t> ToVector() const { return std::vector<uint8_t>(Data(), Data() + Size()); }
+
+            // Drops this handle's reference.
+            void Reset();
+
+        private:
+            static uint8_t* BytesOf(PacketBufferControl* control) {
+                return reinterpret_cast<uint8_t*>(control) + PACKET_BUFFER_CONTROL_SIZE;
+            }
+
+            PacketBufferControl* m_control;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
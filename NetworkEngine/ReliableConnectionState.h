@@ -5,9 +5,11 @@
 #pragma once
 
 #include <cstdint>   // For uint32_t, uint16_t, uint8_t
+#include <array>     // For std::array
+#include <atomic>    // For std::atomic
+#include <memory>    // For std::unique_ptr
 #include <vector>    // For std::vector
 #include <chrono>    // For std::chrono::steady_clock
-#include <list>      // For std::list
 #include <mutex>     // For std::mutex
 #include <algorithm> // For std::min and std::max
 #include <cmath>     // For std::abs
@@ -16,6 +18,9 @@
 // Or if SequenceNumber is a primitive, this might not be strictly needed here but good for context.
 // Assuming SequenceNumber is defined in GamePacketHeader.h or is a basic type.
 #include "GamePacketHeader.h" // For SequenceNumber type
+#include "SentPacketWindow.h" // For SentPacketWindow, SentPacketInfo
+#include "CongestionController.h" // For ICongestionController, TokenBucketPacer, ConnectionTransferStats
+#include "../NetworkHandler/SecureConnectionContext.h" // For SecureConnectionContext (AEAD keys and counters)
 
 namespace RiftForged {
     namespace Networking {
@@ -45,31 +50,85 @@ namespace RiftForged {
         // Global maximum retries for a reliable packet before considering the connection dropped.
         const int MAX_PACKET_RETRIES = 10;
 
+        // Delayed ACK bounds: an ACK-only packet is sent once SRTT/4 has passed since our last send,
+        // clamped to [MIN_ACK_DELAY_MS, max ACK delay]. The max is configurable per caller.
+        const float DEFAULT_MAX_ACK_DELAY_MS = 20.0f;
+        const float MIN_ACK_DELAY_MS = 5.0f;
+
+        // Fragment reassembly limits. A partial message that would exceed either byte cap is rejected,
+        // and one that sees no new fragment for FRAGMENT_REASSEMBLY_TIMEOUT_MS is discarded.
+        const size_t MAX_CONCURRENT_REASSEMBLIES = 4;                        // Per connection
+        const int FRAGMENT_REASSEMBLY_TIMEOUT_MS = 5000;
+        const size_t MAX_REASSEMBLY_BYTES_PER_CONNECTION = 256 * 1024;
+        const size_t MAX_REASSEMBLY_BYTES_TOTAL = 64 * 1024 * 1024;          // Across all connections
+
+        // RELIABLE_ORDERED messages that arrive ahead of a missing one are held back, at most this many
+        // sequence numbers ahead. A power of two, so 'channelSequence % size' survives the 16-bit wrap.
+        const uint16_t ORDERED_CHANNEL_BACKLOG_SIZE = 1024;
+
+        // Ingress rate limiting: each connection has one token bucket per kind of received application message,
+        // counted in messages. The network handler maps C2S payload types onto kinds and sets their rates.
+        const size_t INGRESS_MESSAGE_KINDS = 8;
+
+        // Reliable sequences remembered behind the newest one received, for duplicate detection and ACK
+        // ranges. Spans the whole send window, so any retransmission the remote can still send is recognised.
+        // A multiple of 64.
+        const uint32_t RECEIVED_SEQUENCE_HISTORY_SIZE = SENT_PACKET_WINDOW_SIZE;
+
+        // Fast retransmit: an in-flight packet is taken as lost once the remote acknowledges one sent at
+        // least this many sequences later (smaller gaps are treated as reordering), or NACKs it. It is then
+        // resent once without waiting for its RTO. A receiver NACKs a gap once it is this many sequences old.
+        const uint32_t FAST_RETRANSMIT_REORDER_THRESHOLD = 3;
+
+        // Forward error correction for unreliable datagrams (see FEC_GROUP_SIZE). Off by default; Auto turns it
+        // on once the measured loss rate reaches FEC_ENABLE_LOSS_RATE and off again below FEC_DISABLE_LOSS_RATE,
+        // so only lossy connections pay for the parity datagrams.
+        enum class UnreliableFecMode : uint8_t {
+            Off = 0,
+            Auto = 1,
+            On = 2
+        };
+        const float FEC_ENABLE_LOSS_RATE = 0.02f;
+        const float FEC_DISABLE_LOSS_RATE = 0.005f;
+        // The loss rate is smoothed over reliable packet outcomes: 1 for each taken as lost, 0 for each ACKed.
+        const float LOSS_RATE_SMOOTHING = 1.0f / 64.0f;
+
+        // Goodput is measured over intervals of at least this long and smoothed across them.
+        const int GOODPUT_SAMPLE_INTERVAL_MS = 250;
+        const float GOODPUT_SMOOTHING = 0.25f;
+
+        // Bytes currently reserved by partial messages across all connections.
+        inline std::atomic<size_t>& ReassemblyBytesInUse() {
+            static std::atomic<size_t> s_bytesInUse{ 0 };
+            return s_bytesInUse;
+        }
+
 
         struct ReliableConnectionState {
             mutable std::mutex internalStateMutex;
 
             SequenceNumber nextOutgoingSequenceNumber = 1;
 
-            struct SentPacketInfo {
-                SequenceNumber sequenceNumber;
-                std::chrono::steady_clock::time_point timeSent;
-                std::vector<uint8_t> packetData;
-                int retries = 0;
-                bool isAckOnly = false;
-
-                SentPacketInfo(SequenceNumber seq, const std::vector<uint8_t>& data, bool ackOnlyFlag)
-                    : sequenceNumber(seq),
-                    timeSent(std::chrono::steady_clock::now()),
-                    packetData(data),
-                    retries(0),
-                    isAckOnly(ackOnlyFlag) {
-                }
-            };
-            std::list<SentPacketInfo> unacknowledgedSentPackets;
+            using SentPacketInfo = Networking::SentPacketInfo;
+            SentPacketWindow unacknowledgedSentPackets; // In-flight reliable packets, indexed by sequence number
 
             SequenceNumber highestReceivedSequenceNumberFromRemote = 0;
-            uint32_t receivedSequenceBitfield = 0;
+            uint32_t receivedSequenceBitfield = 0;   // Newest 32 bits of receivedSequenceHistory, as sent in headers
+            // Bit i is set once highestReceivedSequenceNumberFromRemote - (i + 1) has been received.
+            std::array<uint64_t, RECEIVED_SEQUENCE_HISTORY_SIZE / 64> receivedSequenceHistory{};
+            // Set when we hold sequences beyond the header bitfield's reach that the remote may still count
+            // as in flight; the next ACK-only packet then carries them as AckRanges.
+            bool ackRangesPending = false;
+            SequenceNumber lastAckNumberSent = 0;    // ackNumber of the last packet we sent
+
+            // Receiver: when enabled, a gap FAST_RETRANSMIT_REORDER_THRESHOLD sequences old is reported at
+            // once in an ACK-only packet (nackPending) rather than left to the sender's own detection.
+            bool explicitNacksEnabled = true;
+            bool nackPending = false;
+            // Sender: newest of our sequences the remote has acknowledged (0: none yet), and whether an ACK
+            // or NACK since the last CollectFastRetransmissions call may have revealed a loss.
+            SequenceNumber newestAcknowledgedSequence = 0;
+            bool fastRetransmitCheckPending = false;
 
             bool hasPendingAckToSend = false;
             std::chrono::steady_clock::time_point lastPacketSentTimeToRemote;
@@ -83,24 +142,125 @@ namespace RiftForged {
             bool connectionDroppedByMaxRetries;
             bool isConnected;
 
+            // Congestion control: the controller sets the window and pacing rate, the pacer enforces the
+            // rate on the send path. The controller is kept across Reset() (only its state starts over).
+            std::unique_ptr<ICongestionController> congestionController;
+            TokenBucketPacer pacer;
+            ConnectionTransferStats transferStats;
+            std::chrono::steady_clock::time_point goodputSampleStart;
+            uint64_t goodputSampleBytes = 0;
+            float measuredLossRate = 0.0f;
+
+            // FEC. Sender: the open group and the XOR of its units so far (Size() is the longest unit).
+            // Receiver: the newest group seen, which of its datagrams arrived, and the XOR of those plus
+            // its parity. The buffers are allocated on first use.
+            UnreliableFecMode fecMode = UnreliableFecMode::Off;
+            bool fecActive = false;
+            uint32_t fecSendGroup = 1;
+            uint8_t fecSendCount = 0;
+            PacketBuffer fecSendParity;
+            uint32_t fecReceiveGroup = 0;
+            uint32_t fecReceiveMask = 0;
+            uint8_t fecReceiveCount = 0;
+            uint8_t fecReceiveCovered = 0;      // From the group's parity datagram; 0 until it arrives
+            bool fecReceiveRecovered = false;
+            PacketBuffer fecReceiveParity;
+
+            // Compact (v5) headers, see GamePacketHeader.h. Compact datagrams are only accepted once negotiated:
+            // the remote asked for them in its cookie echo, or we are a client that starts compact. compactHeaders
+            // is set once the remote has sent a compact datagram, or by a client that starts compact. The ACK
+            // fields last put in a compact header, and the last ones read from one, stand in for omitted ones.
+            // A resent packet we already had means our ACK for it may have been lost, so the next datagram
+            // carries the ACK fields again.
+            bool compactHeadersNegotiated = false;
+            bool compactHeaders = false;
+            SequenceNumber compactAckNumberSent = 0;
+            uint32_t compactAckBitfieldSent = 0;
+            bool compactAckRefreshPending = false;
+            SequenceNumber compactAckNumberReceived = 0;
+            uint32_t compactAckBitfieldReceived = 0;
+
+            // Largest datagram sent to this peer without fragmenting, as it goes on the wire.
+            size_t maxDatagramSize = DEFAULT_MAX_DATAGRAM_SIZE;
+            // Bytes the wire form adds to every datagram this layer builds (the AEAD counter and tag once the
+            // connection is encrypted); datagrams are built that much below maxDatagramSize.
+            size_t datagramWireOverhead = 0;
+
+            // Encryption, see GamePacketHeader.h. Off until EnablePacketEncryption installs session keys; from
+            // then on datagrams are sealed in both directions and unsealed ones from the peer are dropped.
+            bool encrypted = false;
+            SecureConnectionContext secureContext;
+
+            // Path MTU search, see GamePacketHeader.h. maxDatagramSize is its lower bound (confirmed) and
+            // pathMtuUpperBound the smallest size not confirmed to pass. pathMtuProbeSize is 0 while no probe
+            // is outstanding.
+            bool pathMtuSearching = false;
+            size_t pathMtuUpperBound = PMTU_PROBE_MAX_DATAGRAM_SIZE + 1;
+            size_t pathMtuProbeSize = 0;
+            uint16_t pathMtuProbeId = 0;
+            uint8_t pathMtuProbeAttempts = 0;
+            std::chrono::steady_clock::time_point pathMtuProbeSentTime;
+            std::chrono::steady_clock::time_point pathMtuNextSearchTime = std::chrono::steady_clock::time_point::min();
+
+            // One message being reassembled. Each fragment is copied once, straight to its final offset
+            // in 'message', so completing the message costs no further copy.
             struct IncomingFragmentBuffer {
                 SequenceNumber fragmentStartSequenceNumber = 0;
                 uint16_t totalFragments = 0;
                 uint16_t receivedFragmentCount = 0;
-                std::vector<std::vector<uint8_t>> fragments;
+                uint32_t receivedFragmentMask = 0;   // Bit i is set once fragment i has been copied in
+                uint32_t messageSize = 0;            // Bytes reserved in ReassemblyBytesInUse() while awaiting
+                PacketBuffer message;
                 std::chrono::steady_clock::time_point lastFragmentArrivalTime;
                 bool awaitingFragments = false;
 
+                ~IncomingFragmentBuffer() { Reset(); }
+
                 void Reset() {
+                    if (awaitingFragments) {
+                        ReassemblyBytesInUse().fetch_sub(messageSize, std::memory_order_relaxed);
+                    }
                     fragmentStartSequenceNumber = 0;
                     totalFragments = 0;
                     receivedFragmentCount = 0;
-                    fragments.clear();
+                    receivedFragmentMask = 0;
+                    messageSize = 0;
+                    message.Reset();
                     lastFragmentArrivalTime = std::chrono::steady_clock::time_point::min();
                     awaitingFragments = false;
                 }
             };
-            IncomingFragmentBuffer incomingFragmentBuffer;
+            std::array<IncomingFragmentBuffer, MAX_CONCURRENT_REASSEMBLIES> incomingFragmentBuffers;
+
+            // Messages queued for this connection's next IS_AGGREGATE datagram (see AppendAggregatedMessage).
+            // Room for the GamePacketHeader is left at the front; it is written when the datagram is sealed.
+            PacketBuffer pendingAggregate;
+            bool pendingAggregateHasReliable = false;
+
+            // Per-channel sequencing, indexed by NetworkChannel.
+            struct ChannelState {
+                uint16_t nextOutgoingSequence = 0;
+                uint16_t nextExpectedSequence = 0;     // RELIABLE_ORDERED: next message to deliver
+                uint16_t newestDeliveredSequence = 0;  // UNRELIABLE_SEQUENCED
+                bool hasDeliveredSequenced = false;
+                size_t backlogCount = 0;
+                // RELIABLE_ORDERED messages that arrived early, in slot 'sequence % ORDERED_CHANNEL_BACKLOG_SIZE'.
+                // Allocated on first use, so channels without losses stay small.
+                std::unique_ptr<PacketBuffer[]> backlog;
+
+                void Reset() {
+                    nextOutgoingSequence = 0;
+                    nextExpectedSequence = 0;
+                    newestDeliveredSequence = 0;
+                    hasDeliveredSequenced = false;
+                    backlogCount = 0;
+                    backlog.reset();
+                }
+            };
+            std::array<ChannelState, NETWORK_CHANNEL_COUNT> channels;
+
+            // Ingress rate limiting, see AdmitIngressMessage. The buckets count messages, not bytes, and start full.
+            std::array<TokenBucketPacer, INGRESS_MESSAGE_KINDS> ingressBuckets;
 
         private:
             // This version does the actual work and ASSUMES internalStateMutex is ALREADY HELD by the caller.
@@ -130,7 +290,9 @@ namespace RiftForged {
                 retransmissionTimeout_ms(DEFAULT_INITIAL_RTT_MS * 2.0f),
                 isFirstRTTSample(true),
                 connectionDroppedByMaxRetries(false),
-                isConnected(true) {
+                isConnected(true),
+                congestionController(CreateCongestionController(CongestionControlAlgorithm::AIMD)),
+                goodputSampleStart(std::chrono::steady_clock::time_point::min()) {
                 if (retransmissionTimeout_ms < MIN_RTO_MS) retransmissionTimeout_ms = MIN_RTO_MS;
                 if (retransmissionTimeout_ms > MAX_RTO_MS) retransmissionTimeout_ms = MAX_RTO_MS;
             }
@@ -141,13 +303,65 @@ namespace RiftForged {
                 unacknowledgedSentPackets.clear();
                 highestReceivedSequenceNumberFromRemote = 0;
                 receivedSequenceBitfield = 0;
+                receivedSequenceHistory.fill(0);
+                ackRangesPending = false;
+                lastAckNumberSent = 0;
+                explicitNacksEnabled = true;
+                nackPending = false;
+                newestAcknowledgedSequence = 0;
+                fastRetransmitCheckPending = false;
+                congestionController->Reset();
+                pacer.Reset();
+                transferStats = ConnectionTransferStats();
+                goodputSampleStart = std::chrono::steady_clock::time_point::min();
+                goodputSampleBytes = 0;
+                measuredLossRate = 0.0f;
+                fecMode = UnreliableFecMode::Off;
+                fecActive = false;
+                fecSendGroup = 1;
+                fecSendCount = 0;
+                fecSendParity.Reset();
+                fecReceiveGroup = 0;
+                fecReceiveMask = 0;
+                fecReceiveCount = 0;
+                fecReceiveCovered = 0;
+                fecReceiveRecovered = false;
+                fecReceiveParity.Reset();
+                compactHeadersNegotiated = false;
+                compactHeaders = false;
+                compactAckNumberSent = 0;
+                compactAckBitfieldSent = 0;
+                compactAckRefreshPending = false;
+                compactAckNumberReceived = 0;
+                compactAckBitfieldReceived = 0;
                 hasPendingAckToSend = false;
                 lastPacketSentTimeToRemote = std::chrono::steady_clock::time_point::min();
                 lastPacketReceivedTimeFromRemote = std::chrono::steady_clock::time_point::min();
                 isFirstRTTSample = true;
                 connectionDroppedByMaxRetries = false;
                 isConnected = true; // Or false, depending on desired reset state
-                incomingFragmentBuffer.Reset();
+                for (IncomingFragmentBuffer& fragmentBuffer : incomingFragmentBuffers) {
+                    fragmentBuffer.Reset();
+                }
+                maxDatagramSize = DEFAULT_MAX_DATAGRAM_SIZE;
+                datagramWireOverhead = 0;
+                encrypted = false;
+                secureContext = SecureConnectionContext();
+                pathMtuSearching = false;
+                pathMtuUpperBound = PMTU_PROBE_MAX_DATAGRAM_SIZE + 1;
+                pathMtuProbeSize = 0;
+                pathMtuProbeId = 0;
+                pathMtuProbeAttempts = 0;
+                pathMtuProbeSentTime = std::chrono::steady_clock::time_point();
+                pathMtuNextSearchTime = std::chrono::steady_clock::time_point::min();
+                pendingAggregate.Reset();
+                pendingAggregateHasReliable = false;
+                for (ChannelState& channel : channels) {
+                    channel.Reset();
+                }
+                for (TokenBucketPacer& bucket : ingressBuckets) {
+                    bucket.Reset();
+                }
                 smoothedRTT_ms = DEFAULT_INITIAL_RTT_MS;
                 rttVariance_ms = DEFAULT_INITIAL_RTT_MS / 2.0f;
                 retransmissionTimeout_ms = DEFAULT_INITIAL_RTT_MS * 2.0f;
@@ -164,15 +378,74 @@ namespace RiftForged {
                 return retries >= MAX_PACKET_RETRIES;
             }
 
+            float GetRetransmissionTimeoutMs() const {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                return retransmissionTimeout_ms;
+            }
+
+            bool HasPendingAck() const {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                return hasPendingAckToSend;
+            }
+
+            // A NACK is waiting; send an ACK-only packet now instead of after the ACK delay.
+            bool HasPendingNack() const {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                return nackPending;
+            }
+
+            void SetCongestionControlAlgorithm(CongestionControlAlgorithm algorithm) {
+                std::unique_ptr<ICongestionController> controller = CreateCongestionController(algorithm);
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                congestionController = std::move(controller);
+            }
+
+            // Counters plus the current window, bytes in flight and pacing rate.
+            ConnectionTransferStats GetTransferStats() const {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                ConnectionTransferStats stats = transferStats;
+                stats.congestionWindowBytes = congestionController->GetCongestionWindowBytes();
+                stats.bytesInFlight = unacknowledgedSentPackets.BytesInFlight();
+                stats.pacingRateBytesPerSec = congestionController->GetPacingRateBytesPerSec(smoothedRTT_ms);
+                stats.congestionControlAlgorithm = congestionController->GetName();
+                stats.lossRate = measuredLossRate;
+                stats.fecActive = fecActive;
+                stats.compactHeaders = compactHeaders;
+                stats.maxDatagramSize = maxDatagramSize;
+                stats.encrypted = encrypted;
+                return stats;
+            }
+
+            // Takes one token (one message, whatever its size) from the ingress bucket for 'kind', refilled at
+            // messagesPerSec up to burstMessages. False, with the message counted as rate-limited, if it is empty.
+            bool AdmitIngressMessage(size_t kind, float messagesPerSec, size_t burstMessages, std::chrono::steady_clock::time_point now) {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                TokenBucketPacer& bucket = ingressBuckets[std::min(kind, INGRESS_MESSAGE_KINDS - 1)];
+                bucket.Refill(messagesPerSec, std::max<size_t>(burstMessages, 1), now);
+                if (!bucket.TryConsume(1)) {
+                    transferStats.messagesRateLimited++;
+                    return false;
+                }
+                return true;
+            }
+
+            void SetUnreliableFecMode(UnreliableFecMode mode) {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                fecMode = mode;
+            }
+
+            void SetExplicitNacksEnabled(bool enabled) {
+                std::lock_guard<std::mutex> lock(internalStateMutex);
+                explicitNacksEnabled = enabled;
+                if (!enabled) {
+                    nackPending = false;
+                }
+            }
+
 #ifdef _DEBUG
             void ForceAcknowledgePacket(SequenceNumber seq) {
                 std::lock_guard<std::mutex> lock(internalStateMutex);
-                for (auto it = unacknowledgedSentPackets.begin(); it != unacknowledgedSentPackets.end(); ++it) {
-                    if (it->sequenceNumber == seq) {
-                        unacknowledgedSentPackets.erase(it);
-                        return;
-                    }
-                }
+                unacknowledgedSentPackets.Erase(seq);
             }
 #endif
             // Friend declaration to allow ProcessIncomingPacketHeader to call ApplyRTTSampleUnlocked
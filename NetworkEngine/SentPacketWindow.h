@@ -0,0 +1,150 @@
+﻿// File: SentPacketWindow.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Fixed-capacity ring of in-flight reliable packets, indexed by sequence number.
+// Replaces the per-connection std::list so ACKs are applied by direct indexing.
+
+#pragma once
+
+#include <chrono>           // For std::chrono::steady_clock
+#include <cstdint>          // For uint8_t, uint32_t
+#include <memory>           // For std::unique_ptr
+#include <new>              // For std::nothrow
+
+#include "GamePacketHeader.h"  // For SequenceNumber
+#include "PacketBufferPool.h"  // For PacketBuffer
+
+namespace RiftForged {
+    namespace Networking {
+
+        // Max reliable packets in flight per connection. Must be a power of two that divides the
+        // sequence number range, so 'sequence % size' stays consistent across wrap-around.
+        // The receiver's history (RECEIVED_SEQUENCE_HISTORY_SIZE) spans the same window, so every in-flight
+        // packet can be acknowledged, by the header bitfield or by AckRanges.
+        const uint32_t SENT_PACKET_WINDOW_SIZE = 128;
+
+        struct SentPacketInfo {
+            SequenceNumber sequenceNumber = 0;
+            std::chrono::steady_clock::time_point timeSent;
+            PacketBuffer packet;        // Full datagram (header + payload); shared with the send path
+            size_t sentSize = 0;        // Datagram size when first sent, as counted in BytesInFlight()
+            int retries = 0;
+            bool isAckOnly = false;
+            bool lossReported = false;      // NACKed by the remote; resend without waiting for the RTO
+            bool fastRetransmitted = false; // Already resent early once; only the RTO resends it from now on
+            bool inUse = false;
+        };
+
+        // SentPacketWindow stores packet 'seq' in slot 'seq % SENT_PACKET_WINDOW_SIZE'. Insert, Find and
+        // Erase are O(1) and never touch the heap once the slot array exists. The slot array is allocated
+        // on the first insert and released by clear(), so connections without reliable traffic stay small.
+        // A slot still holding an unacknowledged packet one full window older cannot be overwritten:
+        // Insert() fails instead and the caller must hold off sending reliably.
+        // Not thread-safe; guarded by ReliableConnectionState::internalStateMutex.
+        class SentPacketWindow {
+        public:
+            SentPacketWindow() : m_count(0), m_bytesInFlight(0), m_newestSequence(0) {}
+
+            SentPacketWindow(const SentPacketWindow&) = delete;
+            SentPacketWindow& operator=(const SentPacketWindow&) = delete;
+
+            bool CanInsert(SequenceNumber sequenceNumber) const {
+                return !m_slots || !m_slots[SlotIndex(sequenceNumber)].inUse;
+            }
+
+            /**
+             * @brief Retains a reference to the datagram and tracks it under its sequence number.
+             * @return The tracked entry, or nullptr if the slot is still occupied or allocation failed.
+             */
+            SentPacketInfo* Insert(SequenceNumber sequenceNumber, const PacketBuffer& packet, bool isAckOnly,
+                std::chrono::steady_clock::time_point timeSent) {
+                if (packet.Empty()) {
+                    return nullptr;
+                }
+                if (!m_slots) {
+                    m_slots.reset(new (std::nothrow) SentPacketInfo[SENT_PACKET_WINDOW_SIZE]);
+                    if (!m_slots) {
+                        return nullptr;
+                    }
+                }
+                SentPacketInfo& slot = m_slots[SlotIndex(sequenceNumber)];
+                if (slot.inUse) {
+                    return nullptr;
+                }
+                slot.packet = packet;
+                slot.sentSize = packet.Size();
+                slot.sequenceNumber = sequenceNumber;
+                slot.timeSent = timeSent;
+                slot.retries = 0;
+                slot.isAckOnly = isAckOnly;
+                slot.lossReported = false;
+                slot.fastRetransmitted = false;
+                slot.inUse = true;
+                ++m_count;
+                m_bytesInFlight += slot.sentSize;
+                m_newestSequence = sequenceNumber;
+                return &slot;
+            }
+
+            SentPacketInfo* Find(SequenceNumber sequenceNumber) {
+                if (!m_slots) {
+                    return nullptr;
+                }
+                SentPacketInfo& slot = m_slots[SlotIndex(sequenceNumber)];
+                return (slot.inUse && slot.sequenceNumber == sequenceNumber) ? &slot : nullptr;
+            }
+
+            bool Erase(SequenceNumber sequenceNumber) {
+                SentPacketInfo* slot = Find(sequenceNumber);
+                if (!slot) {
+                    return false;
+                }
+                slot->packet.Reset(); // Back to the pool once the transport is done with it too
+                slot->inUse = false;
+                --m_count;
+                m_bytesInFlight -= slot->sentSize;
+                return true;
+            }
+
+            /**
+             * @brief Calls func(SentPacketInfo&) for every in-flight packet, oldest sequence first.
+             * If func returns false the packet is erased.
+             */
+            template <typename Func>
+            void ForEachInFlight(Func&& func) {
+                if (m_count == 0) {
+                    return;
+                }
+                SequenceNumber sequenceNumber = m_newestSequence - (SENT_PACKET_WINDOW_SIZE - 1);
+                for (uint32_t i = 0; i < SENT_PACKET_WINDOW_SIZE && m_count > 0; ++i, ++sequenceNumber) {
+                    SentPacketInfo* slot = Find(sequenceNumber);
+                    if (slot && !func(*slot)) {
+                        Erase(sequenceNumber);
+                    }
+                }
+            }
+
+            size_t size() const { return m_count; }
+            size_t BytesInFlight() const { return m_bytesInFlight; }
+            bool empty() const { return m_count == 0; }
+
+            void clear() {
+                m_slots.reset(); // Destroying the slots drops their buffer references
+                m_count = 0;
+                m_bytesInFlight = 0;
+                m_newestSequence = 0;
+            }
+
+        private:
+            static uint32_t SlotIndex(SequenceNumber sequenceNumber) {
+                return static_cast<uint32_t>(sequenceNumber) & (SENT_PACKET_WINDOW_SIZE - 1);
+            }
+
+            std::unique_ptr<SentPacketInfo[]> m_slots;
+            size_t m_count;
+            size_t m_bytesInFlight;
+            SequenceNumber m_newestSequence;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
@@ -0,0 +1,199 @@
+﻿// File: TimerWheel.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Hierarchical timer wheel used by UDPPacketHandler to schedule retransmissions,
+// delayed ACKs and staleness checks. Advancing the wheel costs O(expired timers) plus a
+// constant per elapsed tick, independent of how many timers are pending.
+
+#pragma once
+
+#include <array>            // For std::array
+#include <chrono>           // For std::chrono::steady_clock
+#include <cstdint>          // For uint64_t
+#include <mutex>            // For std::mutex, std::lock_guard
+#include <vector>           // For std::vector
+
+namespace RiftForged {
+    namespace Networking {
+
+        // TimerWheel keeps TIMER_WHEEL_LEVELS wheels of TIMER_WHEEL_SLOTS slots each. Level 0 slots
+        // are one tick wide; each higher level's slots span a full revolution of the level below.
+        // A timer lives in the lowest level whose range covers its deadline, and is cascaded down one
+        // level each time the wheel below wraps, so it is touched at most TIMER_WHEEL_LEVELS times.
+        //
+        // Schedule() may be called from any thread. Advance() and NextWakeTime() are meant for the
+        // single thread that owns the wheel. Timers cannot be cancelled: handlers are expected to
+        // check on expiry whether the timer still applies (lazy cancellation).
+        template <typename Payload>
+        class TimerWheel {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr unsigned TIMER_WHEEL_SLOT_BITS = 6;
+            static constexpr unsigned TIMER_WHEEL_SLOTS = 1u << TIMER_WHEEL_SLOT_BITS; // 64
+            static constexpr unsigned TIMER_WHEEL_LEVELS = 4;                          // 64^4 ticks of range
+
+            explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(1))
+                : m_tick(tick.count() > 0 ? tick : std::chrono::milliseconds(1)),
+                m_epoch(Clock::now()),
+                m_currentTick(0),
+                m_plannedWakeTick(0),
+                m_count(0) {
+            }
+
+            TimerWheel(const TimerWheel&) = delete;
+            TimerWheel& operator=(const TimerWheel&) = delete;
+
+            /**
+             * @brief Schedules a payload to expire at (or up to one tick after) the deadline.
+             * @return True if the deadline is earlier than the owner thread's planned wake-up,
+             * i.e. the owner should be woken so it can re-plan.
+             */
+            bool Schedule(Clock::time_point deadline, const Payload& payload) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                uint64_t dueTick = ToTick(deadline);
+                if (dueTick <= m_currentTick) {
+                    dueTick = m_currentTick + 1;
+                }
+                InsertUnlocked(Entry{ dueTick, payload });
+                ++m_count;
+                return dueTick < m_plannedWakeTick;
+            }
+
+            /**
+             * @brief Moves the wheel up to 'now' and appends every expired payload to outExpired.
+             */
+            void Advance(Clock::time_point now, std::vector<Payload>& outExpired) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const uint64_t targetTick = ElapsedTicks(now);
+                if (m_count == 0) {
+                    // Nothing to expire; jump straight to 'now' instead of walking empty ticks.
+                    if (targetTick > m_currentTick) {
+                        m_currentTick = targetTick;
+                    }
+                    return;
+                }
+
+                while (m_currentTick < targetTick && m_count > 0) {
+                    ++m_currentTick;
+
+                    // Cascade every level whose lower levels just wrapped, highest first, so entries
+                    // moved down from level N are themselves cascaded by level N-1 on the same tick.
+                    unsigned topLevel = 0;
+                    for (unsigned level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+                        if ((m_currentTick & ((uint64_t(1) << (level * TIMER_WHEEL_SLOT_BITS)) - 1)) != 0) {
+                            break;
+                        }
+                        topLevel = level;
+                    }
+                    for (unsigned level = topLevel; level >= 1; --level) {
+                        std::vector<Entry>& slot = m_levels[level][SlotIndex(m_currentTick, level)];
+                        m_scratch.swap(slot);
+                        for (Entry& entry : m_scratch) {
+                            if (entry.dueTick <= m_currentTick) {
+                                outExpired.push_back(std::move(entry.payload));
+                                --m_count;
+                            }
+                            else {
+                                InsertUnlocked(std::move(entry));
+                            }
+                        }
+                        m_scratch.clear();
+                    }
+
+                    std::vector<Entry>& due = m_levels[0][SlotIndex(m_currentTick, 0)];
+                    for (Entry& entry : due) {
+                        outExpired.push_back(std::move(entry.payload));
+                    }
+                    m_count -= due.size();
+                    due.clear();
+                }
+
+                if (m_count == 0 && targetTick > m_currentTick) {
+                    m_currentTick = targetTick;
+                }
+            }
+
+            /**
+             * @brief Returns when the owner should next call Advance(): the next non-empty level 0 slot,
+             * or the next level 0 wrap (where higher levels cascade), capped at maxWait from now.
+             */
+            Clock::time_point NextWakeTime(std::chrono::milliseconds maxWait) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const uint64_t capTick = m_currentTick + static_cast<uint64_t>(maxWait / m_tick) + 1;
+                uint64_t wakeTick = capTick;
+                if (m_count > 0) {
+                    const uint64_t nextWrap = (m_currentTick | (TIMER_WHEEL_SLOTS - 1)) + 1;
+                    wakeTick = nextWrap;
+                    for (uint64_t tick = m_currentTick + 1; tick < nextWrap; ++tick) {
+                        if (!m_levels[0][SlotIndex(tick, 0)].empty()) {
+                            wakeTick = tick;
+                            break;
+                        }
+                    }
+                    if (wakeTick > capTick) {
+                        wakeTick = capTick;
+                    }
+                }
+                m_plannedWakeTick = wakeTick;
+                return m_epoch + m_tick * static_cast<int64_t>(wakeTick);
+            }
+
+            size_t Size() const {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_count;
+            }
+
+        private:
+            struct Entry {
+                uint64_t dueTick;
+                Payload payload;
+            };
+
+            static size_t SlotIndex(uint64_t tick, unsigned level) {
+                return static_cast<size_t>((tick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+            }
+
+            // Whole ticks elapsed since the epoch (rounded down); the wheel never runs ahead of the clock.
+            uint64_t ElapsedTicks(Clock::time_point time) const {
+                if (time <= m_epoch) {
+                    return 0;
+                }
+                return static_cast<uint64_t>((time - m_epoch) / m_tick);
+            }
+
+            // Rounds up so a timer never fires before its deadline.
+            uint64_t ToTick(Clock::time_point time) const {
+                if (time <= m_epoch) {
+                    return 0;
+                }
+                const auto elapsed = time - m_epoch;
+                return static_cast<uint64_t>((elapsed + m_tick - Clock::duration(1)) / m_tick);
+            }
+
+            void InsertUnlocked(Entry&& entry) {
+                const uint64_t maxDelta = (uint64_t(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1;
+                if (entry.dueTick - m_currentTick > maxDelta) {
+                    entry.dueTick = m_currentTick + maxDelta; // Beyond the wheel's range; re-checked on expiry.
+                }
+                const uint64_t delta = entry.dueTick - m_currentTick;
+                unsigned level = 0;
+                while (level + 1 < TIMER_WHEEL_LEVELS && delta >= (uint64_t(1) << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) {
+                    ++level;
+                }
+                m_levels[level][SlotIndex(entry.dueTick, level)].push_back(std::move(entry));
+            }
+
+            const std::chrono::milliseconds m_tick;
+            const Clock::time_point m_epoch;
+
+            mutable std::mutex m_mutex;
+            std::array<std::array<std::vector<Entry>, TIMER_WHEEL_SLOTS>, TIMER_WHEEL_LEVELS> m_levels;
+            std::vector<Entry> m_scratch;
+            uint64_t m_currentTick;
+            uint64_t m_plannedWakeTick;
+            size_t m_count;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
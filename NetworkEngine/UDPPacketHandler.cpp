@@ -7,7 +7,6 @@
 #include "UDPPacketHandler.h"
 #include "INetworkIO.h"           // For calling m_networkIO->SendData()
 #include "IMessageHandler.h"      // For calling m_messageHandler->ProcessApplicationMessage() (PacketProcessor)
-#include "OverlappedIOContext.h"  // For the type passed in OnRawDataReceived, OnSendCompleted
 #include "NetworkCommon.h"        // For S2C_Response structure
 #include "UDPReliabilityProtocol.h" // For the free functions and ReliableConnectionState, GamePacketFlag, GamePacketHeader
 
@@ -20,6 +19,7 @@
 #include "../Gameplay/ActivePlayer.h"      // For RiftForged::GameLogic::ActivePlayer
 #include "../Utils/Logger.h"          // For RF_NETWORK_... macros
 
+#include <cstddef>     // For offsetof
 #include <utility>     // For std::move
 #include <algorithm>   // For std::remove_if, std::find_if
 #include <stdexcept>   // For std::invalid_argument
@@ -31,6 +31,139 @@
 namespace RiftForged {
     namespace Networking {
 
+        namespace {
+            // Per-thread outbound queue used between BeginOutboundBatch and FlushOutboundBatch.
+            // Entries hold references to the packet buffers, so queuing a datagram copies no bytes.
+            struct OutboundBatch {
+                struct Entry {
+                    NetworkEndpoint recipient;
+                    PacketBuffer packet;
+                    DeferredDatagramSeal seal; // Key is null unless the packet still has to be sealed
+                };
+                struct AggregatingConnection {
+                    ConnectionTable::Connection* connection;
+                    uint32_t generation;
+                };
+                UDPPacketHandler* owner = nullptr;       // Handler that opened the batch; nullptr when closed
+                size_t bytes = 0;
+                size_t pendingSeals = 0;                 // Entries with a deferred seal
+                std::vector<Entry> entries;
+                std::vector<AggregatingConnection> aggregating; // Connections whose pending aggregate is sealed at flush
+                bool sealingAggregates = false;          // Set while flushing them, so an early flush doesn't recurse
+                std::vector<OutgoingDatagram> datagrams; // Scratch for SendBatch, rebuilt on every flush
+            };
+            thread_local OutboundBatch t_outboundBatch;
+
+            // Channel each S2C message travels on. Combat results and spawns must be applied in order;
+            // entity state is only useful if it is newer than what the client already has.
+            NetworkChannel ChannelForS2CPayload(UDP::S2C::S2C_UDP_Payload payloadType, bool isReliable) {
+                if (!isReliable) {
+                    return payloadType == UDP::S2C::S2C_UDP_Payload_EntityStateUpdate ? NetworkChannel::UNRELIABLE_SEQUENCED : NetworkChannel::UNRELIABLE;
+                }
+                switch (payloadType) {
+                case UDP::S2C::S2C_UDP_Payload_CombatEvent:
+                case UDP::S2C::S2C_UDP_Payload_SpawnProjectile:
+                case UDP::S2C::S2C_UDP_Payload_RiftStepInitiated:
+                    return NetworkChannel::RELIABLE_ORDERED;
+                default:
+                    return NetworkChannel::RELIABLE_UNORDERED;
+                }
+            }
+
+            static_assert(UDP::C2S::C2S_UDP_Payload_MAX < INGRESS_MESSAGE_KINDS, "Every C2S payload type needs an ingress bucket");
+
+            // Default ingress limits, in messages per second and burst. Input is sent every client frame and
+            // combat at human rates; pings and joins are rare. NONE covers messages whose type can't be read.
+            struct IngressRateLimit {
+                float messagesPerSec;
+                uint32_t burst;
+            };
+            IngressRateLimit DefaultIngressRateLimit(UDP::C2S::C2S_UDP_Payload payloadType) {
+                switch (payloadType) {
+                case UDP::C2S::C2S_UDP_Payload_MovementInput:
+                case UDP::C2S::C2S_UDP_Payload_TurnIntent:
+                    return { 60.0f, 30 };
+                case UDP::C2S::C2S_UDP_Payload_RiftStepActivation:
+                    return { 10.0f, 5 };
+                case UDP::C2S::C2S_UDP_Payload_BasicAttackIntent:
+                case UDP::C2S::C2S_UDP_Payload_UseAbility:
+                    return { 20.0f, 10 };
+                case UDP::C2S::C2S_UDP_Payload_Ping:
+                    return { 5.0f, 5 };
+                case UDP::C2S::C2S_UDP_Payload_JoinRequest:
+                    return { 2.0f, 4 };
+                default:
+                    return { 30.0f, 30 };
+                }
+            }
+
+            // What a C2S message is worth while the server is overloaded. Pings can wait and an unreadable type
+            // would most likely fail verification; a movement input is superseded by the next one. Joins and
+            // combat change game state that can't be rebuilt, and each turn intent carries its own delta.
+            // Only messages that arrived unreliably are shed; a reliable one was ACKed already.
+            enum class OverloadShedding : uint8_t { Keep, Thin, Drop };
+            OverloadShedding OverloadSheddingForC2SPayload(UDP::C2S::C2S_UDP_Payload payloadType) {
+                switch (payloadType) {
+                case UDP::C2S::C2S_UDP_Payload_NONE:
+                case UDP::C2S::C2S_UDP_Payload_Ping:
+                    return OverloadShedding::Drop;
+                case UDP::C2S::C2S_UDP_Payload_MovementInput:
+                    return OverloadShedding::Thin;
+                default:
+                    return OverloadShedding::Keep;
+                }
+            }
+
+            // Reads the payload type of a C2S root table without verifying the buffer, so a rate limit can be
+            // applied before verification is paid for. Every offset followed is bounds-checked; a type that
+            // can't be read, or isn't known, comes back as NONE. A client that lies about the type gains
+            // nothing, since admitted messages are still verified in full.
+            UDP::C2S::C2S_UDP_Payload PeekC2SPayloadType(const uint8_t* data, uint16_t size) {
+                flatbuffers::uoffset_t tableOffset = 0;
+                flatbuffers::soffset_t vtableDistance = 0;
+                flatbuffers::voffset_t vtableSize = 0;
+                flatbuffers::voffset_t fieldOffset = 0;
+                if (!data || size < sizeof(tableOffset)) {
+                    return UDP::C2S::C2S_UDP_Payload_NONE;
+                }
+                memcpy(&tableOffset, data, sizeof(tableOffset));
+                if (tableOffset > size - sizeof(vtableDistance)) {
+                    return UDP::C2S::C2S_UDP_Payload_NONE;
+                }
+                memcpy(&vtableDistance, data + tableOffset, sizeof(vtableDistance));
+                const int64_t vtableOffset = static_cast<int64_t>(tableOffset) - vtableDistance;
+                if (vtableOffset < 0 || vtableOffset + static_cast<int64_t>(sizeof(vtableSize)) > size) {
+                    return UDP::C2S::C2S_UDP_Payload_NONE;
+                }
+                memcpy(&vtableSize, data + vtableOffset, sizeof(vtableSize));
+                const size_t fieldSlot = UDP::C2S::Root_C2S_UDP_Message::VT_PAYLOAD_TYPE;
+                if (vtableSize < fieldSlot + sizeof(fieldOffset) || vtableOffset + fieldSlot + sizeof(fieldOffset) > size) {
+                    return UDP::C2S::C2S_UDP_Payload_NONE;
+                }
+                memcpy(&fieldOffset, data + vtableOffset + fieldSlot, sizeof(fieldOffset));
+                if (fieldOffset == 0 || static_cast<size_t>(tableOffset) + fieldOffset >= size) {
+                    return UDP::C2S::C2S_UDP_Payload_NONE;
+                }
+                const uint8_t payloadType = data[tableOffset + fieldOffset];
+                return payloadType <= UDP::C2S::C2S_UDP_Payload_MAX ?
+                    static_cast<UDP::C2S::C2S_UDP_Payload>(payloadType) : UDP::C2S::C2S_UDP_Payload_NONE;
+            }
+        }
+
+        // An outbound batch being sealed and sent by the crypto workers. Each worker seals its own run of
+        // entries; none touches connection state, so they need no lock.
+        struct UDPPacketHandler::CryptoFlush {
+            std::vector<OutboundBatch::Entry> entries;
+            std::vector<OutgoingDatagram> datagrams;  // Scratch for SendBatch
+            size_t bytes = 0;
+            size_t sealCount = 0;
+            size_t workers = 0;
+            std::atomic<size_t> runsRemaining{ 0 };
+            std::atomic<uint64_t> sealCpuMicros{ 0 };
+            std::atomic<size_t> sealFailures{ 0 };
+            std::chrono::steady_clock::time_point handedOffAt;
+        };
+
         // --- Constructor & Destructor ---
 
         UDPPacketHandler::UDPPacketHandler(INetworkIO* networkIO,
@@ -39,7 +172,20 @@ namespace RiftForged {
             : m_networkIO(networkIO),
             m_messageHandler(messageHandler),
             m_gameServerEngine(gameServerEngine),
-            m_isRunning(false) {
+            m_isRunning(false),
+            m_timerWheel(std::chrono::milliseconds(RELIABILITY_TIMER_TICK_MS_PKT)),
+            m_timerWakePending(false),
+            m_ackDelayMs(DEFAULT_ACK_DELAY_MS_PKT),
+            m_explicitNacksEnabled(true),
+            m_congestionControlAlgorithm(CongestionControlAlgorithm::AIMD),
+            m_unreliableFecMode(UnreliableFecMode::Off),
+            m_cryptoFlush(std::make_unique<CryptoFlush>()),
+            m_cryptoFlushInFlight(false) {
+            for (size_t type = 0; type < INGRESS_MESSAGE_KINDS; ++type) {
+                const IngressRateLimit limit = DefaultIngressRateLimit(static_cast<UDP::C2S::C2S_UDP_Payload>(type));
+                m_ingressRatesPerSec[type].store(limit.messagesPerSec, std::memory_order_relaxed);
+                m_ingressBursts[type].store(limit.burst, std::memory_order_relaxed);
+            }
             if (!m_networkIO) {
                 // Note: Logger might not be initialized if this throws super early,
                 // but critical errors should attempt to log.
@@ -95,6 +241,11 @@ namespace RiftForged {
             }
 
             RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Stopping reliability management thread..."));
+            {
+                std::lock_guard<std::mutex> wakeLock(m_timerWakeMutex);
+                m_timerWakePending = true;
+            }
+            m_timerWakeCv.notify_one();
             if (m_reliabilityThread.joinable()) {
                 // Ensure the thread is not trying to join itself if Stop() is called from the thread
                 if (m_reliabilityThread.get_id() == std::this_thread::get_id()) {
@@ -110,13 +261,12 @@ namespace RiftForged {
             }
 
 
+            // Let a batch still with the crypto workers go out before its connections are cleared.
+            WaitForCryptoFlush();
+
             // Clean up reliability states upon stop
-            {
-                std::lock_guard<std::mutex> lock(m_reliabilityStatesMutex);
-                m_reliabilityStates.clear();
-                m_endpointLastSeenTime.clear();
-            }
-            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Reliability states and last seen times cleared."));
+            m_connections.Clear();
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Reliability states cleared."));
             RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Stopped."));
         }
 
@@ -133,38 +283,89 @@ namespace RiftForged {
                 return;
             }
 
-            if (size < GetGamePacketHeaderSize()) {
-                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Received packet too small ({} bytes) from {}. Discarding."), size, sender.ToString());
+            // Either header form may arrive (see GamePacketHeader.h); check it before creating any state.
+            const bool isCompactHeader = IsCompactPacketHeader(data, size);
+            if (isCompactHeader ? GetCompactPacketHeaderSize(data, size) == 0 : size < GetGamePacketHeaderSize()) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Received packet too small or malformed ({} bytes) from {}. Discarding."), size, sender.ToString());
                 return;
             }
-
-            GamePacketHeader receivedHeader;
-            memcpy(&receivedHeader, data, GetGamePacketHeaderSize());
-
-            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Raw Header from {} - Proto: 0x{:X}, Seq: {}, Ack: {}, AckBits: 0x{:08X}, Flags: 0x{:X}"),
-                sender.ToString(), receivedHeader.protocolId,
-                receivedHeader.sequenceNumber,
-                receivedHeader.ackNumber, receivedHeader.ackBitfield, receivedHeader.flags);
-
-            if (receivedHeader.protocolId != CURRENT_PROTOCOL_ID_VERSION) {
-                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Received packet from {} with mismatched protocol ID (Expected: 0x{:X}, Got: 0x{:X}). Discarding."),
-                    sender.ToString(), CURRENT_PROTOCOL_ID_VERSION, receivedHeader.protocolId);
-                return;
+            if (!isCompactHeader) {
+                uint32_t protocolId = 0;
+                memcpy(&protocolId, data + offsetof(GamePacketHeader, protocolId), sizeof(protocolId));
+                if (protocolId != CURRENT_PROTOCOL_ID_VERSION) {
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Received packet from {} with mismatched protocol ID (Expected: 0x{:X}, Got: 0x{:X}). Discarding."),
+                        sender.ToString(), CURRENT_PROTOCOL_ID_VERSION, protocolId);
+                    return;
+                }
             }
 
-            {
-                std::lock_guard<std::mutex> lock(m_reliabilityStatesMutex);
-                m_endpointLastSeenTime[sender] = std::chrono::steady_clock::now();
+            ConnectionTable::Connection* connection = m_connections.Find(sender);
+            if (!connection) {
+                // Cookie messages are always v4, and compact headers are only negotiated in the echo, so a
+                // compact datagram from an unknown sender is never answered.
+                if (isCompactHeader) {
+                    RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Dropping compact-header datagram ({} bytes) from unknown sender {}."), size, sender.ToString());
+                    return;
+                }
+                // No state is created for a sender until it echoes a cookie; until then each datagram costs
+                // one HMAC and at most one challenge no larger than itself.
+                PacketBuffer challenge;
+                uint8_t capabilities = 0;
+                switch (m_cookieIssuer.Process(sender, data, size, std::chrono::steady_clock::now(), challenge, capabilities)) {
+                case ConnectionCookieResult::Challenged:
+                    RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Challenging unknown sender {} ({} bytes)."), sender.ToString(), size);
+                    m_networkIO->SendPacket(sender, challenge);
+                    return;
+                case ConnectionCookieResult::Dropped:
+                    RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Dropping datagram ({} bytes) from unknown sender {}."), size, sender.ToString());
+                    return;
+                case ConnectionCookieResult::Verified:
+                    break;
+                }
+                connection = GetOrCreateConnection(sender);
+                if (!connection) {
+                    RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: Failed to get/create reliability state for {}. Discarding packet."), sender.ToString());
+                    return;
+                }
+                // The echo is the first datagram heard on the connection; without it a client that echoes once and
+                // goes silent would never be found stale. It also says whether the client may send compact headers.
+                const bool compactHeadersRequested = (capabilities & static_cast<uint8_t>(ConnectionCapability::COMPACT_HEADERS)) != 0;
+                {
+                    std::lock_guard<std::mutex> lock(connection->state.internalStateMutex);
+                    connection->state.lastPacketReceivedTimeFromRemote = std::chrono::steady_clock::now();
+                    connection->state.compactHeadersNegotiated = compactHeadersRequested;
+                }
+                RF_NETWORK_DEBUG(FMT_STRING("UDPPacketHandler: {} echoed a valid cookie; connection created{}."), sender.ToString(),
+                    compactHeadersRequested ? " with compact headers" : "");
+                return; // The echo carries nothing else
             }
-
-            std::shared_ptr<ReliableConnectionState> connState = GetOrCreateReliabilityState(sender);
-            if (!connState) {
-                RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: Failed to get/create reliability state for {}. Discarding packet."), sender.ToString());
+            ReliableConnectionState* connState = &connection->state;
+
+            // On an encrypted connection the datagram is authenticated and decrypted before any header field
+            // is used, into a per-thread buffer rather than an allocation.
+            thread_local uint8_t t_openedDatagram[PACKET_BUFFER_BLOCK_SIZE];
+            size_t datagramSize = 0;
+            const uint8_t* datagram = RiftForged::Networking::OpenIncomingDatagram(*connState, data, size,
+                t_openedDatagram, sizeof(t_openedDatagram), datagramSize);
+            if (!datagram) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Datagram ({} bytes) from {} failed authentication or was replayed. Discarding."),
+                    size, sender.ToString());
                 return;
             }
+            GamePacketHeader receivedHeader;
+            const size_t wireHeaderSize = RiftForged::Networking::DecodeIncomingPacketHeader(*connState, datagram, datagramSize, receivedHeader);
+            if (wireHeaderSize == 0) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Failed to decode packet header ({} bytes) from {}. Discarding."), size, sender.ToString());
+                return;
+            }
+
+            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Header from {} ({}, {} bytes) - Seq: {}, Ack: {}, AckBits: 0x{:08X}, Flags: 0x{:X}"),
+                sender.ToString(), isCompactHeader ? "compact" : "v4", wireHeaderSize,
+                receivedHeader.sequenceNumber,
+                receivedHeader.ackNumber, receivedHeader.ackBitfield, receivedHeader.flags);
 
-            const uint8_t* payloadAfterGameHeader = data + GetGamePacketHeaderSize();
-            uint16_t payloadAfterGameHeaderSize = static_cast<uint16_t>(size - GetGamePacketHeaderSize());
+            const uint8_t* payloadAfterGameHeader = datagram + wireHeaderSize;
+            uint16_t payloadAfterGameHeaderSize = static_cast<uint16_t>(datagramSize - wireHeaderSize);
 
             const uint8_t* appPayloadToProcess = nullptr;
             uint16_t appPayloadSize = 0;
@@ -178,83 +379,208 @@ namespace RiftForged {
                 &appPayloadSize
             );
 
+            // New reliable data from the peer must be ACKed within the ACK delay if nothing piggybacks it first.
+            if (HasFlag(receivedHeader.flags, GamePacketFlag::IS_RELIABLE) && connState->HasPendingAck()) {
+                ScheduleAckTimer(*connection);
+            }
+
+            // ACKs that show a packet overtaken (or a NACK for it) resend it now rather than at its RTO.
+            thread_local std::vector<PacketBuffer> t_fastRetransmits;
+            if (RiftForged::Networking::CollectFastRetransmissions(*connState, std::chrono::steady_clock::now(), t_fastRetransmits) > 0) {
+                for (const PacketBuffer& packet : t_fastRetransmits) {
+                    SendRawDatagram(sender, *connState, packet);
+                }
+                t_fastRetransmits.clear();
+            }
+            // A new gap in the peer's reliable packets is NACKed at once, without waiting for the ACK delay.
+            if (connState->HasPendingNack()) {
+                SendAckPacket(sender, *connState);
+            }
+
+            // Path MTU probes and their ACKs are handled here and never reach the application.
+            if (HasFlag(receivedHeader.flags, GamePacketFlag::IS_HEARTBEAT)) {
+                PacketBuffer pathMtuReply;
+                if (RiftForged::Networking::ProcessIncomingPathMtuDatagram(*connState, payloadAfterGameHeader, payloadAfterGameHeaderSize,
+                    size, std::chrono::steady_clock::now(), pathMtuReply)) {
+                    SendRawDatagram(sender, *connState, pathMtuReply);
+                }
+                return;
+            }
+
+            // An unreliable datagram with an FEC tag may complete a group with one datagram missing. The rebuilt
+            // datagram is older than this one, so it is delivered first.
+            if (!HasFlag(receivedHeader.flags, GamePacketFlag::IS_RELIABLE) && receivedHeader.sequenceNumber != 0) {
+                uint8_t recoveredFlags = 0;
+                PacketBuffer recoveredPayload;
+                if (RiftForged::Networking::ProcessIncomingFecDatagram(*connState, receivedHeader, payloadAfterGameHeader, payloadAfterGameHeaderSize,
+                    recoveredFlags, recoveredPayload)) {
+                    DeliverDatagramPayload(sender, *connState, recoveredFlags, recoveredPayload.Data(), static_cast<uint16_t>(recoveredPayload.Size()));
+                }
+            }
+
+            // A fragment is copied into its message's reassembly buffer; the message is dispatched once complete.
+            PacketBuffer reassembledMessage;
+            if (shouldRelayToGameLogic && IsFragment(receivedHeader.flags)) {
+                if (RiftForged::Networking::ProcessIncomingFragment(*connState, receivedHeader, appPayloadToProcess, appPayloadSize, reassembledMessage) !=
+                    FragmentReassemblyResult::Complete) {
+                    return;
+                }
+                if (reassembledMessage.Size() > UINT16_MAX) {
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Reassembled message from {} is {} bytes, more than a C2S message may carry. Discarding."),
+                        sender.ToString(), reassembledMessage.Size());
+                    return;
+                }
+                appPayloadToProcess = reassembledMessage.Data();
+                appPayloadSize = static_cast<uint16_t>(reassembledMessage.Size());
+            }
+
             if (shouldRelayToGameLogic) {
                 if (appPayloadToProcess && appPayloadSize > 0) {
-                    RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Relaying app payload from {} to MessageHandler. Size: {} bytes."),
-                        sender.ToString(), appPayloadSize);
-
-                    RiftForged::GameLogic::ActivePlayer* player = nullptr;
-                    UDP::C2S::C2S_UDP_Payload c2s_payload_type = UDP::C2S::C2S_UDP_Payload_NONE;
-
-                    if (appPayloadToProcess && appPayloadSize >= (sizeof(uint32_t) * 2)) { // Min size for a FB root table
-                        flatbuffers::Verifier verifier(appPayloadToProcess, appPayloadSize);
-                        if (UDP::C2S::VerifyRoot_C2S_UDP_MessageBuffer(verifier)) {
-                            const UDP::C2S::Root_C2S_UDP_Message* root_c2s_msg = UDP::C2S::GetRoot_C2S_UDP_Message(appPayloadToProcess);
-                            if (root_c2s_msg && root_c2s_msg->payload()) {
-                                c2s_payload_type = root_c2s_msg->payload_type();
-                            }
-                            else {
-                                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Valid FlatBuffer root from {} but no payload field present or root_c2s_msg is null."), sender.ToString());
-                                // If no payload type, treat as if player is not needed for dispatch to PacketProcessor,
-                                // which will then handle it based on its internal logic (likely drop if not JoinRequest)
-                            }
-                        }
-                        else {
-                            RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: FlatBuffer verification failed for payload from {}. Not processing for player lookup."), sender.ToString());
-                            return; // Invalid FB, don't pass to message handler
-                        }
+                    DeliverDatagramPayload(sender, *connState, receivedHeader.flags, appPayloadToProcess, appPayloadSize);
+                }
+                else {
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: ProcessIncomingPacketHeader indicated relay, but no app payload provided from {}. Header Flags: 0x{:X}"),
+                        sender.ToString(), receivedHeader.flags);
+                }
+            }
+            else {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Packet from {} not relayed by reliability protocol (e.g., duplicate, pure ACK). Header Flags: 0x{:X}"),
+                    sender.ToString(), receivedHeader.flags);
+            }
+        }
+
+        void UDPPacketHandler::DeliverDatagramPayload(const NetworkEndpoint& sender,
+            ReliableConnectionState& connectionState,
+            uint8_t headerFlags,
+            const uint8_t* payloadData,
+            uint16_t payloadSize) {
+            const bool fromReliableDatagram = HasFlag(headerFlags, GamePacketFlag::IS_RELIABLE);
+            if (!HasFlag(headerFlags, GamePacketFlag::IS_AGGREGATE)) {
+                DispatchApplicationMessage(sender, connectionState, payloadData, payloadSize, fromReliableDatagram);
+                return;
+            }
+            // Several messages share this datagram. Each passes its channel first, so stale sequenced
+            // updates are dropped before FlatBuffer verification and ordered ones wait for gaps to fill.
+            thread_local std::vector<PacketBuffer> t_releasedMessages;
+            const bool wellFormed = ForEachAggregatedMessage(payloadData, payloadSize,
+                [&](const uint8_t* message, const AggregatedMessageHeader& messageHeader) {
+                    if (RiftForged::Networking::ProcessIncomingChannelMessage(connectionState, messageHeader, message,
+                        fromReliableDatagram, t_releasedMessages) == ChannelDeliveryResult::Deliver) {
+                        DispatchApplicationMessage(sender, connectionState, message, messageHeader.messageSize, fromReliableDatagram);
                     }
-                    else if (appPayloadToProcess && appPayloadSize > 0) {
-                        RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Payload from {} too small to be a valid FlatBuffer (size {}). Not processing for player lookup."), sender.ToString(), appPayloadSize);
-                        return; // Too small, don't pass to message handler
+                    // Released messages are from the reliable ordered channel, ACKed when they first arrived.
+                    for (const PacketBuffer& released : t_releasedMessages) {
+                        DispatchApplicationMessage(sender, connectionState, released.Data(), static_cast<uint16_t>(released.Size()), true);
                     }
+                    t_releasedMessages.clear();
+                });
+            if (!wellFormed) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Malformed aggregated payload ({} bytes) from {}. Discarding."), payloadSize, sender.ToString());
+            }
+        }
+
+        void UDPPacketHandler::DispatchApplicationMessage(const NetworkEndpoint& sender,
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            uint16_t payloadSize,
+            bool arrivedReliably) {
+            // Messages over their type's rate are dropped before any verification, so a flooding client
+            // costs the IO thread a bucket lookup per message. While overloaded, low-value types are shed first.
+            // A reliable message was ACKed with its datagram and won't be resent, so it is neither limited nor shed.
+            const UDP::C2S::C2S_UDP_Payload peekedType = PeekC2SPayloadType(payloadData, payloadSize);
+            float ingressRate = m_ingressRatesPerSec[peekedType].load(std::memory_order_relaxed);
+            uint32_t ingressBurst = m_ingressBursts[peekedType].load(std::memory_order_relaxed);
+            bool thinning = false;
+            if (!arrivedReliably && m_overloadDetector.IsOverloaded()) {
+                switch (OverloadSheddingForC2SPayload(peekedType)) {
+                case OverloadShedding::Drop:
+                    m_overloadDetector.RecordShed(peekedType);
+                    RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Overloaded; shedding {} message from {}."),
+                        UDP::C2S::EnumNameC2S_UDP_Payload(peekedType), sender.ToString());
+                    return;
+                case OverloadShedding::Thin:
+                    ingressRate *= OVERLOAD_MOVEMENT_RATE_FACTOR_PKT;
+                    ingressBurst = 1;
+                    thinning = true;
+                    break;
+                case OverloadShedding::Keep:
+                    break;
+                }
+            }
+            if (!arrivedReliably && ingressRate > 0.0f && !connectionState.AdmitIngressMessage(peekedType, ingressRate, ingressBurst, std::chrono::steady_clock::now())) {
+                if (thinning) {
+                    m_overloadDetector.RecordShed(peekedType);
+                }
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: {} message from {} over its ingress rate limit. Dropping."),
+                    UDP::C2S::EnumNameC2S_UDP_Payload(peekedType), sender.ToString());
+                return;
+            }
 
+            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Relaying app payload from {} to MessageHandler. Size: {} bytes."),
+                sender.ToString(), payloadSize);
 
-                    if (c2s_payload_type != UDP::C2S::C2S_UDP_Payload_JoinRequest) {
-                        uint64_t playerId = m_gameServerEngine.GetPlayerIdForEndpoint(sender);
-                        RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: For endpoint {}, GameServerEngine returned PlayerID {}. (MsgType: {})"),
-                            sender.ToString(), playerId, UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
-                        if (playerId != 0) {
-                            player = m_gameServerEngine.GetPlayerManager().FindPlayerById(playerId);
-                            if (!player) {
-                                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Endpoint {} has PlayerID {} but ActivePlayer object not found. Dropping msg type {}."),
-                                    sender.ToString(), playerId, UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
-                                // PacketProcessor will also drop it if player is null and it's not JoinRequest,
-                                // but logging here helps identify where the ActivePlayer* was lost.
-                            }
-                            else {
-                                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Found ActivePlayer (ID: {}) for endpoint {} for message type {}."),
-                                    player->playerId, sender.ToString(), UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
-                            }
-                        }
-                        else {
-                            RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: No PlayerID found for endpoint {} for message type {}. Passing nullptr player to PacketProcessor."),
-                                sender.ToString(), UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
-                        }
+            RiftForged::GameLogic::ActivePlayer* player = nullptr;
+            UDP::C2S::C2S_UDP_Payload c2s_payload_type = UDP::C2S::C2S_UDP_Payload_NONE;
+
+            if (payloadData && payloadSize >= (sizeof(uint32_t) * 2)) { // Min size for a FB root table
+                flatbuffers::Verifier verifier(payloadData, payloadSize);
+                if (UDP::C2S::VerifyRoot_C2S_UDP_MessageBuffer(verifier)) {
+                    const UDP::C2S::Root_C2S_UDP_Message* root_c2s_msg = UDP::C2S::GetRoot_C2S_UDP_Message(payloadData);
+                    if (root_c2s_msg && root_c2s_msg->payload()) {
+                        c2s_payload_type = root_c2s_msg->payload_type();
                     }
                     else {
-                        RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Message from {} is C2S_JoinRequest. Player context will be nullptr for PacketProcessor."), sender.ToString());
+                        RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Valid FlatBuffer root from {} but no payload field present or root_c2s_msg is null."), sender.ToString());
+                        // If no payload type, treat as if player is not needed for dispatch to PacketProcessor,
+                        // which will then handle it based on its internal logic (likely drop if not JoinRequest)
                     }
+                }
+                else {
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: FlatBuffer verification failed for payload from {}. Not processing for player lookup."), sender.ToString());
+                    return; // Invalid FB, don't pass to message handler
+                }
+            }
+            else if (payloadData && payloadSize > 0) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Payload from {} too small to be a valid FlatBuffer (size {}). Not processing for player lookup."), sender.ToString(), payloadSize);
+                return; // Too small, don't pass to message handler
+            }
 
-                    std::optional<S2C_Response> s2c_response_opt = m_messageHandler->ProcessApplicationMessage(
-                        sender,
-                        appPayloadToProcess,
-                        appPayloadSize,
-                        player
-                    );
 
-                    if (s2c_response_opt.has_value()) {
-                        HandleResponseMessage(s2c_response_opt);
+            if (c2s_payload_type != UDP::C2S::C2S_UDP_Payload_JoinRequest) {
+                uint64_t playerId = m_gameServerEngine.GetPlayerIdForEndpoint(sender);
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: For endpoint {}, GameServerEngine returned PlayerID {}. (MsgType: {})"),
+                    sender.ToString(), playerId, UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
+                if (playerId != 0) {
+                    player = m_gameServerEngine.GetPlayerManager().FindPlayerById(playerId);
+                    if (!player) {
+                        RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Endpoint {} has PlayerID {} but ActivePlayer object not found. Dropping msg type {}."),
+                            sender.ToString(), playerId, UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
+                        // PacketProcessor will also drop it if player is null and it's not JoinRequest,
+                        // but logging here helps identify where the ActivePlayer* was lost.
+                    }
+                    else {
+                        RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Found ActivePlayer (ID: {}) for endpoint {} for message type {}."),
+                            player->playerId, sender.ToString(), UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
                     }
                 }
                 else {
-                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: ProcessIncomingPacketHeader indicated relay, but no app payload provided from {}. Header Flags: 0x{:X}"),
-                        sender.ToString(), receivedHeader.flags);
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: No PlayerID found for endpoint {} for message type {}. Passing nullptr player to PacketProcessor."),
+                        sender.ToString(), UDP::C2S::EnumNameC2S_UDP_Payload(c2s_payload_type));
                 }
             }
             else {
-                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Packet from {} not relayed by reliability protocol (e.g., duplicate, pure ACK). Header Flags: 0x{:X}"),
-                    sender.ToString(), receivedHeader.flags);
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Message from {} is C2S_JoinRequest. Player context will be nullptr for PacketProcessor."), sender.ToString());
+            }
+
+            std::optional<S2C_Response> s2c_response_opt = m_messageHandler->ProcessApplicationMessage(
+                sender,
+                payloadData,
+                payloadSize,
+                player
+            );
+
+            if (s2c_response_opt.has_value()) {
+                HandleResponseMessage(s2c_response_opt);
             }
         }
 
@@ -284,30 +610,51 @@ namespace RiftForged {
                 return false;
             }
 
-            std::shared_ptr<ReliableConnectionState> connState = GetOrCreateReliabilityState(recipient);
-            if (!connState) {
+            ConnectionTable::Connection* connection = GetOrCreateConnection(recipient);
+            if (!connection) {
                 RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendReliablePacket - Failed to get/create reliability state for {}. Dropping packet."), recipient.ToString());
                 return false;
             }
+            ReliableConnectionState* connState = &connection->state;
+
+            // Inside an outbound batch the message shares a datagram with the connection's other messages this tick.
+            const NetworkChannel channel = ChannelForS2CPayload(flatbufferPayloadType, true);
+            if (additionalFlags == 0 && QueueChannelMessage(*connection, channel, flatbufferPayload)) {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Queued RELIABLE FB Type {} ({} bytes) on channel {} to {}."),
+                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), flatbufferPayload.size(), static_cast<int>(channel), recipient.ToString());
+                return true;
+            }
+
+            // Messages larger than the connection's datagram size go out as several fragments.
+            // Reused per sending thread so the common single-packet case does not allocate.
+            thread_local std::vector<PacketBuffer> t_outgoingPackets;
+            t_outgoingPackets.clear();
 
+            // A message too large to aggregate keeps its channel; one with extra header flags is sent bare.
             uint8_t flags = static_cast<uint8_t>(GamePacketFlag::IS_RELIABLE) | additionalFlags;
-            std::vector<uint8_t> packetBuffer = RiftForged::Networking::PrepareOutgoingPacket(
-                *connState,
-                flatbufferPayload.data(),
-                static_cast<uint16_t>(flatbufferPayload.size()),
-                flags
-            );
+            const bool prepared = additionalFlags == 0
+                ? RiftForged::Networking::PrepareOutgoingChannelMessage(*connState, channel, flatbufferPayload.data(), flatbufferPayload.size(), t_outgoingPackets)
+                : RiftForged::Networking::PrepareOutgoingReliableMessage(*connState, flatbufferPayload.data(), flatbufferPayload.size(), flags, t_outgoingPackets);
 
-            if (packetBuffer.empty()) {
-                RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendReliablePacket - PrepareOutgoingPacket returned empty for FB type {} to {}."),
-                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), recipient.ToString());
+            if (t_outgoingPackets.empty()) {
+                RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendReliablePacket - PrepareOutgoingReliableMessage failed for FB type {} ({} bytes) to {}."),
+                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), flatbufferPayload.size(), recipient.ToString());
                 return false;
             }
 
-            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Sending RELIABLE FB Type {} ({} bytes total) to {}."),
-                UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), packetBuffer.size(), recipient.ToString());
+            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Sending RELIABLE FB Type {} ({} payload bytes in {} datagrams) to {}."),
+                UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), flatbufferPayload.size(), t_outgoingPackets.size(), recipient.ToString());
 
-            return m_networkIO->SendData(recipient, packetBuffer.data(), static_cast<uint32_t>(packetBuffer.size()));
+            // Every prepared packet is tracked for retransmission, so each must be sent even if the message is incomplete.
+            bool sent = true;
+            const auto now = std::chrono::steady_clock::now();
+            for (const PacketBuffer& packetBuffer : t_outgoingPackets) {
+                RiftForged::Networking::AdmitOutgoingDatagram(*connState, packetBuffer.Size(), true, now);
+                ScheduleRetransmitTimer(*connection, packetBuffer);
+                sent = SendRawDatagram(recipient, *connState, packetBuffer) && sent;
+            }
+            t_outgoingPackets.clear();
+            return prepared && sent;
         }
 
         bool UDPPacketHandler::SendUnreliablePacket(const NetworkEndpoint& recipient,
@@ -319,31 +666,56 @@ namespace RiftForged {
                 return false;
             }
 
-            std::shared_ptr<ReliableConnectionState> connState = GetOrCreateReliabilityState(recipient);
+            ConnectionTable::Connection* connection = GetOrCreateConnection(recipient);
+            ReliableConnectionState* connState = connection ? &connection->state : nullptr;
             if (!connState) {
                 // Unreliable packets still need connState for current ACK info to send.
                 RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendUnreliablePacket - Failed to get/create reliability state for {}. Dropping packet."), recipient.ToString());
                 return false;
             }
 
+            // Unreliable packets are never fragmented; a payload that cannot fit one datagram at the
+            // connection's current size limit would be dropped on the path (or truncated by the uint16
+            // length), so it is refused here instead.
+            const size_t maxPayloadSize = RiftForged::Networking::GetMaxUnfragmentedPayloadSize(*connState);
+            if (flatbufferPayload.size() > maxPayloadSize) {
+                RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendUnreliablePacket - FB Type {} payload of {} bytes exceeds the {} byte datagram limit. Dropping packet to {}."),
+                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), flatbufferPayload.size(), maxPayloadSize, recipient.ToString());
+                return false;
+            }
+
+            const NetworkChannel channel = ChannelForS2CPayload(flatbufferPayloadType, false);
+            if (additionalFlags == 0 && QueueChannelMessage(*connection, channel, flatbufferPayload)) {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Queued UNRELIABLE FB Type {} ({} bytes) on channel {} to {}."),
+                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), flatbufferPayload.size(), static_cast<int>(channel), recipient.ToString());
+                return true;
+            }
+
             uint8_t flags = additionalFlags & (~static_cast<uint8_t>(GamePacketFlag::IS_RELIABLE));
-            std::vector<uint8_t> packetBuffer = RiftForged::Networking::PrepareOutgoingPacket(
+            PacketBuffer packetBuffer = RiftForged::Networking::PrepareOutgoingPacketBuffer(
                 *connState,
                 flatbufferPayload.data(),
                 static_cast<uint16_t>(flatbufferPayload.size()),
                 flags
             );
 
-            if (packetBuffer.empty()) {
+            if (packetBuffer.Empty()) {
                 RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendUnreliablePacket - PrepareOutgoingPacket returned empty for FB Type {} to {}."),
                     UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), recipient.ToString());
                 return false;
             }
 
+            // Under congestion unreliable traffic yields; the next update supersedes this one anyway.
+            if (!RiftForged::Networking::AdmitOutgoingDatagram(*connState, packetBuffer.Size(), false, std::chrono::steady_clock::now())) {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Shedding UNRELIABLE FB Type {} ({} bytes) to congested {}."),
+                    UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), packetBuffer.Size(), recipient.ToString());
+                return false;
+            }
+
             RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Sending UNRELIABLE FB Type {} ({} bytes total) to {}."),
-                UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), packetBuffer.size(), recipient.ToString());
+                UDP::S2C::EnumNameS2C_UDP_Payload(flatbufferPayloadType), packetBuffer.Size(), recipient.ToString());
 
-            return m_networkIO->SendData(recipient, packetBuffer.data(), static_cast<uint32_t>(packetBuffer.size()));
+            return SendUnreliableDatagram(recipient, *connState, packetBuffer);
         }
 
         bool UDPPacketHandler::SendAckPacket(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState) {
@@ -353,17 +725,315 @@ namespace RiftForged {
                 recipient.ToString(), connectionState.highestReceivedSequenceNumberFromRemote, connectionState.receivedSequenceBitfield);
 
             uint8_t flags = static_cast<uint8_t>(GamePacketFlag::IS_RELIABLE) | static_cast<uint8_t>(GamePacketFlag::IS_ACK_ONLY);
-            std::vector<uint8_t> packetBuffer = RiftForged::Networking::PrepareOutgoingPacket(
+            PacketBuffer packetBuffer = RiftForged::Networking::PrepareOutgoingPacketBuffer(
                 connectionState,
                 nullptr, 0,
                 flags
             );
 
-            if (packetBuffer.empty()) {
+            if (packetBuffer.Empty()) {
                 RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: SendAckPacket - PrepareOutgoingPacket returned empty for ACK to {}."), recipient.ToString());
                 return false;
             }
-            return m_networkIO->SendData(recipient, packetBuffer.data(), static_cast<uint32_t>(packetBuffer.size()));
+            // ACK-only packets are sent reliably, so they get a retransmit timer like any other reliable packet.
+            if (ConnectionTable::Connection* connection = m_connections.Find(recipient)) {
+                if (&connection->state == &connectionState) {
+                    ScheduleRetransmitTimer(*connection, packetBuffer);
+                }
+            }
+            return SendRawDatagram(recipient, connectionState, packetBuffer);
+        }
+
+        // --- Outbound Batching ---
+
+        void UDPPacketHandler::BeginOutboundBatch() {
+            OutboundBatch& batch = t_outboundBatch;
+            if (batch.owner != nullptr && batch.owner != this) {
+                // Another handler left a batch open on this thread; don't lose its datagrams.
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: BeginOutboundBatch found an open batch from another handler ({} datagrams). Flushing it now."),
+                    batch.entries.size());
+                batch.owner->FlushOutboundBatch();
+            }
+            batch.owner = this;
+        }
+
+        size_t UDPPacketHandler::FlushOutboundBatch() {
+            OutboundBatch& batch = t_outboundBatch;
+            if (batch.owner != this) {
+                return 0;
+            }
+            // Seal every connection's pending aggregate so its messages join this flush.
+            if (!batch.sealingAggregates) {
+                batch.sealingAggregates = true;
+                for (size_t i = 0; i < batch.aggregating.size(); ++i) {
+                    ConnectionTable::Connection& connection = *batch.aggregating[i].connection;
+                    if (connection.generation != batch.aggregating[i].generation) {
+                        continue; // Dropped during the batch; its state (and pending aggregate) was reset
+                    }
+                    connection.aggregateQueued.store(false, std::memory_order_release);
+                    PacketBuffer sealed = RiftForged::Networking::SealAggregatedDatagram(connection.state);
+                    if (!sealed.Empty()) {
+                        SendSealedAggregate(connection, sealed);
+                    }
+                }
+                batch.aggregating.clear();
+                batch.sealingAggregates = false;
+            }
+
+            batch.owner = nullptr;
+            if (batch.entries.empty()) {
+                return 0;
+            }
+
+            // One flush goes out at a time, in order; normally the previous one left long ago. Both the simulation
+            // and the reliability thread flush, so a thread that will use the shared CryptoFlush claims it in the
+            // same critical section that sees it free.
+            WaitForCryptoFlush(batch.pendingSeals > 0);
+
+            if (batch.pendingSeals > 0) {
+                // Hand the batch to the crypto workers, which seal and send it. The entries are swapped, not
+                // copied, and this thread gets the previous flush's (emptied) vector back.
+                CryptoFlush& flush = *m_cryptoFlush;
+                flush.entries.swap(batch.entries);
+                flush.bytes = batch.bytes;
+                flush.sealCount = batch.pendingSeals;
+                flush.workers = std::clamp<size_t>(flush.sealCount / OUTBOUND_CRYPTO_MIN_DATAGRAMS_PER_WORKER_PKT,
+                    1, m_cryptoWorkers->getThreadCount());
+                flush.runsRemaining.store(flush.workers, std::memory_order_relaxed);
+                flush.sealCpuMicros.store(0, std::memory_order_relaxed);
+                flush.sealFailures.store(0, std::memory_order_relaxed);
+                flush.handedOffAt = std::chrono::steady_clock::now();
+                batch.bytes = 0;
+                batch.pendingSeals = 0;
+
+                // Contiguous runs: consecutive datagrams mostly share a connection, and so a key schedule.
+                const size_t count = flush.entries.size();
+                for (size_t run = 0; run < flush.workers; ++run) {
+                    const size_t begin = count * run / flush.workers;
+                    const size_t end = count * (run + 1) / flush.workers;
+                    m_cryptoWorkers->enqueue([this, begin, end]() { SealCryptoFlushRange(begin, end); });
+                }
+                return count;
+            }
+
+            batch.datagrams.clear();
+            batch.datagrams.reserve(batch.entries.size());
+            for (const OutboundBatch::Entry& entry : batch.entries) {
+                batch.datagrams.push_back(OutgoingDatagram{ &entry.recipient, entry.packet.Data(), static_cast<uint32_t>(entry.packet.Size()), &entry.packet });
+            }
+
+            size_t sent = 0;
+            if (m_networkIO) {
+                sent = m_networkIO->SendBatch(batch.datagrams.data(), batch.datagrams.size());
+            }
+            if (sent < batch.datagrams.size()) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: FlushOutboundBatch sent {}/{} datagrams."), sent, batch.datagrams.size());
+            }
+            else {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: FlushOutboundBatch sent {} datagrams ({} bytes)."), sent, batch.bytes);
+            }
+
+            // Drops the batch's buffer references; the vectors keep their capacity for the next tick.
+            batch.entries.clear();
+            batch.bytes = 0;
+            batch.datagrams.clear();
+            return sent;
+        }
+
+        void UDPPacketHandler::SealCryptoFlushRange(size_t begin, size_t end) {
+            CryptoFlush& flush = *m_cryptoFlush;
+            const auto start = std::chrono::steady_clock::now();
+            size_t failures = 0;
+            for (size_t i = begin; i < end; ++i) {
+                OutboundBatch::Entry& entry = flush.entries[i];
+                if (entry.seal.key && !RiftForged::Networking::SealDeferredDatagram(entry.packet, entry.seal)) {
+                    entry.packet = PacketBuffer(); // Never sent in the clear
+                    ++failures;
+                }
+            }
+            flush.sealCpuMicros.fetch_add(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()),
+                std::memory_order_relaxed);
+            flush.sealFailures.fetch_add(failures, std::memory_order_relaxed);
+
+            if (flush.runsRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                SendCryptoFlush();
+            }
+        }
+
+        void UDPPacketHandler::SendCryptoFlush() {
+            CryptoFlush& flush = *m_cryptoFlush;
+            flush.datagrams.clear();
+            flush.datagrams.reserve(flush.entries.size());
+            for (const OutboundBatch::Entry& entry : flush.entries) {
+                if (!entry.packet.Empty()) {
+                    flush.datagrams.push_back(OutgoingDatagram{ &entry.recipient, entry.packet.Data(), static_cast<uint32_t>(entry.packet.Size()), &entry.packet });
+                }
+            }
+
+            size_t sent = 0;
+            if (m_networkIO && !flush.datagrams.empty()) {
+                sent = m_networkIO->SendBatch(flush.datagrams.data(), flush.datagrams.size());
+            }
+            const auto latencyMicros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - flush.handedOffAt).count());
+            const uint64_t sealCpuMicros = flush.sealCpuMicros.load(std::memory_order_relaxed);
+            const size_t failures = flush.sealFailures.load(std::memory_order_relaxed);
+            if (failures > 0) {
+                RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: Failed to seal {}/{} outbound datagrams; they were dropped."), failures, flush.sealCount);
+            }
+            if (sent < flush.datagrams.size()) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: FlushOutboundBatch sent {}/{} datagrams."), sent, flush.datagrams.size());
+            }
+            else {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: FlushOutboundBatch sealed {} datagrams in {} us of CPU on {} workers and sent {} ({} bytes) {} us after the hand-off."),
+                    flush.sealCount, sealCpuMicros, flush.workers, sent, flush.bytes, latencyMicros);
+            }
+
+            // Drops the flush's buffer and key references before the next flush may reuse it.
+            flush.entries.clear();
+            flush.datagrams.clear();
+            {
+                std::lock_guard<std::mutex> lock(m_cryptoFlushMutex);
+                m_cryptoStats.flushes++;
+                m_cryptoStats.datagramsSealed += flush.sealCount - failures;
+                m_cryptoStats.sealFailures += failures;
+                m_cryptoStats.sealCpuMicros += sealCpuMicros;
+                m_cryptoStats.lastFlushDatagramsSealed = flush.sealCount - failures;
+                m_cryptoStats.lastFlushWorkers = flush.workers;
+                m_cryptoStats.lastFlushSealCpuMicros = sealCpuMicros;
+                m_cryptoStats.lastFlushLatencyMicros = latencyMicros;
+                m_cryptoFlushInFlight = false;
+            }
+            m_cryptoFlushCv.notify_all();
+        }
+
+        void UDPPacketHandler::WaitForCryptoFlush(bool claimFlush) {
+            std::unique_lock<std::mutex> lock(m_cryptoFlushMutex);
+            if (m_cryptoFlushInFlight) {
+                const auto stallStart = std::chrono::steady_clock::now();
+                m_cryptoFlushCv.wait(lock, [this] { return !m_cryptoFlushInFlight; });
+                m_cryptoStats.flushStallMicros += static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stallStart).count());
+            }
+            if (claimFlush) {
+                m_cryptoFlushInFlight = true;
+            }
+        }
+
+        OutboundCryptoStats UDPPacketHandler::GetOutboundCryptoStats() {
+            std::lock_guard<std::mutex> lock(m_cryptoFlushMutex);
+            return m_cryptoStats;
+        }
+
+        void UDPPacketHandler::LogPeriodicStats() {
+            const OutboundCryptoStats crypto = GetOutboundCryptoStats();
+            if (crypto.flushes > 0) {
+                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Outbound encryption - {} flush(es), {} datagram(s) sealed, {} failed, {} us seal CPU, {} us flush stalls. Last flush: {} datagram(s) on {} worker(s), {} us CPU, sent {} us after hand-off."),
+                    crypto.flushes, crypto.datagramsSealed, crypto.sealFailures, crypto.sealCpuMicros, crypto.flushStallMicros,
+                    crypto.lastFlushDatagramsSealed, crypto.lastFlushWorkers, crypto.lastFlushSealCpuMicros, crypto.lastFlushLatencyMicros);
+            }
+            const OverloadStats overload = GetOverloadStats();
+            if (overload.overloadEpisodes > 0) {
+                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Overload - {}, tick load {:.2f}, receive queue {:.0f}% full, {}/{} tick(s) overrun, {} episode(s), {} ms overloaded. Shed: {} ping(s), {} movement input(s), {} unreadable."),
+                    overload.overloaded ? "shedding" : "normal", overload.tickLoad, overload.receiveQueueFill * 100.0f,
+                    overload.ticksOverrun, overload.ticks, overload.overloadEpisodes, overload.overloadedMillis,
+                    overload.messagesShed[UDP::C2S::C2S_UDP_Payload_Ping], overload.messagesShed[UDP::C2S::C2S_UDP_Payload_MovementInput],
+                    overload.messagesShed[UDP::C2S::C2S_UDP_Payload_NONE]);
+            }
+        }
+
+        bool UDPPacketHandler::QueueChannelMessage(ConnectionTable::Connection& connection,
+            NetworkChannel channel,
+            const flatbuffers::DetachedBuffer& flatbufferPayload) {
+            OutboundBatch& batch = t_outboundBatch;
+
+            PacketBuffer sealed;
+            if (!RiftForged::Networking::AppendAggregatedMessage(connection.state, flatbufferPayload.data(), flatbufferPayload.size(), channel, sealed)) {
+                // Too large to share a datagram. Seal what is pending first so messages leave in order.
+                PacketBuffer pending = RiftForged::Networking::SealAggregatedDatagram(connection.state);
+                if (!pending.Empty()) {
+                    SendSealedAggregate(connection, pending);
+                }
+                return false;
+            }
+            if (!sealed.Empty()) {
+                SendSealedAggregate(connection, sealed);
+            }
+            if (batch.owner != this) {
+                // No batch to wait for: the message leaves now, in a datagram of its own.
+                PacketBuffer single = RiftForged::Networking::SealAggregatedDatagram(connection.state);
+                if (!single.Empty()) {
+                    SendSealedAggregate(connection, single);
+                }
+                return true;
+            }
+            if (!connection.aggregateQueued.exchange(true, std::memory_order_acq_rel)) {
+                batch.aggregating.push_back(OutboundBatch::AggregatingConnection{ &connection, connection.generation });
+            }
+            return true;
+        }
+
+        void UDPPacketHandler::SendSealedAggregate(ConnectionTable::Connection& connection, PacketBuffer& packet) {
+            GamePacketHeader header;
+            memcpy(&header, packet.Data(), GetGamePacketHeaderSize());
+            const bool isReliable = HasFlag(header.flags, GamePacketFlag::IS_RELIABLE);
+            if (!RiftForged::Networking::AdmitOutgoingDatagram(connection.state, packet.Size(), isReliable, std::chrono::steady_clock::now())) {
+                RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Shedding unreliable aggregated datagram ({} bytes) to congested {}."),
+                    packet.Size(), connection.endpoint.ToString());
+                return;
+            }
+            RF_NETWORK_TRACE(FMT_STRING("UDPPacketHandler: Sending aggregated datagram ({} bytes, Seq: {}) to {}."),
+                packet.Size(), header.sequenceNumber, connection.endpoint.ToString());
+            if (isReliable) {
+                ScheduleRetransmitTimer(connection, packet);
+                SendRawDatagram(connection.endpoint, connection.state, packet);
+            }
+            else {
+                SendUnreliableDatagram(connection.endpoint, connection.state, packet);
+            }
+        }
+
+        bool UDPPacketHandler::SendUnreliableDatagram(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState, PacketBuffer& packet) {
+            PacketBuffer parity;
+            const bool groupComplete = RiftForged::Networking::ProtectUnreliableDatagram(connectionState, packet, parity);
+            const bool sent = SendRawDatagram(recipient, connectionState, packet);
+            // Parity is droppable overhead: it yields to congestion like any unreliable datagram.
+            if (groupComplete && RiftForged::Networking::AdmitOutgoingDatagram(connectionState, parity.Size(), false, std::chrono::steady_clock::now())) {
+                SendRawDatagram(recipient, connectionState, parity);
+            }
+            return sent;
+        }
+
+        bool UDPPacketHandler::SendRawDatagram(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState, const PacketBuffer& packet) {
+            // A connection on compact headers or encryption gets a copy with its header rewritten and/or its
+            // payload sealed; the original is left intact for retransmission.
+            OutboundBatch& batch = t_outboundBatch;
+            if (batch.owner != this) {
+                const PacketBuffer wirePacket = RiftForged::Networking::PrepareOutgoingDatagramForWire(connectionState, packet);
+                if (wirePacket.Empty()) {
+                    return false;
+                }
+                return m_networkIO->SendPacket(recipient, wirePacket);
+            }
+
+            // In a batch, encryption is left to the crypto workers at flush time.
+            DeferredDatagramSeal seal;
+            PacketBuffer wirePacket = RiftForged::Networking::PrepareOutgoingDatagramForWire(connectionState, packet, &seal);
+            if (wirePacket.Empty()) {
+                return false;
+            }
+            if (seal.key) {
+                batch.pendingSeals++;
+            }
+            batch.bytes += wirePacket.Size();
+            batch.entries.push_back(OutboundBatch::Entry{ recipient, std::move(wirePacket), std::move(seal) });
+
+            if (batch.entries.size() >= OUTBOUND_BATCH_MAX_DATAGRAMS_PKT) {
+                FlushOutboundBatch();
+                batch.owner = this; // Keep the batch open for the rest of the caller's work.
+            }
+            return true;
         }
 
         // --- Internal Helper for Handling Responses ---
@@ -386,14 +1056,14 @@ namespace RiftForged {
                 RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Broadcasting S2C_Response MsgType {} to {} clients."),
                     UDP::S2C::EnumNameS2C_UDP_Payload(payloadType), all_clients.size());
                 for (const auto& client_ep : all_clients) {
-                    if (client_ep.ipAddress.empty() || client_ep.port == 0) continue;
+                    if (!client_ep.IsValid()) continue;
                     // Assuming reliable for most broadcast game messages. Adjust flags if needed.
                     SendReliablePacket(client_ep, payloadType, payloadData);
                 }
             }
             else {
                 NetworkEndpoint targetRecipient = response.specific_recipient;
-                if (!targetRecipient.ipAddress.empty() && targetRecipient.port != 0) {
+                if (targetRecipient.IsValid()) {
                     // Assuming reliable for direct responses to clients. Adjust flags if needed.
                     SendReliablePacket(targetRecipient, payloadType, payloadData);
                 }
@@ -404,117 +1074,288 @@ namespace RiftForged {
             }
         }
 
-        // --- Private Reliability Protocol Methods ---
+        void UDPPacketHandler::SetAckDelay(std::chrono::milliseconds ackDelay) {
+            const int ackDelayMs = static_cast<int>(std::max<long long>(0, ackDelay.count()));
+            m_ackDelayMs.store(ackDelayMs, std::memory_order_relaxed);
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: ACK delay set to {} ms."), ackDelayMs);
+        }
+
+        void UDPPacketHandler::SetCongestionControlAlgorithm(CongestionControlAlgorithm algorithm) {
+            m_congestionControlAlgorithm.store(algorithm, std::memory_order_relaxed);
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Congestion control algorithm set to {} for new connections."),
+                CreateCongestionController(algorithm)->GetName());
+        }
+
+        bool UDPPacketHandler::GetConnectionTransferStats(const NetworkEndpoint& endpoint, ConnectionTransferStats& outStats) {
+            ConnectionTable::Connection* connection = m_connections.Find(endpoint);
+            if (!connection) {
+                return false;
+            }
+            outStats = connection->state.GetTransferStats();
+            return true;
+        }
+
+        void UDPPacketHandler::SetExplicitNacksEnabled(bool enabled) {
+            m_explicitNacksEnabled.store(enabled, std::memory_order_relaxed);
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Explicit NACKs {}."), enabled ? "enabled" : "disabled");
+        }
+
+        void UDPPacketHandler::SetUnreliableFecMode(UnreliableFecMode mode) {
+            m_unreliableFecMode.store(mode, std::memory_order_relaxed);
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Unreliable FEC mode set to {}."),
+                mode == UnreliableFecMode::On ? "On" : (mode == UnreliableFecMode::Auto ? "Auto" : "Off"));
+        }
+
+        void UDPPacketHandler::SetIngressRateLimit(UDP::C2S::C2S_UDP_Payload payloadType, float messagesPerSecond, uint32_t burst) {
+            if (static_cast<size_t>(payloadType) >= INGRESS_MESSAGE_KINDS) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Cannot set ingress rate limit for unknown payload type {}."), static_cast<int>(payloadType));
+                return;
+            }
+            m_ingressRatesPerSec[payloadType].store(std::max(messagesPerSecond, 0.0f), std::memory_order_relaxed);
+            m_ingressBursts[payloadType].store(burst, std::memory_order_relaxed);
+            RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Ingress rate limit for {} set to {} msg/s (burst {})."),
+                UDP::C2S::EnumNameC2S_UDP_Payload(payloadType), messagesPerSecond, burst);
+        }
 
-        std::shared_ptr<ReliableConnectionState> UDPPacketHandler::GetOrCreateReliabilityState(const NetworkEndpoint& endpoint) {
-            std::lock_guard<std::mutex> lock(m_reliabilityStatesMutex);
-            auto it = m_reliabilityStates.find(endpoint);
-            if (it != m_reliabilityStates.end()) {
-                return it->second;
+        void UDPPacketHandler::ReportSimulationTick(std::chrono::steady_clock::duration processingTime, std::chrono::steady_clock::duration tickInterval) {
+            const float receiveQueueFill = m_networkIO ? m_networkIO->GetReceiveQueueFill() : 0.0f;
+            if (!m_overloadDetector.RecordTick(processingTime, tickInterval, receiveQueueFill, std::chrono::steady_clock::now())) {
+                return;
+            }
+            const OverloadStats stats = m_overloadDetector.GetStats();
+            if (stats.overloaded) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Server overloaded (tick load {:.2f}, {} overrun(s), receive queue {:.0f}% full). Shedding pings and redundant movement input."),
+                    stats.tickLoad, stats.ticksOverrun, stats.receiveQueueFill * 100.0f);
             }
             else {
-                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Creating new ReliableConnectionState for endpoint: {}."), endpoint.ToString());
-                try {
-                    auto newState = std::make_shared<ReliableConnectionState>();
-                    m_reliabilityStates[endpoint] = newState;
-                    m_endpointLastSeenTime[endpoint] = std::chrono::steady_clock::now(); // Initialize last seen time
-                    return newState;
+                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Overload cleared (tick load {:.2f}, receive queue {:.0f}% full). Shed so far: {} ping(s), {} movement input(s)."),
+                    stats.tickLoad, stats.receiveQueueFill * 100.0f,
+                    stats.messagesShed[UDP::C2S::C2S_UDP_Payload_Ping], stats.messagesShed[UDP::C2S::C2S_UDP_Payload_MovementInput]);
+            }
+        }
+
+        bool UDPPacketHandler::EnablePacketEncryption(const NetworkEndpoint& endpoint, const SecureConnectionContext& handshakeContext,
+            CryptoManager::AeadCipher cipher) {
+            if (!PACKET_ENCRYPTION_ENABLED_PKT) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Packet encryption is disabled; {} stays unencrypted."), endpoint.ToString());
+                return false;
+            }
+            ConnectionTable::Connection* connection = m_connections.Find(endpoint);
+            if (!connection) {
+                RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Cannot enable encryption for {}: no connection."), endpoint.ToString());
+                return false;
+            }
+            // Datagrams for the connection are sealed on the crypto workers from its next flush on.
+            std::call_once(m_cryptoWorkersStarted, [this]() {
+                m_cryptoWorkers = std::make_unique<RiftForged::Utils::Threading::TaskThreadPool>(OUTBOUND_CRYPTO_WORKER_THREADS_PKT);
+                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Started {} outbound crypto worker(s)."), OUTBOUND_CRYPTO_WORKER_THREADS_PKT);
+                });
+            RiftForged::Networking::EnablePacketEncryption(connection->state, handshakeContext, cipher);
+            return true;
+        }
+
+        // --- Private Reliability Protocol Methods ---
+
+        ConnectionTable::Connection* UDPPacketHandler::GetOrCreateConnection(const NetworkEndpoint& endpoint) {
+            bool created = false;
+            ConnectionTable::Connection* connection = m_connections.FindOrCreate(endpoint, &created);
+            if (!connection) {
+                // ConnectionTable has already logged why (table full or allocation failure).
+                return nullptr;
+            }
+            if (created) {
+                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Created new ReliableConnectionState for endpoint: {} ({} active)."),
+                    endpoint.ToString(), m_connections.Size());
+                connection->state.SetExplicitNacksEnabled(m_explicitNacksEnabled.load(std::memory_order_relaxed));
+                connection->state.SetUnreliableFecMode(m_unreliableFecMode.load(std::memory_order_relaxed));
+                const CongestionControlAlgorithm algorithm = m_congestionControlAlgorithm.load(std::memory_order_relaxed);
+                if (algorithm != CongestionControlAlgorithm::AIMD) {
+                    connection->state.SetCongestionControlAlgorithm(algorithm);
+                }
+                ReliabilityTimer staleTimer;
+                staleTimer.endpoint = endpoint;
+                staleTimer.generation = connection->generation;
+                staleTimer.kind = ReliabilityTimer::Kind::Stale;
+                ScheduleTimer(std::chrono::steady_clock::now() + std::chrono::seconds(STALE_CONNECTION_TIMEOUT_SECONDS_PKT), staleTimer);
+                if (m_networkIO && m_networkIO->SupportsPathMtuProbing()) {
+                    ReliabilityTimer pathMtuTimer = staleTimer;
+                    pathMtuTimer.kind = ReliabilityTimer::Kind::PathMtu;
+                    ScheduleTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(PMTU_FIRST_PROBE_DELAY_MS), pathMtuTimer);
+                }
+            }
+            return connection;
+        }
+
+        void UDPPacketHandler::ScheduleTimer(std::chrono::steady_clock::time_point deadline, const ReliabilityTimer& timer) {
+            if (m_timerWheel.Schedule(deadline, timer)) {
+                // Earlier than the reliability thread's planned wake-up; let it re-plan.
+                {
+                    std::lock_guard<std::mutex> lock(m_timerWakeMutex);
+                    m_timerWakePending = true;
+                }
+                m_timerWakeCv.notify_one();
+            }
+        }
+
+        void UDPPacketHandler::ScheduleRetransmitTimer(const ConnectionTable::Connection& connection, const PacketBuffer& packet) {
+            if (packet.Size() < GetGamePacketHeaderSize()) {
+                return;
+            }
+            GamePacketHeader header;
+            memcpy(&header, packet.Data(), GetGamePacketHeaderSize());
+
+            ReliabilityTimer timer;
+            timer.endpoint = connection.endpoint;
+            timer.generation = connection.generation;
+            timer.sequenceNumber = header.sequenceNumber;
+            timer.kind = ReliabilityTimer::Kind::Retransmit;
+            const auto rto = std::chrono::duration<float, std::milli>(connection.state.GetRetransmissionTimeoutMs());
+            ScheduleTimer(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(rto), timer);
+        }
+
+        void UDPPacketHandler::ScheduleAckTimer(ConnectionTable::Connection& connection) {
+            if (connection.ackTimerArmed.exchange(true, std::memory_order_acq_rel)) {
+                return; // One delayed ACK per connection is enough; it carries the latest ack bits when it fires.
+            }
+            ReliabilityTimer timer;
+            timer.endpoint = connection.endpoint;
+            timer.generation = connection.generation;
+            timer.kind = ReliabilityTimer::Kind::Ack;
+            ScheduleTimer(std::chrono::steady_clock::now() + GetAckDelay(), timer);
+        }
+
+        void UDPPacketHandler::HandleExpiredTimer(const ReliabilityTimer& timer,
+            std::chrono::steady_clock::time_point now,
+            std::vector<NetworkEndpoint>& clientsToDrop) {
+            ConnectionTable::Connection* connection = m_connections.Find(timer.endpoint);
+            if (!connection || connection->generation != timer.generation) {
+                return; // Connection was dropped (or its slot reused) after the timer was armed.
+            }
+            ReliableConnectionState& state = connection->state;
+
+            switch (timer.kind) {
+            case ReliabilityTimer::Kind::Retransmit:
+            {
+                PacketBuffer packet;
+                std::chrono::steady_clock::time_point nextDeadline;
+                switch (RiftForged::Networking::ProcessRetransmitTimer(state, timer.sequenceNumber, now, packet, nextDeadline)) {
+                case RetransmitTimerResult::Retransmitted:
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Retransmitting packet ({} bytes) to {}."), packet.Size(), timer.endpoint.ToString());
+                    SendRawDatagram(timer.endpoint, state, packet);
+                    ScheduleTimer(nextDeadline, timer);
+                    break;
+                case RetransmitTimerResult::NotYetDue:
+                    ScheduleTimer(nextDeadline, timer);
+                    break;
+                case RetransmitTimerResult::ConnectionDropped:
+                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Endpoint {} flagged for drop by MAX RETRIES."), timer.endpoint.ToString());
+                    clientsToDrop.push_back(timer.endpoint);
+                    break;
+                case RetransmitTimerResult::Acknowledged:
+                    break;
+                }
+                break;
+            }
+            case ReliabilityTimer::Kind::Ack:
+            {
+                connection->ackTimerArmed.store(false, std::memory_order_release);
+                const bool sent = RiftForged::Networking::TrySendAckOnlyPacketBuffer(
+                    state,
+                    now,
+                    [this, connection](const PacketBuffer& ackPacket) {
+                        // SendRawDatagram only appends to this thread's outbound batch here.
+                        SendRawDatagram(connection->endpoint, connection->state, ackPacket);
+                        ScheduleRetransmitTimer(*connection, ackPacket);
+                    },
+                    static_cast<float>(m_ackDelayMs.load(std::memory_order_relaxed))
+                );
+                if (!sent && state.HasPendingAck()) {
+                    // We sent something recently, so the ACK delay restarts from that send.
+                    ScheduleAckTimer(*connection);
+                }
+                break;
+            }
+            case ReliabilityTimer::Kind::Stale:
+            {
+                std::chrono::steady_clock::time_point nextCheck;
+                bool isStale = false;
+                {
+                    std::lock_guard<std::mutex> lock(state.internalStateMutex);
+                    const auto staleTimeout = std::chrono::seconds(STALE_CONNECTION_TIMEOUT_SECONDS_PKT);
+                    if (state.lastPacketReceivedTimeFromRemote == std::chrono::steady_clock::time_point::min()) {
+                        isStale = true; // Nothing ever received; 'now - min()' would overflow
+                    }
+                    else if (now - state.lastPacketReceivedTimeFromRemote > staleTimeout &&
+                        state.unacknowledgedSentPackets.empty()) { // Only if we are not waiting for their ACKs
+                        isStale = true;
+                    }
+                    else if (now - state.lastPacketReceivedTimeFromRemote > staleTimeout) {
+                        nextCheck = now + staleTimeout; // Still waiting on our in-flight packets; check again later.
+                    }
+                    else {
+                        nextCheck = state.lastPacketReceivedTimeFromRemote + staleTimeout + std::chrono::seconds(1);
+                    }
                 }
-                catch (const std::bad_alloc& e) {
-                    RF_NETWORK_CRITICAL(FMT_STRING("UDPPacketHandler: Failed to allocate ReliableConnectionState for {}: {}"), endpoint.ToString(), e.what());
-                    return nullptr;
+                if (isStale) {
+                    RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Endpoint {} flagged for drop due to STALENESS."), timer.endpoint.ToString());
+                    clientsToDrop.push_back(timer.endpoint);
+                }
+                else {
+                    ScheduleTimer(nextCheck, timer);
+                }
+                break;
+            }
+            case ReliabilityTimer::Kind::PathMtu:
+            {
+                PacketBuffer probe;
+                std::chrono::steady_clock::time_point nextDeadline;
+                switch (RiftForged::Networking::ProcessPathMtuTimer(state, now, probe, nextDeadline)) {
+                case PathMtuTimerResult::ProbeReady:
+                    SendRawDatagram(timer.endpoint, state, probe); // Never FEC-protected: it must keep its size.
+                    ScheduleTimer(nextDeadline, timer);
+                    break;
+                case PathMtuTimerResult::Wait:
+                    ScheduleTimer(nextDeadline, timer);
+                    break;
+                case PathMtuTimerResult::Stopped:
+                    break;
                 }
+                break;
+            }
             }
         }
 
         void UDPPacketHandler::ReliabilityManagementThread() {
             RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: ReliabilityManagementThread started."));
+            std::vector<ReliabilityTimer> expiredTimers;
+            std::vector<NetworkEndpoint> clientsToDrop;
             std::vector<NetworkEndpoint> clientsToNotifyDropped;
+            auto nextStatsLogTime = std::chrono::steady_clock::now() + std::chrono::seconds(HANDLER_STATS_LOG_INTERVAL_SECONDS_PKT);
 
             while (m_isRunning.load(std::memory_order_acquire)) {
-                auto currentTime = std::chrono::steady_clock::now();
+                const auto currentTime = std::chrono::steady_clock::now();
+                if (currentTime >= nextStatsLogTime) {
+                    LogPeriodicStats();
+                    nextStatsLogTime = currentTime + std::chrono::seconds(HANDLER_STATS_LOG_INTERVAL_SECONDS_PKT);
+                }
+                expiredTimers.clear();
+                clientsToDrop.clear();
                 clientsToNotifyDropped.clear();
 
-                std::vector<std::pair<NetworkEndpoint, std::vector<uint8_t>>> packetsToResendList;
-                std::vector<NetworkEndpoint> endpointsNeedingExplicitAck;
+                // Only connections with an expired timer are touched; idle connections cost nothing here.
+                m_timerWheel.Advance(currentTime, expiredTimers);
 
-                {
-                    std::lock_guard<std::mutex> lock(m_reliabilityStatesMutex);
-                    for (auto it = m_reliabilityStates.begin(); it != m_reliabilityStates.end(); /* manual increment/erase */) {
-                        const NetworkEndpoint& endpoint = it->first;
-                        std::shared_ptr<ReliableConnectionState> state = it->second;
-                        bool dropClientThisPass = false;
-
-                        // Must check if state is valid, though make_shared should succeed or throw.
-                        if (!state) {
-                            RF_NETWORK_ERROR(FMT_STRING("UDPPacketHandler: Null ReliableConnectionState found in map for endpoint {}. Removing entry."), endpoint.ToString());
-                            m_endpointLastSeenTime.erase(endpoint);
-                            it = m_reliabilityStates.erase(it);
-                            continue;
-                        }
-
-                        // 1. Check for retransmissions
-                        std::vector<std::vector<uint8_t>> retransmitsForEndpoint =
-                            RiftForged::Networking::GetPacketsForRetransmission(*state, currentTime);
-                        for (const auto& pktData : retransmitsForEndpoint) {
-                            packetsToResendList.emplace_back(endpoint, pktData);
-                        }
-                        if (state->connectionDroppedByMaxRetries) {
-                            RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Endpoint {} flagged for drop by MAX RETRIES."), endpoint.ToString());
-                            dropClientThisPass = true;
-                        }
-
-                        // 2. Check for stale connections
-                        if (!dropClientThisPass) {
-                            if (std::chrono::duration_cast<std::chrono::seconds>(currentTime - state->lastPacketReceivedTimeFromRemote).count() > STALE_CONNECTION_TIMEOUT_SECONDS_PKT &&
-                                state->unacknowledgedSentPackets.empty()) { // Only if we are not waiting for their ACKs
-                                RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: Endpoint {} flagged for drop due to STALENESS."), endpoint.ToString());
-                                dropClientThisPass = true;
-                            }
-                        }
-
-                        // 3. Check for pending explicit ACKs
-                        if (!dropClientThisPass && state->hasPendingAckToSend) {
-                            endpointsNeedingExplicitAck.push_back(endpoint);
-                        }
-
-                        if (dropClientThisPass) {
-                            clientsToNotifyDropped.push_back(endpoint);
-                            m_endpointLastSeenTime.erase(endpoint);
-                            it = m_reliabilityStates.erase(it);
-                        }
-                        else {
-                            ++it;
-                        }
-                    }
-                } // Mutex m_reliabilityStatesMutex released
-
-                // Perform network sends outside the main state lock
-                for (const auto& pair : packetsToResendList) {
-                    RF_NETWORK_WARN(FMT_STRING("UDPPacketHandler: Retransmitting packet ({} bytes) to {}."), pair.second.size(), pair.first.ToString());
-                    m_networkIO->SendData(pair.first, pair.second.data(), static_cast<uint32_t>(pair.second.size()));
-                }
-
-                for (const auto& endpoint : endpointsNeedingExplicitAck) {
-                    std::shared_ptr<ReliableConnectionState> state;
-                    {
-                        std::lock_guard<std::mutex> lock(m_reliabilityStatesMutex);
-                        auto it_find = m_reliabilityStates.find(endpoint);
-                        if (it_find != m_reliabilityStates.end()) {
-                            state = it_find->second;
-                        }
-                    }
-                    if (state) {
-                        RiftForged::Networking::TrySendAckOnlyPacket(
-                            *state,
-                            currentTime,
-                            [this, &endpoint](const std::vector<uint8_t>& packetData) {
-                                // This lambda is called by TrySendAckOnlyPacket, which itself already holds the
-                                // ReliableConnectionState's internal mutex when calling PrepareOutgoingPacketUnlocked.
-                                // The actual SendData call is thread-safe.
-                                m_networkIO->SendData(endpoint, packetData.data(), static_cast<uint32_t>(packetData.size()));
-                            }
-                        );
+                // Retransmits and explicit ACKs of this pass go out as one batch.
+                BeginOutboundBatch();
+                for (const ReliabilityTimer& timer : expiredTimers) {
+                    HandleExpiredTimer(timer, currentTime, clientsToDrop);
+                }
+                FlushOutboundBatch();
+
+                for (const auto& droppedEndpoint : clientsToDrop) {
+                    // The same connection can be flagged twice in one pass (e.g. two packets hit max retries).
+                    if (m_connections.Remove(droppedEndpoint)) {
+                        clientsToNotifyDropped.push_back(droppedEndpoint);
                     }
                 }
 
@@ -524,7 +1365,14 @@ namespace RiftForged {
                         m_gameServerEngine.OnClientDisconnected(droppedEndpoint);
                     }
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(RELIABILITY_THREAD_SLEEP_MS_PKT));
+
+                // Sleep until the next timer is due, or until a sender schedules an earlier one (or Stop()).
+                const auto wakeTime = m_timerWheel.NextWakeTime(std::chrono::milliseconds(RELIABILITY_THREAD_SLEEP_MS_PKT));
+                std::unique_lock<std::mutex> lock(m_timerWakeMutex);
+                m_timerWakeCv.wait_until(lock, wakeTime, [this] {
+                    return m_timerWakePending || !m_isRunning.load(std::memory_order_acquire);
+                    });
+                m_timerWakePending = false;
             }
             RF_NETWORK_INFO(FMT_STRING("UDPPacketHandler: ReliabilityManagementThread gracefully exited."));
         }
@@ -10,7 +10,13 @@
 #include "NetworkEndpoint.h"       // For representing remote client addresses
 #include "GamePacketHeader.h"      // Defines GamePacketHeader structure (now simplified, no app MessageType)
 #include "UDPReliabilityProtocol.h"// Defines ReliableConnectionState and associated reliability logic/types
+#include "ConnectionTable.h"       // Per-endpoint connection state storage
+#include "ConnectionCookie.h"      // Stateless cookies for senders without a connection
+#include "OverloadDetector.h"      // Inbound shedding while the server is overloaded
+#include "CongestionController.h"  // For CongestionControlAlgorithm, ConnectionTransferStats
+#include "TimerWheel.h"            // Retransmit / ACK / staleness timers
 #include "NetworkCommon.h"         // For common network types like S2C_Response (now uses FB S2C payload type)
+#include "../Utils/ThreadPool.h"   // For TaskThreadPool (outbound batch encryption)
 
 // Include FlatBuffers generated headers that define payload enums
 #include "../FlatBuffers/V0.0.4/riftforged_c2s_udp_messages_generated.h" // For C2S_UDP_Payload
@@ -18,11 +24,13 @@
 
 #include <string>
 #include <vector>
+#include <array>       // For the per-payload-type ingress rate limits
 #include <map>
 #include <memory>      // For std::shared_ptr
 #include <mutex>       // For std::mutex
 #include <thread>      // For std::thread (reliability thread)
 #include <atomic>      // For std::atomic_bool
+#include <condition_variable> // For waking the reliability thread when an earlier timer is scheduled
 #include <optional>    // For std::optional (handling responses from MessageHandler)
 #include <chrono>      // For std::chrono::steady_clock
 
@@ -39,14 +47,37 @@ namespace RiftForged {
 }
 
 // Constants for the reliability protocol managed by this PacketHandler.
-const int RELIABILITY_THREAD_SLEEP_MS_PKT = 20; // How often the reliability thread wakes up.
+const int RELIABILITY_THREAD_SLEEP_MS_PKT = 100; // Longest the reliability thread sleeps when no timer is due sooner.
+const int RELIABILITY_TIMER_TICK_MS_PKT = 1;    // Resolution of the reliability timer wheel.
+const int DEFAULT_ACK_DELAY_MS_PKT = 10;        // Max delay before a standalone ACK is sent for received reliable data.
 // DEFAULT_RTO_MS_PKT and DEFAULT_MAX_RETRIES_PKT are now defined/used in UDPReliabilityProtocol.h
 const int STALE_CONNECTION_TIMEOUT_SECONDS_PKT = 60; // Duration of inactivity before a connection is considered stale.
+const size_t OUTBOUND_BATCH_MAX_DATAGRAMS_PKT = 4096; // An open outbound batch is flushed early once it holds this many datagrams.
+const bool PACKET_ENCRYPTION_ENABLED_PKT = false;     // No key exchange runs over UDP yet; until one calls EnablePacketEncryption, it refuses.
+const size_t OUTBOUND_CRYPTO_WORKER_THREADS_PKT = 2;  // Threads that seal and send encrypted outbound batches.
+const size_t OUTBOUND_CRYPTO_MIN_DATAGRAMS_PER_WORKER_PKT = 64; // A flush only spreads over more workers once each gets this many datagrams to seal.
+const int HANDLER_STATS_LOG_INTERVAL_SECONDS_PKT = 30; // How often the reliability thread logs handler-wide counters.
+const float OVERLOAD_MOVEMENT_RATE_FACTOR_PKT = 0.25f; // While overloaded, movement input is admitted at this fraction of its ingress rate, with no burst.
 
 
 namespace RiftForged {
     namespace Networking {
 
+        // Encryption of outbound batches (see FlushOutboundBatch): the most recent flush that had datagrams to
+        // seal, and totals since start. CPU time is summed over the workers that sealed the flush; latency runs
+        // from the hand-off to the crypto workers until the network layer has the sealed batch.
+        struct OutboundCryptoStats {
+            uint64_t flushes = 0;
+            uint64_t datagramsSealed = 0;
+            uint64_t sealFailures = 0;           // Datagrams dropped because sealing failed
+            uint64_t sealCpuMicros = 0;
+            uint64_t flushStallMicros = 0;       // Time flushing threads waited for the previous flush to go out
+            size_t lastFlushDatagramsSealed = 0;
+            size_t lastFlushWorkers = 0;
+            uint64_t lastFlushSealCpuMicros = 0;
+            uint64_t lastFlushLatencyMicros = 0;
+        };
+
         class UDPPacketHandler : public INetworkIOEvents {
         public:
             /**
@@ -118,6 +149,7 @@ namespace RiftForged {
             /**
              * @brief Sends a packet reliably to a specific recipient.
              * Handles adding reliability headers and queuing for potential retransmission.
+             * Payloads larger than the connection's max datagram size are sent as fragments.
              * @param recipient The target client endpoint.
              * @param flatbufferPayloadType The FlatBuffer payload's type (e.g., S2C_UDP_Payload_EntityStateUpdate).
              * @param flatbufferPayload The serialized application payload (FlatBuffer bytes).
@@ -151,16 +183,183 @@ namespace RiftForged {
              */
             bool SendAckPacket(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState);
 
+            /**
+             * @brief Sets the max delay before a standalone ACK is sent when no outgoing packet
+             * piggybacks it. Values below MIN_ACK_DELAY_MS are honoured as-is. Takes effect for new ACKs.
+             */
+            void SetAckDelay(std::chrono::milliseconds ackDelay);
+            std::chrono::milliseconds GetAckDelay() const {
+                return std::chrono::milliseconds(m_ackDelayMs.load(std::memory_order_relaxed));
+            }
+
+            /**
+             * @brief Enables or disables explicit NACKs (on by default). When enabled, a gap in a peer's
+             * reliable packets is reported at once so the peer can fast-retransmit the missing one instead
+             * of waiting for its RTO. Applies to connections created afterwards.
+             */
+            void SetExplicitNacksEnabled(bool enabled);
+            bool GetExplicitNacksEnabled() const {
+                return m_explicitNacksEnabled.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Selects the congestion control algorithm (AIMD by default) for connections created afterwards.
+             */
+            void SetCongestionControlAlgorithm(CongestionControlAlgorithm algorithm);
+
+            /**
+             * @brief Selects forward error correction for unreliable datagrams (Off by default) for connections
+             * created afterwards. Auto protects a connection's unreliable datagrams with XOR parity only while
+             * its measured loss rate is high; On always does.
+             */
+            void SetUnreliableFecMode(UnreliableFecMode mode);
+
+            /**
+             * @brief Limits how many C2S messages of one payload type each endpoint may send: every connection
+             * has a token bucket per type, refilled at messagesPerSecond and holding up to burst messages.
+             * Messages over the limit are dropped before FlatBuffer verification and counted in the
+             * connection's messagesRateLimited. Only messages that arrived unreliably are limited: a reliable
+             * one has been ACKed by the time it is dispatched, so dropping it would lose it for good. A rate
+             * of 0 removes the limit. Takes effect at once.
+             */
+            void SetIngressRateLimit(UDP::C2S::C2S_UDP_Payload payloadType, float messagesPerSecond, uint32_t burst);
+
+            /**
+             * @brief Feeds the overload detector, once per simulation tick, with the tick's processing time and
+             * the network layer's receive queue fill. While the server is overloaded, received pings and
+             * messages whose type can't be read are dropped, and movement input (where only the newest counts)
+             * is thinned to OVERLOAD_MOVEMENT_RATE_FACTOR_PKT of its ingress rate; joins, combat and turning are
+             * kept. Only messages that arrived unreliably are shed, since reliable ones were ACKed already.
+             * Disconnects never pass through dispatch and are unaffected.
+             */
+            void ReportSimulationTick(std::chrono::steady_clock::duration processingTime, std::chrono::steady_clock::duration tickInterval);
+
+            /**
+             * @brief Returns whether the server is overloaded, the inputs that decided it, and the messages shed
+             * per C2S payload type since start. Logged every HANDLER_STATS_LOG_INTERVAL_SECONDS_PKT once the
+             * server has been overloaded at least once; entering and leaving overload are logged as they happen.
+             */
+            OverloadStats GetOverloadStats() const { return m_overloadDetector.GetStats(); }
+
+            /**
+             * @brief Copies the transfer counters and congestion state (window, bytes in flight, pacing rate,
+             * goodput) of one connection.
+             * @return False if there is no connection for the endpoint.
+             */
+            bool GetConnectionTransferStats(const NetworkEndpoint& endpoint, ConnectionTransferStats& outStats);
+
+            /**
+             * @brief Turns on AEAD for a connection once a handshake has derived its session keys: from then on
+             * every datagram to and from the endpoint is sealed, and unsealed or replayed ones are dropped.
+             * The cipher must match the peer's; by default AES-256-GCM where the CPU has hardware AES.
+             * Gated by PACKET_ENCRYPTION_ENABLED_PKT until the UDP handshake that supplies the keys exists.
+             * @return False if encryption is disabled or there is no connection for the endpoint.
+             */
+            bool EnablePacketEncryption(const NetworkEndpoint& endpoint, const SecureConnectionContext& handshakeContext,
+                CryptoManager::AeadCipher cipher = CryptoManager::SelectPreferredCipher());
+
+            // --- Outbound Batching ---
+            // While a batch is open on the calling thread, every datagram this handler sends from that
+            // thread is copied into a per-thread queue instead of going straight to INetworkIO::SendData.
+            // FlushOutboundBatch hands the whole queue to INetworkIO::SendBatch (sendmmsg/GSO on Linux).
+            // Sends made from other threads (e.g. IO threads answering pings) are unaffected.
+            // While the batch is open, SendReliablePacket/SendUnreliablePacket also pack each connection's
+            // messages into shared IS_AGGREGATE datagrams (up to its max datagram size); the last partly
+            // filled datagram of every connection is sealed by FlushOutboundBatch. Outside a batch each
+            // message still travels in an aggregate of its own, so it keeps its NetworkChannel.
+            // Datagrams queued for encrypted connections are numbered in send order but not encrypted: the
+            // flush hands the whole queue to the crypto workers, which seal it in place, split in contiguous
+            // runs across OUTBOUND_CRYPTO_WORKER_THREADS_PKT threads, and then send it. The flushing thread
+            // (the simulation thread, at the end of a tick) does not wait for that; only the next flush waits
+            // if the previous one is still going out, so batches leave in order.
+
+            /**
+             * @brief Opens an outbound batch on the calling thread (e.g. at the start of a simulation tick).
+             */
+            void BeginOutboundBatch();
+
+            /**
+             * @brief Closes the calling thread's outbound batch and sends everything queued in it, or hands
+             * it to the crypto workers if any of it must be sealed.
+             * @return The number of datagrams accepted by the network layer, or handed to the crypto workers.
+             */
+            size_t FlushOutboundBatch();
+
+            /**
+             * @brief Returns the time spent encrypting outbound batches, per flush (i.e. per tick) and in total.
+             */
+            OutboundCryptoStats GetOutboundCryptoStats();
+
         private:
             // --- Internal Reliability Protocol Methods ---
 
-            void ReliabilityManagementThread(); // Manages retransmissions, timeouts, sending pending ACKs.
+            void ReliabilityManagementThread(); // Fires retransmit, delayed-ACK, staleness and path MTU timers.
+            // Logs handler-wide counters (outbound encryption, overload shedding), every HANDLER_STATS_LOG_INTERVAL_SECONDS_PKT.
+            void LogPeriodicStats();
+
+            // Work items for the reliability thread, expired by m_timerWheel.
+            // The generation ties a timer to one use of a ConnectionTable slot; timers for a removed
+            // or recycled connection are ignored when they fire.
+            struct ReliabilityTimer {
+                enum class Kind : uint8_t { Retransmit, Ack, Stale, PathMtu };
+                NetworkEndpoint endpoint;
+                uint32_t generation = 0;
+                SequenceNumber sequenceNumber = 0; // Retransmit only
+                Kind kind = Kind::Retransmit;
+            };
+
+            // Gets or creates the connection for a given client endpoint; arms its staleness timer when created,
+            // and its path MTU timer if the socket sends with Don't Fragment set.
+            // The returned pointer stays valid for the handler's lifetime (see ConnectionTable).
+            ConnectionTable::Connection* GetOrCreateConnection(const NetworkEndpoint& endpoint);
 
-            // Gets or creates a reliability state for a given client endpoint.
-            std::shared_ptr<ReliableConnectionState> GetOrCreateReliabilityState(const NetworkEndpoint& endpoint);
+            void ScheduleTimer(std::chrono::steady_clock::time_point deadline, const ReliabilityTimer& timer);
+            // Arms the retransmit timer for a reliable packet that was just prepared for this connection.
+            void ScheduleRetransmitTimer(const ConnectionTable::Connection& connection, const PacketBuffer& packet);
+            // Arms the delayed-ACK timer unless one is already pending for this connection.
+            void ScheduleAckTimer(ConnectionTable::Connection& connection);
+            // Handles one expired timer; connections that must be dropped are appended to clientsToDrop.
+            void HandleExpiredTimer(const ReliabilityTimer& timer, std::chrono::steady_clock::time_point now,
+                std::vector<NetworkEndpoint>& clientsToDrop);
 
             INetworkIO* m_networkIO = nullptr; // Member to store the network IO instance  
 
+            // Applies the ingress rate limit to one C2S message unless it arrived reliably (and so was ACKed
+            // already), then verifies it, looks up its player and hands it to the message handler.
+            void DispatchApplicationMessage(const NetworkEndpoint& sender, ReliableConnectionState& connectionState,
+                const uint8_t* payloadData, uint16_t payloadSize, bool arrivedReliably);
+
+            // Adds the message to the connection's pending aggregated datagram on 'channel'. With an outbound
+            // batch open on this thread it waits for the flush; otherwise it is sealed and sent right away.
+            // Returns false if it must be sent on its own (too large, or the send window is full).
+            bool QueueChannelMessage(ConnectionTable::Connection& connection,
+                NetworkChannel channel,
+                const flatbuffers::DetachedBuffer& flatbufferPayload);
+            // Arms the retransmit timer for a sealed aggregated datagram if it is reliable, then sends it.
+            void SendSealedAggregate(ConnectionTable::Connection& connection, PacketBuffer& packet);
+            // Sends an admitted unreliable datagram, FEC-protected if the connection has FEC active, followed
+            // by its group's parity datagram if it completed one.
+            bool SendUnreliableDatagram(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState, PacketBuffer& packet);
+            // Hands a received (or FEC-rebuilt) datagram's payload to the message handler; an IS_AGGREGATE
+            // payload passes its channels first.
+            void DeliverDatagramPayload(const NetworkEndpoint& sender, ReliableConnectionState& connectionState,
+                uint8_t headerFlags, const uint8_t* payloadData, uint16_t payloadSize);
+
+            // Queues the datagram if an outbound batch is open on this thread, otherwise sends it now.
+            // Either way only a reference to the packet buffer is taken; the bytes are not copied unless
+            // the connection uses compact headers or encryption (see PrepareOutgoingDatagramForWire).
+            bool SendRawDatagram(const NetworkEndpoint& recipient, ReliableConnectionState& connectionState, const PacketBuffer& packet);
+
+            // Outbound batch encryption, see FlushOutboundBatch. A CryptoFlush holds the one batch being sealed.
+            struct CryptoFlush;
+            // Crypto worker task: seals entries [begin, end) of the flush in place. The worker that seals
+            // the last run sends the flush.
+            void SealCryptoFlushRange(size_t begin, size_t end);
+            void SendCryptoFlush();
+            // Blocks until the flush handed to the crypto workers, if any, has been sent. With claimFlush the
+            // caller then owns m_cryptoFlush (marked in flight under the same lock) until SendCryptoFlush frees it.
+            void WaitForCryptoFlush(bool claimFlush = false);
+
             /**
              * @brief Helper to handle responses returned by IMessageHandler.
              * This function will decide whether to send a reliable or unreliable packet
@@ -176,10 +375,35 @@ namespace RiftForged {
             std::atomic<bool> m_isRunning;     // Controls the reliability thread loop
 
             // Reliability-specific state
-            std::map<NetworkEndpoint, std::shared_ptr<ReliableConnectionState>> m_reliabilityStates;
-            std::mutex m_reliabilityStatesMutex; // Protects m_reliabilityStates and m_endpointLastSeenTime
+            ConnectionTable m_connections;       // Reliability state and last-seen time per endpoint
+            ConnectionCookieIssuer m_cookieIssuer; // Gates the creation of connections for unknown senders
             std::thread m_reliabilityThread;     // Thread dedicated to reliability tasks
-            std::map<NetworkEndpoint, std::chrono::steady_clock::time_point> m_endpointLastSeenTime; // Tracks last communication
+
+            // Timers drive the reliability thread: it sleeps until the next timer is due and only touches
+            // connections with an expired timer, instead of sweeping every connection on a fixed interval.
+            TimerWheel<ReliabilityTimer> m_timerWheel;
+            std::mutex m_timerWakeMutex;
+            std::condition_variable m_timerWakeCv;
+            bool m_timerWakePending;             // Guarded by m_timerWakeMutex
+            std::atomic<int> m_ackDelayMs;
+            std::atomic<bool> m_explicitNacksEnabled;
+            std::atomic<CongestionControlAlgorithm> m_congestionControlAlgorithm;
+            std::atomic<UnreliableFecMode> m_unreliableFecMode;
+            // Ingress rate limit per C2S payload type, indexed by the type (see SetIngressRateLimit).
+            std::array<std::atomic<float>, INGRESS_MESSAGE_KINDS> m_ingressRatesPerSec;
+            std::array<std::atomic<uint32_t>, INGRESS_MESSAGE_KINDS> m_ingressBursts;
+            OverloadDetector m_overloadDetector;
+
+            // Outbound batch encryption
+            std::unique_ptr<CryptoFlush> m_cryptoFlush; // Reused by every flush; its buffers keep their capacity
+            std::mutex m_cryptoFlushMutex;
+            std::condition_variable m_cryptoFlushCv;
+            bool m_cryptoFlushInFlight;                 // Guarded by m_cryptoFlushMutex
+            OutboundCryptoStats m_cryptoStats;          // Guarded by m_cryptoFlushMutex
+            // Started by the first EnablePacketEncryption; a server with no encrypted connection runs no crypto
+            // threads. Declared last: its threads stop first.
+            std::once_flag m_cryptoWorkersStarted;
+            std::unique_ptr<RiftForged::Utils::Threading::TaskThreadPool> m_cryptoWorkers;
         };
 
     } // namespace Networking
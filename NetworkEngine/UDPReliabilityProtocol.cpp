@@ -5,9 +5,10 @@
 #include "UDPReliabilityProtocol.h"
 #include "../Utils/Logger.h"       // For RF_NETWORK_... macros
 #include "GamePacketHeader.h"      // For GamePacketFlag, SequenceNumber, GetGamePacketHeaderSize, CURRENT_PROTOCOL_ID_VERSION
+#include <cstddef>                 // For offsetof
 #include <cstring>                 // For memcpy
+#include <new>                     // For std::nothrow
 #include <vector>                  // For std::vector
-#include <list>                    // For std::list in ReliableConnectionState
 #include <chrono>                  // For time points
 #include <mutex>                   // For std::mutex
 #include <cmath>                   // For std::abs in RTT calculation
@@ -17,31 +18,25 @@
 namespace RiftForged {
     namespace Networking {
 
-        // Internal helper function to do the core work of PrepareOutgoingPacket without locking.
-        // Assumes the caller (PrepareOutgoingPacket or TrySendAckOnlyPacket) holds the lock on connectionState.internalStateMutex.
-        static std::vector<uint8_t> PrepareOutgoingPacketUnlocked_Internal(
+        // Fills in the header of an outgoing packet with the current ACK state and, for a reliable packet,
+        // claims the next sequence number. Fails if the send window has no room for another reliable packet.
+        // Assumes the caller holds connectionState.internalStateMutex.
+        static bool BuildOutgoingHeaderUnlocked(
             ReliableConnectionState& connectionState,
-            const uint8_t* payloadData,
-            uint16_t payloadSize,
-            uint8_t packetFlags
+            uint8_t packetFlags,
+            GamePacketHeader& header
         ) {
-            if (!HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY) && payloadSize > 0 && payloadData == nullptr) {
-                RF_NETWORK_WARN("PrepareOutgoingPacketUnlocked: Payload data is null for a non-ACK-only packet with payload size > 0. Flags: 0x{:X}", packetFlags);
-                return {};
-            }
-            if (HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY) && payloadSize > 0) {
-                RF_NETWORK_WARN("PrepareOutgoingPacketUnlocked: ACK-only packet should not have a payload. PayloadSize: {}. Ignoring payload.", payloadSize);
-                payloadSize = 0;
-                payloadData = nullptr;
-            }
-
-            GamePacketHeader header;
             header.protocolId = CURRENT_PROTOCOL_ID_VERSION;
             header.flags = packetFlags;
             header.ackNumber = connectionState.highestReceivedSequenceNumberFromRemote;
             header.ackBitfield = connectionState.receivedSequenceBitfield;
 
             if (HasFlag(packetFlags, GamePacketFlag::IS_RELIABLE)) {
+                if (!connectionState.unacknowledgedSentPackets.CanInsert(connectionState.nextOutgoingSequenceNumber)) {
+                    RF_NETWORK_ERROR("PrepareOutgoingPacketUnlocked: Send window full ({} reliable packets in flight, oldest not yet ACKed). Flags: 0x{:X}",
+                        connectionState.unacknowledgedSentPackets.size(), packetFlags);
+                    return false;
+                }
                 header.sequenceNumber = connectionState.nextOutgoingSequenceNumber++;
                 RF_NETWORK_TRACE("PrepareOutgoingPacketUnlocked: RELIABLE packet Seq: {}, Ack: {}, AckBits: 0x{:08X}, Flags: 0x{:X}",
                     header.sequenceNumber, header.ackNumber, header.ackBitfield, header.flags);
@@ -51,24 +46,391 @@ namespace RiftForged {
                 RF_NETWORK_TRACE("PrepareOutgoingPacketUnlocked: UNRELIABLE packet, Ack: {}, AckBits: 0x{:08X}, Flags: 0x{:X}",
                     header.ackNumber, header.ackBitfield, header.flags);
             }
+            return true;
+        }
 
-            std::vector<uint8_t> packetBuffer = SerializePacket(header, payloadData, payloadSize);
-
-            if (HasFlag(packetFlags, GamePacketFlag::IS_RELIABLE)) {
-                connectionState.unacknowledgedSentPackets.emplace_back(
+        // Records a fully written packet as sent: a reliable one is tracked for retransmission, and the
+        // pending ACK is cleared because the header carried it. Assumes the caller holds the lock.
+        static bool CommitOutgoingPacketUnlocked(
+            ReliableConnectionState& connectionState,
+            const GamePacketHeader& header,
+            const PacketBuffer& packetBuffer
+        ) {
+            if (HasFlag(header.flags, GamePacketFlag::IS_RELIABLE)) {
+                if (!connectionState.unacknowledgedSentPackets.Insert(
                     header.sequenceNumber,
                     packetBuffer,
-                    HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY)
-                );
+                    HasFlag(header.flags, GamePacketFlag::IS_ACK_ONLY),
+                    std::chrono::steady_clock::now())) {
+                    RF_NETWORK_ERROR("PrepareOutgoingPacketUnlocked: Failed to track reliable packet Seq: {} ({} bytes). Packet not sent.",
+                        header.sequenceNumber, packetBuffer.Size());
+                    return false;
+                }
                 RF_NETWORK_TRACE("PrepareOutgoingPacketUnlocked: Queued reliable packet Seq: {} for ACK. Unacked count: {}",
                     header.sequenceNumber, connectionState.unacknowledgedSentPackets.size());
+                // Unreliable datagrams are counted when AdmitOutgoingDatagram lets them through.
+                connectionState.transferStats.datagramsSent++;
+                connectionState.transferStats.bytesSent += packetBuffer.Size();
+                connectionState.congestionController->OnPacketSent(packetBuffer.Size(),
+                    connectionState.unacknowledgedSentPackets.BytesInFlight(), std::chrono::steady_clock::now());
             }
 
-            connectionState.hasPendingAckToSend = false; // This packet carries ACKs or is fresh
+            // This packet carries our ACK state; ranges the header cannot express still need an ACK-only packet.
+            connectionState.hasPendingAckToSend = connectionState.ackRangesPending;
+            connectionState.lastAckNumberSent = header.ackNumber;
             connectionState.lastPacketSentTimeToRemote = std::chrono::steady_clock::now();
+            return true;
+        }
+
+        static bool IsReceivedHistoryBitSet(const ReliableConnectionState& connectionState, uint32_t index) {
+            return ((connectionState.receivedSequenceHistory[index / 64] >> (index % 64)) & 1ULL) != 0;
+        }
+
+        // Marks highestReceivedSequenceNumberFromRemote - (index + 1) as received. Assumes the caller holds the lock.
+        static void SetReceivedHistoryBitUnlocked(ReliableConnectionState& connectionState, uint32_t index) {
+            connectionState.receivedSequenceHistory[index / 64] |= 1ULL << (index % 64);
+            connectionState.receivedSequenceBitfield = static_cast<uint32_t>(connectionState.receivedSequenceHistory[0]);
+        }
+
+        // Moves the received history 'diff' sequences on, for a new highest sequence; the previous highest
+        // becomes bit diff - 1 unless nothing had been received yet. Assumes the caller holds the lock.
+        static void AdvanceReceivedHistoryUnlocked(ReliableConnectionState& connectionState, uint32_t diff, bool markPreviousHighest) {
+            auto& history = connectionState.receivedSequenceHistory;
+            if (diff >= RECEIVED_SEQUENCE_HISTORY_SIZE) {
+                history.fill(0);
+            }
+            else {
+                const size_t wordShift = diff / 64;
+                const uint32_t bitShift = diff % 64;
+                for (size_t word = history.size(); word-- > 0; ) {
+                    uint64_t value = 0;
+                    if (word >= wordShift) {
+                        value = history[word - wordShift] << bitShift;
+                        if (bitShift != 0 && word > wordShift) {
+                            value |= history[word - wordShift - 1] >> (64 - bitShift);
+                        }
+                    }
+                    history[word] = value;
+                }
+            }
+            if (markPreviousHighest && diff <= RECEIVED_SEQUENCE_HISTORY_SIZE) {
+                history[(diff - 1) / 64] |= 1ULL << ((diff - 1) % 64);
+            }
+            connectionState.receivedSequenceBitfield = static_cast<uint32_t>(history[0]);
+        }
+
+        // After advancing the history by 'diff', reports whether a received sequence just slid out of the
+        // header bitfield's reach without our last ACK having covered it. Assumes the caller holds the lock.
+        static bool HasUnreportedSequenceBeyondBitfieldUnlocked(const ReliableConnectionState& connectionState, uint32_t diff) {
+            const uint32_t end = std::min(32 + diff, RECEIVED_SEQUENCE_HISTORY_SIZE);
+            for (uint32_t index = 32; index < end; ++index) {
+                if (!IsReceivedHistoryBitSet(connectionState, index)) {
+                    continue;
+                }
+                const SequenceNumber sequenceNumber = connectionState.highestReceivedSequenceNumberFromRemote - (index + 1);
+                if (IsSequenceGreaterThan(sequenceNumber, connectionState.lastAckNumberSent) ||
+                    connectionState.lastAckNumberSent - sequenceNumber > 32) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Number of history bits that map to real sequences (sequence 0 is never sent reliably).
+        static uint32_t ValidHistoryBitsUnlocked(const ReliableConnectionState& connectionState) {
+            const SequenceNumber highest = connectionState.highestReceivedSequenceNumberFromRemote;
+            return highest > RECEIVED_SEQUENCE_HISTORY_SIZE ? RECEIVED_SEQUENCE_HISTORY_SIZE : (highest > 0 ? highest - 1 : 0);
+        }
+
+        // After advancing the history by 'diff', reports whether a missing sequence just became
+        // FAST_RETRANSMIT_REORDER_THRESHOLD sequences old, i.e. is due a NACK. Assumes the caller holds the lock.
+        static bool HasNewGapToNackUnlocked(const ReliableConnectionState& connectionState, uint32_t diff) {
+            const uint32_t end = std::min({ FAST_RETRANSMIT_REORDER_THRESHOLD - 1 + diff, 32U, ValidHistoryBitsUnlocked(connectionState) });
+            for (uint32_t index = FAST_RETRANSMIT_REORDER_THRESHOLD - 1; index < end; ++index) {
+                if (!IsReceivedHistoryBitSet(connectionState, index)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Writes up to MAX_ACK_RANGES_PER_PACKET runs of history bits in [firstIndex, endIndex) that equal
+        // 'received', newest first, starting at 'out'. Returns the number written; outComplete is false if
+        // some runs did not fit.
+        static uint8_t WriteHistoryRunsUnlocked(const ReliableConnectionState& connectionState,
+            uint32_t firstIndex, uint32_t endIndex, bool received, uint8_t* out, bool& outComplete) {
+            uint8_t runCount = 0;
+            outComplete = true;
+            uint32_t index = firstIndex;
+            while (index < endIndex) {
+                if (IsReceivedHistoryBitSet(connectionState, index) != received) {
+                    ++index;
+                    continue;
+                }
+                if (runCount == MAX_ACK_RANGES_PER_PACKET) {
+                    outComplete = false;
+                    break;
+                }
+                const uint32_t runStart = index;
+                while (index < endIndex && IsReceivedHistoryBitSet(connectionState, index) == received) {
+                    ++index;
+                }
+                AckRange range;
+                range.offset = static_cast<uint16_t>(runStart + 1);
+                range.length = static_cast<uint16_t>(index - runStart);
+                std::memcpy(out + runCount * GetAckRangeSize(), &range, GetAckRangeSize());
+                ++runCount;
+            }
+            return runCount;
+        }
+
+        // Writes an AckRangesHeader followed by the runs of received sequences beyond the header bitfield
+        // (if includeAcked) and the runs of missing sequences at least FAST_RETRANSMIT_REORDER_THRESHOLD old
+        // within it (if includeNacks). Returns the bytes written (0 if there is nothing to report);
+        // outAckedComplete is false if some received runs did not fit. Assumes the caller holds the lock.
+        static size_t WriteAckRangesUnlocked(const ReliableConnectionState& connectionState, bool includeAcked, bool includeNacks,
+            uint8_t* out, bool& outAckedComplete) {
+            AckRangesHeader rangesHeader{ 0, 0 };
+            outAckedComplete = true;
+            uint8_t* runs = out + GetAckRangesHeaderSize();
+            const uint32_t validBits = ValidHistoryBitsUnlocked(connectionState);
+            if (includeAcked) {
+                rangesHeader.rangeCount = WriteHistoryRunsUnlocked(connectionState, 32, validBits, true, runs, outAckedComplete);
+            }
+            if (includeNacks) {
+                bool nacksComplete = true; // Later gaps are still found by the sender's own loss detection.
+                rangesHeader.nackCount = WriteHistoryRunsUnlocked(connectionState, FAST_RETRANSMIT_REORDER_THRESHOLD - 1,
+                    std::min(32U, validBits), false, runs + rangesHeader.rangeCount * GetAckRangeSize(), nacksComplete);
+            }
+            const size_t runCount = static_cast<size_t>(rangesHeader.rangeCount) + rangesHeader.nackCount;
+            if (runCount == 0) {
+                return 0;
+            }
+            std::memcpy(out, &rangesHeader, GetAckRangesHeaderSize());
+            return GetAckRangesHeaderSize() + runCount * GetAckRangeSize();
+        }
+
+        // Internal helper function to do the core work of PrepareOutgoingPacket without locking.
+        // Assumes the caller (PrepareOutgoingPacket or TrySendAckOnlyPacket) holds the lock on connectionState.internalStateMutex.
+        // If fragmentHeader is given it is written between the GamePacketHeader and the payload.
+        static PacketBuffer PrepareOutgoingPacketUnlocked_Internal(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            uint16_t payloadSize,
+            uint8_t packetFlags,
+            const FragmentHeader* fragmentHeader = nullptr
+        ) {
+            if (!HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY) && payloadSize > 0 && payloadData == nullptr) {
+                RF_NETWORK_WARN("PrepareOutgoingPacketUnlocked: Payload data is null for a non-ACK-only packet with payload size > 0. Flags: 0x{:X}", packetFlags);
+                return {};
+            }
+            if (HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY) && payloadSize > 0) {
+                RF_NETWORK_WARN("PrepareOutgoingPacketUnlocked: ACK-only packet should not have a payload. PayloadSize: {}. Ignoring payload.", payloadSize);
+                payloadSize = 0;
+                payloadData = nullptr;
+            }
+
+            // An ACK-only packet reports the received sequences the header bitfield cannot reach, and NACKs gaps.
+            uint8_t ackRanges[GetAckRangesHeaderSize() + 2 * MAX_ACK_RANGES_PER_PACKET * GetAckRangeSize()];
+            size_t ackRangesSize = 0;
+            bool ackRangesComplete = true;
+            const bool isAckOnly = HasFlag(packetFlags, GamePacketFlag::IS_ACK_ONLY);
+            const bool reportsAckRanges = isAckOnly && connectionState.ackRangesPending;
+            const bool reportsNacks = isAckOnly && connectionState.nackPending;
+            if (reportsAckRanges || reportsNacks) {
+                ackRangesSize = WriteAckRangesUnlocked(connectionState, reportsAckRanges, reportsNacks, ackRanges, ackRangesComplete);
+                if (ackRangesSize > 0) {
+                    packetFlags |= GamePacketFlag::HAS_ACK_RANGES;
+                }
+            }
+
+            GamePacketHeader header;
+            if (!BuildOutgoingHeaderUnlocked(connectionState, packetFlags, header)) {
+                return {};
+            }
+
+            // Header and payload are written once, straight into the buffer that the send path, the
+            // transport and the retransmit window all share.
+            const size_t prefixSize = GetGamePacketHeaderSize() + (fragmentHeader ? GetFragmentHeaderSize() : 0) + ackRangesSize;
+            PacketBuffer packetBuffer = PacketBuffer::Allocate(prefixSize + payloadSize);
+            if (!packetBuffer.MutableData()) {
+                RF_NETWORK_ERROR("PrepareOutgoingPacketUnlocked: Failed to allocate a {} byte packet buffer.", prefixSize + payloadSize);
+                return {};
+            }
+            std::memcpy(packetBuffer.MutableData(), &header, GetGamePacketHeaderSize());
+            if (fragmentHeader) {
+                std::memcpy(packetBuffer.MutableData() + GetGamePacketHeaderSize(), fragmentHeader, GetFragmentHeaderSize());
+            }
+            if (ackRangesSize > 0) {
+                std::memcpy(packetBuffer.MutableData() + GetGamePacketHeaderSize(), ackRanges, ackRangesSize);
+            }
+            if (payloadData && payloadSize > 0) {
+                std::memcpy(packetBuffer.MutableData() + prefixSize, payloadData, payloadSize);
+            }
+            packetBuffer.SetSize(prefixSize + payloadSize);
+
+            if (reportsAckRanges) {
+                connectionState.ackRangesPending = !ackRangesComplete;
+            }
+            if (reportsNacks) {
+                connectionState.nackPending = false;
+            }
+            if (!CommitOutgoingPacketUnlocked(connectionState, header, packetBuffer)) {
+                connectionState.ackRangesPending = connectionState.ackRangesPending || reportsAckRanges;
+                connectionState.nackPending = connectionState.nackPending || reportsNacks;
+                return {};
+            }
             return packetBuffer;
         }
 
+        // Seals the pending aggregated datagram: writes its header into the space reserved at the front
+        // and commits it like any other packet. If it is reliable and the send window is full, it stays
+        // pending (a RELIABLE_ORDERED message must not be lost, or its channel would stall) and an empty
+        // buffer is returned. Assumes the caller holds the lock.
+        static PacketBuffer SealAggregatedDatagramUnlocked(ReliableConnectionState& connectionState) {
+            if (connectionState.pendingAggregateHasReliable &&
+                !connectionState.unacknowledgedSentPackets.CanInsert(connectionState.nextOutgoingSequenceNumber)) {
+                RF_NETWORK_WARN("SealAggregatedDatagram: Send window full ({} reliable packets in flight). Holding {} byte aggregate.",
+                    connectionState.unacknowledgedSentPackets.size(), connectionState.pendingAggregate.Size());
+                return {};
+            }
+            PacketBuffer packetBuffer = std::move(connectionState.pendingAggregate);
+            const bool isReliable = connectionState.pendingAggregateHasReliable;
+            connectionState.pendingAggregate.Reset();
+            connectionState.pendingAggregateHasReliable = false;
+            if (packetBuffer.Size() <= GetGamePacketHeaderSize()) {
+                return {};
+            }
+
+            uint8_t packetFlags = static_cast<uint8_t>(GamePacketFlag::IS_AGGREGATE);
+            if (isReliable) {
+                packetFlags |= GamePacketFlag::IS_RELIABLE;
+            }
+            GamePacketHeader header;
+            if (!BuildOutgoingHeaderUnlocked(connectionState, packetFlags, header)) {
+                return {};
+            }
+            std::memcpy(packetBuffer.MutableData(), &header, GetGamePacketHeaderSize());
+            if (!CommitOutgoingPacketUnlocked(connectionState, header, packetBuffer)) {
+                return {};
+            }
+            return packetBuffer;
+        }
+
+        // An aggregated datagram is retransmitted without its unreliable messages: they are stale by
+        // then and would only cost bandwidth. Rebuilds the tracked packet in place; the sequence number
+        // and header stay the same, so the receiver's duplicate detection is unaffected.
+        static void DropUnreliableMessagesUnlocked(ReliableConnectionState::SentPacketInfo& sentPacket) {
+            const PacketBuffer& original = sentPacket.packet;
+            if (original.Size() <= GetGamePacketHeaderSize()) {
+                return;
+            }
+            GamePacketHeader header;
+            std::memcpy(&header, original.Data(), GetGamePacketHeaderSize());
+            if (!HasFlag(header.flags, GamePacketFlag::IS_AGGREGATE)) {
+                return;
+            }
+
+            const uint8_t* payload = original.Data() + GetGamePacketHeaderSize();
+            const size_t payloadSize = original.Size() - GetGamePacketHeaderSize();
+            size_t reliableBytes = 0;
+            if (!ForEachAggregatedMessage(payload, payloadSize, [&](const uint8_t*, const AggregatedMessageHeader& messageHeader) {
+                if (IsReliableChannel(static_cast<NetworkChannel>(messageHeader.channel))) {
+                    reliableBytes += GetAggregatedMessageHeaderSize() + messageHeader.messageSize;
+                }
+                })) {
+                return;
+            }
+            if (reliableBytes == payloadSize) {
+                return; // Nothing to strip
+            }
+
+            PacketBuffer stripped = PacketBuffer::Allocate(GetGamePacketHeaderSize() + reliableBytes);
+            if (!stripped.MutableData()) {
+                return; // Resend the original rather than nothing
+            }
+            uint8_t* writePtr = stripped.MutableData();
+            std::memcpy(writePtr, &header, GetGamePacketHeaderSize());
+            writePtr += GetGamePacketHeaderSize();
+            ForEachAggregatedMessage(payload, payloadSize, [&](const uint8_t* message, const AggregatedMessageHeader& messageHeader) {
+                if (IsReliableChannel(static_cast<NetworkChannel>(messageHeader.channel))) {
+                    const size_t messageBytes = GetAggregatedMessageHeaderSize() + messageHeader.messageSize;
+                    std::memcpy(writePtr, message - GetAggregatedMessageHeaderSize(), messageBytes);
+                    writePtr += messageBytes;
+                }
+                });
+            stripped.SetSize(GetGamePacketHeaderSize() + reliableBytes);
+            RF_NETWORK_TRACE("RETRANSMIT: Aggregated packet Seq={} trimmed from {} to {} bytes (unreliable messages dropped).",
+                sentPacket.sequenceNumber, original.Size(), stripped.Size());
+            sentPacket.packet = std::move(stripped);
+        }
+
+        static std::chrono::steady_clock::duration RtoAsDuration(float rtoMs) {
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(rtoMs));
+        }
+
+        // Tops up the pacer at the controller's current pacing rate. Assumes the caller holds the lock.
+        static void RefillPacerUnlocked(ReliableConnectionState& connectionState, std::chrono::steady_clock::time_point now) {
+            const float rate = connectionState.congestionController->GetPacingRateBytesPerSec(connectionState.smoothedRTT_ms);
+            const size_t burst = std::max(2 * connectionState.maxDatagramSize, static_cast<size_t>(rate * PACER_BURST_MS / 1000.0f));
+            connectionState.pacer.Refill(rate, burst, now);
+        }
+
+        // Accounts for a packet being resent after it was taken as lost: the controller reacts to the loss
+        // and the resend is charged to the pacer. Assumes the caller holds the lock.
+        static void RecordRetransmissionUnlocked(
+            ReliableConnectionState& connectionState,
+            const ReliableConnectionState::SentPacketInfo& sentPacket,
+            bool isTimeout,
+            std::chrono::steady_clock::time_point now
+        ) {
+            if (!sentPacket.isAckOnly) {
+                // An ACK-only packet is only ACKed when the peer has something to send, so its RTO says
+                // little about congestion.
+                connectionState.congestionController->OnPacketLost(sentPacket.sentSize, isTimeout, now);
+                connectionState.measuredLossRate += LOSS_RATE_SMOOTHING * (1.0f - connectionState.measuredLossRate);
+            }
+            RefillPacerUnlocked(connectionState, now);
+            connectionState.pacer.ForceConsume(sentPacket.packet.Size());
+            connectionState.transferStats.packetsLost++;
+            connectionState.transferStats.datagramsSent++;
+            connectionState.transferStats.bytesSent += sentPacket.packet.Size();
+            connectionState.transferStats.bytesRetransmitted += sentPacket.packet.Size();
+        }
+
+        // Marks a timed-out packet for resend and backs off the connection RTO, or drops the connection
+        // once MAX_PACKET_RETRIES is reached. Returns false if the connection was dropped (the packet is NOT erased here).
+        // Assumes the caller holds connectionState.internalStateMutex.
+        static bool RetransmitOrDropUnlocked(
+            ReliableConnectionState& connectionState,
+            ReliableConnectionState::SentPacketInfo& sentPacket,
+            std::chrono::steady_clock::time_point currentTime
+        ) {
+            if (connectionState.ShouldDropPacket(sentPacket.retries)) {
+                RF_NETWORK_ERROR("MAX RETRIES: Packet Seq={} EXCEEDED MAX RETRIES ({}). RTO used: {:.0f}ms. Dropping packet and flagging connection as lost.",
+                    sentPacket.sequenceNumber, MAX_PACKET_RETRIES, connectionState.retransmissionTimeout_ms);
+                connectionState.connectionDroppedByMaxRetries = true;
+                connectionState.isConnected = false;
+                return false;
+            }
+
+            sentPacket.retries++;
+            sentPacket.timeSent = currentTime;
+
+            // Store current RTO before doubling for logging
+            float rtoThatTriggered = connectionState.retransmissionTimeout_ms;
+
+            connectionState.retransmissionTimeout_ms = connectionState.retransmissionTimeout_ms * 2.0f;
+            connectionState.retransmissionTimeout_ms = std::min(connectionState.retransmissionTimeout_ms, MAX_RTO_MS);
+            connectionState.retransmissionTimeout_ms = std::max(connectionState.retransmissionTimeout_ms, MIN_RTO_MS);
+
+            RF_NETWORK_WARN("RETRANSMIT: Packet Seq={} (Attempt #{}). RTO that triggered retransmit: {:.0f}ms. New connection RTO: {:.0f}ms",
+                sentPacket.sequenceNumber, sentPacket.retries,
+                rtoThatTriggered,
+                connectionState.retransmissionTimeout_ms);
+            return true;
+        }
+
         // Helper function to serialize the GamePacketHeader and payload into a byte vector.
         std::vector<uint8_t> SerializePacket(const GamePacketHeader& header, const uint8_t* payload, uint16_t payloadSize) {
             std::vector<uint8_t> packetBuffer(GetGamePacketHeaderSize() + payloadSize);
@@ -98,11 +460,434 @@ namespace RiftForged {
             const uint8_t* payloadData,
             uint16_t payloadSize,
             uint8_t packetFlags
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            return PrepareOutgoingPacketUnlocked_Internal(connectionState, payloadData, payloadSize, packetFlags).ToVector();
+        }
+
+        // --- PrepareOutgoingPacketBuffer ---
+        PacketBuffer PrepareOutgoingPacketBuffer(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            uint16_t payloadSize,
+            uint8_t packetFlags
         ) {
             std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
             return PrepareOutgoingPacketUnlocked_Internal(connectionState, payloadData, payloadSize, packetFlags);
         }
 
+        // Largest datagram this layer may build for the connection: what is left of maxDatagramSize once the
+        // wire form's own bytes (AEAD counter and tag) are added. Assumes the caller holds the lock.
+        static size_t DatagramSizeLimitUnlocked(const ReliableConnectionState& connectionState) {
+            return connectionState.maxDatagramSize - connectionState.datagramWireOverhead;
+        }
+
+        // --- GetMaxUnfragmentedPayloadSize ---
+        size_t GetMaxUnfragmentedPayloadSize(ReliableConnectionState& connectionState) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            const size_t datagramLimit = DatagramSizeLimitUnlocked(connectionState);
+            return datagramLimit > GetGamePacketHeaderSize() ? datagramLimit - GetGamePacketHeaderSize() : 0;
+        }
+
+        // Does the work of PrepareOutgoingReliableMessage. Assumes the caller holds connectionState.internalStateMutex.
+        static bool PrepareOutgoingReliableMessageUnlocked(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            size_t payloadSize,
+            uint8_t packetFlags,
+            std::vector<PacketBuffer>& outPackets
+        ) {
+            outPackets.clear();
+            if (!payloadData || payloadSize == 0) {
+                RF_NETWORK_WARN("PrepareOutgoingReliableMessage: Empty payload. Flags: 0x{:X}", packetFlags);
+                return false;
+            }
+            packetFlags |= static_cast<uint8_t>(GamePacketFlag::IS_RELIABLE);
+            packetFlags &= static_cast<uint8_t>(~(static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_START) | static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_END)));
+
+            const size_t datagramLimit = DatagramSizeLimitUnlocked(connectionState);
+            if (GetGamePacketHeaderSize() + payloadSize <= datagramLimit) {
+                PacketBuffer packet = PrepareOutgoingPacketUnlocked_Internal(connectionState, payloadData, static_cast<uint16_t>(payloadSize), packetFlags);
+                if (packet.Empty()) {
+                    return false;
+                }
+                outPackets.push_back(std::move(packet));
+                return true;
+            }
+
+            const size_t maxChunkSize = datagramLimit - GetGamePacketHeaderSize() - GetFragmentHeaderSize();
+            const size_t fragmentCount = (payloadSize + maxChunkSize - 1) / maxChunkSize;
+            if (fragmentCount > MAX_FRAGMENTS_PER_MESSAGE || payloadSize > UINT32_MAX) {
+                RF_NETWORK_ERROR("PrepareOutgoingReliableMessage: Message of {} bytes needs {} fragments (max {} at {} byte datagrams). Not sent.",
+                    payloadSize, fragmentCount, MAX_FRAGMENTS_PER_MESSAGE, datagramLimit);
+                return false;
+            }
+            // All fragments or none: a partially sent message could never be reassembled.
+            for (size_t i = 0; i < fragmentCount; ++i) {
+                if (!connectionState.unacknowledgedSentPackets.CanInsert(connectionState.nextOutgoingSequenceNumber + static_cast<SequenceNumber>(i))) {
+                    RF_NETWORK_ERROR("PrepareOutgoingReliableMessage: Send window has no room for {} fragments ({} reliable packets in flight). Not sent.",
+                        fragmentCount, connectionState.unacknowledgedSentPackets.size());
+                    return false;
+                }
+            }
+
+            const size_t stride = (payloadSize + fragmentCount - 1) / fragmentCount;
+            FragmentHeader fragmentHeader;
+            fragmentHeader.fragmentCount = static_cast<uint8_t>(fragmentCount);
+            fragmentHeader.messageSize = static_cast<uint32_t>(payloadSize);
+            outPackets.reserve(fragmentCount);
+            for (size_t i = 0; i < fragmentCount; ++i) {
+                const size_t offset = i * stride;
+                const size_t chunkSize = std::min(stride, payloadSize - offset);
+                fragmentHeader.fragmentIndex = static_cast<uint8_t>(i);
+                PacketBuffer packet = PrepareOutgoingPacketUnlocked_Internal(connectionState, payloadData + offset, static_cast<uint16_t>(chunkSize),
+                    packetFlags | FragmentFlagsFor(static_cast<uint8_t>(i), static_cast<uint8_t>(fragmentCount)), &fragmentHeader);
+                if (packet.Empty()) {
+                    // Fragments already prepared are tracked for retransmission; the caller should still send them.
+                    RF_NETWORK_ERROR("PrepareOutgoingReliableMessage: Failed to prepare fragment {}/{} of a {} byte message.", i + 1, fragmentCount, payloadSize);
+                    return false;
+                }
+                outPackets.push_back(std::move(packet));
+            }
+            RF_NETWORK_DEBUG("PrepareOutgoingReliableMessage: Split {} byte message into {} fragments starting at Seq: {}.",
+                payloadSize, fragmentCount, connectionState.nextOutgoingSequenceNumber - static_cast<SequenceNumber>(fragmentCount));
+            return true;
+        }
+
+        // --- PrepareOutgoingReliableMessage ---
+        bool PrepareOutgoingReliableMessage(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            size_t payloadSize,
+            uint8_t packetFlags,
+            std::vector<PacketBuffer>& outPackets
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            return PrepareOutgoingReliableMessageUnlocked(connectionState, payloadData, payloadSize, packetFlags, outPackets);
+        }
+
+        // Builds the header of the next message on 'channel', claiming a channel sequence number where
+        // the channel uses one. Assumes the caller holds the lock.
+        static AggregatedMessageHeader NextChannelMessageHeaderUnlocked(
+            ReliableConnectionState& connectionState,
+            NetworkChannel channel,
+            size_t messageSize
+        ) {
+            AggregatedMessageHeader messageHeader;
+            messageHeader.messageSize = static_cast<uint16_t>(messageSize);
+            messageHeader.channel = static_cast<uint8_t>(channel);
+            messageHeader.channelSequence = 0;
+            if (channel == NetworkChannel::RELIABLE_ORDERED || channel == NetworkChannel::UNRELIABLE_SEQUENCED) {
+                messageHeader.channelSequence = connectionState.channels[static_cast<size_t>(channel)].nextOutgoingSequence++;
+            }
+            return messageHeader;
+        }
+
+        // --- PrepareOutgoingChannelMessage ---
+        bool PrepareOutgoingChannelMessage(
+            ReliableConnectionState& connectionState,
+            NetworkChannel channel,
+            const uint8_t* messageData,
+            size_t messageSize,
+            std::vector<PacketBuffer>& outPackets
+        ) {
+            outPackets.clear();
+            if (!IsReliableChannel(channel) || !messageData || messageSize == 0 || messageSize > UINT16_MAX) {
+                RF_NETWORK_ERROR("PrepareOutgoingChannelMessage: Cannot send a {} byte message on channel {} on its own.",
+                    messageSize, static_cast<int>(channel));
+                return false;
+            }
+            // The framed message (header + data) is what gets fragmented; the receiver unpacks it like any aggregate.
+            const size_t framedSize = GetAggregatedMessageHeaderSize() + messageSize;
+            PacketBuffer framed = PacketBuffer::Allocate(framedSize);
+            if (!framed.MutableData()) {
+                RF_NETWORK_ERROR("PrepareOutgoingChannelMessage: Failed to allocate {} bytes.", framedSize);
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            const AggregatedMessageHeader messageHeader = NextChannelMessageHeaderUnlocked(connectionState, channel, messageSize);
+            std::memcpy(framed.MutableData(), &messageHeader, GetAggregatedMessageHeaderSize());
+            std::memcpy(framed.MutableData() + GetAggregatedMessageHeaderSize(), messageData, messageSize);
+            framed.SetSize(framedSize);
+            const bool prepared = PrepareOutgoingReliableMessageUnlocked(connectionState, framed.Data(), framed.Size(),
+                static_cast<uint8_t>(GamePacketFlag::IS_AGGREGATE), outPackets);
+            if (outPackets.empty() && channel == NetworkChannel::RELIABLE_ORDERED) {
+                // Nothing went out; give the sequence number back so the channel has no gap.
+                connectionState.channels[static_cast<size_t>(channel)].nextOutgoingSequence--;
+            }
+            return prepared;
+        }
+
+        // --- ProcessIncomingChannelMessage ---
+        ChannelDeliveryResult ProcessIncomingChannelMessage(
+            ReliableConnectionState& connectionState,
+            const AggregatedMessageHeader& messageHeader,
+            const uint8_t* messageData,
+            bool fromReliableDatagram,
+            std::vector<PacketBuffer>& outReleased
+        ) {
+            if (messageHeader.channel >= NETWORK_CHANNEL_COUNT) {
+                RF_NETWORK_WARN("CHANNEL: Message on unknown channel {}. Dropping.", messageHeader.channel);
+                return ChannelDeliveryResult::Dropped;
+            }
+            const NetworkChannel channel = static_cast<NetworkChannel>(messageHeader.channel);
+            if (IsReliableChannel(channel) && !fromReliableDatagram) {
+                // Only reliable datagrams are deduplicated; a reliable-channel message outside one is malformed.
+                RF_NETWORK_WARN("CHANNEL: Reliable channel {} message in an unreliable datagram. Dropping.", messageHeader.channel);
+                return ChannelDeliveryResult::Dropped;
+            }
+            if (channel == NetworkChannel::RELIABLE_UNORDERED || channel == NetworkChannel::UNRELIABLE) {
+                return ChannelDeliveryResult::Deliver;
+            }
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            ReliableConnectionState::ChannelState& channelState = connectionState.channels[messageHeader.channel];
+
+            if (channel == NetworkChannel::UNRELIABLE_SEQUENCED) {
+                if (channelState.hasDeliveredSequenced &&
+                    static_cast<int16_t>(messageHeader.channelSequence - channelState.newestDeliveredSequence) <= 0) {
+                    RF_NETWORK_TRACE("CHANNEL: Stale sequenced message {} (newest delivered {}). Dropping.",
+                        messageHeader.channelSequence, channelState.newestDeliveredSequence);
+                    return ChannelDeliveryResult::Dropped;
+                }
+                channelState.newestDeliveredSequence = messageHeader.channelSequence;
+                channelState.hasDeliveredSequenced = true;
+                return ChannelDeliveryResult::Deliver;
+            }
+
+            // RELIABLE_ORDERED
+            const int16_t distance = static_cast<int16_t>(messageHeader.channelSequence - channelState.nextExpectedSequence);
+            if (distance < 0) {
+                RF_NETWORK_TRACE("CHANNEL: Ordered message {} already delivered (expecting {}). Dropping.",
+                    messageHeader.channelSequence, channelState.nextExpectedSequence);
+                return ChannelDeliveryResult::Dropped;
+            }
+            if (distance >= static_cast<int16_t>(ORDERED_CHANNEL_BACKLOG_SIZE)) {
+                RF_NETWORK_ERROR("CHANNEL: Ordered message {} is {} ahead of the next expected ({}); backlog holds {}. Dropping.",
+                    messageHeader.channelSequence, distance, channelState.nextExpectedSequence, ORDERED_CHANNEL_BACKLOG_SIZE);
+                return ChannelDeliveryResult::Dropped;
+            }
+            if (distance > 0) {
+                if (!channelState.backlog) {
+                    channelState.backlog.reset(new (std::nothrow) PacketBuffer[ORDERED_CHANNEL_BACKLOG_SIZE]);
+                    if (!channelState.backlog) {
+                        RF_NETWORK_ERROR("CHANNEL: Failed to allocate the ordered backlog. Dropping message {}.", messageHeader.channelSequence);
+                        return ChannelDeliveryResult::Dropped;
+                    }
+                }
+                PacketBuffer& slot = channelState.backlog[messageHeader.channelSequence & (ORDERED_CHANNEL_BACKLOG_SIZE - 1)];
+                if (!slot.Empty()) {
+                    return ChannelDeliveryResult::Dropped; // Already held back
+                }
+                slot = PacketBuffer::CopyFrom(messageData, messageHeader.messageSize);
+                if (slot.Empty()) {
+                    RF_NETWORK_ERROR("CHANNEL: Failed to hold back ordered message {}. Dropping.", messageHeader.channelSequence);
+                    return ChannelDeliveryResult::Dropped;
+                }
+                channelState.backlogCount++;
+                RF_NETWORK_TRACE("CHANNEL: Ordered message {} held back until {} arrives ({} waiting).",
+                    messageHeader.channelSequence, channelState.nextExpectedSequence, channelState.backlogCount);
+                return ChannelDeliveryResult::Buffered;
+            }
+
+            // In order: deliver it, then everything held back behind it that is now contiguous.
+            channelState.nextExpectedSequence++;
+            while (channelState.backlogCount > 0) {
+                PacketBuffer& slot = channelState.backlog[channelState.nextExpectedSequence & (ORDERED_CHANNEL_BACKLOG_SIZE - 1)];
+                if (slot.Empty()) {
+                    break;
+                }
+                outReleased.push_back(std::move(slot));
+                slot.Reset();
+                channelState.backlogCount--;
+                channelState.nextExpectedSequence++;
+            }
+            return ChannelDeliveryResult::Deliver;
+        }
+
+        // --- AppendAggregatedMessage ---
+        bool AppendAggregatedMessage(
+            ReliableConnectionState& connectionState,
+            const uint8_t* messageData,
+            size_t messageSize,
+            NetworkChannel channel,
+            PacketBuffer& outSealedDatagram
+        ) {
+            outSealedDatagram.Reset();
+            if (!messageData || messageSize == 0 || static_cast<size_t>(channel) >= NETWORK_CHANNEL_COUNT) {
+                return false;
+            }
+            const bool isReliable = IsReliableChannel(channel);
+            const size_t messageBytes = GetAggregatedMessageHeaderSize() + messageSize;
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            const size_t datagramLimit = std::min(DatagramSizeLimitUnlocked(connectionState), PACKET_BUFFER_BLOCK_SIZE - connectionState.datagramWireOverhead);
+            if (GetGamePacketHeaderSize() + messageBytes > datagramLimit) {
+                return false; // Never fits; the caller sends it on its own (fragmented if needed)
+            }
+
+            if (!connectionState.pendingAggregate.Empty() && connectionState.pendingAggregate.Size() + messageBytes > datagramLimit) {
+                outSealedDatagram = SealAggregatedDatagramUnlocked(connectionState);
+                if (!connectionState.pendingAggregate.Empty()) {
+                    return false; // Held back by a full send window; no room for this message either
+                }
+                if (outSealedDatagram.Empty()) {
+                    RF_NETWORK_ERROR("AppendAggregatedMessage: Failed to seal a full aggregated datagram; its messages are lost.");
+                }
+            }
+            if (connectionState.pendingAggregate.Empty()) {
+                connectionState.pendingAggregate = PacketBuffer::Allocate(datagramLimit);
+                if (!connectionState.pendingAggregate.MutableData()) {
+                    RF_NETWORK_ERROR("AppendAggregatedMessage: Failed to allocate an aggregated datagram.");
+                    connectionState.pendingAggregate.Reset();
+                    return false;
+                }
+                connectionState.pendingAggregate.SetSize(GetGamePacketHeaderSize()); // Header written at seal time
+            }
+
+            const AggregatedMessageHeader messageHeader = NextChannelMessageHeaderUnlocked(connectionState, channel, messageSize);
+            uint8_t* writePtr = connectionState.pendingAggregate.MutableData() + connectionState.pendingAggregate.Size();
+            std::memcpy(writePtr, &messageHeader, GetAggregatedMessageHeaderSize());
+            std::memcpy(writePtr + GetAggregatedMessageHeaderSize(), messageData, messageSize);
+            connectionState.pendingAggregate.SetSize(connectionState.pendingAggregate.Size() + messageBytes);
+            connectionState.pendingAggregateHasReliable = connectionState.pendingAggregateHasReliable || isReliable;
+            return true;
+        }
+
+        // --- SealAggregatedDatagram ---
+        PacketBuffer SealAggregatedDatagram(ReliableConnectionState& connectionState) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (connectionState.pendingAggregate.Empty()) {
+                return {};
+            }
+            PacketBuffer packetBuffer = SealAggregatedDatagramUnlocked(connectionState);
+            if (packetBuffer.Empty() && connectionState.pendingAggregate.Empty()) {
+                RF_NETWORK_ERROR("SealAggregatedDatagram: Failed to seal aggregated datagram; its messages are lost.");
+            }
+            return packetBuffer;
+        }
+
+        // --- ProcessIncomingFragment ---
+        FragmentReassemblyResult ProcessIncomingFragment(
+            ReliableConnectionState& connectionState,
+            const GamePacketHeader& receivedHeader,
+            const uint8_t* fragmentData,
+            uint16_t fragmentLength,
+            PacketBuffer& outMessage
+        ) {
+            if (!HasFlag(receivedHeader.flags, GamePacketFlag::IS_RELIABLE) || !fragmentData || fragmentLength <= GetFragmentHeaderSize()) {
+                RF_NETWORK_WARN("FRAGMENT: Malformed fragment (Seq={}, Flags: 0x{:X}, Length: {}). Dropping.",
+                    receivedHeader.sequenceNumber, receivedHeader.flags, fragmentLength);
+                return FragmentReassemblyResult::Rejected;
+            }
+            FragmentHeader fragmentHeader;
+            std::memcpy(&fragmentHeader, fragmentData, GetFragmentHeaderSize());
+            const uint8_t index = fragmentHeader.fragmentIndex;
+            const uint8_t count = fragmentHeader.fragmentCount;
+            const uint32_t messageSize = fragmentHeader.messageSize;
+            const size_t chunkSize = fragmentLength - GetFragmentHeaderSize();
+            const uint8_t fragmentFlags = receivedHeader.flags &
+                (static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_START) | static_cast<uint8_t>(GamePacketFlag::IS_FRAGMENT_END));
+
+            if (count < 2 || count > MAX_FRAGMENTS_PER_MESSAGE || index >= count ||
+                fragmentFlags != FragmentFlagsFor(index, count) ||
+                messageSize == 0 || messageSize > MAX_REASSEMBLY_BYTES_PER_CONNECTION) {
+                RF_NETWORK_WARN("FRAGMENT: Invalid fragment header (Seq={}, Index: {}, Count: {}, MessageSize: {}, Flags: 0x{:X}). Dropping.",
+                    receivedHeader.sequenceNumber, index, count, messageSize, receivedHeader.flags);
+                return FragmentReassemblyResult::Rejected;
+            }
+            const size_t stride = (static_cast<size_t>(messageSize) + count - 1) / count;
+            const size_t offset = index * stride;
+            const size_t expectedChunkSize = (index + 1 == count) ? (offset < messageSize ? messageSize - offset : 0) : stride;
+            if (expectedChunkSize == 0 || chunkSize != expectedChunkSize) {
+                RF_NETWORK_WARN("FRAGMENT: Fragment Seq={} carries {} bytes, expected {} (Index: {}, Count: {}, MessageSize: {}). Dropping.",
+                    receivedHeader.sequenceNumber, chunkSize, expectedChunkSize, index, count, messageSize);
+                return FragmentReassemblyResult::Rejected;
+            }
+            const SequenceNumber firstSequenceNumber = receivedHeader.sequenceNumber - index;
+            const auto now = std::chrono::steady_clock::now();
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+
+            ReliableConnectionState::IncomingFragmentBuffer* reassembly = nullptr;
+            ReliableConnectionState::IncomingFragmentBuffer* freeSlot = nullptr;
+            size_t bytesHeld = 0;
+            for (ReliableConnectionState::IncomingFragmentBuffer& fragmentBuffer : connectionState.incomingFragmentBuffers) {
+                if (fragmentBuffer.awaitingFragments &&
+                    now - fragmentBuffer.lastFragmentArrivalTime > std::chrono::milliseconds(FRAGMENT_REASSEMBLY_TIMEOUT_MS)) {
+                    RF_NETWORK_WARN("FRAGMENT: Reassembly of message starting at Seq={} timed out with {}/{} fragments. Discarding.",
+                        fragmentBuffer.fragmentStartSequenceNumber, fragmentBuffer.receivedFragmentCount, fragmentBuffer.totalFragments);
+                    fragmentBuffer.Reset();
+                }
+                if (!fragmentBuffer.awaitingFragments) {
+                    if (!freeSlot) freeSlot = &fragmentBuffer;
+                    continue;
+                }
+                if (fragmentBuffer.fragmentStartSequenceNumber == firstSequenceNumber) {
+                    reassembly = &fragmentBuffer;
+                }
+                bytesHeld += fragmentBuffer.messageSize;
+            }
+
+            if (reassembly) {
+                if (reassembly->totalFragments != count || reassembly->messageSize != messageSize) {
+                    RF_NETWORK_WARN("FRAGMENT: Fragment Seq={} disagrees with its message (Count: {} vs {}, MessageSize: {} vs {}). Dropping.",
+                        receivedHeader.sequenceNumber, count, reassembly->totalFragments, messageSize, reassembly->messageSize);
+                    return FragmentReassemblyResult::Rejected;
+                }
+            }
+            else {
+                if (!freeSlot) {
+                    RF_NETWORK_WARN("FRAGMENT: {} messages already being reassembled. Dropping fragment Seq={}.",
+                        MAX_CONCURRENT_REASSEMBLIES, receivedHeader.sequenceNumber);
+                    return FragmentReassemblyResult::Rejected;
+                }
+                if (bytesHeld + messageSize > MAX_REASSEMBLY_BYTES_PER_CONNECTION) {
+                    RF_NETWORK_WARN("FRAGMENT: Connection reassembly limit reached ({} + {} bytes > {}). Dropping fragment Seq={}.",
+                        bytesHeld, messageSize, MAX_REASSEMBLY_BYTES_PER_CONNECTION, receivedHeader.sequenceNumber);
+                    return FragmentReassemblyResult::Rejected;
+                }
+                if (ReassemblyBytesInUse().fetch_add(messageSize, std::memory_order_relaxed) + messageSize > MAX_REASSEMBLY_BYTES_TOTAL) {
+                    ReassemblyBytesInUse().fetch_sub(messageSize, std::memory_order_relaxed);
+                    RF_NETWORK_WARN("FRAGMENT: Global reassembly limit ({} bytes) reached. Dropping fragment Seq={}.",
+                        MAX_REASSEMBLY_BYTES_TOTAL, receivedHeader.sequenceNumber);
+                    return FragmentReassemblyResult::Rejected;
+                }
+                reassembly = freeSlot;
+                reassembly->message = PacketBuffer::Allocate(messageSize);
+                reassembly->messageSize = messageSize;
+                reassembly->awaitingFragments = true; // From here on Reset() returns the reserved bytes
+                if (!reassembly->message.MutableData()) {
+                    RF_NETWORK_ERROR("FRAGMENT: Failed to allocate {} bytes for reassembly. Dropping fragment Seq={}.", messageSize, receivedHeader.sequenceNumber);
+                    reassembly->Reset();
+                    return FragmentReassemblyResult::Rejected;
+                }
+                reassembly->fragmentStartSequenceNumber = firstSequenceNumber;
+                reassembly->totalFragments = count;
+                reassembly->receivedFragmentCount = 0;
+                reassembly->receivedFragmentMask = 0;
+            }
+
+            const uint32_t fragmentBit = 1U << index;
+            if (reassembly->receivedFragmentMask & fragmentBit) {
+                return FragmentReassemblyResult::Incomplete; // Duplicate; the sequence check should already have caught it
+            }
+            std::memcpy(reassembly->message.MutableData() + offset, fragmentData + GetFragmentHeaderSize(), chunkSize);
+            reassembly->receivedFragmentMask |= fragmentBit;
+            reassembly->receivedFragmentCount++;
+            reassembly->lastFragmentArrivalTime = now;
+
+            if (reassembly->receivedFragmentCount < reassembly->totalFragments) {
+                return FragmentReassemblyResult::Incomplete;
+            }
+            reassembly->message.SetSize(messageSize);
+            outMessage = std::move(reassembly->message);
+            RF_NETWORK_DEBUG("FRAGMENT: Reassembled {} byte message from {} fragments (first Seq={}).", messageSize, count, firstSequenceNumber);
+            reassembly->Reset();
+            return FragmentReassemblyResult::Complete;
+        }
+
         // --- ProcessIncomingPacketHeader ---
         bool ProcessIncomingPacketHeader(
             ReliableConnectionState& connectionState,
@@ -122,6 +907,30 @@ namespace RiftForged {
             SequenceNumber remoteAckNum = receivedHeader.ackNumber;
             uint32_t remoteAckBits = receivedHeader.ackBitfield;
 
+            // ACK ranges sit in front of any payload; take them off before the payload is looked at.
+            const uint8_t* ackRangesData = nullptr;
+            uint8_t ackRangeCount = 0;
+            uint8_t nackRangeCount = 0;
+            if (HasFlag(receivedHeader.flags, GamePacketFlag::HAS_ACK_RANGES)) {
+                AckRangesHeader rangesHeader{ 0, 0 };
+                if (packetPayloadData && packetPayloadLength >= GetAckRangesHeaderSize()) {
+                    std::memcpy(&rangesHeader, packetPayloadData, GetAckRangesHeaderSize());
+                }
+                const size_t runCount = static_cast<size_t>(rangesHeader.rangeCount) + rangesHeader.nackCount;
+                const size_t rangesSize = GetAckRangesHeaderSize() + runCount * GetAckRangeSize();
+                if (runCount == 0 || rangesHeader.rangeCount > MAX_ACK_RANGES_PER_PACKET || rangesHeader.nackCount > MAX_ACK_RANGES_PER_PACKET ||
+                    packetPayloadLength < rangesSize) {
+                    RF_NETWORK_WARN("ACK RECV: Malformed ACK ranges ({} ranges, {} NACKs in a {} byte payload). Discarding packet.",
+                        rangesHeader.rangeCount, rangesHeader.nackCount, packetPayloadLength);
+                    return false;
+                }
+                ackRangesData = packetPayloadData + GetAckRangesHeaderSize();
+                ackRangeCount = rangesHeader.rangeCount;
+                nackRangeCount = rangesHeader.nackCount;
+                packetPayloadData += rangesSize;
+                packetPayloadLength = static_cast<uint16_t>(packetPayloadLength - rangesSize);
+            }
+
             if (remoteAckNum > 0 || remoteAckBits > 0 || HasFlag(receivedHeader.flags, GamePacketFlag::IS_ACK_ONLY)) {
                 RF_NETWORK_TRACE("ACK RECV: Processing ACKs from remote: RemoteAckNum={}, RemoteAckBits=0x{:08X}. Our current unacked count: {}. HeaderFlags=0x{:02X}",
                     remoteAckNum, remoteAckBits, connectionState.unacknowledgedSentPackets.size(), receivedHeader.flags);
@@ -129,63 +938,117 @@ namespace RiftForged {
 
             size_t preAckRemovalCount = connectionState.unacknowledgedSentPackets.size();
             int actualAckedCountThisPass = 0;
+            const auto ackTime = std::chrono::steady_clock::now();
+
+            // Each acknowledged sequence maps straight to its window slot; nothing else is visited.
+            auto acknowledge = [&](SequenceNumber ackedSeq, uint32_t diff) {
+                ReliableConnectionState::SentPacketInfo* sentPacket = connectionState.unacknowledgedSentPackets.Find(ackedSeq);
+                if (!sentPacket) {
+                    return; // Not in flight (already ACKed, never reliable, or from a previous window).
+                }
+                if (diff == 0) {
+                    RF_NETWORK_INFO("ACK MATCH: Direct ACK for our_sent_seq={} by remote_ack_num={}. Removing.",
+                        ackedSeq, remoteAckNum);
+                }
+                else if (diff > 32) {
+                    RF_NETWORK_INFO("ACK MATCH: Range ACK for our_sent_seq={} (diff={}) by remote_ack_num={}. Removing.",
+                        ackedSeq, diff, remoteAckNum);
+                }
+                else {
+                    RF_NETWORK_INFO("ACK MATCH: Bitfield ACK for our_sent_seq={} (diff={}, bitIndex={}) by remote_ack_num={}, remote_ack_bits=0x{:08X}. Removing.",
+                        ackedSeq, diff, diff - 1, remoteAckNum, remoteAckBits);
+                }
+
+                actualAckedCountThisPass++;
+                if (sentPacket->retries == 0) {
+                    float rtt_sample_ms = static_cast<float>(
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                            ackTime - sentPacket->timeSent
+                        ).count()
+                        );
+                    RF_NETWORK_TRACE("RTT Sample for Seq {}: {:.2f} ms", ackedSeq, rtt_sample_ms);
+                    connectionState.ApplyRTTSampleUnlocked(rtt_sample_ms); // <<< USING UNLOCKED VERSION
+                    RF_NETWORK_INFO("RTO Updated for connection: {:.2f} ms (SRTT: {:.2f}, RTTVAR: {:.2f})",
+                        connectionState.retransmissionTimeout_ms,
+                        connectionState.smoothedRTT_ms,
+                        connectionState.rttVariance_ms);
+                }
+                else {
+                    RF_NETWORK_TRACE("RTT Sample Skipped for retransmitted packet Seq {} (retries={})",
+                        ackedSeq, sentPacket->retries);
+                }
+                connectionState.congestionController->OnPacketAcked(sentPacket->sentSize,
+                    connectionState.smoothedRTT_ms, connectionState.rttVariance_ms, ackTime);
+                if (!sentPacket->isAckOnly) {
+                    connectionState.measuredLossRate -= LOSS_RATE_SMOOTHING * connectionState.measuredLossRate;
+                }
+                connectionState.transferStats.bytesAcknowledged += sentPacket->sentSize;
+                connectionState.goodputSampleBytes += sentPacket->sentSize;
+                // Anything still in flight well behind this sequence is now a fast retransmit candidate.
+                if (connectionState.newestAcknowledgedSequence == 0 ||
+                    IsSequenceGreaterThan(ackedSeq, connectionState.newestAcknowledgedSequence)) {
+                    connectionState.newestAcknowledgedSequence = ackedSeq;
+                    connectionState.fastRetransmitCheckPending = true;
+                }
+                connectionState.unacknowledgedSentPackets.Erase(ackedSeq);
+            };
 
-            connectionState.unacknowledgedSentPackets.remove_if(
-                [&](const ReliableConnectionState::SentPacketInfo& sentPacket) {
-                    bool acknowledged = false;
-                    if (sentPacket.sequenceNumber == remoteAckNum) {
-                        acknowledged = true;
-                        RF_NETWORK_INFO("ACK MATCH: Direct ACK for our_sent_seq={} by remote_ack_num={}. Marking for removal.",
-                            sentPacket.sequenceNumber, remoteAckNum);
+            if (preAckRemovalCount > 0) {
+                // Sequence 0 is never assigned to a reliable packet, so an ackNumber of 0 acknowledges nothing.
+                if (remoteAckNum != 0) {
+                    acknowledge(remoteAckNum, 0);
+                }
+                // Bit i of the bitfield acknowledges remoteAckNum - (i + 1).
+                for (uint32_t bitIndex = 0; bitIndex < 32; ++bitIndex) {
+                    if ((remoteAckBits >> bitIndex) & 1U) {
+                        acknowledge(remoteAckNum - (bitIndex + 1), bitIndex + 1);
                     }
-                    else if (sentPacket.sequenceNumber < remoteAckNum) {
-                        uint32_t diff = remoteAckNum - sentPacket.sequenceNumber;
-                        if (diff > 0 && diff <= 32) {
-                            uint32_t bitIndex = diff - 1;
-                            if ((remoteAckBits >> bitIndex) & 1U) {
-                                acknowledged = true;
-                                RF_NETWORK_INFO("ACK MATCH: Bitfield ACK for our_sent_seq={} (diff={}, bitIndex={}) by remote_ack_num={}, remote_ack_bits=0x{:08X}. Marking for removal.",
-                                    sentPacket.sequenceNumber, diff, bitIndex, remoteAckNum, remoteAckBits);
-                            }
-                            else {
-                                RF_NETWORK_TRACE("ACK CHECK: Bitfield NO match for our_sent_seq={} (diff={}, bitIndex={}). Remote AckBits: 0x{:08X}, Bit to test: 0x{:08X}",
-                                    sentPacket.sequenceNumber, diff, bitIndex, remoteAckBits, (1U << bitIndex));
-                            }
-                        }
-                        else {
-                            RF_NETWORK_TRACE("ACK CHECK: our_sent_seq={} is too old (diff={}) to be in bitfield of remote_ack_num={}. Not acknowledged by this packet.",
-                                sentPacket.sequenceNumber, diff, remoteAckNum);
-                        }
+                }
+                // Each range acknowledges 'length' sequences ending 'offset' behind remoteAckNum.
+                for (uint8_t rangeIndex = 0; rangeIndex < ackRangeCount; ++rangeIndex) {
+                    AckRange range;
+                    std::memcpy(&range, ackRangesData + rangeIndex * GetAckRangeSize(), GetAckRangeSize());
+                    if (range.offset <= 32 || range.length == 0 ||
+                        static_cast<uint32_t>(range.offset) + range.length - 1 > RECEIVED_SEQUENCE_HISTORY_SIZE) {
+                        continue; // Outside the window the remote can report; ignore rather than walk it.
                     }
-                    else {
-                        RF_NETWORK_TRACE("ACK CHECK: our_sent_seq={} > remote_ack_num={}. Not ACKed by this ack number or bitfield.",
-                            sentPacket.sequenceNumber, remoteAckNum);
+                    for (uint32_t k = 0; k < range.length; ++k) {
+                        acknowledge(remoteAckNum - (range.offset + k), range.offset + k);
                     }
-
-                    if (acknowledged) {
-                        actualAckedCountThisPass++;
-                        if (sentPacket.retries == 0) {
-                            float rtt_sample_ms = static_cast<float>(
-                                std::chrono::duration_cast<std::chrono::milliseconds>(
-                                    std::chrono::steady_clock::now() - sentPacket.timeSent
-                                ).count()
-                                );
-                            RF_NETWORK_TRACE("RTT Sample for Seq {}: {:.2f} ms", sentPacket.sequenceNumber, rtt_sample_ms);
-                            connectionState.ApplyRTTSampleUnlocked(rtt_sample_ms); // <<< USING UNLOCKED VERSION
-                            RF_NETWORK_INFO("RTO Updated for connection: {:.2f} ms (SRTT: {:.2f}, RTTVAR: {:.2f})",
-                                connectionState.retransmissionTimeout_ms,
-                                connectionState.smoothedRTT_ms,
-                                connectionState.rttVariance_ms);
-                        }
-                        else {
-                            RF_NETWORK_TRACE("RTT Sample Skipped for retransmitted packet Seq {} (retries={})",
-                                sentPacket.sequenceNumber, sentPacket.retries);
+                }
+                // NACKed runs follow; their packets are resent by the next CollectFastRetransmissions call.
+                for (uint8_t nackIndex = 0; nackIndex < nackRangeCount; ++nackIndex) {
+                    AckRange range;
+                    std::memcpy(&range, ackRangesData + (ackRangeCount + nackIndex) * GetAckRangeSize(), GetAckRangeSize());
+                    if (range.offset == 0 || range.length == 0 ||
+                        static_cast<uint32_t>(range.offset) + range.length - 1 > RECEIVED_SEQUENCE_HISTORY_SIZE) {
+                        continue;
+                    }
+                    for (uint32_t k = 0; k < range.length; ++k) {
+                        ReliableConnectionState::SentPacketInfo* sentPacket =
+                            connectionState.unacknowledgedSentPackets.Find(remoteAckNum - (range.offset + k));
+                        if (sentPacket && !sentPacket->fastRetransmitted) {
+                            RF_NETWORK_DEBUG("NACK RECV: Remote reports our_sent_seq={} missing.", sentPacket->sequenceNumber);
+                            sentPacket->lossReported = true;
+                            connectionState.fastRetransmitCheckPending = true;
                         }
-                        return true;
                     }
-                    return false;
                 }
-            );
+            }
+
+            // Goodput: bytes acknowledged per second, over intervals of at least GOODPUT_SAMPLE_INTERVAL_MS.
+            if (connectionState.goodputSampleStart == std::chrono::steady_clock::time_point::min()) {
+                connectionState.goodputSampleStart = ackTime;
+                connectionState.goodputSampleBytes = 0;
+            }
+            else if (ackTime - connectionState.goodputSampleStart >= std::chrono::milliseconds(GOODPUT_SAMPLE_INTERVAL_MS)) {
+                const float elapsedSec = std::chrono::duration<float>(ackTime - connectionState.goodputSampleStart).count();
+                const float sample = static_cast<float>(connectionState.goodputSampleBytes) / elapsedSec;
+                float& goodput = connectionState.transferStats.goodputBytesPerSec;
+                goodput = goodput == 0.0f ? sample : goodput + GOODPUT_SMOOTHING * (sample - goodput);
+                connectionState.goodputSampleStart = ackTime;
+                connectionState.goodputSampleBytes = 0;
+            }
 
             if (actualAckedCountThisPass > 0) {
                 RF_NETWORK_TRACE("Processed {} ACKs. Unacked packets remaining: {} (was {})",
@@ -206,19 +1069,22 @@ namespace RiftForged {
 
                 if (IsSequenceGreaterThan(incomingSeqNum, connectionState.highestReceivedSequenceNumberFromRemote)) {
                     uint32_t diff = incomingSeqNum - connectionState.highestReceivedSequenceNumberFromRemote; // Careful with wrap-around if not using IsSequenceGreaterThan
-                    if (diff >= 32) { // If using proper sequence comparison, diff is direct for positive jumps
-                        connectionState.receivedSequenceBitfield = 0;
-                        RF_NETWORK_WARN("RECV RELIABLE: Large sequence number jump detected (Seq={}, prev_highest={}, diff={}). Resetting receivedSequenceBitfield.",
+                    if (diff >= RECEIVED_SEQUENCE_HISTORY_SIZE) { // If using proper sequence comparison, diff is direct for positive jumps
+                        RF_NETWORK_WARN("RECV RELIABLE: Large sequence number jump detected (Seq={}, prev_highest={}, diff={}). Resetting receivedSequenceHistory.",
                             incomingSeqNum, connectionState.highestReceivedSequenceNumberFromRemote, diff);
                     }
-                    else {
-                        connectionState.receivedSequenceBitfield <<= diff;
-                        // Bit for the *old* highest needs to be set before new highest is updated
-                        if (connectionState.highestReceivedSequenceNumberFromRemote > 0 || diff > 0) { // Only if old highest was valid or there's a diff
-                            connectionState.receivedSequenceBitfield |= (1U << (diff - 1));
-                        }
-                    }
+                    // Bit for the *old* highest needs to be set before new highest is updated
+                    AdvanceReceivedHistoryUnlocked(connectionState, diff, connectionState.highestReceivedSequenceNumberFromRemote > 0);
                     connectionState.highestReceivedSequenceNumberFromRemote = incomingSeqNum;
+                    if (!connectionState.ackRangesPending && HasUnreportedSequenceBeyondBitfieldUnlocked(connectionState, diff)) {
+                        connectionState.ackRangesPending = true;
+                        RF_NETWORK_TRACE("RECV RELIABLE: Sequences behind Seq={} left the ACK bitfield unreported. ACK ranges pending.", incomingSeqNum);
+                    }
+                    if (connectionState.explicitNacksEnabled && HasNewGapToNackUnlocked(connectionState, diff)) {
+                        connectionState.nackPending = true;
+                        RF_NETWORK_DEBUG("RECV RELIABLE: Gap behind Seq={} is {} sequences old. NACK pending.",
+                            incomingSeqNum, FAST_RETRANSMIT_REORDER_THRESHOLD);
+                    }
                     shouldRelayToGameLogic = true;
                     ackStateForRemoteUpdated = true;
                     RF_NETWORK_INFO("RECV RELIABLE: New highest remote Seq={}. Our ACK state FOR THEM: highest_ack_to_send={}, bits_to_send=0x{:08X}. Will process payload.",
@@ -226,29 +1092,44 @@ namespace RiftForged {
                 }
                 else if (IsSequenceLessThan(incomingSeqNum, connectionState.highestReceivedSequenceNumberFromRemote)) {
                     uint32_t diff = connectionState.highestReceivedSequenceNumberFromRemote - incomingSeqNum; // Careful with wrap-around
-                    if (diff > 0 && diff <= 32) {
-                        uint32_t bitToSet = (1U << (diff - 1));
-                        if (!(connectionState.receivedSequenceBitfield & bitToSet)) {
-                            connectionState.receivedSequenceBitfield |= bitToSet;
+                    if (diff > 0 && diff <= RECEIVED_SEQUENCE_HISTORY_SIZE) {
+                        if (diff > 32) {
+                            // Beyond the header bitfield: only ACK ranges can tell the remote we have it,
+                            // including when this is a retransmission of a packet whose ACK it never saw.
+                            connectionState.ackRangesPending = true;
+                            ackStateForRemoteUpdated = true;
+                        }
+                        if (!IsReceivedHistoryBitSet(connectionState, diff - 1)) {
+                            SetReceivedHistoryBitUnlocked(connectionState, diff - 1);
                             shouldRelayToGameLogic = true;
                             ackStateForRemoteUpdated = true;
                             RF_NETWORK_INFO("RECV RELIABLE: Accepted out-of-order remote Seq={} (diff={}). Our ACK state FOR THEM: highest_ack_to_send={}, bits_to_send=0x{:08X}. Will process payload.",
                                 incomingSeqNum, diff, connectionState.highestReceivedSequenceNumberFromRemote, connectionState.receivedSequenceBitfield);
                         }
                         else {
-                            RF_NETWORK_TRACE("RECV RELIABLE: Duplicate OLD reliable remote Seq={} (already in bitfield). Discarding payload.", incomingSeqNum);
+                            RF_NETWORK_TRACE("RECV RELIABLE: Duplicate OLD reliable remote Seq={} (already in history). Discarding payload.", incomingSeqNum);
                             shouldRelayToGameLogic = false;
+                            if (connectionState.compactHeaders) {
+                                connectionState.compactAckRefreshPending = true;
+                                ackStateForRemoteUpdated = true;
+                            }
                         }
                     }
                     else {
-                        RF_NETWORK_TRACE("RECV RELIABLE: Very OLD reliable remote Seq={} (older than highest_remote_seq {} - 32). Discarding payload.",
-                            incomingSeqNum, connectionState.highestReceivedSequenceNumberFromRemote);
+                        RF_NETWORK_TRACE("RECV RELIABLE: Very OLD reliable remote Seq={} (older than highest_remote_seq {} - {}). Discarding payload.",
+                            incomingSeqNum, connectionState.highestReceivedSequenceNumberFromRemote, RECEIVED_SEQUENCE_HISTORY_SIZE);
                         shouldRelayToGameLogic = false;
                     }
                 }
                 else { // incomingSeqNum == connectionState.highestReceivedSequenceNumberFromRemote
                     RF_NETWORK_TRACE("RECV RELIABLE: Duplicate of current highest remote Seq={}. Discarding payload.", incomingSeqNum);
                     shouldRelayToGameLogic = false;
+                    // Compact headers leave unchanged ACK fields out, so if the datagram that carried this
+                    // sequence's ACK was lost, only a resend of the ACK fields tells the remote.
+                    if (connectionState.compactHeaders) {
+                        connectionState.compactAckRefreshPending = true;
+                        ackStateForRemoteUpdated = true;
+                    }
                 }
             }
             else if (packetPayloadData && packetPayloadLength > 0 && !HasFlag(receivedHeader.flags, GamePacketFlag::IS_ACK_ONLY)) {
@@ -293,53 +1174,786 @@ namespace RiftForged {
         ) {
             std::vector<std::vector<uint8_t>> packetsToResend;
             std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
-            auto it = connectionState.unacknowledgedSentPackets.begin();
-
-            while (it != connectionState.unacknowledgedSentPackets.end()) {
-                ReliableConnectionState::SentPacketInfo& sentPacket = *it;
+            connectionState.unacknowledgedSentPackets.ForEachInFlight([&](ReliableConnectionState::SentPacketInfo& sentPacket) {
                 auto timeSinceSent = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - sentPacket.timeSent);
 
                 if (timeSinceSent.count() >= static_cast<long long>(connectionState.retransmissionTimeout_ms)) {
-                    if (connectionState.ShouldDropPacket(sentPacket.retries)) {
-                        RF_NETWORK_ERROR("MAX RETRIES: Packet Seq={} EXCEEDED MAX RETRIES ({}). RTO used: {:.0f}ms. Dropping packet and flagging connection as lost.",
-                            sentPacket.sequenceNumber, MAX_PACKET_RETRIES, connectionState.retransmissionTimeout_ms);
-                        connectionState.connectionDroppedByMaxRetries = true;
-                        connectionState.isConnected = false;
-                        it = connectionState.unacknowledgedSentPackets.erase(it);
+                    if (!RetransmitOrDropUnlocked(connectionState, sentPacket, currentTime)) {
+                        return false;
                     }
-                    else {
-                        sentPacket.retries++;
-                        sentPacket.timeSent = currentTime;
-                        packetsToResend.push_back(sentPacket.packetData);
-
-                        // Store current RTO before doubling for logging
-                        float rtoThatTriggered = connectionState.retransmissionTimeout_ms;
-
-                        connectionState.retransmissionTimeout_ms = connectionState.retransmissionTimeout_ms * 2.0f;
-                        connectionState.retransmissionTimeout_ms = std::min(connectionState.retransmissionTimeout_ms, MAX_RTO_MS);
-                        connectionState.retransmissionTimeout_ms = std::max(connectionState.retransmissionTimeout_ms, MIN_RTO_MS);
-
-                        RF_NETWORK_WARN("RETRANSMIT: Packet Seq={} (Attempt #{}). RTO that triggered retransmit: {:.0f}ms. New connection RTO: {:.0f}ms",
-                            sentPacket.sequenceNumber, sentPacket.retries,
-                            rtoThatTriggered,
-                            connectionState.retransmissionTimeout_ms);
-                        it++;
+                    DropUnreliableMessagesUnlocked(sentPacket);
+                    RecordRetransmissionUnlocked(connectionState, sentPacket, true, currentTime);
+                    packetsToResend.push_back(sentPacket.packet.ToVector());
+                }
+                return true;
+                });
+            if (!packetsToResend.empty()) {
+                RF_NETWORK_TRACE("RETRANSMIT: Found {} packets to retransmit this cycle.", packetsToResend.size());
+            }
+            return packetsToResend;
+        }
+
+        // --- ProcessRetransmitTimer ---
+        RetransmitTimerResult ProcessRetransmitTimer(
+            ReliableConnectionState& connectionState,
+            SequenceNumber sequenceNumber,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket,
+            std::chrono::steady_clock::time_point& outNextDeadline
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            ReliableConnectionState::SentPacketInfo* sentPacket = connectionState.unacknowledgedSentPackets.Find(sequenceNumber);
+            if (!sentPacket) {
+                return RetransmitTimerResult::Acknowledged;
+            }
+
+            const auto rto = RtoAsDuration(connectionState.retransmissionTimeout_ms);
+            if (currentTime - sentPacket->timeSent < rto) {
+                outNextDeadline = sentPacket->timeSent + rto;
+                return RetransmitTimerResult::NotYetDue;
+            }
+
+            // While the pacer is overdrawn, timed-out packets wait their turn instead of going out together.
+            RefillPacerUnlocked(connectionState, currentTime);
+            if (connectionState.pacer.InDebt()) {
+                const float rate = connectionState.congestionController->GetPacingRateBytesPerSec(connectionState.smoothedRTT_ms);
+                outNextDeadline = currentTime + std::max<std::chrono::steady_clock::duration>(
+                    connectionState.pacer.TimeUntilRepaid(rate), std::chrono::milliseconds(1));
+                return RetransmitTimerResult::NotYetDue;
+            }
+
+            if (!RetransmitOrDropUnlocked(connectionState, *sentPacket, currentTime)) {
+                connectionState.unacknowledgedSentPackets.Erase(sequenceNumber);
+                return RetransmitTimerResult::ConnectionDropped;
+            }
+            DropUnreliableMessagesUnlocked(*sentPacket);
+            RecordRetransmissionUnlocked(connectionState, *sentPacket, true, currentTime);
+            if (sentPacket->packet.Size() + connectionState.datagramWireOverhead > DEFAULT_MAX_DATAGRAM_SIZE &&
+                sentPacket->retries >= PMTU_BLACK_HOLE_RETRIES &&
+                connectionState.maxDatagramSize > DEFAULT_MAX_DATAGRAM_SIZE) {
+                // Datagrams already in flight keep their size; only new ones are held to the default again.
+                RF_NETWORK_WARN("PathMtu: {} byte packet Seq={} keeps timing out. Falling back to {} byte datagrams until the next search.",
+                    sentPacket->packet.Size(), sequenceNumber, DEFAULT_MAX_DATAGRAM_SIZE);
+                connectionState.maxDatagramSize = DEFAULT_MAX_DATAGRAM_SIZE;
+                connectionState.pathMtuSearching = false;
+                connectionState.pathMtuProbeSize = 0;
+                connectionState.pathMtuNextSearchTime = currentTime + std::chrono::milliseconds(PMTU_RESEARCH_INTERVAL_MS);
+            }
+            outPacket = sentPacket->packet; // Another reference to the same bytes, no copy
+            outNextDeadline = currentTime + RtoAsDuration(connectionState.retransmissionTimeout_ms);
+            return RetransmitTimerResult::Retransmitted;
+        }
+
+        // --- CollectFastRetransmissions ---
+        size_t CollectFastRetransmissions(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            std::vector<PacketBuffer>& outPackets
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (!connectionState.fastRetransmitCheckPending) {
+                return 0;
+            }
+            connectionState.fastRetransmitCheckPending = false;
+
+            const SequenceNumber newestAcknowledged = connectionState.newestAcknowledgedSequence;
+            size_t collected = 0;
+            connectionState.unacknowledgedSentPackets.ForEachInFlight([&](ReliableConnectionState::SentPacketInfo& sentPacket) {
+                if (sentPacket.isAckOnly || sentPacket.fastRetransmitted) {
+                    return true; // A stale ACK is not worth resending early; the RTO handles repeat losses.
+                }
+                const bool overtaken = newestAcknowledged != 0 &&
+                    IsSequenceGreaterEqual(newestAcknowledged, sentPacket.sequenceNumber + FAST_RETRANSMIT_REORDER_THRESHOLD);
+                if (!overtaken && !sentPacket.lossReported) {
+                    return true;
+                }
+                if (connectionState.ShouldDropPacket(sentPacket.retries)) {
+                    return true; // Out of retries; its retransmission timer drops the connection.
+                }
+                // A loss inferred from ACKs says nothing about the path's RTT, so the RTO is not backed off.
+                sentPacket.retries++;
+                sentPacket.timeSent = currentTime;
+                sentPacket.fastRetransmitted = true;
+                DropUnreliableMessagesUnlocked(sentPacket);
+                RecordRetransmissionUnlocked(connectionState, sentPacket, false, currentTime);
+                outPackets.push_back(sentPacket.packet);
+                ++collected;
+                RF_NETWORK_WARN("FAST RETRANSMIT: Packet Seq={} (Attempt #{}). {}.", sentPacket.sequenceNumber, sentPacket.retries,
+                    sentPacket.lossReported ? "NACKed by remote" : "Later packets already ACKed");
+                return true;
+                });
+            return collected;
+        }
+
+        // --- AdmitOutgoingDatagram ---
+        bool AdmitOutgoingDatagram(
+            ReliableConnectionState& connectionState,
+            size_t datagramSize,
+            bool isReliable,
+            std::chrono::steady_clock::time_point currentTime
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            RefillPacerUnlocked(connectionState, currentTime);
+            if (isReliable) {
+                connectionState.pacer.ForceConsume(datagramSize);
+                return true;
+            }
+            const bool windowFull = connectionState.unacknowledgedSentPackets.BytesInFlight() >=
+                connectionState.congestionController->GetCongestionWindowBytes();
+            if (windowFull || !connectionState.pacer.TryConsume(datagramSize)) {
+                connectionState.transferStats.unreliableBytesShed += datagramSize;
+                RF_NETWORK_TRACE("AdmitOutgoingDatagram: Shedding {} byte unreliable datagram ({}).", datagramSize,
+                    windowFull ? "congestion window full" : "pacer empty");
+                return false;
+            }
+            connectionState.transferStats.datagramsSent++;
+            connectionState.transferStats.bytesSent += datagramSize;
+            return true;
+        }
+
+        // Applies the connection's FEC mode; in Auto, switches FEC with hysteresis on the measured loss rate.
+        // An open group is abandoned when FEC turns off. Assumes the caller holds the lock.
+        static void UpdateFecActiveUnlocked(ReliableConnectionState& connectionState) {
+            bool active = connectionState.fecActive;
+            switch (connectionState.fecMode) {
+            case UnreliableFecMode::On:
+                active = true;
+                break;
+            case UnreliableFecMode::Auto:
+                if (!active && connectionState.measuredLossRate >= FEC_ENABLE_LOSS_RATE) {
+                    active = true;
+                }
+                else if (active && connectionState.measuredLossRate < FEC_DISABLE_LOSS_RATE) {
+                    active = false;
+                }
+                break;
+            case UnreliableFecMode::Off:
+            default:
+                active = false;
+                break;
+            }
+            if (active == connectionState.fecActive) {
+                return;
+            }
+            RF_NETWORK_INFO("FEC: {} unreliable datagram protection (loss rate {:.3f}).", active ? "Enabling" : "Disabling",
+                connectionState.measuredLossRate);
+            connectionState.fecActive = active;
+            if (!active && connectionState.fecSendCount > 0) {
+                connectionState.fecSendGroup = (connectionState.fecSendGroup % FEC_GROUP_MASK) + 1;
+                connectionState.fecSendCount = 0;
+            }
+        }
+
+        // XORs 'length' bytes into an FEC accumulator, first zero-extending it if they reach past its end.
+        static bool XorIntoFecAccumulator(PacketBuffer& accumulator, size_t offset, const uint8_t* data, size_t length) {
+            if (accumulator.Capacity() == 0) {
+                accumulator = PacketBuffer::Allocate(PACKET_BUFFER_BLOCK_SIZE);
+            }
+            if (offset + length > accumulator.Capacity()) {
+                return false;
+            }
+            uint8_t* bytes = accumulator.MutableData();
+            if (offset + length > accumulator.Size()) {
+                std::memset(bytes + accumulator.Size(), 0, offset + length - accumulator.Size());
+                accumulator.SetSize(offset + length);
+            }
+            for (size_t i = 0; i < length; ++i) {
+                bytes[offset + i] ^= data[i];
+            }
+            return true;
+        }
+
+        static bool XorFecUnit(PacketBuffer& accumulator, uint8_t flags, const uint8_t* payloadData, size_t payloadLength) {
+            const uint8_t prefix[FEC_UNIT_PREFIX_SIZE] = {
+                flags, static_cast<uint8_t>(payloadLength & 0xFF), static_cast<uint8_t>((payloadLength >> 8) & 0xFF) };
+            return XorIntoFecAccumulator(accumulator, 0, prefix, FEC_UNIT_PREFIX_SIZE) &&
+                (payloadLength == 0 || XorIntoFecAccumulator(accumulator, FEC_UNIT_PREFIX_SIZE, payloadData, payloadLength));
+        }
+
+        // --- ProtectUnreliableDatagram ---
+        bool ProtectUnreliableDatagram(
+            ReliableConnectionState& connectionState,
+            PacketBuffer& datagram,
+            PacketBuffer& outParity
+        ) {
+            if (datagram.Size() < GetGamePacketHeaderSize()) {
+                return false;
+            }
+            GamePacketHeader header;
+            std::memcpy(&header, datagram.Data(), GetGamePacketHeaderSize());
+            if (HasFlag(header.flags, GamePacketFlag::IS_RELIABLE) || HasFlag(header.flags, GamePacketFlag::IS_ACK_ONLY)) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            UpdateFecActiveUnlocked(connectionState);
+            if (!connectionState.fecActive) {
+                return false;
+            }
+            // The parity datagram is FEC_UNIT_PREFIX_SIZE bytes longer than the group's longest datagram.
+            const size_t payloadLength = datagram.Size() - GetGamePacketHeaderSize();
+            if (datagram.Size() + FEC_UNIT_PREFIX_SIZE > DatagramSizeLimitUnlocked(connectionState)) {
+                RF_NETWORK_TRACE("FEC: {} byte datagram leaves no room for parity. Sending it unprotected.", datagram.Size());
+                return false;
+            }
+
+            if (connectionState.fecSendCount == 0) {
+                connectionState.fecSendParity.SetSize(0);
+            }
+            if (!XorFecUnit(connectionState.fecSendParity, header.flags, datagram.Data() + GetGamePacketHeaderSize(), payloadLength)) {
+                RF_NETWORK_ERROR("FEC: Failed to add a {} byte datagram to the parity. Sending it unprotected.", datagram.Size());
+                connectionState.fecSendGroup = (connectionState.fecSendGroup % FEC_GROUP_MASK) + 1;
+                connectionState.fecSendCount = 0;
+                return false;
+            }
+            const SequenceNumber tag = MakeFecTag(connectionState.fecSendGroup, connectionState.fecSendCount);
+            std::memcpy(datagram.MutableData() + offsetof(GamePacketHeader, sequenceNumber), &tag, sizeof(tag));
+            if (++connectionState.fecSendCount < FEC_GROUP_SIZE) {
+                return false;
+            }
+
+            // Group complete: emit its parity with the current ACK state, then open the next group.
+            GamePacketHeader parityHeader;
+            BuildOutgoingHeaderUnlocked(connectionState, static_cast<uint8_t>(GamePacketFlag::IS_ACK_ONLY), parityHeader);
+            parityHeader.sequenceNumber = MakeFecTag(connectionState.fecSendGroup, connectionState.fecSendCount);
+            const size_t paritySize = GetGamePacketHeaderSize() + connectionState.fecSendParity.Size();
+            outParity = PacketBuffer::Allocate(paritySize);
+            if (outParity.Capacity() >= paritySize) {
+                std::memcpy(outParity.MutableData(), &parityHeader, GetGamePacketHeaderSize());
+                std::memcpy(outParity.MutableData() + GetGamePacketHeaderSize(), connectionState.fecSendParity.Data(), connectionState.fecSendParity.Size());
+                outParity.SetSize(paritySize);
+                connectionState.transferStats.fecParityBytesSent += paritySize;
+            }
+            connectionState.fecSendGroup = (connectionState.fecSendGroup % FEC_GROUP_MASK) + 1;
+            connectionState.fecSendCount = 0;
+            return !outParity.Empty();
+        }
+
+        // --- ProcessIncomingFecDatagram ---
+        bool ProcessIncomingFecDatagram(
+            ReliableConnectionState& connectionState,
+            const GamePacketHeader& receivedHeader,
+            const uint8_t* packetPayloadData,
+            uint16_t packetPayloadLength,
+            uint8_t& outRecoveredFlags,
+            PacketBuffer& outRecoveredPayload
+        ) {
+            if (HasFlag(receivedHeader.flags, GamePacketFlag::IS_RELIABLE) || receivedHeader.sequenceNumber == 0) {
+                return false;
+            }
+            const bool isParity = HasFlag(receivedHeader.flags, GamePacketFlag::IS_ACK_ONLY);
+            const uint32_t group = FecGroupOf(receivedHeader.sequenceNumber);
+            const uint8_t index = FecIndexOf(receivedHeader.sequenceNumber);
+            if (group == 0 || (isParity ? (index == 0 || index > FEC_MAX_GROUP_SIZE) : index >= FEC_MAX_GROUP_SIZE) ||
+                (packetPayloadLength > 0 && !packetPayloadData)) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (connectionState.fecReceiveGroup == 0 || IsFecGroupNewer(group, connectionState.fecReceiveGroup)) {
+                connectionState.fecReceiveGroup = group;
+                connectionState.fecReceiveMask = 0;
+                connectionState.fecReceiveCount = 0;
+                connectionState.fecReceiveCovered = 0;
+                connectionState.fecReceiveRecovered = false;
+                connectionState.fecReceiveParity.SetSize(0);
+            }
+            else if (group != connectionState.fecReceiveGroup || connectionState.fecReceiveRecovered) {
+                return false; // An older group, or nothing left to rebuild in this one
+            }
+
+            if (isParity) {
+                if (connectionState.fecReceiveCovered != 0 ||
+                    !XorIntoFecAccumulator(connectionState.fecReceiveParity, 0, packetPayloadData, packetPayloadLength)) {
+                    return false;
+                }
+                connectionState.fecReceiveCovered = index;
+            }
+            else {
+                const uint32_t bit = 1U << index;
+                if ((connectionState.fecReceiveMask & bit) != 0 ||
+                    !XorFecUnit(connectionState.fecReceiveParity, receivedHeader.flags, packetPayloadData, packetPayloadLength)) {
+                    return false;
+                }
+                connectionState.fecReceiveMask |= bit;
+                connectionState.fecReceiveCount++;
+            }
+
+            // Rebuild once the parity and all but one of the datagrams it covers are in.
+            const uint8_t covered = connectionState.fecReceiveCovered;
+            if (covered == 0 || connectionState.fecReceiveCount + 1 != covered) {
+                return false;
+            }
+            const uint32_t coveredMask = covered >= 32 ? 0xFFFFFFFFU : ((1U << covered) - 1);
+            const PacketBuffer& unit = connectionState.fecReceiveParity;
+            connectionState.fecReceiveRecovered = true;
+            if ((connectionState.fecReceiveMask & ~coveredMask) != 0 || unit.Size() < FEC_UNIT_PREFIX_SIZE) {
+                RF_NETWORK_WARN("FEC: Group {} does not match its parity ({} datagrams covered). Not rebuilding.", group, covered);
+                return false;
+            }
+            const uint8_t flags = unit.Data()[0];
+            const size_t payloadLength = static_cast<size_t>(unit.Data()[1]) | (static_cast<size_t>(unit.Data()[2]) << 8);
+            if (payloadLength == 0 || FEC_UNIT_PREFIX_SIZE + payloadLength > unit.Size() ||
+                HasFlag(flags, GamePacketFlag::IS_RELIABLE) || HasFlag(flags, GamePacketFlag::IS_ACK_ONLY)) {
+                RF_NETWORK_WARN("FEC: Rebuilt datagram of group {} is malformed (flags 0x{:02X}, {} of {} bytes). Discarding.",
+                    group, flags, payloadLength, unit.Size());
+                return false;
+            }
+            outRecoveredPayload = PacketBuffer::CopyFrom(unit.Data() + FEC_UNIT_PREFIX_SIZE, payloadLength);
+            if (outRecoveredPayload.Empty()) {
+                return false;
+            }
+            outRecoveredFlags = flags;
+            connectionState.transferStats.fecDatagramsRecovered++;
+            RF_NETWORK_DEBUG("FEC: Rebuilt a lost {} byte datagram of group {} from parity.", payloadLength, group);
+            return true;
+        }
+
+        static_assert(AEAD_TAG_SIZE == CryptoManager::AEAD_TAG_BYTES, "GamePacketHeader.h and CryptoManager disagree on the AEAD tag size");
+
+        // --- Compact headers ---
+        static void WriteLittleEndian(uint8_t* out, uint32_t value, size_t byteCount) {
+            for (size_t i = 0; i < byteCount; ++i) {
+                out[i] = static_cast<uint8_t>(value >> (8 * i));
+            }
+        }
+
+        static uint32_t ReadLittleEndian(const uint8_t* in, size_t byteCount) {
+            uint32_t value = 0;
+            for (size_t i = 0; i < byteCount; ++i) {
+                value |= static_cast<uint32_t>(in[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        void EnableCompactPacketHeaders(ReliableConnectionState& connectionState) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            connectionState.compactHeadersNegotiated = true;
+            connectionState.compactHeaders = true;
+        }
+
+        // Numbers a wire datagram whose header (headerSize bytes) is already in place at 'wire': takes the
+        // next transmit counter and writes it after the header. Assumes the caller holds the lock.
+        static uint64_t ReserveSealCounterUnlocked(ReliableConnectionState& connectionState, uint8_t* wire, size_t headerSize) {
+            const uint64_t counter = connectionState.secureContext.next_tx_nonce++;
+            uint8_t* counterField = wire + headerSize;
+            WriteLittleEndian(counterField, static_cast<uint32_t>(counter), 4);
+            WriteLittleEndian(counterField + 4, static_cast<uint32_t>(counter >> 32), 4);
+            return counter;
+        }
+
+        // Seals a numbered wire datagram: encrypts the payload from 'payload' into the space after the
+        // counter (in place when 'payload' is that space) and appends the tag. Touches no connection state.
+        static bool SealWireDatagram(
+            const CryptoManager::AeadSessionKey& key,
+            uint8_t* wire,
+            size_t headerSize,
+            uint64_t counter,
+            const uint8_t* payload,
+            size_t payloadSize
+        ) {
+            uint8_t nonce[CryptoManager::AEAD_NONCE_BYTES];
+            SecureConnectionContext::write_aead_nonce(counter, nonce);
+
+            uint8_t* ciphertext = wire + headerSize + AEAD_COUNTER_SIZE;
+            return CryptoManager::AeadEncrypt(key,
+                std::span<const uint8_t>(payload, payloadSize),
+                std::span<uint8_t>(ciphertext, payloadSize),
+                std::span<const uint8_t>(wire, headerSize + AEAD_COUNTER_SIZE),
+                nonce,
+                std::span<uint8_t, AEAD_TAG_SIZE>(ciphertext + payloadSize, AEAD_TAG_SIZE));
+        }
+
+        // --- PrepareOutgoingDatagramForWire ---
+        PacketBuffer PrepareOutgoingDatagramForWire(
+            ReliableConnectionState& connectionState,
+            const PacketBuffer& datagram,
+            DeferredDatagramSeal* outDeferredSeal
+        ) {
+            if (outDeferredSeal) {
+                *outDeferredSeal = DeferredDatagramSeal();
+            }
+            if (datagram.Size() < GetGamePacketHeaderSize()) {
+                return datagram;
+            }
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (!connectionState.compactHeaders && !connectionState.encrypted) {
+                return datagram;
+            }
+
+            GamePacketHeader header;
+            std::memcpy(&header, datagram.Data(), GetGamePacketHeaderSize());
+            // A path MTU probe keeps its full header, so it goes out at exactly the size under test.
+            const bool compact = connectionState.compactHeaders && !HasFlag(header.flags, GamePacketFlag::IS_HEARTBEAT);
+            uint8_t compactHeader[MAX_COMPACT_HEADER_SIZE];
+            const uint8_t* wireHeader = datagram.Data();
+            size_t headerSize = GetGamePacketHeaderSize();
+            bool sendAck = false;
+            if (compact) {
+                uint8_t fields = 0;
+                headerSize = MIN_COMPACT_HEADER_SIZE;
+                compactHeader[1] = header.flags;
+
+                const bool isReliable = HasFlag(header.flags, GamePacketFlag::IS_RELIABLE);
+                if (header.sequenceNumber != 0) {
+                    fields |= static_cast<uint8_t>(CompactHeaderField::HAS_SEQUENCE);
+                    const size_t sequenceBytes = isReliable ? 2 : 4; // Unreliable sequences are FEC tags
+                    if (!isReliable) {
+                        fields |= static_cast<uint8_t>(CompactHeaderField::WIDE_SEQUENCE);
                     }
+                    WriteLittleEndian(compactHeader + headerSize, header.sequenceNumber, sequenceBytes);
+                    headerSize += sequenceBytes;
+                }
+                // Reliable and ACK-only datagrams always carry the ACK fields, so losing one unreliable
+                // datagram never leaves the remote without our latest ACK for long.
+                sendAck = isReliable || HasFlag(header.flags, GamePacketFlag::IS_ACK_ONLY) ||
+                    connectionState.compactAckRefreshPending ||
+                    header.ackNumber != connectionState.compactAckNumberSent || header.ackBitfield != connectionState.compactAckBitfieldSent;
+                if (sendAck) {
+                    fields |= static_cast<uint8_t>(CompactHeaderField::HAS_ACK);
+                    WriteLittleEndian(compactHeader + headerSize, header.ackNumber, 2);
+                    WriteLittleEndian(compactHeader + headerSize + 2, header.ackBitfield, 4);
+                    headerSize += 6;
+                }
+                compactHeader[0] = static_cast<uint8_t>(COMPACT_HEADER_MARKER | fields);
+                wireHeader = compactHeader;
+            }
+
+            const uint8_t* payload = datagram.Data() + GetGamePacketHeaderSize();
+            const size_t payloadSize = datagram.Size() - GetGamePacketHeaderSize();
+            const size_t wireSize = headerSize + payloadSize + (connectionState.encrypted ? AEAD_DATAGRAM_OVERHEAD : 0);
+            PacketBuffer wireDatagram = PacketBuffer::Allocate(wireSize);
+            if (wireDatagram.Capacity() < wireSize) {
+                RF_NETWORK_ERROR("PrepareOutgoingDatagramForWire: Failed to allocate a {} byte datagram.", wireSize);
+                return PacketBuffer();
+            }
+            std::memcpy(wireDatagram.MutableData(), wireHeader, headerSize);
+            if (connectionState.encrypted && outDeferredSeal) {
+                // Numbered now, in send order; the caller seals it in place later, without the lock.
+                outDeferredSeal->counter = ReserveSealCounterUnlocked(connectionState, wireDatagram.MutableData(), headerSize);
+                outDeferredSeal->key = connectionState.secureContext.tx_aead_key;
+                outDeferredSeal->headerSize = static_cast<uint16_t>(headerSize);
+                outDeferredSeal->payloadSize = static_cast<uint16_t>(payloadSize);
+                if (payloadSize > 0) {
+                    std::memcpy(wireDatagram.MutableData() + headerSize + AEAD_COUNTER_SIZE, payload, payloadSize);
+                }
+            }
+            else if (connectionState.encrypted) {
+                // The payload is read once, from the retained datagram, and written once, encrypted.
+                const uint64_t counter = ReserveSealCounterUnlocked(connectionState, wireDatagram.MutableData(), headerSize);
+                if (!SealWireDatagram(*connectionState.secureContext.tx_aead_key, wireDatagram.MutableData(), headerSize, counter, payload, payloadSize)) {
+                    RF_NETWORK_ERROR("PrepareOutgoingDatagramForWire: Failed to seal a {} byte datagram.", wireSize);
+                    return PacketBuffer();
+                }
+            }
+            else if (payloadSize > 0) {
+                std::memcpy(wireDatagram.MutableData() + headerSize, payload, payloadSize);
+            }
+            wireDatagram.SetSize(wireSize);
+
+            if (sendAck) {
+                connectionState.compactAckNumberSent = header.ackNumber;
+                connectionState.compactAckBitfieldSent = header.ackBitfield;
+                connectionState.compactAckRefreshPending = false;
+            }
+            connectionState.transferStats.headerBytesSaved += GetGamePacketHeaderSize() - headerSize;
+            return wireDatagram;
+        }
+
+        // --- SealDeferredDatagram ---
+        bool SealDeferredDatagram(PacketBuffer& wireDatagram, const DeferredDatagramSeal& seal) {
+            if (!seal.key) {
+                return true;
+            }
+            if (wireDatagram.Size() != static_cast<size_t>(seal.headerSize) + seal.payloadSize + AEAD_DATAGRAM_OVERHEAD) {
+                return false;
+            }
+            uint8_t* wire = wireDatagram.MutableData();
+            return SealWireDatagram(*seal.key, wire, seal.headerSize, seal.counter,
+                wire + seal.headerSize + AEAD_COUNTER_SIZE, seal.payloadSize);
+        }
+
+        // --- EnablePacketEncryption ---
+        void EnablePacketEncryption(
+            ReliableConnectionState& connectionState,
+            const SecureConnectionContext& handshakeContext,
+            CryptoManager::AeadCipher cipher
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            SecureConnectionContext& secure = connectionState.secureContext;
+            std::memcpy(secure.session_tx_key, handshakeContext.session_tx_key, sizeof(secure.session_tx_key));
+            std::memcpy(secure.session_rx_key, handshakeContext.session_rx_key, sizeof(secure.session_rx_key));
+            secure.install_aead_keys(cipher);
+            connectionState.encrypted = true;
+            connectionState.datagramWireOverhead = AEAD_DATAGRAM_OVERHEAD;
+            RF_NETWORK_INFO("EnablePacketEncryption: Datagrams are now sealed with {}.",
+                cipher == CryptoManager::AeadCipher::AES256GCM ? "AES-256-GCM" : "ChaCha20-Poly1305");
+        }
+
+        // --- OpenIncomingDatagram ---
+        const uint8_t* OpenIncomingDatagram(
+            ReliableConnectionState& connectionState,
+            const uint8_t* data,
+            size_t size,
+            uint8_t* scratch,
+            size_t scratchCapacity,
+            size_t& outSize
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (!connectionState.encrypted) {
+                outSize = size;
+                return data;
+            }
+
+            // The header is only sized here; none of its fields is trusted before the tag checks out.
+            const size_t headerSize = IsCompactPacketHeader(data, size) ? GetCompactPacketHeaderSize(data, size) : GetGamePacketHeaderSize();
+            if (headerSize == 0 || size < headerSize + AEAD_DATAGRAM_OVERHEAD || size - AEAD_DATAGRAM_OVERHEAD > scratchCapacity) {
+                connectionState.transferStats.datagramsRejected++;
+                return nullptr;
+            }
+            const uint8_t* counterField = data + headerSize;
+            const uint64_t counter = ReadLittleEndian(counterField, 4) | (static_cast<uint64_t>(ReadLittleEndian(counterField + 4, 4)) << 32);
+            uint8_t nonce[CryptoManager::AEAD_NONCE_BYTES];
+            SecureConnectionContext::write_aead_nonce(counter, nonce);
+
+            const size_t payloadSize = size - headerSize - AEAD_DATAGRAM_OVERHEAD;
+            const uint8_t* ciphertext = counterField + AEAD_COUNTER_SIZE;
+            SecureConnectionContext& secure = connectionState.secureContext;
+            if (!CryptoManager::AeadDecrypt(secure.rx_aead_key,
+                std::span<const uint8_t>(ciphertext, payloadSize),
+                std::span<uint8_t>(scratch + headerSize, payloadSize),
+                std::span<const uint8_t>(data, headerSize + AEAD_COUNTER_SIZE),
+                nonce,
+                std::span<const uint8_t, AEAD_TAG_SIZE>(ciphertext + payloadSize, AEAD_TAG_SIZE)) ||
+                !secure.accept_rx_counter(counter)) {
+                connectionState.transferStats.datagramsRejected++;
+                return nullptr;
+            }
+            std::memcpy(scratch, data, headerSize);
+            outSize = headerSize + payloadSize;
+            return scratch;
+        }
+
+        // --- DecodeIncomingPacketHeader ---
+        size_t DecodeIncomingPacketHeader(
+            ReliableConnectionState& connectionState,
+            const uint8_t* data,
+            size_t size,
+            GamePacketHeader& outHeader
+        ) {
+            if (!data) {
+                return 0;
+            }
+            if (!IsCompactPacketHeader(data, size)) {
+                if (size < GetGamePacketHeaderSize()) {
+                    return 0;
+                }
+                std::memcpy(&outHeader, data, GetGamePacketHeaderSize());
+                return outHeader.protocolId == CURRENT_PROTOCOL_ID_VERSION ? GetGamePacketHeaderSize() : 0;
+            }
+
+            const size_t headerSize = GetCompactPacketHeaderSize(data, size);
+            if (headerSize == 0) {
+                return 0;
+            }
+            const uint8_t fields = data[0];
+            outHeader = GamePacketHeader(data[1]);
+            const uint8_t* field = data + MIN_COMPACT_HEADER_SIZE;
+
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            // A compact header has no protocol ID to check; only a peer that negotiated it may send one.
+            if (!connectionState.compactHeadersNegotiated) {
+                return 0;
+            }
+            if ((fields & static_cast<uint8_t>(CompactHeaderField::HAS_SEQUENCE)) != 0) {
+                if ((fields & static_cast<uint8_t>(CompactHeaderField::WIDE_SEQUENCE)) != 0) {
+                    outHeader.sequenceNumber = ReadLittleEndian(field, 4);
+                    field += 4;
                 }
                 else {
-                    it++;
+                    // The sequence nearest the newest one received with the same low 16 bits.
+                    const SequenceNumber newestReceived = connectionState.highestReceivedSequenceNumberFromRemote;
+                    const int16_t delta = static_cast<int16_t>(static_cast<uint16_t>(ReadLittleEndian(field, 2) - newestReceived));
+                    outHeader.sequenceNumber = newestReceived + static_cast<SequenceNumber>(static_cast<int32_t>(delta));
+                    field += 2;
                 }
             }
-            if (!packetsToResend.empty()) {
-                RF_NETWORK_TRACE("RETRANSMIT: Found {} packets to retransmit this cycle.", packetsToResend.size());
+            if ((fields & static_cast<uint8_t>(CompactHeaderField::HAS_ACK)) != 0) {
+                // ACKs are never ahead of what we sent: take the newest such sequence with these low 16 bits.
+                const SequenceNumber newestSent = connectionState.nextOutgoingSequenceNumber - 1;
+                const uint16_t behind = static_cast<uint16_t>(newestSent - ReadLittleEndian(field, 2));
+                connectionState.compactAckNumberReceived = newestSent - behind;
+                connectionState.compactAckBitfieldReceived = ReadLittleEndian(field + 2, 4);
             }
-            return packetsToResend;
+            outHeader.ackNumber = connectionState.compactAckNumberReceived;
+            outHeader.ackBitfield = connectionState.compactAckBitfieldReceived;
+            if (!connectionState.compactHeaders) {
+                connectionState.compactHeaders = true;
+                RF_NETWORK_INFO("DecodeIncomingPacketHeader: Remote sent a compact (v{}) header. Switching the connection to compact headers.",
+                    COMPACT_HEADER_VERSION);
+            }
+            return headerSize;
         }
 
-        // --- TrySendAckOnlyPacket ---
-        bool TrySendAckOnlyPacket(ReliableConnectionState& connectionState,
+        // --- Path MTU discovery ---
+        // Builds an IS_HEARTBEAT datagram of exactly datagramSize bytes whose payload starts with 'message'
+        // and is zero-padded from there. Assumes the caller holds the lock.
+        static PacketBuffer PreparePathMtuDatagramUnlocked(
+            ReliableConnectionState& connectionState,
+            const void* message,
+            size_t messageSize,
+            size_t datagramSize
+        ) {
+            uint8_t payload[PMTU_PROBE_MAX_DATAGRAM_SIZE] = {};
+            const size_t payloadSize = datagramSize - GetGamePacketHeaderSize();
+            std::memcpy(payload, message, messageSize);
+
+            // A probe may well be dropped on the way, so it must not stand in for an ACK we still owe.
+            const bool hadPendingAck = connectionState.hasPendingAckToSend;
+            const SequenceNumber lastAckNumberSent = connectionState.lastAckNumberSent;
+            const auto lastPacketSentTime = connectionState.lastPacketSentTimeToRemote;
+            PacketBuffer datagram = PrepareOutgoingPacketUnlocked_Internal(connectionState, payload, static_cast<uint16_t>(payloadSize),
+                static_cast<uint8_t>(GamePacketFlag::IS_HEARTBEAT));
+            connectionState.hasPendingAckToSend = connectionState.hasPendingAckToSend || hadPendingAck;
+            connectionState.lastAckNumberSent = lastAckNumberSent;
+            connectionState.lastPacketSentTimeToRemote = lastPacketSentTime;
+
+            if (!datagram.Empty()) {
+                // Like ACK-only packets, heartbeats bypass AdmitOutgoingDatagram.
+                connectionState.transferStats.datagramsSent++;
+                connectionState.transferStats.bytesSent += datagram.Size();
+            }
+            return datagram;
+        }
+
+        // Prepares the next probe of the running search into outPacket: the same size again while it has
+        // attempts left, otherwise a new size between the bounds (the largest size first, since most paths
+        // carry it). Ends the search once the bounds are PMTU_SEARCH_PRECISION apart and returns false.
+        // Assumes the caller holds the lock.
+        static bool PrepareNextPathMtuProbeUnlocked(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket
+        ) {
+            if (connectionState.pathMtuProbeSize == 0) {
+                if (connectionState.pathMtuUpperBound <= connectionState.maxDatagramSize + PMTU_SEARCH_PRECISION) {
+                    connectionState.pathMtuSearching = false;
+                    connectionState.pathMtuNextSearchTime = currentTime + std::chrono::milliseconds(PMTU_RESEARCH_INTERVAL_MS);
+                    RF_NETWORK_INFO("PathMtu: Search finished. Datagrams up to {} bytes reach the remote unfragmented.",
+                        connectionState.maxDatagramSize);
+                    return false;
+                }
+                connectionState.pathMtuProbeSize = connectionState.pathMtuUpperBound > PMTU_PROBE_MAX_DATAGRAM_SIZE ?
+                    PMTU_PROBE_MAX_DATAGRAM_SIZE : (connectionState.maxDatagramSize + connectionState.pathMtuUpperBound) / 2;
+                connectionState.pathMtuProbeAttempts = 0;
+            }
+
+            PathMtuProbe probe;
+            probe.kind = static_cast<uint8_t>(PathMtuMessageKind::PROBE);
+            probe.probeId = ++connectionState.pathMtuProbeId;
+            connectionState.pathMtuProbeAttempts++;
+            connectionState.pathMtuProbeSentTime = currentTime;
+            outPacket = PreparePathMtuDatagramUnlocked(connectionState, &probe, sizeof(probe),
+                connectionState.pathMtuProbeSize - connectionState.datagramWireOverhead);
+            RF_NETWORK_DEBUG("PathMtu: Probing {} bytes (attempt {}, confirmed {}, bound {}).", connectionState.pathMtuProbeSize,
+                connectionState.pathMtuProbeAttempts, connectionState.maxDatagramSize, connectionState.pathMtuUpperBound);
+            return true;
+        }
+
+        // --- ProcessPathMtuTimer ---
+        PathMtuTimerResult ProcessPathMtuTimer(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket,
+            std::chrono::steady_clock::time_point& outNextDeadline
+        ) {
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (!connectionState.compactHeaders || !connectionState.isConnected) {
+                return PathMtuTimerResult::Stopped; // A v4 peer drops IS_HEARTBEAT datagrams unanswered.
+            }
+
+            const auto rto = RtoAsDuration(connectionState.retransmissionTimeout_ms);
+            if (!connectionState.pathMtuSearching) {
+                if (currentTime < connectionState.pathMtuNextSearchTime) {
+                    outNextDeadline = connectionState.pathMtuNextSearchTime;
+                    return PathMtuTimerResult::Wait;
+                }
+                connectionState.pathMtuSearching = true;
+                connectionState.pathMtuUpperBound = PMTU_PROBE_MAX_DATAGRAM_SIZE + 1;
+                connectionState.pathMtuProbeSize = 0;
+            }
+            else if (connectionState.pathMtuProbeSize != 0) {
+                if (currentTime - connectionState.pathMtuProbeSentTime < rto) {
+                    outNextDeadline = connectionState.pathMtuProbeSentTime + rto;
+                    return PathMtuTimerResult::Wait;
+                }
+                if (connectionState.pathMtuProbeAttempts >= PMTU_PROBE_ATTEMPTS) {
+                    RF_NETWORK_DEBUG("PathMtu: {} byte probes went unanswered {} times; taking that size as too large.",
+                        connectionState.pathMtuProbeSize, connectionState.pathMtuProbeAttempts);
+                    connectionState.pathMtuUpperBound = connectionState.pathMtuProbeSize;
+                    connectionState.pathMtuProbeSize = 0;
+                }
+            }
+
+            if (!PrepareNextPathMtuProbeUnlocked(connectionState, currentTime, outPacket)) {
+                outNextDeadline = connectionState.pathMtuNextSearchTime;
+                return PathMtuTimerResult::Wait;
+            }
+            outNextDeadline = currentTime + rto;
+            return outPacket.Empty() ? PathMtuTimerResult::Wait : PathMtuTimerResult::ProbeReady;
+        }
+
+        // --- ProcessIncomingPathMtuDatagram ---
+        bool ProcessIncomingPathMtuDatagram(
+            ReliableConnectionState& connectionState,
+            const uint8_t* packetPayloadData,
+            uint16_t packetPayloadLength,
+            size_t receivedDatagramSize,
             std::chrono::steady_clock::time_point currentTime,
-            std::function<void(const std::vector<uint8_t>&)> sendPacketFunc) {
+            PacketBuffer& outPacket
+        ) {
+            if (!packetPayloadData || packetPayloadLength == 0) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
+            if (packetPayloadData[0] == static_cast<uint8_t>(PathMtuMessageKind::PROBE) && packetPayloadLength >= sizeof(PathMtuProbe)) {
+                PathMtuProbe probe;
+                std::memcpy(&probe, packetPayloadData, sizeof(probe));
+                PathMtuProbeAck probeAck;
+                probeAck.kind = static_cast<uint8_t>(PathMtuMessageKind::PROBE_ACK);
+                probeAck.probeId = probe.probeId;
+                probeAck.receivedSize = static_cast<uint16_t>(std::min<size_t>(receivedDatagramSize, UINT16_MAX));
+                outPacket = PreparePathMtuDatagramUnlocked(connectionState, &probeAck, sizeof(probeAck),
+                    GetGamePacketHeaderSize() + sizeof(probeAck));
+                return !outPacket.Empty();
+            }
+            if (packetPayloadData[0] != static_cast<uint8_t>(PathMtuMessageKind::PROBE_ACK) || packetPayloadLength < sizeof(PathMtuProbeAck)) {
+                RF_NETWORK_TRACE("PathMtu: Ignoring malformed heartbeat ({} bytes).", packetPayloadLength);
+                return false;
+            }
+
+            PathMtuProbeAck probeAck;
+            std::memcpy(&probeAck, packetPayloadData, sizeof(probeAck));
+            // Any probe that arrived proves its size, even one answered after we gave up on it.
+            if (!connectionState.pathMtuSearching || probeAck.receivedSize <= connectionState.maxDatagramSize ||
+                probeAck.receivedSize > PMTU_PROBE_MAX_DATAGRAM_SIZE) {
+                return false;
+            }
+            connectionState.maxDatagramSize = probeAck.receivedSize;
+            connectionState.pathMtuUpperBound = std::max(connectionState.pathMtuUpperBound, connectionState.maxDatagramSize + 1);
+            RF_NETWORK_DEBUG("PathMtu: Probe {} of {} bytes acknowledged.", probeAck.probeId, probeAck.receivedSize);
+            if (connectionState.pathMtuProbeSize > connectionState.maxDatagramSize) {
+                return false; // The outstanding probe is larger still; its timer handles it.
+            }
+            connectionState.pathMtuProbeSize = 0;
+            return PrepareNextPathMtuProbeUnlocked(connectionState, currentTime, outPacket) && !outPacket.Empty();
+        }
+
+        // --- TrySendAckOnlyPacketBuffer ---
+        bool TrySendAckOnlyPacketBuffer(ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            std::function<void(const PacketBuffer&)> sendPacketFunc,
+            float maxAckDelayMs) {
 
             // Temp store values needed outside lock to avoid holding lock during PrepareOutgoingPacketUnlocked_Internal
             bool needsToSendAck = false;
@@ -354,8 +1968,9 @@ namespace RiftForged {
                     return false;
                 }
 
-                float ackDelayThresholdMs = std::min(connectionState.smoothedRTT_ms / 4.0f, 20.0f); // e.g. RTT/4 or max 20ms
-                if (ackDelayThresholdMs < 5.0f) ackDelayThresholdMs = 5.0f; // Minimum 5ms delay
+                // RTT/4, clamped to [MIN_ACK_DELAY_MS, maxAckDelayMs]; a max below MIN_ACK_DELAY_MS wins.
+                float ackDelayThresholdMs = std::min(connectionState.smoothedRTT_ms / 4.0f, maxAckDelayMs);
+                ackDelayThresholdMs = std::max(ackDelayThresholdMs, std::min(MIN_ACK_DELAY_MS, maxAckDelayMs));
 
                 calculatedTimeSinceLastSent = std::chrono::duration_cast<std::chrono::milliseconds>(
                     currentTime - connectionState.lastPacketSentTimeToRemote
@@ -383,7 +1998,7 @@ namespace RiftForged {
                 // The original problem was TrySendAckOnlyPacket locking, then calling public PrepareOutgoingPacket which also locked.
                 // Now, TrySendAckOnlyPacket can lock, then call the internal PrepareOutgoingPacketUnlocked_Internal
 
-                std::vector<uint8_t> ackPacket;
+                PacketBuffer ackPacket;
                 { // Scope for the lock needed by PrepareOutgoingPacketUnlocked_Internal
                     std::lock_guard<std::mutex> lock(connectionState.internalStateMutex);
                     ackPacket = PrepareOutgoingPacketUnlocked_Internal( // Use the internal unlocked version
@@ -394,11 +2009,11 @@ namespace RiftForged {
                     );
                 } // Lock for PrepareOutgoingPacketUnlocked_Internal released
 
-                if (!ackPacket.empty()) {
+                if (!ackPacket.Empty()) {
                     sendPacketFunc(ackPacket); // Use the provided callback to send the packet.
                     // Note: hasPendingAckToSend is set to false inside PrepareOutgoingPacketUnlocked_Internal
                     RF_NETWORK_DEBUG("Sent ACK-only packet (Header Seq: {}, Acking Remote Seq: {}, Bits: 0x{:08X}) after {}ms delay.",
-                        reinterpret_cast<const GamePacketHeader*>(ackPacket.data())->sequenceNumber,
+                        reinterpret_cast<const GamePacketHeader*>(ackPacket.Data())->sequenceNumber,
                         currentHighestRemoteSeq,
                         currentRemoteAckBits,
                         calculatedTimeSinceLastSent);
@@ -411,5 +2026,15 @@ namespace RiftForged {
             return false;
         }
 
+        // --- TrySendAckOnlyPacket ---
+        bool TrySendAckOnlyPacket(ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            std::function<void(const std::vector<uint8_t>&)> sendPacketFunc,
+            float maxAckDelayMs) {
+            return TrySendAckOnlyPacketBuffer(connectionState, currentTime,
+                [&sendPacketFunc](const PacketBuffer& ackPacket) { sendPacketFunc(ackPacket.ToVector()); },
+                maxAckDelayMs);
+        }
+
     } // namespace Networking
 } // namespace RiftForged
\ No newline at end of file
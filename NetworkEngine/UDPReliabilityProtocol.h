@@ -5,13 +5,16 @@
 #pragma once
 
 #include <cstdint>   // For uint32_t, uint16_t, uint8_t
+#include <cstring>   // For std::memcpy in ForEachAggregatedMessage
 #include <vector>    // For std::vector
 #include <string>    // For std::string
 #include <chrono>    // For std::chrono::steady_clock
 #include <functional>// For std::function
+#include <memory>    // For std::shared_ptr in DeferredDatagramSeal
 
 #include "ReliableConnectionState.h" // <<< INCLUDE THE NEW HEADER
 #include "GamePacketHeader.h"        // Still needed for GamePacketHeader struct used in function signatures
+#include "PacketBufferPool.h"        // For PacketBuffer
 
 namespace RiftForged {
     namespace Networking {
@@ -41,6 +44,7 @@ namespace RiftForged {
             return IsSequenceGreaterThan(s1, s2) || (s1 == s2);
         }
 
+        // Returns a copy of the datagram; kept for callers that want to own plain bytes (e.g. test clients).
         std::vector<uint8_t> PrepareOutgoingPacket(
             ReliableConnectionState& connectionState,
             const uint8_t* payloadData,
@@ -48,6 +52,123 @@ namespace RiftForged {
             uint8_t packetFlags
         );
 
+        // Zero-copy variant: the returned buffer is the same one a reliable packet's retransmit window
+        // retains, so it can be handed to the transport without copying. Empty on failure.
+        PacketBuffer PrepareOutgoingPacketBuffer(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            uint16_t payloadSize,
+            uint8_t packetFlags
+        );
+
+        // Largest payload one unfragmented datagram to this peer can carry right now: the connection's
+        // datagram limit (maxDatagramSize less datagramWireOverhead) minus the packet header.
+        size_t GetMaxUnfragmentedPayloadSize(ReliableConnectionState& connectionState);
+
+        // Prepares a reliable message for sending. A message that fits in connectionState.maxDatagramSize
+        // becomes one packet; a larger one is split into up to MAX_FRAGMENTS_PER_MESSAGE fragments with
+        // consecutive sequence numbers (see FragmentHeader). Either every fragment fits in the send window
+        // or nothing is prepared. On success outPackets holds the datagrams to send, in order.
+        bool PrepareOutgoingReliableMessage(
+            ReliableConnectionState& connectionState,
+            const uint8_t* payloadData,
+            size_t payloadSize,
+            uint8_t packetFlags,
+            std::vector<PacketBuffer>& outPackets
+        );
+
+        enum class FragmentReassemblyResult {
+            Incomplete,     // Fragment stored; the message still has missing fragments.
+            Complete,       // outMessage holds the reassembled message.
+            Rejected        // Malformed fragment or a reassembly limit was hit; the fragment was dropped.
+        };
+
+        // Copies one fragment (a payload relayed by ProcessIncomingPacketHeader for a packet with
+        // IsFragment(flags)) into its message's reassembly buffer.
+        FragmentReassemblyResult ProcessIncomingFragment(
+            ReliableConnectionState& connectionState,
+            const GamePacketHeader& receivedHeader,
+            const uint8_t* fragmentData,
+            uint16_t fragmentLength,
+            PacketBuffer& outMessage
+        );
+
+        // Queues a message for 'channel' in the connection's pending IS_AGGREGATE datagram. If the pending
+        // datagram has no room left it is sealed first and returned in outSealedDatagram, which the caller
+        // must send (and, if reliable, arm a retransmit timer for). Returns false if the message cannot fit
+        // in any aggregated datagram, the send window is full, or allocation failed; the caller then sends
+        // it on its own.
+        bool AppendAggregatedMessage(
+            ReliableConnectionState& connectionState,
+            const uint8_t* messageData,
+            size_t messageSize,
+            NetworkChannel channel,
+            PacketBuffer& outSealedDatagram
+        );
+
+        // Sends one message on a reliable channel in datagrams of its own (fragmented if needed), framed
+        // like an aggregate so the receiver applies the channel's ordering. Used for messages too large to
+        // aggregate. On success outPackets holds the datagrams to send, in order.
+        bool PrepareOutgoingChannelMessage(
+            ReliableConnectionState& connectionState,
+            NetworkChannel channel,
+            const uint8_t* messageData,
+            size_t messageSize,
+            std::vector<PacketBuffer>& outPackets
+        );
+
+        enum class ChannelDeliveryResult {
+            Deliver,    // Hand the message to game logic now (then any released backlog, in order).
+            Buffered,   // RELIABLE_ORDERED message arrived early; a copy is held until the gap fills.
+            Dropped     // Stale sequenced update, duplicate or malformed; discard without verifying it.
+        };
+
+        // Applies the channel's delivery semantics to one message unpacked from an aggregated datagram.
+        // Cheap enough to run before FlatBuffer verification. When an in-order RELIABLE_ORDERED message
+        // fills a gap, the held-back messages it releases are appended to outReleased, in order; deliver
+        // them right after this one.
+        ChannelDeliveryResult ProcessIncomingChannelMessage(
+            ReliableConnectionState& connectionState,
+            const AggregatedMessageHeader& messageHeader,
+            const uint8_t* messageData,
+            bool fromReliableDatagram,
+            std::vector<PacketBuffer>& outReleased
+        );
+
+        // Writes the header of the pending aggregated datagram with the current ACK state and commits it
+        // (tracked for retransmission if any message is reliable). Empty if nothing was pending.
+        PacketBuffer SealAggregatedDatagram(ReliableConnectionState& connectionState);
+
+        // Calls func(const uint8_t* message, const AggregatedMessageHeader& messageHeader) for each message
+        // of an IS_AGGREGATE payload. The whole payload is validated first; a malformed one visits
+        // nothing and returns false.
+        template <typename Func>
+        bool ForEachAggregatedMessage(const uint8_t* payloadData, size_t payloadSize, Func&& func) {
+            if (!payloadData || payloadSize == 0) {
+                return false;
+            }
+            for (size_t offset = 0; offset < payloadSize; ) {
+                if (payloadSize - offset < GetAggregatedMessageHeaderSize()) {
+                    return false;
+                }
+                AggregatedMessageHeader messageHeader;
+                std::memcpy(&messageHeader, payloadData + offset, GetAggregatedMessageHeaderSize());
+                offset += GetAggregatedMessageHeaderSize();
+                if (messageHeader.messageSize == 0 || payloadSize - offset < messageHeader.messageSize) {
+                    return false;
+                }
+                offset += messageHeader.messageSize;
+            }
+            for (size_t offset = 0; offset < payloadSize; ) {
+                AggregatedMessageHeader messageHeader;
+                std::memcpy(&messageHeader, payloadData + offset, GetAggregatedMessageHeaderSize());
+                offset += GetAggregatedMessageHeaderSize();
+                func(payloadData + offset, messageHeader);
+                offset += messageHeader.messageSize;
+            }
+            return true;
+        }
+
         bool ProcessIncomingPacketHeader(
             ReliableConnectionState& connectionState,
             const GamePacketHeader& receivedHeader,
@@ -65,7 +186,173 @@ namespace RiftForged {
         bool TrySendAckOnlyPacket(
             ReliableConnectionState& connectionState,
             std::chrono::steady_clock::time_point currentTime,
-            std::function<void(const std::vector<uint8_t>&)> sendPacketFunc
+            std::function<void(const std::vector<uint8_t>&)> sendPacketFunc,
+            float maxAckDelayMs = DEFAULT_MAX_ACK_DELAY_MS
+        );
+
+        // Same as TrySendAckOnlyPacket, but hands the callback the shared packet buffer instead of a copy.
+        bool TrySendAckOnlyPacketBuffer(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            std::function<void(const PacketBuffer&)> sendPacketFunc,
+            float maxAckDelayMs = DEFAULT_MAX_ACK_DELAY_MS
+        );
+
+        // Outcome of a single packet's retransmission timer (see ProcessRetransmitTimer).
+        enum class RetransmitTimerResult {
+            Acknowledged,       // The packet is no longer in flight; drop the timer.
+            NotYetDue,          // RTO has not elapsed yet (e.g. it grew); re-arm at outNextDeadline.
+            Retransmitted,      // outPacket must be resent; re-arm at outNextDeadline.
+            ConnectionDropped   // MAX_PACKET_RETRIES exceeded; the connection is flagged as lost.
+        };
+
+        // Timer-driven counterpart of GetPacketsForRetransmission for one packet: only the expired
+        // packet is examined, instead of every in-flight packet of the connection.
+        RetransmitTimerResult ProcessRetransmitTimer(
+            ReliableConnectionState& connectionState,
+            SequenceNumber sequenceNumber,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket,
+            std::chrono::steady_clock::time_point& outNextDeadline
+        );
+
+        // Congestion control gate for a datagram about to be sent to the connection's peer. A reliable
+        // datagram is always admitted and charged to the pacer, which it may overdraw. An unreliable one is
+        // refused (and should be dropped) while the congestion window is full or the pacer lacks the tokens.
+        // ACK-only packets and retransmissions are accounted for by the protocol and bypass this.
+        bool AdmitOutgoingDatagram(
+            ReliableConnectionState& connectionState,
+            size_t datagramSize,
+            bool isReliable,
+            std::chrono::steady_clock::time_point currentTime
+        );
+
+        // Forward error correction for an unreliable datagram that is about to be sent (and was admitted by
+        // AdmitOutgoingDatagram). While FEC is active for the connection (see UnreliableFecMode), stamps the
+        // datagram's FEC tag and adds it to the open group; when that completes the group, outParity receives
+        // the group's parity datagram, to send right after it. Returns true if outParity was filled.
+        // Datagrams too close to connectionState.maxDatagramSize for the parity to fit go out unprotected.
+        bool ProtectUnreliableDatagram(
+            ReliableConnectionState& connectionState,
+            PacketBuffer& datagram,
+            PacketBuffer& outParity
+        );
+
+        // Feeds an unreliable datagram with an FEC tag (protected or parity; its payload as received) to the
+        // connection's current receive group. If that leaves exactly one datagram of the group missing, the
+        // missing one is rebuilt: outRecoveredFlags and outRecoveredPayload hold its header flags and payload,
+        // to be handled as if it had just arrived. Returns true in that case.
+        bool ProcessIncomingFecDatagram(
+            ReliableConnectionState& connectionState,
+            const GamePacketHeader& receivedHeader,
+            const uint8_t* packetPayloadData,
+            uint16_t packetPayloadLength,
+            uint8_t& outRecoveredFlags,
+            PacketBuffer& outRecoveredPayload
+        );
+
+        // Appends to outPackets every in-flight packet that ACKs or NACKs received since the last call show
+        // as lost (see FAST_RETRANSMIT_REORDER_THRESHOLD) and that has not been resent early before. Call it
+        // after ProcessIncomingPacketHeader and send the packets right away; each counts as a retry, and its
+        // retransmission timer restarts from currentTime. Returns the number of packets appended.
+        size_t CollectFastRetransmissions(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            std::vector<PacketBuffer>& outPackets
+        );
+
+        // Compact (v5) headers, see GamePacketHeader.h. Makes the connection send (and accept) compact headers
+        // from now on; a client that starts compact calls it before sending its join request.
+        void EnableCompactPacketHeaders(ReliableConnectionState& connectionState);
+
+        // The bytes to put on the wire for a datagram built by this layer: the datagram itself unless the
+        // connection uses compact headers or encryption, otherwise a copy with a compact header in place of
+        // its GamePacketHeader and/or its payload sealed (see EnablePacketEncryption). Call it once per
+        // transmission and in send order, since it tracks which ACK fields the remote already has and
+        // consumes an AEAD counter. Returns a null buffer if the copy could not be made.
+        // With outDeferredSeal, an encrypted datagram is only numbered: its payload is copied in the clear
+        // and outDeferredSeal says how to seal it later with SealDeferredDatagram, which must happen before
+        // it is sent. outDeferredSeal->key stays null when there is nothing to seal.
+        struct DeferredDatagramSeal {
+            std::shared_ptr<const CryptoManager::AeadSessionKey> key;
+            uint64_t counter = 0;
+            uint16_t headerSize = 0;
+            uint16_t payloadSize = 0;
+        };
+        PacketBuffer PrepareOutgoingDatagramForWire(
+            ReliableConnectionState& connectionState,
+            const PacketBuffer& datagram,
+            DeferredDatagramSeal* outDeferredSeal = nullptr
+        );
+
+        // Encrypts a datagram left unsealed by PrepareOutgoingDatagramForWire in place and writes its tag.
+        // Takes no lock, so batches of them can be sealed on any thread. Returns false if it failed; the
+        // datagram must then not be sent.
+        bool SealDeferredDatagram(PacketBuffer& wireDatagram, const DeferredDatagramSeal& seal);
+
+        // Reads the header of a received datagram, in either form, into outHeader. A compact header's short
+        // fields are widened against the connection's state, and omitted ACK fields repeat the last ones
+        // received; the first compact header switches the connection to compact headers. Returns the size
+        // of the header on the wire (the payload follows it), or 0 if it is malformed, a v4 header with
+        // another protocol ID, or a compact header on a connection that has not negotiated compact headers.
+        size_t DecodeIncomingPacketHeader(
+            ReliableConnectionState& connectionState,
+            const uint8_t* data,
+            size_t size,
+            GamePacketHeader& outHeader
+        );
+
+        // Encryption, see GamePacketHeader.h. Installs the session keys derived by a completed handshake
+        // (handshakeContext.session_tx_key / session_rx_key) and seals every datagram from now on; received
+        // ones must then pass OpenIncomingDatagram. Both peers must use the same cipher.
+        void EnablePacketEncryption(
+            ReliableConnectionState& connectionState,
+            const SecureConnectionContext& handshakeContext,
+            CryptoManager::AeadCipher cipher
+        );
+
+        // Returns the datagram to read, and its size in outSize: 'data' itself if the connection is not
+        // encrypted, otherwise its header and decrypted payload, written to 'scratch' in one pass. Returns
+        // nullptr if the datagram is malformed, fails authentication or replays a counter already seen.
+        // Call it before DecodeIncomingPacketHeader, so no header field is used before it is authenticated.
+        const uint8_t* OpenIncomingDatagram(
+            ReliableConnectionState& connectionState,
+            const uint8_t* data,
+            size_t size,
+            uint8_t* scratch,
+            size_t scratchCapacity,
+            size_t& outSize
+        );
+
+        // Outcome of a connection's path MTU timer (see ProcessPathMtuTimer).
+        enum class PathMtuTimerResult {
+            ProbeReady,         // outProbe must be sent as is (never FEC-protected); re-arm at outNextDeadline.
+            Wait,               // Nothing to send; re-arm at outNextDeadline.
+            Stopped             // The peer cannot answer probes (no compact headers); drop the timer.
+        };
+
+        // Drives path MTU discovery for one connection (see GamePacketHeader.h): starts a search when one
+        // is due, gives up on a probe size after PMTU_PROBE_ATTEMPTS probes went unanswered for an RTO
+        // each, and prepares the next probe. The first call should come PMTU_FIRST_PROBE_DELAY_MS after the
+        // connection is created, and only if the socket sends with Don't Fragment set.
+        PathMtuTimerResult ProcessPathMtuTimer(
+            ReliableConnectionState& connectionState,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket,
+            std::chrono::steady_clock::time_point& outNextDeadline
+        );
+
+        // Handles the payload of a received IS_HEARTBEAT datagram. A probe is answered: outPacket receives
+        // the PathMtuProbeAck. An ACK for the outstanding probe raises maxDatagramSize to its size and,
+        // unless that ends the search, outPacket receives the next probe. Returns true if outPacket was
+        // filled and must be sent. receivedDatagramSize is the size of the whole datagram as received.
+        bool ProcessIncomingPathMtuDatagram(
+            ReliableConnectionState& connectionState,
+            const uint8_t* packetPayloadData,
+            uint16_t packetPayloadLength,
+            size_t receivedDatagramSize,
+            std::chrono::steady_clock::time_point currentTime,
+            PacketBuffer& outPacket
         );
 
         // These helpers might be better as static functions within UDPReliabilityProtocol.cpp
@@ -14,6 +14,7 @@
 #include <winsock2.h>            // For WSAGetLastError, closesocket, etc.
 #include <ws2tcpip.h>            // For inet_pton, etc.
 #include <system_error>          // For std::system_error
+#include <algorithm>             // For std::min
 
 // DetermineNumWorkerThreads: A helper function to decide how many IOCP worker threads to create.
 // This is currently a static function. If thread count needs to be dynamically configurable per instance,
@@ -41,7 +42,8 @@ namespace RiftForged {
             m_eventHandler(nullptr), // Must be set via Init() before use.
             m_socket(INVALID_SOCKET),
             m_iocpHandle(NULL), // NULL is for HANDLE, INVALID_HANDLE_VALUE for CreateIoCompletionPort
-            m_isRunning(false)
+            m_isRunning(false),
+            m_dontFragmentSet(false)
         {
             RF_NETWORK_INFO("UDPSocketAsync: Constructor called.");
         }
@@ -58,6 +60,20 @@ namespace RiftForged {
             return m_isRunning.load(std::memory_order_acquire);
         }
 
+        // GetReceiveQueueFill: Compares the bytes queued on the socket with its receive buffer size.
+        float UDPSocketAsync::GetReceiveQueueFill() const {
+            SOCKET socket = m_socket;
+            u_long queuedBytes = 0;
+            int receiveBufferBytes = 0;
+            int optionLength = sizeof(receiveBufferBytes);
+            if (socket == INVALID_SOCKET || ioctlsocket(socket, FIONREAD, &queuedBytes) == SOCKET_ERROR ||
+                getsockopt(socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char*>(&receiveBufferBytes), &optionLength) == SOCKET_ERROR ||
+                receiveBufferBytes <= 0) {
+                return 0.0f;
+            }
+            return (std::min)(1.0f, static_cast<float>(queuedBytes) / receiveBufferBytes);
+        }
+
         // Init: Initializes the Winsock environment, creates and binds the UDP socket,
         // and sets up the I/O Completion Port.
         bool UDPSocketAsync::Init(const std::string& listenIp, uint16_t listenPort, INetworkIOEvents* eventHandler) {
@@ -99,6 +115,14 @@ namespace RiftForged {
             }
             RF_NETWORK_INFO("UDPSocketAsync: Socket created successfully (Socket ID: %llu).", m_socket); // Use %llu for SOCKET type
 
+            // Send with Don't Fragment so oversized datagrams are dropped rather than fragmented by IP;
+            // path MTU discovery relies on it and is disabled if the option cannot be set.
+            DWORD dontFragment = 1;
+            m_dontFragmentSet = setsockopt(m_socket, IPPROTO_IP, IP_DONTFRAGMENT, reinterpret_cast<const char*>(&dontFragment), sizeof(dontFragment)) == 0;
+            if (!m_dontFragmentSet) {
+                RF_NETWORK_WARN("UDPSocketAsync: setsockopt(IP_DONTFRAGMENT) failed with error: %d. Path MTU discovery disabled.", WSAGetLastError());
+            }
+
             // Prepare the server address structure.
             sockaddr_in serverAddr;
             serverAddr.sin_family = AF_INET;
@@ -150,19 +174,19 @@ namespace RiftForged {
             }
             RF_NETWORK_DEBUG("UDPSocketAsync: Socket associated with IOCP successfully.");
 
-            // Pre-allocate and initialize a pool of OverlappedIOContext objects for receive operations.
-            // This avoids dynamic allocations during high-frequency receive events.
+            // Pre-allocate and initialize pools of OverlappedIOContext objects for receive and send operations.
+            // This avoids dynamic allocations and locks during high-frequency I/O events.
             try {
-                m_receiveContextPool.reserve(MAX_PENDING_RECEIVES_IOCP);
-                for (int i = 0; i < MAX_PENDING_RECEIVES_IOCP; ++i) {
-                    m_receiveContextPool.emplace_back(std::make_unique<OverlappedIOContext>(IOOperationType::Recv, DEFAULT_UDP_BUFFER_SIZE_IOCP));
-                    m_freeReceiveContexts.push_back(m_receiveContextPool.back().get());
-                }
-                RF_NETWORK_INFO("UDPSocketAsync: Receive context pool initialized with %zu contexts.", m_freeReceiveContexts.size());
+                m_receiveContextPool.Init(MAX_PENDING_RECEIVES_IOCP, DEFAULT_UDP_BUFFER_SIZE_IOCP, IOOperationType::Recv);
+                m_sendContextPool.Init(MAX_PENDING_SENDS_IOCP, DEFAULT_UDP_BUFFER_SIZE_IOCP, IOOperationType::Send);
+                RF_NETWORK_INFO("UDPSocketAsync: Context pools initialized ({} receive, {} send contexts).",
+                    m_receiveContextPool.Capacity(), m_sendContextPool.Capacity());
             }
             catch (const std::bad_alloc& e) {
-                RF_NETWORK_CRITICAL("UDPSocketAsync: Failed to allocate memory for receive context pool: %s", e.what());
-                m_eventHandler->OnNetworkError("Failed to allocate receive context pool", 0);
+                RF_NETWORK_CRITICAL("UDPSocketAsync: Failed to allocate memory for context pools: {}", e.what());
+                m_eventHandler->OnNetworkError("Failed to allocate context pools", 0);
+                m_receiveContextPool.Clear();
+                m_sendContextPool.Clear();
                 if (m_iocpHandle) { CloseHandle(m_iocpHandle); m_iocpHandle = NULL; }
                 if (m_socket != INVALID_SOCKET) { closesocket(m_socket); m_socket = INVALID_SOCKET; }
                 WSACleanup();
@@ -281,13 +305,10 @@ namespace RiftForged {
                 RF_NETWORK_INFO("UDPSocketAsync: IOCP handle closed.");
             }
 
-            // Clear the receive context pool. unique_ptr's destructor will free memory.
-            {
-                std::lock_guard<std::mutex> lock(m_receiveContextMutex);
-                m_freeReceiveContexts.clear(); // Clear deque of raw pointers.
-            }
-            m_receiveContextPool.clear(); // unique_ptrs automatically delete owned objects.
-            RF_NETWORK_DEBUG("UDPSocketAsync: Receive context pool cleared.");
+            // Release the context pools and their slabs.
+            m_receiveContextPool.Clear();
+            m_sendContextPool.Clear();
+            RF_NETWORK_DEBUG("UDPSocketAsync: Context pools cleared.");
 
             // Clean up Winsock.
             WSACleanup();
@@ -297,21 +318,47 @@ namespace RiftForged {
 
         // GetFreeReceiveContextInternal: Retrieves a context from the pool for a receive operation.
         OverlappedIOContext* UDPSocketAsync::GetFreeReceiveContextInternal() {
-            std::lock_guard<std::mutex> lock(m_receiveContextMutex);
-            if (m_freeReceiveContexts.empty()) {
+            OverlappedIOContext* pContext = m_receiveContextPool.Acquire();
+            if (!pContext) {
                 RF_NETWORK_WARN("UDPSocketAsync: No free receive contexts available in pool. Consider increasing MAX_PENDING_RECEIVES_IOCP.");
-                return nullptr;
             }
-            OverlappedIOContext* pContext = m_freeReceiveContexts.front();
-            m_freeReceiveContexts.pop_front();
             return pContext;
         }
 
         // ReturnReceiveContextInternal: Returns a context to the pool.
         void UDPSocketAsync::ReturnReceiveContextInternal(OverlappedIOContext* pContext) {
             if (!pContext) return; // Prevent null pointer issues.
-            std::lock_guard<std::mutex> lock(m_receiveContextMutex);
-            m_freeReceiveContexts.push_back(pContext); // Add back to the end of the deque.
+            m_receiveContextPool.Release(pContext);
+        }
+
+        // AcquireSendContextInternal: Pooled send context when the datagram fits, heap fallback otherwise.
+        OverlappedIOContext* UDPSocketAsync::AcquireSendContextInternal(uint32_t size) {
+            if (size <= static_cast<uint32_t>(DEFAULT_UDP_BUFFER_SIZE_IOCP)) {
+                OverlappedIOContext* pContext = m_sendContextPool.Acquire();
+                if (pContext) {
+                    pContext->ResetForSend();
+                    return pContext;
+                }
+                RF_NETWORK_DEBUG("UDPSocketAsync: Send context pool exhausted ({} in flight). Falling back to heap allocation.", m_sendContextPool.Capacity());
+            }
+            try {
+                return new OverlappedIOContext(IOOperationType::Send, static_cast<size_t>(size));
+            }
+            catch (const std::bad_alloc&) {
+                return nullptr;
+            }
+        }
+
+        // ReleaseSendContextInternal: Returns pooled send contexts, deletes heap fallback ones.
+        void UDPSocketAsync::ReleaseSendContextInternal(OverlappedIOContext* pContext) {
+            if (!pContext) return;
+            pContext->packet.Reset(); // Drop our reference to a zero-copy send's buffer.
+            if (pContext->IsPooled()) {
+                m_sendContextPool.Release(pContext);
+            }
+            else {
+                delete pContext;
+            }
         }
 
         // PostReceiveInternal: Initiates an asynchronous receive operation.
@@ -414,12 +461,12 @@ namespace RiftForged {
                             RF_NETWORK_ERROR("WorkerThread: Failed Send Op in GQCS. Error: %d. Context %p.", errorCode, (void*)pIoContext);
                             // Notify event handler about failed send.
                             if (m_eventHandler) m_eventHandler->OnSendCompleted(pIoContext, false, 0);
-                            delete pIoContext; // Send contexts are dynamically allocated.
+                            ReleaseSendContextInternal(pIoContext);
                         }
                         else {
                             RF_NETWORK_ERROR("WorkerThread: Unknown operation type in failed GQCS. Context %p.", (void*)pIoContext);
-                            // Fallback cleanup for unknown types; assume dynamic allocation for safety.
-                            delete pIoContext;
+                            // Fallback cleanup for unknown types; pooled contexts are owned by their pool.
+                            if (!pIoContext->IsPooled()) delete pIoContext;
                         }
                         pIoContext = nullptr; // Context has been handled.
                     }
@@ -446,45 +493,24 @@ namespace RiftForged {
                 case IOOperationType::Recv:
                 {
                     if (bytesTransferred > 0) {
-                        NetworkEndpoint sender_endpoint;
-                        char senderIpBuffer[INET_ADDRSTRLEN]; // Standard buffer size for IPv4 addresses.
-
-                        // Convert binary address to string IP and port.
-                        if (inet_ntop(AF_INET, &(pIoContext->remoteAddrNative.sin_addr), senderIpBuffer, INET_ADDRSTRLEN)) {
-                            sender_endpoint.ipAddress = senderIpBuffer;
-                            sender_endpoint.port = ntohs(pIoContext->remoteAddrNative.sin_port);
-
-                            // Hand off the received raw data to the INetworkIOEvents handler.
-                            if (m_eventHandler) {
-                                m_eventHandler->OnRawDataReceived(sender_endpoint,
-                                    reinterpret_cast<const uint8_t*>(pIoContext->buffer.data()),
-                                    bytesTransferred,
-                                    pIoContext); // Pass context for informational purposes.
-                            }
-                        }
-                        else { // inet_ntop failed.
-                            int ntopErrorCode = WSAGetLastError();
-                            RF_NETWORK_ERROR("UDPSocketAsync: WorkerThread - inet_ntop failed for received packet. Error: %d.", ntopErrorCode);
-                            if (m_eventHandler) m_eventHandler->OnNetworkError("inet_ntop failed", ntopErrorCode);
+                        // Keep the sender address in its binary form; no string conversion on the receive path.
+                        const NetworkEndpoint sender_endpoint(pIoContext->remoteAddrNative.sin_addr.s_addr, ntohs(pIoContext->remoteAddrNative.sin_port));
+
+                        // Hand off the received raw data to the INetworkIOEvents handler.
+                        if (m_eventHandler) {
+                            m_eventHandler->OnRawDataReceived(sender_endpoint,
+                                reinterpret_cast<const uint8_t*>(pIoContext->buffer),
+                                bytesTransferred,
+                                pIoContext); // Pass context for informational purposes.
                         }
                     }
                     else if (bytesTransferred == 0) {
                         // For UDP, receiving 0 bytes means an empty datagram was sent.
                         RF_NETWORK_WARN("UDPSocketAsync: WorkerThread - Received 0 bytes on a Recv operation (UDP). Context: %p.", (void*)pIoContext);
                         // Still, identify the sender and potentially pass a 0-byte payload.
-                        NetworkEndpoint sender_endpoint;
-                        char senderIpBuffer[INET_ADDRSTRLEN];
-                        if (inet_ntop(AF_INET, &(pIoContext->remoteAddrNative.sin_addr), senderIpBuffer, INET_ADDRSTRLEN)) {
-                            sender_endpoint.ipAddress = senderIpBuffer;
-                            sender_endpoint.port = ntohs(pIoContext->remoteAddrNative.sin_port);
-                            if (m_eventHandler) {
-                                m_eventHandler->OnRawDataReceived(sender_endpoint, nullptr, 0, pIoContext);
-                            }
-                        }
-                        else {
-                            int ntopErrorCode = WSAGetLastError();
-                            RF_NETWORK_ERROR("UDPSocketAsync: WorkerThread - inet_ntop failed for 0-byte received packet. Error: %d.", ntopErrorCode);
-                            if (m_eventHandler) m_eventHandler->OnNetworkError("inet_ntop failed for 0-byte packet", ntopErrorCode);
+                        const NetworkEndpoint sender_endpoint(pIoContext->remoteAddrNative.sin_addr.s_addr, ntohs(pIoContext->remoteAddrNative.sin_port));
+                        if (m_eventHandler) {
+                            m_eventHandler->OnRawDataReceived(sender_endpoint, nullptr, 0, pIoContext);
                         }
                     }
 
@@ -512,7 +538,7 @@ namespace RiftForged {
                     if (m_eventHandler) {
                         m_eventHandler->OnSendCompleted(pIoContext, true, bytesTransferred); // true for success (bSuccess was true).
                     }
-                    delete pIoContext; // Send contexts are dynamically allocated with `new`, so delete them here.
+                    ReleaseSendContextInternal(pIoContext); // Back to the send pool (or deleted if it was a heap fallback).
                     pIoContext = nullptr; // Context has been handled.
                     break;
                 } // End of case IOOperationType::Send
@@ -524,7 +550,7 @@ namespace RiftForged {
                     if (m_eventHandler) m_eventHandler->OnNetworkError("Unknown operation type dequeued", (pIoContext ? static_cast<int>(pIoContext->operationType) : -1));
                     if (pIoContext) { // Attempt to clean up unexpected context types.
                         RF_NETWORK_ERROR("WorkerThread: Deleting unexpected context %p due to unknown type.", (void*)pIoContext);
-                        delete pIoContext; // Assume dynamically allocated for safety.
+                        if (!pIoContext->IsPooled()) delete pIoContext; // Pooled contexts are owned by their pool.
                         pIoContext = nullptr;
                     }
                     break;
@@ -538,6 +564,16 @@ namespace RiftForged {
 
         // SendData: Sends raw data asynchronously to a specified recipient.
         bool UDPSocketAsync::SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) {
+            return PostSendInternal(recipient, data, size, nullptr);
+        }
+
+        // SendPacket: Sends a refcounted packet buffer without copying it.
+        bool UDPSocketAsync::SendPacket(const NetworkEndpoint& recipient, const PacketBuffer& packet) {
+            return PostSendInternal(recipient, packet.Data(), static_cast<uint32_t>(packet.Size()), &packet);
+        }
+
+        // PostSendInternal: Posts one WSASendTo, copying the bytes or referencing the packet buffer.
+        bool UDPSocketAsync::PostSendInternal(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size, const PacketBuffer* packet) {
             if (m_socket == INVALID_SOCKET) {
                 RF_NETWORK_ERROR("UDPSocketAsync::SendData: Socket not valid. Cannot send to %s.", recipient.ToString().c_str());
                 return false;
@@ -551,31 +587,33 @@ namespace RiftForged {
                 return false;
             }
 
-            // Create a new OverlappedIOContext for each send operation.
-            // This context is dynamically allocated and will be deleted by the worker thread
-            // when the send operation completes via `OnSendCompleted`.
-            OverlappedIOContext* sendContext = nullptr;
-            try {
-                sendContext = new OverlappedIOContext(IOOperationType::Send, static_cast<size_t>(size));
-            }
-            catch (const std::bad_alloc& e) {
-                RF_NETWORK_CRITICAL("UDPSocketAsync::SendData: Failed to allocate memory for send context to %s: %s", recipient.ToString().c_str(), e.what());
+            // Take a send context from the lock-free pool (heap fallback if exhausted or oversized).
+            // The worker thread returns it when the send operation completes via `OnSendCompleted`.
+            OverlappedIOContext* sendContext = AcquireSendContextInternal(packet ? 0 : size);
+            if (!sendContext) {
+                RF_NETWORK_CRITICAL("UDPSocketAsync::SendData: Failed to allocate memory for send context to {}.", recipient.ToString());
                 return false;
             }
 
-            // Copy the data into the context's buffer.
-            if (size > 0 && data != nullptr) { // Only copy if there's data and a valid pointer.
-                std::memcpy(sendContext->buffer.data(), data, size);
+            if (packet) {
+                // Point WSASendTo at the shared buffer; the context's reference keeps it alive until completion.
+                sendContext->packet = *packet;
+                sendContext->wsaBuf.buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(data));
+            }
+            else if (size > 0 && data != nullptr) { // Only copy if there's data and a valid pointer.
+                // Copy the data into the context's buffer.
+                std::memcpy(sendContext->buffer, data, size);
             }
             sendContext->wsaBuf.len = size; // Set the buffer length for WSASendTo.
 
             // Set up recipient address.
             sendContext->remoteAddrNative.sin_family = AF_INET;
-            sendContext->remoteAddrNative.sin_port = htons(recipient.port);
-            // Convert recipient IP string to binary.
-            if (inet_pton(AF_INET, recipient.ipAddress.c_str(), &(sendContext->remoteAddrNative.sin_addr)) != 1) {
-                RF_NETWORK_ERROR("UDPSocketAsync::SendData: inet_pton failed for IP %s to %s. Error: %d", recipient.ipAddress.c_str(), recipient.ToString().c_str(), WSAGetLastError());
-                delete sendContext; // Clean up context on failure.
+            sendContext->remoteAddrNative.sin_port = htons(recipient.GetPort());
+            // The endpoint already holds the binary address.
+            sendContext->remoteAddrNative.sin_addr.s_addr = recipient.GetAddressV4();
+            if (!recipient.IsValid()) {
+                RF_NETWORK_ERROR("UDPSocketAsync::SendData: Invalid recipient %s.", recipient.ToString().c_str());
+                ReleaseSendContextInternal(sendContext); // Clean up context on failure.
                 return false;
             }
             sendContext->remoteAddrNativeLen = sizeof(sockaddr_in); // Set size of address structure.
@@ -600,7 +638,7 @@ namespace RiftForged {
                     RF_NETWORK_ERROR("UDPSocketAsync::SendData: WSASendTo failed immediately to %s with error: %d.", recipient.ToString().c_str(), errorCode);
                     // Notify handler of failed send attempt.
                     if (m_eventHandler) m_eventHandler->OnSendCompleted(sendContext, false, 0);
-                    delete sendContext; // Clean up context on failure.
+                    ReleaseSendContextInternal(sendContext); // Clean up context on failure.
                     return false;
                 }
                 // If WSA_IO_PENDING, the operation will eventually complete via IOCP.
@@ -10,8 +10,6 @@
 #include <vector>           // For std::vector
 #include <thread>           // For std::thread
 #include <atomic>           // For std::atomic
-#include <mutex>            // For std::mutex
-#include <deque>            // For std::deque
 #include <memory>           // For std::unique_ptr
 
 // Winsock specific includes
@@ -27,11 +25,13 @@
 #include "INetworkIO.h"           // Definition of the interface we are implementing
 #include "NetworkEndpoint.h"      // Defines NetworkEndpoint struct
 #include "OverlappedIOContext.h"  // Defines OverlappedIOContext struct
+#include "OverlappedIOContextPool.h" // Lock-free, slab-backed context pools
 
 // Constants for the UDP buffer and pending receives.
 // These could be made configurable in a production system.
 const int DEFAULT_UDP_BUFFER_SIZE_IOCP = 4096; // Default buffer size for UDP datagrams
 const int MAX_PENDING_RECEIVES_IOCP = 200;     // Maximum number of concurrent WSARecvFrom operations
+const int MAX_PENDING_SENDS_IOCP = 4096;       // Pooled send contexts; beyond this SendData falls back to the heap
 
 namespace RiftForged {
     namespace Networking {
@@ -86,12 +86,32 @@ namespace RiftForged {
              */
             bool SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) override;
 
+            /**
+             * @brief Sends a refcounted packet buffer without copying it: WSASendTo points straight at the
+             * buffer and the send context holds a reference until the operation completes.
+             * @return True if the send operation was successfully initiated, false otherwise.
+             */
+            bool SendPacket(const NetworkEndpoint& recipient, const PacketBuffer& packet) override;
+
             /**
              * @brief Checks if the network I/O is currently running.
              * @return True if running, false otherwise.
              */
             bool IsRunning() const override;
 
+            /**
+             * @brief Checks if datagrams are sent with IP_DONTFRAGMENT, which path MTU discovery needs.
+             * @return True if the option was set in Init().
+             */
+            bool SupportsPathMtuProbing() const override { return m_dontFragmentSet; }
+
+            /**
+             * @brief Reports the bytes waiting on the socket (FIONREAD, which for UDP on Windows is every queued
+             * datagram) against its receive buffer size. Data only queues there once no receive is posted.
+             * @return The fill fraction, 0 if it can't be read.
+             */
+            float GetReceiveQueueFill() const override;
+
         private:
             // The main loop for IOCP worker threads, processing completed I/O operations.
             void WorkerThread();
@@ -116,6 +136,23 @@ namespace RiftForged {
              */
             void ReturnReceiveContextInternal(OverlappedIOContext* pContext);
 
+            /**
+             * @brief Retrieves a send context able to hold 'size' bytes.
+             * Uses the send pool when possible and falls back to a heap-allocated context otherwise.
+             * @return A context ready for WSASendTo, or nullptr on allocation failure.
+             */
+            OverlappedIOContext* AcquireSendContextInternal(uint32_t size);
+
+            /**
+             * @brief Returns a pooled send context to the send pool, or deletes a heap fallback context.
+             * @param pContext The context to release.
+             */
+            void ReleaseSendContextInternal(OverlappedIOContext* pContext);
+
+            // Shared body of SendData/SendPacket. With a packet buffer the context references it; otherwise
+            // the bytes are copied into the context's buffer.
+            bool PostSendInternal(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size, const PacketBuffer* packet);
+
             // --- Member Variables ---
             std::string m_listenIp;           // The IP address the socket is bound to.
             uint16_t m_listenPort;            // The port number the socket is listening on.
@@ -127,10 +164,12 @@ namespace RiftForged {
             std::vector<std::thread> m_workerThreads; // Collection of threads processing IOCP completions.
             std::atomic<bool> m_isRunning;            // Atomic flag to control the lifetime of worker threads.
 
-            // Receive context pooling for efficient reuse of OVERLAPPED structures and buffers.
-            std::vector<std::unique_ptr<OverlappedIOContext>> m_receiveContextPool; // Owns the memory for all contexts.
-            std::deque<OverlappedIOContext*> m_freeReceiveContexts;                 // Queue of currently available contexts.
-            std::mutex m_receiveContextMutex;                                       // Protects access to m_freeReceiveContexts.
+            // Context pooling for efficient reuse of OVERLAPPED structures and buffers.
+            // Both pools are lock-free and carve their buffers from one contiguous slab each.
+            OverlappedIOContextPool m_receiveContextPool; // MAX_PENDING_RECEIVES_IOCP contexts.
+            OverlappedIOContextPool m_sendContextPool;    // MAX_PENDING_SENDS_IOCP contexts.
+
+            bool m_dontFragmentSet;                       // IP_DONTFRAGMENT set on m_socket in Init().
         };
 
     } // namespace Networking
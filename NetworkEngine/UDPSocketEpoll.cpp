@@ -0,0 +1,563 @@
+﻿// File: UDPSocketEpoll.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements INetworkIO for Linux using epoll + recvmmsg on non-blocking UDP sockets,
+// optionally sharded across SO_REUSEPORT sockets with one pinned receive thread each.
+
+#if defined(__linux__)
+
+#include "UDPSocketEpoll.h"
+#include "INetworkIOEvents.h"    // For m_eventHandler calls
+#include "../Utils/Logger.h"     // For RF_NETWORK_... macros
+
+#include <algorithm>             // For std::clamp
+#include <cerrno>                // For errno
+#include <cstring>               // For std::memset, std::strerror
+#include <functional>            // For std::hash
+#include <sstream>               // For std::ostringstream
+#include <system_error>          // For std::system_error
+
+#include <unistd.h>              // For close
+#include <pthread.h>             // For pthread_setaffinity_np
+#include <sched.h>               // For cpu_set_t
+#include <arpa/inet.h>           // For inet_pton, inet_ntop, htons
+#include <sys/epoll.h>           // For epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>         // For eventfd
+#include <netinet/udp.h>         // For SOL_UDP, UDP_SEGMENT
+#include <linux/sock_diag.h>     // For SK_MEMINFO_RMEM_ALLOC, SK_MEMINFO_RCVBUF
+
+namespace RiftForged {
+    namespace Networking {
+
+        UDPSocketEpoll::UDPSocketEpoll(size_t numReceiveShards)
+            : m_listenIp(""),
+            m_listenPort(0),
+            m_eventHandler(nullptr),
+            m_numReceiveShards(std::clamp<size_t>(numReceiveShards, 1, MAX_RECEIVE_SHARDS_EPOLL)),
+            m_isRunning(false),
+            m_gsoSupported(false),
+            m_dontFragmentSet(false)
+        {
+            RF_NETWORK_INFO("UDPSocketEpoll: Constructor called ({} receive shard(s)).", m_numReceiveShards);
+        }
+
+        UDPSocketEpoll::~UDPSocketEpoll() {
+            RF_NETWORK_INFO("UDPSocketEpoll: Destructor called. Attempting to stop...");
+            Stop();
+            CloseDescriptors();
+        }
+
+        bool UDPSocketEpoll::IsRunning() const {
+            return m_isRunning.load(std::memory_order_acquire);
+        }
+
+        float UDPSocketEpoll::GetReceiveQueueFill() const {
+            // SO_MEMINFO gives the memory charged for queued datagrams and the limit at which the kernel starts
+            // dropping them, so their ratio is how close the socket is to losing traffic.
+            float fullest = 0.0f;
+            for (const auto& shard : m_shards) {
+                uint32_t memInfo[SK_MEMINFO_VARS] = {};
+                socklen_t memInfoLength = sizeof(memInfo);
+                if (shard->socketFd < 0 || getsockopt(shard->socketFd, SOL_SOCKET, SO_MEMINFO, memInfo, &memInfoLength) != 0 ||
+                    memInfo[SK_MEMINFO_RCVBUF] == 0) {
+                    continue;
+                }
+                fullest = std::max(fullest, std::min(1.0f, static_cast<float>(memInfo[SK_MEMINFO_RMEM_ALLOC]) / memInfo[SK_MEMINFO_RCVBUF]));
+            }
+            return fullest;
+        }
+
+        void UDPSocketEpoll::CloseDescriptors() {
+            for (auto& shard : m_shards) {
+                if (shard->epollFd >= 0) { close(shard->epollFd); shard->epollFd = -1; }
+                if (shard->wakeEventFd >= 0) { close(shard->wakeEventFd); shard->wakeEventFd = -1; }
+                if (shard->socketFd >= 0) { close(shard->socketFd); shard->socketFd = -1; }
+            }
+            // The shard objects themselves are kept until the next Init() so late SendData calls see -1, not freed memory.
+        }
+
+        bool UDPSocketEpoll::InitShard(ReceiveShard& shard, const sockaddr_in& bindAddr) {
+            shard.socketFd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+            if (shard.socketFd < 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: socket() failed for shard {} with error: {} ({})", shard.index, errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("socket failed", errorCode);
+                return false;
+            }
+
+            // Every shard binds the same ip:port; the kernel then spreads flows across the sockets.
+            if (m_numReceiveShards > 1) {
+                int enable = 1;
+                if (setsockopt(shard.socketFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+                    int errorCode = errno;
+                    RF_NETWORK_CRITICAL("UDPSocketEpoll: setsockopt(SO_REUSEPORT) failed for shard {} with error: {} ({})", shard.index, errorCode, std::strerror(errorCode));
+                    m_eventHandler->OnNetworkError("setsockopt SO_REUSEPORT failed", errorCode);
+                    return false;
+                }
+            }
+
+            // Larger kernel buffers absorb bursts between drains at high client counts.
+            // The kernel clamps these to net.core.rmem_max / wmem_max, so failure is only logged.
+            int kernelBufferBytes = DEFAULT_SOCKET_KERNEL_BUFFER_BYTES_EPOLL;
+            if (setsockopt(shard.socketFd, SOL_SOCKET, SO_RCVBUF, &kernelBufferBytes, sizeof(kernelBufferBytes)) != 0) {
+                RF_NETWORK_WARN("UDPSocketEpoll: setsockopt(SO_RCVBUF) failed with error: {}", errno);
+            }
+            if (setsockopt(shard.socketFd, SOL_SOCKET, SO_SNDBUF, &kernelBufferBytes, sizeof(kernelBufferBytes)) != 0) {
+                RF_NETWORK_WARN("UDPSocketEpoll: setsockopt(SO_SNDBUF) failed with error: {}", errno);
+            }
+
+            // Don't Fragment on every datagram, without the kernel's own (ICMP-driven) PMTU cache capping
+            // our sends; path MTU discovery probes each connection instead. Without it probing is disabled.
+            int pmtuDiscovery = IP_PMTUDISC_PROBE;
+            if (setsockopt(shard.socketFd, IPPROTO_IP, IP_MTU_DISCOVER, &pmtuDiscovery, sizeof(pmtuDiscovery)) != 0) {
+                RF_NETWORK_WARN("UDPSocketEpoll: setsockopt(IP_MTU_DISCOVER) failed with error: {}. Path MTU discovery disabled.", errno);
+                m_dontFragmentSet = false;
+            }
+
+            if (bind(shard.socketFd, reinterpret_cast<const sockaddr*>(&bindAddr), sizeof(bindAddr)) != 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: bind() failed for shard {} with error: {} ({})", shard.index, errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("bind failed", errorCode);
+                return false;
+            }
+
+            shard.epollFd = epoll_create1(EPOLL_CLOEXEC);
+            shard.wakeEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (shard.epollFd < 0 || shard.wakeEventFd < 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: epoll_create1/eventfd failed with error: {} ({})", errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("epoll_create1/eventfd failed", errorCode);
+                return false;
+            }
+
+            epoll_event socketEvent{};
+            socketEvent.events = EPOLLIN;
+            socketEvent.data.fd = shard.socketFd;
+            epoll_event wakeEvent{};
+            wakeEvent.events = EPOLLIN;
+            wakeEvent.data.fd = shard.wakeEventFd;
+            if (epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, shard.socketFd, &socketEvent) != 0 ||
+                epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, shard.wakeEventFd, &wakeEvent) != 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: epoll_ctl(ADD) failed with error: {} ({})", errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("epoll_ctl failed", errorCode);
+                return false;
+            }
+
+            // Pre-allocate the recvmmsg batch once; every datagram slot points into one contiguous slab.
+            try {
+                shard.receiveSlab.assign(static_cast<size_t>(RECVMMSG_BATCH_SIZE_EPOLL) * DEFAULT_UDP_BUFFER_SIZE_EPOLL, 0);
+                shard.receiveMessages.assign(RECVMMSG_BATCH_SIZE_EPOLL, mmsghdr{});
+                shard.receiveIovecs.assign(RECVMMSG_BATCH_SIZE_EPOLL, iovec{});
+                shard.receiveAddrs.assign(RECVMMSG_BATCH_SIZE_EPOLL, sockaddr_in{});
+            }
+            catch (const std::bad_alloc& e) {
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: Failed to allocate recvmmsg batch buffers: {}", e.what());
+                m_eventHandler->OnNetworkError("Failed to allocate recvmmsg batch buffers", 0);
+                return false;
+            }
+            for (int i = 0; i < RECVMMSG_BATCH_SIZE_EPOLL; ++i) {
+                shard.receiveIovecs[i].iov_base = shard.receiveSlab.data() + static_cast<size_t>(i) * DEFAULT_UDP_BUFFER_SIZE_EPOLL;
+                shard.receiveIovecs[i].iov_len = DEFAULT_UDP_BUFFER_SIZE_EPOLL;
+            }
+            return true;
+        }
+
+        bool UDPSocketEpoll::Init(const std::string& listenIp, uint16_t listenPort, INetworkIOEvents* eventHandler) {
+            RF_NETWORK_INFO("UDPSocketEpoll: Initializing for {}:{}...", listenIp, listenPort);
+
+            if (m_isRunning.load(std::memory_order_relaxed)) {
+                RF_NETWORK_WARN("UDPSocketEpoll: Already initialized and potentially running. Please call Stop() first.");
+                return false;
+            }
+            if (!eventHandler) {
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: Initialization failed - INetworkIOEvents handler is null.");
+                return false;
+            }
+
+            m_eventHandler = eventHandler;
+            m_listenIp = listenIp;
+            m_listenPort = listenPort;
+
+            sockaddr_in serverAddr;
+            std::memset(&serverAddr, 0, sizeof(serverAddr));
+            serverAddr.sin_family = AF_INET;
+            serverAddr.sin_port = htons(m_listenPort);
+            if (inet_pton(AF_INET, m_listenIp.c_str(), &serverAddr.sin_addr) != 1) {
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: inet_pton failed for IP {}.", m_listenIp);
+                m_eventHandler->OnNetworkError("inet_pton failed for listen IP", EINVAL);
+                return false;
+            }
+
+            CloseDescriptors();
+            m_shards.clear();
+            m_shards.reserve(m_numReceiveShards);
+            m_dontFragmentSet = true; // Cleared by InitShard if any socket refuses it.
+            for (size_t i = 0; i < m_numReceiveShards; ++i) {
+                m_shards.push_back(std::make_unique<ReceiveShard>());
+                m_shards.back()->index = i;
+                if (!InitShard(*m_shards.back(), serverAddr)) {
+                    CloseDescriptors();
+                    return false;
+                }
+            }
+
+            // Probe UDP GSO once; SendBatch falls back to one message per datagram without it.
+            int gsoSize = 0;
+            socklen_t gsoOptLen = sizeof(gsoSize);
+            m_gsoSupported = getsockopt(m_shards.front()->socketFd, SOL_UDP, UDP_SEGMENT, &gsoSize, &gsoOptLen) == 0;
+
+            RF_NETWORK_INFO("UDPSocketEpoll: Initialization successful. {} socket(s) bound to {}:{} (recvmmsg batch size {}, UDP GSO {}).",
+                m_numReceiveShards, m_listenIp, m_listenPort, RECVMMSG_BATCH_SIZE_EPOLL, m_gsoSupported ? "enabled" : "unavailable");
+            return true;
+        }
+
+        bool UDPSocketEpoll::Start() {
+            if (m_shards.empty() || m_shards.front()->socketFd < 0) {
+                RF_NETWORK_ERROR("UDPSocketEpoll: Cannot start. Sockets not initialized.");
+                return false;
+            }
+            if (!m_eventHandler) {
+                RF_NETWORK_CRITICAL("UDPSocketEpoll: Cannot start. Event handler is null (was Init called and successful?).");
+                return false;
+            }
+            if (m_isRunning.load(std::memory_order_relaxed)) {
+                RF_NETWORK_WARN("UDPSocketEpoll: Already running.");
+                return true;
+            }
+
+            RF_NETWORK_INFO("UDPSocketEpoll: Starting network operations...");
+            m_isRunning = true;
+            for (auto& shard : m_shards) {
+                try {
+                    shard->receiveThread = std::thread(&UDPSocketEpoll::ReceiveThread, this, shard.get());
+                }
+                catch (const std::system_error& e) {
+                    RF_NETWORK_CRITICAL("UDPSocketEpoll: Failed to create receive thread for shard {}: {}", shard->index, e.what());
+                    m_eventHandler->OnNetworkError("Failed to create receive thread", 0);
+                    Stop();
+                    return false;
+                }
+            }
+            RF_NETWORK_INFO("UDPSocketEpoll: {} receive thread(s) started. Server is listening.", m_shards.size());
+            return true;
+        }
+
+        void UDPSocketEpoll::Stop() {
+            if (!m_isRunning.exchange(false, std::memory_order_acq_rel)) {
+                RF_NETWORK_INFO("UDPSocketEpoll: Stop called but already not running or stop initiated.");
+                return;
+            }
+            RF_NETWORK_INFO("UDPSocketEpoll: Stopping network operations...");
+
+            // Wake the receive threads so they do not sit out the remainder of their epoll_wait timeout.
+            for (auto& shard : m_shards) {
+                if (shard->wakeEventFd >= 0) {
+                    uint64_t one = 1;
+                    if (write(shard->wakeEventFd, &one, sizeof(one)) != sizeof(one)) {
+                        RF_NETWORK_DEBUG("UDPSocketEpoll: Wake eventfd write failed ({}); receive thread will exit on timeout.", errno);
+                    }
+                }
+            }
+
+            for (auto& shard : m_shards) {
+                if (shard->receiveThread.joinable()) {
+                    shard->receiveThread.join();
+                }
+                RF_NETWORK_INFO("UDPSocketEpoll: Shard {} stats - datagrams received: {}, recvmmsg calls: {}.",
+                    shard->index, shard->statDatagramsReceived.load(), shard->statReceiveSyscalls.load());
+            }
+            RF_NETWORK_INFO("UDPSocketEpoll: Receive threads joined.");
+
+            CloseDescriptors();
+            RF_NETWORK_INFO("UDPSocketEpoll: Network operations stopped successfully.");
+        }
+
+        void UDPSocketEpoll::PinCurrentThreadToCore(size_t shardIndex) {
+            unsigned int coreCount = std::thread::hardware_concurrency();
+            if (m_numReceiveShards <= 1 || coreCount == 0) {
+                return; // A single socket is left to the scheduler, as before.
+            }
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(static_cast<int>(shardIndex % coreCount), &cpuSet);
+            int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+            if (result != 0) {
+                RF_NETWORK_WARN("UDPSocketEpoll: Could not pin shard {} receive thread to core {} (error {}).",
+                    shardIndex, shardIndex % coreCount, result);
+            }
+            else {
+                RF_NETWORK_INFO("UDPSocketEpoll: Shard {} receive thread pinned to core {}.", shardIndex, shardIndex % coreCount);
+            }
+        }
+
+        int UDPSocketEpoll::DrainReceiveBatch(ReceiveShard& shard) {
+            for (int i = 0; i < RECVMMSG_BATCH_SIZE_EPOLL; ++i) {
+                msghdr& hdr = shard.receiveMessages[i].msg_hdr;
+                hdr.msg_name = &shard.receiveAddrs[i];
+                hdr.msg_namelen = sizeof(sockaddr_in);
+                hdr.msg_iov = &shard.receiveIovecs[i];
+                hdr.msg_iovlen = 1;
+                hdr.msg_control = nullptr;
+                hdr.msg_controllen = 0;
+                hdr.msg_flags = 0;
+                shard.receiveMessages[i].msg_len = 0;
+            }
+
+            int received = recvmmsg(shard.socketFd, shard.receiveMessages.data(), RECVMMSG_BATCH_SIZE_EPOLL, MSG_DONTWAIT, nullptr);
+            shard.statReceiveSyscalls.fetch_add(1, std::memory_order_relaxed);
+            if (received < 0) {
+                int errorCode = errno;
+                if (errorCode != EAGAIN && errorCode != EWOULDBLOCK && errorCode != EINTR) {
+                    RF_NETWORK_ERROR("UDPSocketEpoll: recvmmsg failed with error: {} ({})", errorCode, std::strerror(errorCode));
+                    if (m_eventHandler) m_eventHandler->OnNetworkError("recvmmsg failed", errorCode);
+                }
+                return -1;
+            }
+            shard.statDatagramsReceived.fetch_add(static_cast<uint64_t>(received), std::memory_order_relaxed);
+
+            for (int i = 0; i < received; ++i) {
+                const mmsghdr& msg = shard.receiveMessages[i];
+                if (msg.msg_hdr.msg_flags & MSG_TRUNC) {
+                    RF_NETWORK_WARN("UDPSocketEpoll: Datagram larger than {} bytes was truncated. Discarding.", DEFAULT_UDP_BUFFER_SIZE_EPOLL);
+                    continue;
+                }
+
+                const NetworkEndpoint sender_endpoint(shard.receiveAddrs[i].sin_addr.s_addr, ntohs(shard.receiveAddrs[i].sin_port));
+
+                if (m_eventHandler) {
+                    m_eventHandler->OnRawDataReceived(sender_endpoint,
+                        msg.msg_len > 0 ? static_cast<const uint8_t*>(shard.receiveIovecs[i].iov_base) : nullptr,
+                        msg.msg_len,
+                        nullptr);
+                }
+            }
+            return received;
+        }
+
+        void UDPSocketEpoll::ReceiveThread(ReceiveShard* shard) {
+            std::ostringstream oss_thread_id_start;
+            oss_thread_id_start << std::this_thread::get_id();
+            RF_NETWORK_INFO("UDPSocketEpoll: Receive thread for shard {} started (ID: {})", shard->index, oss_thread_id_start.str());
+
+            PinCurrentThreadToCore(shard->index);
+
+            epoll_event events[2];
+            while (m_isRunning.load(std::memory_order_acquire)) {
+                int ready = epoll_wait(shard->epollFd, events, 2, EPOLL_WAIT_TIMEOUT_MS);
+                if (ready < 0) {
+                    if (errno == EINTR) continue;
+                    RF_NETWORK_ERROR("UDPSocketEpoll: epoll_wait failed with error: {}. Exiting receive thread.", errno);
+                    if (m_eventHandler) m_eventHandler->OnNetworkError("epoll_wait failed", errno);
+                    break;
+                }
+
+                for (int e = 0; e < ready; ++e) {
+                    if (events[e].data.fd != shard->socketFd) {
+                        continue; // Wake eventfd: the loop condition handles shutdown.
+                    }
+                    // Level-triggered: drain until EAGAIN so one wake-up handles the whole backlog.
+                    while (m_isRunning.load(std::memory_order_relaxed)) {
+                        int received = DrainReceiveBatch(*shard);
+                        if (received < RECVMMSG_BATCH_SIZE_EPOLL) {
+                            break;
+                        }
+                    }
+                }
+            }
+
+            std::ostringstream exit_tid_oss;
+            exit_tid_oss << std::this_thread::get_id();
+            RF_NETWORK_INFO("UDPSocketEpoll: Receive thread {} (shard {}) exiting gracefully.", exit_tid_oss.str(), shard->index);
+        }
+
+        bool UDPSocketEpoll::ToSockaddr(const NetworkEndpoint& endpoint, sockaddr_in& outAddr) {
+            std::memset(&outAddr, 0, sizeof(outAddr));
+            outAddr.sin_family = AF_INET;
+            outAddr.sin_port = htons(endpoint.GetPort());
+            outAddr.sin_addr.s_addr = endpoint.GetAddressV4();
+            return endpoint.IsValid();
+        }
+
+        size_t UDPSocketEpoll::ShardForDestination(const sockaddr_in& destAddr) const {
+            // All shards share the bound port, so any socket works; hashing keeps a client on one socket's send queue.
+            if (m_shards.size() <= 1) {
+                return 0;
+            }
+            return (std::hash<uint32_t>{}(destAddr.sin_addr.s_addr) ^ destAddr.sin_port) % m_shards.size();
+        }
+
+        bool UDPSocketEpoll::SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) {
+            if (m_shards.empty()) {
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendData: Socket not valid. Cannot send to {}.", recipient.ToString());
+                return false;
+            }
+            if (data == nullptr && size > 0) {
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendData: Data is null but size {} > 0 for sending to {}.", size, recipient.ToString());
+                return false;
+            }
+
+            sockaddr_in destAddr;
+            if (!ToSockaddr(recipient, destAddr)) {
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendData: Invalid recipient {}.", recipient.ToString());
+                return false;
+            }
+
+            int socketFd = m_shards[ShardForDestination(destAddr)]->socketFd;
+            if (socketFd < 0) {
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendData: Socket closed. Cannot send to {}.", recipient.ToString());
+                return false;
+            }
+
+            ssize_t sent = sendto(socketFd, data, size, MSG_DONTWAIT | MSG_NOSIGNAL,
+                reinterpret_cast<const sockaddr*>(&destAddr), sizeof(destAddr));
+            if (sent < 0) {
+                int errorCode = errno;
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendData: sendto failed to {} with error: {} ({}).", recipient.ToString(), errorCode, std::strerror(errorCode));
+                return false;
+            }
+            RF_NETWORK_TRACE("UDPSocketEpoll::SendData: Sent {} bytes to {}.", sent, recipient.ToString());
+            return true;
+        }
+
+        size_t UDPSocketEpoll::SendBatch(const OutgoingDatagram* datagrams, size_t count) {
+            if (count == 0 || datagrams == nullptr) {
+                return 0;
+            }
+            if (m_shards.empty()) {
+                RF_NETWORK_ERROR("UDPSocketEpoll::SendBatch: Socket not valid. Dropping {} datagrams.", count);
+                return 0;
+            }
+
+            // GSO control message: one cmsghdr carrying the segment size.
+            struct GsoControl {
+                alignas(cmsghdr) char buffer[CMSG_SPACE(sizeof(uint16_t))];
+            };
+
+            // Scratch space is per thread: the tick thread and the reliability thread flush concurrently.
+            thread_local std::vector<sockaddr_in> destAddrs;
+            thread_local std::vector<bool> destValid;
+            thread_local std::vector<mmsghdr> messages;
+            thread_local std::vector<size_t> datagramsPerMessage;
+            thread_local std::vector<iovec> iovecs;
+            thread_local std::vector<GsoControl> gsoControls;
+
+            destAddrs.resize(count);
+            destValid.assign(count, false);
+            for (size_t i = 0; i < count; ++i) {
+                const OutgoingDatagram& dg = datagrams[i];
+                if (!dg.recipient || (dg.data == nullptr && dg.size > 0) || !ToSockaddr(*dg.recipient, destAddrs[i])) {
+                    RF_NETWORK_ERROR("UDPSocketEpoll::SendBatch: Invalid datagram {} in batch ({}). Skipping.",
+                        i, dg.recipient ? dg.recipient->ToString() : std::string("null recipient"));
+                    continue;
+                }
+                destValid[i] = true;
+            }
+
+            auto sameDestination = [](const sockaddr_in& a, const sockaddr_in& b) {
+                return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+            };
+
+            size_t totalSent = 0;
+            for (size_t shardIndex = 0; shardIndex < m_shards.size(); ++shardIndex) {
+                const int socketFd = m_shards[shardIndex]->socketFd;
+
+                // iovecs/gsoControls are sized up front so the pointers stored in messages stay valid.
+                messages.clear();
+                datagramsPerMessage.clear();
+                iovecs.resize(count);
+                gsoControls.resize(count);
+                size_t iovecCursor = 0;
+
+                size_t i = 0;
+                while (i < count) {
+                    if (!destValid[i] || ShardForDestination(destAddrs[i]) != shardIndex) {
+                        ++i;
+                        continue;
+                    }
+
+                    // Find a run of datagrams to the same recipient that GSO can send as one super-datagram:
+                    // equal segment sizes, with only the last segment allowed to be shorter.
+                    size_t runEnd = i + 1;
+                    if (m_gsoSupported && datagrams[i].size > 0) {
+                        const uint32_t segmentSize = datagrams[i].size;
+                        size_t runBytes = segmentSize;
+                        while (runEnd < count && destValid[runEnd] &&
+                            runEnd - i < UDP_GSO_MAX_SEGMENTS_EPOLL &&
+                            sameDestination(destAddrs[runEnd], destAddrs[i]) &&
+                            datagrams[runEnd].size > 0 && datagrams[runEnd].size <= segmentSize &&
+                            runBytes + datagrams[runEnd].size <= UDP_GSO_MAX_BYTES_EPOLL) {
+                            runBytes += datagrams[runEnd].size;
+                            const bool shorterTail = datagrams[runEnd].size < segmentSize;
+                            ++runEnd;
+                            if (shorterTail) {
+                                break;
+                            }
+                        }
+                    }
+
+                    mmsghdr msg{};
+                    msg.msg_hdr.msg_name = &destAddrs[i];
+                    msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                    msg.msg_hdr.msg_iov = &iovecs[iovecCursor];
+                    msg.msg_hdr.msg_iovlen = runEnd - i;
+                    for (size_t k = i; k < runEnd; ++k) {
+                        iovecs[iovecCursor].iov_base = const_cast<uint8_t*>(datagrams[k].data);
+                        iovecs[iovecCursor].iov_len = datagrams[k].size;
+                        ++iovecCursor;
+                    }
+                    if (runEnd - i > 1) {
+                        GsoControl& control = gsoControls[messages.size()];
+                        std::memset(control.buffer, 0, sizeof(control.buffer));
+                        msg.msg_hdr.msg_control = control.buffer;
+                        msg.msg_hdr.msg_controllen = sizeof(control.buffer);
+                        cmsghdr* cm = CMSG_FIRSTHDR(&msg.msg_hdr);
+                        cm->cmsg_level = SOL_UDP;
+                        cm->cmsg_type = UDP_SEGMENT;
+                        cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                        const uint16_t segmentSize = static_cast<uint16_t>(datagrams[i].size);
+                        std::memcpy(CMSG_DATA(cm), &segmentSize, sizeof(segmentSize));
+                    }
+                    messages.push_back(msg);
+                    datagramsPerMessage.push_back(runEnd - i);
+                    i = runEnd;
+                }
+
+                if (messages.empty()) {
+                    continue;
+                }
+                if (socketFd < 0) {
+                    RF_NETWORK_ERROR("UDPSocketEpoll::SendBatch: Socket for shard {} closed. Dropping {} messages.", shardIndex, messages.size());
+                    continue;
+                }
+
+                size_t offset = 0;
+                while (offset < messages.size()) {
+                    const unsigned int chunk = static_cast<unsigned int>(std::min(messages.size() - offset, SENDMMSG_BATCH_SIZE_EPOLL));
+                    int result = sendmmsg(socketFd, &messages[offset], chunk, MSG_DONTWAIT | MSG_NOSIGNAL);
+                    if (result < 0) {
+                        int errorCode = errno;
+                        if (errorCode == EINTR) {
+                            continue;
+                        }
+                        // The first message of the chunk failed; report it and move past it.
+                        RF_NETWORK_ERROR("UDPSocketEpoll::SendBatch: sendmmsg failed with error: {} ({}). Dropping {} datagram(s).",
+                            errorCode, std::strerror(errorCode), datagramsPerMessage[offset]);
+                        ++offset;
+                        continue;
+                    }
+                    for (int m = 0; m < result; ++m) {
+                        totalSent += datagramsPerMessage[offset + m];
+                    }
+                    offset += static_cast<size_t>(result);
+                }
+            }
+
+            RF_NETWORK_TRACE("UDPSocketEpoll::SendBatch: Sent {}/{} datagrams.", totalSent, count);
+            return totalSent;
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
+
+#endif // __linux__
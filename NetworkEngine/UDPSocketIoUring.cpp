@@ -0,0 +1,541 @@
+﻿// File: UDPSocketIoUring.cpp
+// RiftForged Game Development Team
+// Copyright (c) 2023-2025 RiftForged Game Development Team
+// Description: Implements INetworkIO on Linux with io_uring (multishot recvmsg + provided buffer ring).
+
+#include "UDPSocketIoUring.h"
+
+#if defined(RF_HAS_IO_URING)
+
+#include "INetworkIOEvents.h"    // For m_eventHandler calls
+#include "../Utils/Logger.h"     // For RF_NETWORK_... macros
+
+#include <algorithm>             // For std::min
+#include <cerrno>                // For errno
+#include <chrono>                // For std::chrono::milliseconds
+#include <cstring>               // For std::memset, std::memcpy, std::strerror
+#include <sstream>               // For std::ostringstream
+#include <system_error>          // For std::system_error
+
+#include <unistd.h>              // For close
+#include <arpa/inet.h>           // For inet_pton, inet_ntop, htons
+#include <linux/sock_diag.h>     // For SK_MEMINFO_RMEM_ALLOC, SK_MEMINFO_RCVBUF
+
+namespace RiftForged {
+    namespace Networking {
+
+        namespace {
+            // Sends made on the ring thread (replies raised from OnRawDataReceived) are only queued; the ring
+            // thread submits them together once it has handled the completions it reaped.
+            thread_local bool t_isRingThread = false;
+        }
+
+        UDPSocketIoUring::UDPSocketIoUring()
+            : m_listenIp(""),
+            m_listenPort(0),
+            m_eventHandler(nullptr),
+            m_socketFd(-1),
+            m_dontFragmentSet(false),
+            m_ring{},
+            m_ringInitialized(false),
+            m_recvBufferRing(nullptr),
+            m_recvBufferEntrySize(0),
+            m_recvMsgTemplate{},
+            m_submitPending(false),
+            m_isRunning(false),
+            m_statDatagramsReceived(0),
+            m_statReceiveRearms(0),
+            m_statSendSubmits(0)
+        {
+            RF_NETWORK_INFO("UDPSocketIoUring: Constructor called.");
+        }
+
+        UDPSocketIoUring::~UDPSocketIoUring() {
+            RF_NETWORK_INFO("UDPSocketIoUring: Destructor called. Attempting to stop...");
+            Stop();
+            TeardownRing();
+        }
+
+        bool UDPSocketIoUring::IsRunning() const {
+            return m_isRunning.load(std::memory_order_acquire);
+        }
+
+        float UDPSocketIoUring::GetReceiveQueueFill() const {
+            // Datagrams wait on the socket once the ring runs out of provided buffers; SO_MEMINFO gives the
+            // memory they take and the limit at which the kernel starts dropping them.
+            uint32_t memInfo[SK_MEMINFO_VARS] = {};
+            socklen_t memInfoLength = sizeof(memInfo);
+            if (m_socketFd < 0 || getsockopt(m_socketFd, SOL_SOCKET, SO_MEMINFO, memInfo, &memInfoLength) != 0 ||
+                memInfo[SK_MEMINFO_RCVBUF] == 0) {
+                return 0.0f;
+            }
+            return std::min(1.0f, static_cast<float>(memInfo[SK_MEMINFO_RMEM_ALLOC]) / memInfo[SK_MEMINFO_RCVBUF]);
+        }
+
+        void UDPSocketIoUring::TeardownRing() {
+            if (m_ringInitialized) {
+                if (m_recvBufferRing) {
+                    io_uring_free_buf_ring(&m_ring, m_recvBufferRing, IOURING_RECV_BUFFER_COUNT, IOURING_RECV_BUFFER_GROUP_ID);
+                    m_recvBufferRing = nullptr;
+                }
+                io_uring_queue_exit(&m_ring); // Cancels anything still in flight.
+                m_ringInitialized = false;
+            }
+            if (m_socketFd >= 0) {
+                close(m_socketFd);
+                m_socketFd = -1;
+            }
+        }
+
+        bool UDPSocketIoUring::Init(const std::string& listenIp, uint16_t listenPort, INetworkIOEvents* eventHandler) {
+            RF_NETWORK_INFO("UDPSocketIoUring: Initializing for {}:{}...", listenIp, listenPort);
+
+            if (m_isRunning.load(std::memory_order_relaxed)) {
+                RF_NETWORK_WARN("UDPSocketIoUring: Already initialized and potentially running. Please call Stop() first.");
+                return false;
+            }
+            if (!eventHandler) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: Initialization failed - INetworkIOEvents handler is null.");
+                return false;
+            }
+
+            m_eventHandler = eventHandler;
+            m_listenIp = listenIp;
+            m_listenPort = listenPort;
+
+            m_socketFd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+            if (m_socketFd < 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: socket() failed with error: {} ({})", errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("socket failed", errorCode);
+                return false;
+            }
+
+            int kernelBufferBytes = 4 * 1024 * 1024;
+            if (setsockopt(m_socketFd, SOL_SOCKET, SO_RCVBUF, &kernelBufferBytes, sizeof(kernelBufferBytes)) != 0) {
+                RF_NETWORK_WARN("UDPSocketIoUring: setsockopt(SO_RCVBUF) failed with error: {}", errno);
+            }
+            if (setsockopt(m_socketFd, SOL_SOCKET, SO_SNDBUF, &kernelBufferBytes, sizeof(kernelBufferBytes)) != 0) {
+                RF_NETWORK_WARN("UDPSocketIoUring: setsockopt(SO_SNDBUF) failed with error: {}", errno);
+            }
+            // Don't Fragment, ignoring the kernel's PMTU cache; path MTU discovery probes each connection instead.
+            int pmtuDiscovery = IP_PMTUDISC_PROBE;
+            m_dontFragmentSet = setsockopt(m_socketFd, IPPROTO_IP, IP_MTU_DISCOVER, &pmtuDiscovery, sizeof(pmtuDiscovery)) == 0;
+            if (!m_dontFragmentSet) {
+                RF_NETWORK_WARN("UDPSocketIoUring: setsockopt(IP_MTU_DISCOVER) failed with error: {}. Path MTU discovery disabled.", errno);
+            }
+
+            sockaddr_in serverAddr;
+            std::memset(&serverAddr, 0, sizeof(serverAddr));
+            serverAddr.sin_family = AF_INET;
+            serverAddr.sin_port = htons(m_listenPort);
+            if (inet_pton(AF_INET, m_listenIp.c_str(), &serverAddr.sin_addr) != 1) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: inet_pton failed for IP {}.", m_listenIp);
+                m_eventHandler->OnNetworkError("inet_pton failed for listen IP", EINVAL);
+                TeardownRing();
+                return false;
+            }
+            if (bind(m_socketFd, reinterpret_cast<sockaddr*>(&serverAddr), sizeof(serverAddr)) != 0) {
+                int errorCode = errno;
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: bind() failed with error: {} ({})", errorCode, std::strerror(errorCode));
+                m_eventHandler->OnNetworkError("bind failed", errorCode);
+                TeardownRing();
+                return false;
+            }
+            RF_NETWORK_INFO("UDPSocketIoUring: Socket bound successfully to {}:{}.", m_listenIp, m_listenPort);
+
+            int ret = io_uring_queue_init(IOURING_QUEUE_DEPTH, &m_ring, 0);
+            if (ret < 0) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: io_uring_queue_init failed with error: {} ({})", -ret, std::strerror(-ret));
+                m_eventHandler->OnNetworkError("io_uring_queue_init failed", -ret);
+                TeardownRing();
+                return false;
+            }
+            m_ringInitialized = true;
+
+            // Multishot recvmsg lays each completion out as [io_uring_recvmsg_out][sockaddr][payload]
+            // inside the selected buffer, so every ring entry must hold all three.
+            m_recvBufferEntrySize = static_cast<unsigned>(sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + DEFAULT_UDP_BUFFER_SIZE_IOURING);
+            std::memset(&m_recvMsgTemplate, 0, sizeof(m_recvMsgTemplate));
+            m_recvMsgTemplate.msg_namelen = sizeof(sockaddr_in);
+            m_recvMsgTemplate.msg_controllen = 0;
+
+            try {
+                m_recvSlab.assign(static_cast<size_t>(IOURING_RECV_BUFFER_COUNT) * m_recvBufferEntrySize, 0);
+                m_sendSlab.assign(static_cast<size_t>(IOURING_SEND_SLOT_COUNT) * DEFAULT_UDP_BUFFER_SIZE_IOURING, 0);
+                m_sendSlots.assign(IOURING_SEND_SLOT_COUNT, SendSlot{});
+                m_freeSendSlots.clear();
+                m_freeSendSlots.reserve(IOURING_SEND_SLOT_COUNT);
+            }
+            catch (const std::bad_alloc& e) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: Failed to allocate buffer slabs: {}", e.what());
+                m_eventHandler->OnNetworkError("Failed to allocate io_uring buffer slabs", 0);
+                TeardownRing();
+                return false;
+            }
+
+            for (uint32_t i = 0; i < IOURING_SEND_SLOT_COUNT; ++i) {
+                SendSlot& slot = m_sendSlots[i];
+                slot.buffer = m_sendSlab.data() + static_cast<size_t>(i) * DEFAULT_UDP_BUFFER_SIZE_IOURING;
+                slot.iov.iov_base = slot.buffer;
+                slot.iov.iov_len = 0;
+                slot.msg.msg_name = &slot.destAddr;
+                slot.msg.msg_namelen = sizeof(sockaddr_in);
+                slot.msg.msg_iov = &slot.iov;
+                slot.msg.msg_iovlen = 1;
+                m_freeSendSlots.push_back(IOURING_SEND_SLOT_COUNT - 1 - i);
+            }
+
+            int bufRingError = 0;
+            m_recvBufferRing = io_uring_setup_buf_ring(&m_ring, IOURING_RECV_BUFFER_COUNT, IOURING_RECV_BUFFER_GROUP_ID, 0, &bufRingError);
+            if (!m_recvBufferRing) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: io_uring_setup_buf_ring failed with error: {} ({}). Kernel 5.19+ is required.",
+                    -bufRingError, std::strerror(-bufRingError));
+                m_eventHandler->OnNetworkError("io_uring_setup_buf_ring failed", -bufRingError);
+                TeardownRing();
+                return false;
+            }
+            const int ringMask = io_uring_buf_ring_mask(IOURING_RECV_BUFFER_COUNT);
+            for (unsigned i = 0; i < IOURING_RECV_BUFFER_COUNT; ++i) {
+                io_uring_buf_ring_add(m_recvBufferRing, m_recvSlab.data() + static_cast<size_t>(i) * m_recvBufferEntrySize,
+                    m_recvBufferEntrySize, static_cast<unsigned short>(i), ringMask, static_cast<int>(i));
+            }
+            io_uring_buf_ring_advance(m_recvBufferRing, IOURING_RECV_BUFFER_COUNT);
+
+            RF_NETWORK_INFO("UDPSocketIoUring: Initialization successful ({} provided receive buffers, {} send slots).",
+                IOURING_RECV_BUFFER_COUNT, IOURING_SEND_SLOT_COUNT);
+            return true;
+        }
+
+        bool UDPSocketIoUring::ArmMultishotReceiveUnlocked() {
+            io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+            if (!sqe) {
+                RF_NETWORK_ERROR("UDPSocketIoUring: Submission queue full while arming multishot recvmsg.");
+                return false;
+            }
+            io_uring_prep_recvmsg_multishot(sqe, m_socketFd, &m_recvMsgTemplate, 0);
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = IOURING_RECV_BUFFER_GROUP_ID;
+            io_uring_sqe_set_data64(sqe, RECV_TAG);
+            int ret = io_uring_submit(&m_ring);
+            if (ret < 0) {
+                RF_NETWORK_ERROR("UDPSocketIoUring: io_uring_submit failed while arming recvmsg: {} ({})", -ret, std::strerror(-ret));
+                return false;
+            }
+            m_statReceiveRearms.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool UDPSocketIoUring::Start() {
+            if (!m_ringInitialized || m_socketFd < 0) {
+                RF_NETWORK_ERROR("UDPSocketIoUring: Cannot start. Socket or ring not initialized.");
+                return false;
+            }
+            if (!m_eventHandler) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: Cannot start. Event handler is null (was Init called and successful?).");
+                return false;
+            }
+            if (m_isRunning.load(std::memory_order_relaxed)) {
+                RF_NETWORK_WARN("UDPSocketIoUring: Already running.");
+                return true;
+            }
+
+            RF_NETWORK_INFO("UDPSocketIoUring: Starting network operations...");
+            {
+                std::lock_guard<std::mutex> lock(m_submitMutex);
+                if (!ArmMultishotReceiveUnlocked()) {
+                    m_eventHandler->OnNetworkError("Failed to arm multishot recvmsg", 0);
+                    return false;
+                }
+            }
+
+            m_isRunning = true;
+            try {
+                m_ringThread = std::thread(&UDPSocketIoUring::RingThread, this);
+            }
+            catch (const std::system_error& e) {
+                RF_NETWORK_CRITICAL("UDPSocketIoUring: Failed to create ring thread: {}", e.what());
+                m_eventHandler->OnNetworkError("Failed to create ring thread", 0);
+                m_isRunning = false;
+                return false;
+            }
+            RF_NETWORK_INFO("UDPSocketIoUring: Ring thread started. Server is listening.");
+            return true;
+        }
+
+        void UDPSocketIoUring::Stop() {
+            if (!m_isRunning.exchange(false, std::memory_order_acq_rel)) {
+                RF_NETWORK_INFO("UDPSocketIoUring: Stop called but already not running or stop initiated.");
+                return;
+            }
+            m_sendSlotFreed.notify_all(); // Senders waiting for a slot give up
+            RF_NETWORK_INFO("UDPSocketIoUring: Stopping network operations...");
+
+            // A NOP completion wakes the ring thread out of io_uring_wait_cqe.
+            {
+                std::lock_guard<std::mutex> lock(m_submitMutex);
+                io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+                if (sqe) {
+                    io_uring_prep_nop(sqe);
+                    io_uring_sqe_set_data64(sqe, WAKE_TAG);
+                    io_uring_submit(&m_ring);
+                }
+                else {
+                    RF_NETWORK_ERROR("UDPSocketIoUring: Submission queue full; could not post wake NOP.");
+                }
+            }
+
+            if (m_ringThread.joinable()) {
+                m_ringThread.join();
+            }
+            RF_NETWORK_INFO("UDPSocketIoUring: Ring thread joined.");
+
+            RF_NETWORK_INFO("UDPSocketIoUring: Stats - datagrams received: {}, recvmsg arms: {}, send submits: {}.",
+                m_statDatagramsReceived.load(), m_statReceiveRearms.load(), m_statSendSubmits.load());
+
+            TeardownRing();
+            RF_NETWORK_INFO("UDPSocketIoUring: Network operations stopped successfully.");
+        }
+
+        void UDPSocketIoUring::RecycleReceiveBuffer(unsigned short bufferId) {
+            io_uring_buf_ring_add(m_recvBufferRing, m_recvSlab.data() + static_cast<size_t>(bufferId) * m_recvBufferEntrySize,
+                m_recvBufferEntrySize, bufferId, io_uring_buf_ring_mask(IOURING_RECV_BUFFER_COUNT), 0);
+            io_uring_buf_ring_advance(m_recvBufferRing, 1);
+        }
+
+        void UDPSocketIoUring::HandleReceiveCompletion(const io_uring_cqe* cqe) {
+            if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+                // No buffer attached: an error, or ENOBUFS when the ring ran dry. Multishot is terminated in both cases.
+                if (cqe->res != -ENOBUFS && cqe->res != -ECANCELED) {
+                    RF_NETWORK_ERROR("UDPSocketIoUring: recvmsg completion failed with error: {} ({})", -cqe->res, std::strerror(-cqe->res));
+                    if (m_eventHandler) m_eventHandler->OnNetworkError("recvmsg completion failed", -cqe->res);
+                }
+                else if (cqe->res == -ENOBUFS) {
+                    RF_NETWORK_WARN("UDPSocketIoUring: Provided buffer ring exhausted; re-arming recvmsg.");
+                }
+                return;
+            }
+
+            const unsigned short bufferId = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            uint8_t* buffer = m_recvSlab.data() + static_cast<size_t>(bufferId) * m_recvBufferEntrySize;
+
+            if (cqe->res >= 0) {
+                io_uring_recvmsg_out* out = io_uring_recvmsg_validate(buffer, cqe->res, &m_recvMsgTemplate);
+                if (!out) {
+                    RF_NETWORK_WARN("UDPSocketIoUring: Received malformed recvmsg completion ({} bytes). Discarding.", cqe->res);
+                }
+                else if (out->flags & MSG_TRUNC) {
+                    RF_NETWORK_WARN("UDPSocketIoUring: Datagram larger than {} bytes was truncated. Discarding.", DEFAULT_UDP_BUFFER_SIZE_IOURING);
+                }
+                else if (out->namelen >= sizeof(sockaddr_in)) {
+                    const sockaddr_in* senderAddr = static_cast<const sockaddr_in*>(io_uring_recvmsg_name(out));
+                    const uint8_t* payload = static_cast<const uint8_t*>(io_uring_recvmsg_payload(out, &m_recvMsgTemplate));
+                    const uint32_t payloadLength = io_uring_recvmsg_payload_length(out, cqe->res, &m_recvMsgTemplate);
+
+                    const NetworkEndpoint sender_endpoint(senderAddr->sin_addr.s_addr, ntohs(senderAddr->sin_port));
+
+                    m_statDatagramsReceived.fetch_add(1, std::memory_order_relaxed);
+                    if (m_eventHandler) {
+                        m_eventHandler->OnRawDataReceived(sender_endpoint, payloadLength > 0 ? payload : nullptr, payloadLength, nullptr);
+                    }
+                }
+            }
+
+            RecycleReceiveBuffer(bufferId);
+        }
+
+        void UDPSocketIoUring::RingThread() {
+            std::ostringstream oss_thread_id_start;
+            oss_thread_id_start << std::this_thread::get_id();
+            RF_NETWORK_INFO("UDPSocketIoUring: Ring thread started (ID: {})", oss_thread_id_start.str());
+            t_isRingThread = true;
+
+            bool exitRequested = false;
+            while (!exitRequested) {
+                io_uring_cqe* cqe = nullptr;
+                int ret = io_uring_wait_cqe(&m_ring, &cqe);
+                if (ret == -EINTR) continue;
+                if (ret < 0) {
+                    RF_NETWORK_ERROR("UDPSocketIoUring: io_uring_wait_cqe failed with error: {}. Exiting ring thread.", -ret);
+                    if (m_eventHandler) m_eventHandler->OnNetworkError("io_uring_wait_cqe failed", -ret);
+                    break;
+                }
+
+                bool rearmReceive = false;
+                bool sendSlotsFreed = false;
+                unsigned reaped = 0;
+                unsigned head;
+                io_uring_for_each_cqe(&m_ring, head, cqe) {
+                    ++reaped;
+                    const uint64_t tag = io_uring_cqe_get_data64(cqe);
+                    if (tag == RECV_TAG) {
+                        HandleReceiveCompletion(cqe);
+                        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                            rearmReceive = true; // The kernel dropped the multishot request.
+                        }
+                    }
+                    else if (tag & SEND_TAG) {
+                        const uint32_t slotIndex = static_cast<uint32_t>(tag & ~SEND_TAG);
+                        if (cqe->res < 0) {
+                            RF_NETWORK_ERROR("UDPSocketIoUring: sendmsg completion failed with error: {} ({})", -cqe->res, std::strerror(-cqe->res));
+                        }
+                        std::lock_guard<std::mutex> lock(m_submitMutex);
+                        SendSlot& slot = m_sendSlots[slotIndex];
+                        slot.packet.Reset();
+                        slot.iov.iov_base = slot.buffer;
+                        m_freeSendSlots.push_back(slotIndex);
+                        sendSlotsFreed = true;
+                    }
+                    else if (tag == WAKE_TAG) {
+                        exitRequested = true;
+                    }
+                }
+                io_uring_cq_advance(&m_ring, reaped);
+                if (sendSlotsFreed) {
+                    m_sendSlotFreed.notify_all();
+                }
+
+                if (rearmReceive && !exitRequested && m_isRunning.load(std::memory_order_acquire)) {
+                    std::lock_guard<std::mutex> lock(m_submitMutex);
+                    ArmMultishotReceiveUnlocked();
+                }
+                // One submit for the sends queued while handling these completions, and for any left in the SQ by
+                // a failed submit (reaping has made room in the CQ).
+                if (!exitRequested) {
+                    std::lock_guard<std::mutex> lock(m_submitMutex);
+                    if (m_submitPending) {
+                        SubmitQueuedUnlocked("RingThread");
+                    }
+                }
+            }
+
+            std::ostringstream exit_tid_oss;
+            exit_tid_oss << std::this_thread::get_id();
+            RF_NETWORK_INFO("UDPSocketIoUring: Ring thread {} exiting gracefully.", exit_tid_oss.str());
+        }
+
+        bool UDPSocketIoUring::QueueSendUnlocked(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size, const PacketBuffer* packet) {
+            if (data == nullptr && size > 0) {
+                RF_NETWORK_ERROR("UDPSocketIoUring::QueueSend: Data is null but size {} > 0 for sending to {}.", size, recipient.ToString());
+                return false;
+            }
+            if (!packet && size > static_cast<uint32_t>(DEFAULT_UDP_BUFFER_SIZE_IOURING)) {
+                RF_NETWORK_ERROR("UDPSocketIoUring::QueueSend: Size {} exceeds max datagram size {}.", size, DEFAULT_UDP_BUFFER_SIZE_IOURING);
+                return false;
+            }
+
+            sockaddr_in destAddr;
+            std::memset(&destAddr, 0, sizeof(destAddr));
+            destAddr.sin_family = AF_INET;
+            destAddr.sin_port = htons(recipient.GetPort());
+            destAddr.sin_addr.s_addr = recipient.GetAddressV4();
+            if (!recipient.IsValid()) {
+                RF_NETWORK_ERROR("UDPSocketIoUring::QueueSend: Invalid recipient {}.", recipient.ToString());
+                return false;
+            }
+
+            if (m_freeSendSlots.empty()) {
+                RF_NETWORK_WARN("UDPSocketIoUring::QueueSend: All {} send slots in flight. Dropping datagram to {}.",
+                    IOURING_SEND_SLOT_COUNT, recipient.ToString());
+                return false;
+            }
+            io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+            if (!sqe) {
+                RF_NETWORK_WARN("UDPSocketIoUring::QueueSend: Submission queue full. Dropping datagram to {}.", recipient.ToString());
+                return false;
+            }
+
+            const uint32_t slotIndex = m_freeSendSlots.back();
+            m_freeSendSlots.pop_back();
+            SendSlot& slot = m_sendSlots[slotIndex];
+            if (packet) {
+                slot.packet = *packet;
+                slot.iov.iov_base = const_cast<uint8_t*>(data);
+            }
+            else if (size > 0) {
+                std::memcpy(slot.buffer, data, size);
+            }
+            slot.iov.iov_len = size;
+            slot.destAddr = destAddr;
+
+            io_uring_prep_sendmsg(sqe, m_socketFd, &slot.msg, 0);
+            io_uring_sqe_set_data64(sqe, SEND_TAG | slotIndex);
+            return true;
+        }
+
+        void UDPSocketIoUring::SubmitQueuedUnlocked(const char* caller) {
+            int ret = io_uring_submit(&m_ring);
+            if (ret < 0) {
+                if (!m_submitPending) {
+                    RF_NETWORK_WARN("UDPSocketIoUring::{}: io_uring_submit failed with error: {} ({}). Queued sends stay in the ring and are retried.",
+                        caller, -ret, std::strerror(-ret));
+                }
+                m_submitPending = true;
+                return;
+            }
+            m_submitPending = false;
+            m_statSendSubmits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        bool UDPSocketIoUring::SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) {
+            const OutgoingDatagram datagram{ &recipient, data, size };
+            return SendBatch(&datagram, 1) == 1;
+        }
+
+        bool UDPSocketIoUring::SendPacket(const NetworkEndpoint& recipient, const PacketBuffer& packet) {
+            const OutgoingDatagram datagram{ &recipient, packet.Data(), static_cast<uint32_t>(packet.Size()), &packet };
+            return SendBatch(&datagram, 1) == 1;
+        }
+
+        size_t UDPSocketIoUring::SendBatch(const OutgoingDatagram* datagrams, size_t count) {
+            if (count == 0 || datagrams == nullptr) {
+                return 0;
+            }
+            if (!m_ringInitialized || m_socketFd < 0) {
+                RF_NETWORK_ERROR("UDPSocketIoUring::SendBatch: Ring not valid. Dropping {} datagrams.", count);
+                return 0;
+            }
+
+            size_t queued = 0;
+            std::unique_lock<std::mutex> lock(m_submitMutex);
+            for (size_t i = 0; i < count; ++i) {
+                if (!datagrams[i].recipient) {
+                    continue;
+                }
+                // A tick's batch may hold more datagrams than there are slots (OUTBOUND_BATCH_MAX_DATAGRAMS_PKT):
+                // submit what is queued and wait for the ring thread to recycle slots from its completions. The
+                // ring thread itself cannot wait for its own reaping, so there QueueSendUnlocked drops instead.
+                if (m_freeSendSlots.empty() && !t_isRingThread) {
+                    if (m_submitPending) {
+                        SubmitQueuedUnlocked("SendBatch");
+                    }
+                    m_sendSlotFreed.wait_for(lock, std::chrono::milliseconds(IOURING_SEND_SLOT_WAIT_MS), [this]() {
+                        return !m_freeSendSlots.empty() || !m_isRunning.load(std::memory_order_acquire);
+                        });
+                    if (m_freeSendSlots.empty()) {
+                        RF_NETWORK_WARN("UDPSocketIoUring::SendBatch: No send slot freed within {} ms. Dropping {} of {} datagrams.",
+                            IOURING_SEND_SLOT_WAIT_MS, count - i, count);
+                        break;
+                    }
+                }
+                if (QueueSendUnlocked(*datagrams[i].recipient, datagrams[i].data, datagrams[i].size, datagrams[i].packet)) {
+                    ++queued;
+                    m_submitPending = true;
+                }
+            }
+            if (queued == 0) {
+                return 0;
+            }
+
+            // io_uring_submit flushes every SQE queued so far, so concurrent senders share syscalls.
+            if (!t_isRingThread && m_submitPending) {
+                SubmitQueuedUnlocked("SendBatch");
+            }
+            RF_NETWORK_TRACE("UDPSocketIoUring::SendBatch: Queued {}/{} datagrams.", queued, count);
+            return queued;
+        }
+
+    } // namespace Networking
+} // namespace RiftForged
+
+#endif // RF_HAS_IO_URING
@@ -0,0 +1,191 @@
+﻿// File: UDPSocketIoUring.h
+// RiftForged Game Engine
+// Copyright (C) 2023 RiftForged Team
+// Description: Header file for the UDPSocketIoUring class, the io_uring implementation of INetworkIO.
+// Receives with a single multishot recvmsg backed by a kernel-managed provided buffer ring and
+// submits sends as sendmsg SQEs from a pre-allocated slot pool.
+
+#pragma once
+
+// io_uring support is only compiled when liburing is available (Linux, liburing >= 2.4).
+#if defined(__linux__) && __has_include(<liburing.h>)
+#define RF_HAS_IO_URING 1
+#endif
+
+#if defined(RF_HAS_IO_URING)
+
+#include <string>           // For std::string
+#include <vector>           // For std::vector
+#include <thread>           // For std::thread
+#include <atomic>           // For std::atomic
+#include <mutex>            // For std::mutex
+#include <condition_variable> // For std::condition_variable
+
+#include <liburing.h>       // For io_uring, io_uring_buf_ring
+#include <netinet/in.h>     // For sockaddr_in
+#include <sys/socket.h>     // For msghdr
+
+// Project-specific includes
+#include "INetworkIO.h"           // Definition of the interface we are implementing
+#include "NetworkEndpoint.h"      // Defines NetworkEndpoint struct
+
+// Constants for the io_uring transport.
+// These could be made configurable in a production system.
+const int DEFAULT_UDP_BUFFER_SIZE_IOURING = 4096;        // Max datagram payload (matches the IOCP/epoll backends)
+const unsigned IOURING_QUEUE_DEPTH = 2048;                // SQ entries; CQ is sized 2x by the kernel
+const unsigned IOURING_RECV_BUFFER_COUNT = 1024;          // Entries in the provided buffer ring (power of two)
+const unsigned short IOURING_RECV_BUFFER_GROUP_ID = 0;    // Buffer group consumed by the multishot recvmsg
+const unsigned IOURING_SEND_SLOT_COUNT = 1024;            // Max sendmsg operations in flight at once
+const int IOURING_SEND_SLOT_WAIT_MS = 10;                 // How long SendBatch waits for a slot before dropping the rest
+
+namespace RiftForged {
+    namespace Networking {
+
+        // UDPSocketIoUring implements INetworkIO on Linux using io_uring.
+        // The receive path is a single multishot recvmsg: the kernel picks a buffer from the provided
+        // buffer ring for every datagram and keeps the request armed, so no per-receive contexts are
+        // posted and no syscalls are made per datagram. Buffers are returned to the ring after
+        // OnRawDataReceived returns (context is always nullptr, as with the epoll backend).
+        // Sends copy into a pre-allocated slot and queue a sendmsg SQE; the slot is recycled when its
+        // completion is reaped. Completions are reaped by one ring thread.
+        class UDPSocketIoUring : public INetworkIO {
+        public:
+            UDPSocketIoUring();
+            ~UDPSocketIoUring() override;
+
+            UDPSocketIoUring(const UDPSocketIoUring&) = delete;
+            UDPSocketIoUring& operator=(const UDPSocketIoUring&) = delete;
+
+            // --- INetworkIO Interface Implementation ---
+
+            /**
+             * @brief Creates and binds the UDP socket, sets up the ring and registers the receive buffer ring.
+             * @param listenIp The IP address to bind the socket to (e.g., "0.0.0.0" for all interfaces).
+             * @param listenPort The port number to listen on.
+             * @param eventHandler A pointer to the object that will receive network I/O events.
+             * @return True if initialization is successful, false otherwise.
+             */
+            bool Init(const std::string& listenIp, uint16_t listenPort, INetworkIOEvents* eventHandler) override;
+
+            /**
+             * @brief Arms the multishot recvmsg and starts the ring (completion) thread.
+             * @return True if the ring thread was started, false otherwise.
+             */
+            bool Start() override;
+
+            /**
+             * @brief Wakes and joins the ring thread, then tears down the ring and closes the socket.
+             */
+            void Stop() override;
+
+            /**
+             * @brief Sends one datagram through SendBatch: it is copied into a send slot and submitted as a sendmsg SQE.
+             * OnSendCompleted is not raised; the slot is recycled internally on completion.
+             * @return True if the send was queued to the kernel, false otherwise (e.g., all slots busy).
+             */
+            bool SendData(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size) override;
+
+            /**
+             * @brief Sends one packet buffer through SendBatch; the sendmsg SQE points straight at it and the slot
+             * keeps a reference until the completion is reaped, so the datagram is not copied.
+             * @return True if the send was queued to the kernel, false otherwise (e.g., all slots busy).
+             */
+            bool SendPacket(const NetworkEndpoint& recipient, const PacketBuffer& packet) override;
+
+            /**
+             * @brief Queues one sendmsg SQE per datagram and submits them all with a single io_uring_submit.
+             * Datagrams that carry a PacketBuffer are referenced rather than copied. On the ring thread the
+             * submit is left to the ring thread's next pass, so replies to one batch of receives share it.
+             * A batch larger than the free slots is sent in chunks: what is queued is submitted and the call
+             * waits (up to IOURING_SEND_SLOT_WAIT_MS per slot) for completions to free more.
+             * @return The number of datagrams queued to the kernel.
+             */
+            size_t SendBatch(const OutgoingDatagram* datagrams, size_t count) override;
+
+            bool IsRunning() const override;
+
+            bool SupportsPathMtuProbing() const override { return m_dontFragmentSet; }
+
+            /**
+             * @brief Bytes queued on the socket (not yet placed in a provided buffer) against its receive buffer
+             * limit (SO_MEMINFO).
+             */
+            float GetReceiveQueueFill() const override;
+
+        private:
+            // Tags stored in the SQE user_data so the ring thread can tell completions apart.
+            // Send completions carry SEND_TAG | slotIndex.
+            static constexpr uint64_t RECV_TAG = 1ULL << 62;
+            static constexpr uint64_t WAKE_TAG = 1ULL << 61;
+            static constexpr uint64_t SEND_TAG = 1ULL << 60;
+
+            // One pre-allocated outbound datagram. Owned by the kernel between submit and completion.
+            struct SendSlot {
+                msghdr msg;
+                iovec iov;
+                sockaddr_in destAddr;
+                uint8_t* buffer;  // Points into m_sendSlab
+                PacketBuffer packet; // When set, iov points into it instead of 'buffer'; released on completion
+            };
+
+            // Reaps completions until Stop() posts the wake NOP.
+            void RingThread();
+
+            // Queues (or re-queues) the multishot recvmsg. Caller must hold m_submitMutex.
+            bool ArmMultishotReceiveUnlocked();
+
+            // Handles one recvmsg completion and recycles its provided buffer.
+            void HandleReceiveCompletion(const io_uring_cqe* cqe);
+
+            // Returns a provided buffer to the ring so the kernel can reuse it.
+            void RecycleReceiveBuffer(unsigned short bufferId);
+
+            // Prepares a sendmsg SQE for one datagram in a free slot (no submit). With a packet buffer the slot
+            // references it; otherwise the bytes are copied into the slot. Caller must hold m_submitMutex.
+            bool QueueSendUnlocked(const NetworkEndpoint& recipient, const uint8_t* data, uint32_t size, const PacketBuffer* packet);
+
+            // Submits every SQE queued so far. io_uring_submit publishes them to the SQ ring before it enters the
+            // kernel, so a failed submit cannot take them back: they go out on the next io_uring_enter and their
+            // slots are recycled on completion as usual. The ring thread submits again after reaping, which
+            // clears the usual cause (EBUSY with the CQ full). Caller must hold m_submitMutex.
+            void SubmitQueuedUnlocked(const char* caller);
+
+            void TeardownRing();
+
+            // --- Member Variables ---
+            std::string m_listenIp;
+            uint16_t m_listenPort;
+            INetworkIOEvents* m_eventHandler;
+
+            int m_socketFd;
+            bool m_dontFragmentSet;                // IP_PMTUDISC_PROBE set in Init()
+            io_uring m_ring;
+            bool m_ringInitialized;
+
+            // Provided buffer ring for receives (registered with the kernel as IOURING_RECV_BUFFER_GROUP_ID).
+            io_uring_buf_ring* m_recvBufferRing;
+            std::vector<uint8_t> m_recvSlab;       // IOURING_RECV_BUFFER_COUNT * m_recvBufferEntrySize bytes
+            unsigned m_recvBufferEntrySize;        // recvmsg_out header + sockaddr + payload
+            msghdr m_recvMsgTemplate;              // Only msg_namelen/msg_controllen are read by the kernel
+
+            // The SQ is single-producer; every SQE preparation and submit happens under this mutex.
+            std::mutex m_submitMutex;
+            std::vector<SendSlot> m_sendSlots;
+            std::vector<uint8_t> m_sendSlab;       // IOURING_SEND_SLOT_COUNT * DEFAULT_UDP_BUFFER_SIZE_IOURING bytes
+            std::vector<uint32_t> m_freeSendSlots; // Guarded by m_submitMutex
+            std::condition_variable m_sendSlotFreed; // Signalled by the ring thread when it recycles send slots
+            bool m_submitPending;                  // SQEs queued but not (successfully) submitted; guarded by m_submitMutex
+
+            std::thread m_ringThread;
+            std::atomic<bool> m_isRunning;
+
+            // Receive-path counters, logged on Stop() for comparing backends under load.
+            std::atomic<uint64_t> m_statDatagramsReceived;
+            std::atomic<uint64_t> m_statReceiveRearms;
+            std::atomic<uint64_t> m_statSendSubmits;
+        };
+
+    } // namespace Networking
+} // namespace RiftForged
+
+#endif // RF_HAS_IO_URING
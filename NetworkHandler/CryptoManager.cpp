@@ -1,5 +1,6 @@
 ﻿// File: CryptoManager.cpp
 #include "CryptoManager.h"
+#include <cstring> // For std::memcpy
 // Include libsodium headers if not already pulled in by CryptoManager.h
 // or if specific implementation details here need them.
 // e.g., #include "sodium.h"
@@ -126,4 +127,84 @@ std::vector<uint8_t> CryptoManager::DecryptAES_GCM(
     }
     decrypted.resize(decrypted_len);
     return decrypted;
-}
\ No newline at end of file
+}
+
+// --- Datagram AEAD (in place) ---
+static_assert(crypto_aead_aes256gcm_KEYBYTES == CryptoManager::AEAD_KEY_BYTES &&
+    crypto_aead_chacha20poly1305_ietf_KEYBYTES == CryptoManager::AEAD_KEY_BYTES, "AEAD key sizes differ");
+static_assert(crypto_aead_aes256gcm_NPUBBYTES == CryptoManager::AEAD_NONCE_BYTES &&
+    crypto_aead_chacha20poly1305_ietf_NPUBBYTES == CryptoManager::AEAD_NONCE_BYTES, "AEAD nonce sizes differ");
+static_assert(crypto_aead_aes256gcm_ABYTES == CryptoManager::AEAD_TAG_BYTES &&
+    crypto_aead_chacha20poly1305_ietf_ABYTES == CryptoManager::AEAD_TAG_BYTES, "AEAD tag sizes differ");
+
+CryptoManager::AeadCipher CryptoManager::SelectPreferredCipher() {
+    // sodium_init() is idempotent; the CPU feature checks behind is_available depend on it.
+    if (sodium_init() < 0) {
+        return AeadCipher::ChaCha20Poly1305;
+    }
+    return crypto_aead_aes256gcm_is_available() ? AeadCipher::AES256GCM : AeadCipher::ChaCha20Poly1305;
+}
+
+void CryptoManager::InitSessionKey(AeadSessionKey& outKey, AeadCipher cipher, std::span<const uint8_t, AEAD_KEY_BYTES> key) {
+    outKey.cipher = cipher;
+    if (cipher == AeadCipher::AES256GCM) {
+        crypto_aead_aes256gcm_beforenm(&outKey.aesState, key.data());
+        sodium_memzero(outKey.key, sizeof(outKey.key));
+    }
+    else {
+        std::memcpy(outKey.key, key.data(), sizeof(outKey.key));
+    }
+}
+
+bool CryptoManager::AeadEncrypt(
+    const AeadSessionKey& key,
+    std::span<const uint8_t> input,
+    std::span<uint8_t> output,
+    std::span<const uint8_t> associatedData,
+    std::span<const uint8_t, AEAD_NONCE_BYTES> nonce,
+    std::span<uint8_t, AEAD_TAG_BYTES> outTag) {
+
+    if (output.size() != input.size()) {
+        return false;
+    }
+    unsigned long long tagLength = 0;
+    if (key.cipher == AeadCipher::AES256GCM) {
+        return crypto_aead_aes256gcm_encrypt_detached_afternm(
+            output.data(), outTag.data(), &tagLength,
+            input.data(), input.size(),
+            associatedData.data(), associatedData.size(),
+            NULL, nonce.data(), &key.aesState) == 0;
+    }
+    return crypto_aead_chacha20poly1305_ietf_encrypt_detached(
+        output.data(), outTag.data(), &tagLength,
+        input.data(), input.size(),
+        associatedData.data(), associatedData.size(),
+        NULL, nonce.data(), key.key) == 0;
+}
+
+bool CryptoManager::AeadDecrypt(
+    const AeadSessionKey& key,
+    std::span<const uint8_t> input,
+    std::span<uint8_t> output,
+    std::span<const uint8_t> associatedData,
+    std::span<const uint8_t, AEAD_NONCE_BYTES> nonce,
+    std::span<const uint8_t, AEAD_TAG_BYTES> tag) {
+
+    if (output.size() != input.size()) {
+        return false;
+    }
+    if (key.cipher == AeadCipher::AES256GCM) {
+        return crypto_aead_aes256gcm_decrypt_detached_afternm(
+            output.data(), NULL,
+            input.data(), input.size(),
+            tag.data(),
+            associatedData.data(), associatedData.size(),
+            nonce.data(), &key.aesState) == 0;
+    }
+    return crypto_aead_chacha20poly1305_ietf_decrypt_detached(
+        output.data(), NULL,
+        input.data(), input.size(),
+        tag.data(),
+        associatedData.data(), associatedData.size(),
+        nonce.data(), key.key) == 0;
+}
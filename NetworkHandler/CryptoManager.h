@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <span>      // For the in-place datagram API
 #include <stdexcept> // For std::runtime_error
 // It's good practice to forward-declare if you only need pointers/references,
 // but for std::vector return types and parameters, including <vector> is necessary.
@@ -12,6 +14,57 @@
 
 class CryptoManager {
 public:
+    // --- Datagram AEAD (in place, no allocations) ---
+    // The vector functions below allocate their output on every call, which is fine for a handshake but
+    // not for every datagram. These work on caller-owned spans instead: the key schedule is expanded once
+    // per session into an AeadSessionKey, the payload is read and written in a single pass (in place when
+    // output is input), and the tag is detached. Both ciphers take a 96-bit nonce, so ChaCha20-Poly1305 is
+    // its IETF variant here. Failures return false rather than throw: on an open UDP port, datagrams that
+    // fail authentication are routine.
+
+    static constexpr size_t AEAD_KEY_BYTES = 32;
+    static constexpr size_t AEAD_NONCE_BYTES = 12;
+    static constexpr size_t AEAD_TAG_BYTES = 16;
+
+    enum class AeadCipher : uint8_t {
+        ChaCha20Poly1305 = 0, // Constant-time in software everywhere
+        AES256GCM = 1         // Needs AES-NI and PCLMULQDQ; much faster where present
+    };
+
+    struct AeadSessionKey {
+        crypto_aead_aes256gcm_state aesState;  // AES256GCM only: the expanded key schedule (16-byte aligned)
+        unsigned char key[AEAD_KEY_BYTES];     // ChaCha20Poly1305 only
+        AeadCipher cipher = AeadCipher::ChaCha20Poly1305;
+    };
+
+    // AES256GCM when the CPU has hardware AES (crypto_aead_aes256gcm_is_available), else ChaCha20Poly1305.
+    // Both peers must use the same cipher, so the side that picks it has to tell the other.
+    static AeadCipher SelectPreferredCipher();
+
+    static void InitSessionKey(AeadSessionKey& outKey, AeadCipher cipher, std::span<const uint8_t, AEAD_KEY_BYTES> key);
+
+    // Encrypts input into output (the same length; may be the same memory) and writes the tag.
+    // associatedData is authenticated but not encrypted.
+    static bool AeadEncrypt(
+        const AeadSessionKey& key,
+        std::span<const uint8_t> input,
+        std::span<uint8_t> output,
+        std::span<const uint8_t> associatedData,
+        std::span<const uint8_t, AEAD_NONCE_BYTES> nonce,
+        std::span<uint8_t, AEAD_TAG_BYTES> outTag
+    );
+
+    // Verifies the tag over input and associatedData and decrypts input into output (the same length;
+    // may be the same memory). Returns false, leaving output unspecified, if authentication fails.
+    static bool AeadDecrypt(
+        const AeadSessionKey& key,
+        std::span<const uint8_t> input,
+        std::span<uint8_t> output,
+        std::span<const uint8_t> associatedData,
+        std::span<const uint8_t, AEAD_NONCE_BYTES> nonce,
+        std::span<const uint8_t, AEAD_TAG_BYTES> tag
+    );
+
     // ChaCha20-Poly1305 Functions
     std::vector<uint8_t> EncryptChaCha20Poly1305(
         const std::vector<uint8_t>& plaintext,
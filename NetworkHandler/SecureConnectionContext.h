@@ -2,10 +2,13 @@
 #pragma once
 
 #include "sodium.h" // For crypto_kx_...BYTES constants and other libsodium types
+#include "CryptoManager.h" // For CryptoManager::AeadSessionKey
 #include <vector>
+#include <cstring>   // For memcpy
 #include <atomic>    // For handshake_state if you anticipate multithreaded access to it,
                      // otherwise, regular enum state is fine if access is synchronized.
 #include <cstdint>   // For uint64_t
+#include <memory>    // For std::shared_ptr
 
 namespace RiftForged {
     namespace Networking {
@@ -38,10 +41,20 @@ namespace RiftForged {
             uint64_t next_tx_nonce;
             uint64_t next_rx_nonce; // Track expected nonce from the other side
 
+            // Datagram AEAD: the session keys with their key schedules expanded (see install_aead_keys), and
+            // the counters received most recently. Bit i of rx_replay_window is set once counter
+            // (next_rx_nonce - 1 - i) has been accepted. The transmit key is shared and never changed in
+            // place, so datagrams waiting to be sealed off the connection's lock keep the key they were
+            // numbered under even if the connection is reset meanwhile.
+            std::shared_ptr<const CryptoManager::AeadSessionKey> tx_aead_key;
+            CryptoManager::AeadSessionKey rx_aead_key;
+            uint64_t rx_replay_window;
+
             SecureConnectionContext() :
                 handshake_state(SecureHandshakeState::INITIAL),
                 next_tx_nonce(0), // Start nonces from 0 (or a random value if preferred, but must be unique)
-                next_rx_nonce(0)
+                next_rx_nonce(0),
+                rx_replay_window(0)
             {
                 // Initialize memory to prevent use of uninitialized values, though they get overwritten.
                 sodium_memzero(client_ephemeral_pk, crypto_kx_PUBLICKEYBYTES);
@@ -78,8 +91,45 @@ namespace RiftForged {
                 return nonce_bytes;
             }
 
-            // You'll also need a way to construct the *expected* nonce for received messages
-            // based on next_rx_nonce.
+            // Expands session_tx_key and session_rx_key for datagram AEAD with the cipher both sides agreed on,
+            // and restarts both counters. Keys must be derived first.
+            void install_aead_keys(CryptoManager::AeadCipher cipher) {
+                auto txKey = std::make_shared<CryptoManager::AeadSessionKey>();
+                CryptoManager::InitSessionKey(*txKey, cipher, std::span<const uint8_t, CryptoManager::AEAD_KEY_BYTES>(session_tx_key, CryptoManager::AEAD_KEY_BYTES));
+                tx_aead_key = std::move(txKey);
+                CryptoManager::InitSessionKey(rx_aead_key, cipher, std::span<const uint8_t, CryptoManager::AEAD_KEY_BYTES>(session_rx_key, CryptoManager::AEAD_KEY_BYTES));
+                next_tx_nonce = 0;
+                next_rx_nonce = 0;
+                rx_replay_window = 0;
+                handshake_state = SecureHandshakeState::HANDSHAKE_COMPLETE;
+            }
+
+            // Allocation-free nonce for a datagram counter: 4 zero bytes, then the counter little-endian.
+            // Each direction has its own key, so the two sides' counters never share a nonce.
+            static void write_aead_nonce(uint64_t counter, uint8_t (&nonce)[CryptoManager::AEAD_NONCE_BYTES]) {
+                std::memset(nonce, 0, sizeof(nonce));
+                for (size_t i = 0; i < sizeof(counter); ++i) {
+                    nonce[4 + i] = static_cast<uint8_t>(counter >> (8 * i));
+                }
+            }
+
+            // Replay check for the counter of a datagram that passed authentication: accepts each counter once,
+            // in any order within the 64 newest. Returns false for a repeat or an older counter.
+            bool accept_rx_counter(uint64_t counter) {
+                if (counter >= next_rx_nonce) {
+                    const uint64_t shift = counter - next_rx_nonce + 1;
+                    rx_replay_window = shift >= 64 ? 0 : rx_replay_window << shift;
+                    rx_replay_window |= 1;
+                    next_rx_nonce = counter + 1;
+                    return true;
+                }
+                const uint64_t age = next_rx_nonce - 1 - counter;
+                if (age >= 64 || (rx_replay_window & (1ULL << age)) != 0) {
+                    return false;
+                }
+                rx_replay_window |= 1ULL << age;
+                return true;
+            }
         };
 
     }
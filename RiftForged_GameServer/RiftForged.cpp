@@ -20,7 +20,7 @@
 
 // Networking Components
 #include "../NetworkEngine/INetworkIO.h"
-#include "../NetworkEngine/UDPSocketAsync.h"
+#include "../NetworkEngine/NetworkIOFactory.h"
 #include "../NetworkEngine/INetworkIOEvents.h"
 #include "../NetworkEngine/UDPPacketHandler.h"
 #include "../NetworkEngine/IMessageHandler.h"
@@ -40,7 +40,7 @@
 
 std::atomic<bool> g_isServerRunning = true;
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "RiftForged GameServer Starting (Refactored Network Stack & Main)..." << std::endl;
 
     RiftForged::Utilities::Logger::Init();
@@ -51,8 +51,33 @@ int main() {
     const size_t GAME_LOGIC_THREAD_POOL_SIZE = 12; // Or std::thread::hardware_concurrency() if appropriate
     const std::chrono::milliseconds GAME_TICK_INTERVAL_MS(5); // Approx 200 TPS
 
+    // Network backend: platform default, overridable with --net-backend=<iocp|epoll|iouring>.
+    // --net-shards=<N> opens N SO_REUSEPORT sockets with one pinned receive thread each (epoll only).
+    RiftForged::Networking::NetworkIOBackend networkBackend = RiftForged::Networking::GetDefaultNetworkIOBackend();
+    size_t networkReceiveShards = 1;
+    const std::string NET_BACKEND_ARG = "--net-backend=";
+    const std::string NET_SHARDS_ARG = "--net-shards=";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind(NET_BACKEND_ARG, 0) == 0) {
+            if (!RiftForged::Networking::ParseNetworkIOBackend(arg.substr(NET_BACKEND_ARG.size()), networkBackend)) {
+                RF_CORE_CRITICAL("Server: Unknown network backend '{}'. Expected iocp, epoll or iouring.", arg.substr(NET_BACKEND_ARG.size()));
+                return 1;
+            }
+        }
+        else if (arg.rfind(NET_SHARDS_ARG, 0) == 0) {
+            try {
+                networkReceiveShards = static_cast<size_t>(std::stoul(arg.substr(NET_SHARDS_ARG.size())));
+            }
+            catch (const std::exception&) {
+                RF_CORE_CRITICAL("Server: Invalid receive shard count '{}'.", arg.substr(NET_SHARDS_ARG.size()));
+                return 1;
+            }
+        }
+    }
+
     // Declare unique_ptrs for RAII
-    std::unique_ptr<RiftForged::Networking::UDPSocketAsync> udpSocket;
+    std::unique_ptr<RiftForged::Networking::INetworkIO> udpSocket;
     std::unique_ptr<RiftForged::Networking::UDPPacketHandler> packetHandler;
     std::unique_ptr<RiftForged::Networking::PacketProcessor> packetProcessor;
     std::unique_ptr<RiftForged::Networking::MessageDispatcher> messageDispatcher;
@@ -125,9 +150,14 @@ int main() {
         // ** CRITICAL REORDERING FOR INetworkIO DEPENDENCY **
         // *******************************************************************
 
-        // 1. Instantiate UDPSocketAsync (implements INetworkIO) FIRST
-        udpSocket = std::make_unique<RiftForged::Networking::UDPSocketAsync>();
-        RF_CORE_INFO("UDPSocketAsync (INetworkIO) created.");
+        // 1. Instantiate the selected INetworkIO backend FIRST
+        udpSocket = RiftForged::Networking::CreateNetworkIO(networkBackend, networkReceiveShards);
+        if (!udpSocket) {
+            RF_CORE_CRITICAL("Server: Network backend '{}' is not available on this platform/build. Exiting.",
+                RiftForged::Networking::NetworkIOBackendToString(networkBackend));
+            return 1;
+        }
+        RF_CORE_INFO("INetworkIO backend '{}' created.", RiftForged::Networking::NetworkIOBackendToString(networkBackend));
         // Now udpSocket.get() will return a valid pointer.
 
         // 2. Instantiate UDPPacketHandler, providing the valid INetworkIO pointer
@@ -243,7 +273,7 @@ int main() {
         packetHandler->Stop();
     }
     if (udpSocket) {
-        RF_CORE_INFO("MAIN: Signaling UDPSocketAsync (NetworkIO) to stop...");
+        RF_CORE_INFO("MAIN: Signaling NetworkIO ({}) to stop...", RiftForged::Networking::NetworkIOBackendToString(networkBackend));
         udpSocket->Stop();
     }
 
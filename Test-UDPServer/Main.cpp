@@ -35,6 +35,7 @@
 // GamePacketHeader is still needed for GetGamePacketHeaderSize, struct definition for reliability, flags, and protocol ID
 #include "../NetworkEngine/GamePacketHeader.h"
 #include "../NetworkEngine/UDPReliabilityProtocol.h"
+#include "../NetworkEngine/ConnectionCookie.h" // The server challenges us until we echo its cookie
 
 // Constants
 const int CLIENT_RECEIVE_BUFFER_SIZE = 4096;
@@ -46,6 +47,7 @@ RiftForged::Networking::Shared::Quaternion g_client_orientation_quaternion(0.0f,
 uint64_t g_client_player_id = 0;
 std::string g_last_server_event_for_display = "Initializing...";
 RiftForged::Networking::ReliableConnectionState g_clientToServerState;
+std::vector<RiftForged::Networking::PacketBuffer> g_releasedMessages; // Ordered-channel messages released by a gap filling
 
 enum class ClientJoinState {
     Disconnected,
@@ -348,6 +350,56 @@ void ParseJoinFailedPacket(const uint8_t* app_payload_ptr, uint16_t app_payload_
     RF_CORE_ERROR("Client: {}", g_last_server_event_for_display);
 }
 
+// Verifies one S2C root message and hands it to its parser. Returns true if the display should be refreshed.
+bool HandleS2CMessage(const uint8_t* app_payload_ptr, uint16_t app_payload_size) {
+    flatbuffers::Verifier verifier(app_payload_ptr, static_cast<size_t>(app_payload_size));
+    if (!RiftForged::Networking::UDP::S2C::VerifyRoot_S2C_UDP_MessageBuffer(verifier)) {
+        RF_CORE_ERROR("Client: S2C Root FlatBuffer verification failed. Size: {}", app_payload_size);
+        g_last_server_event_for_display = "S2C Root Verification Failed";
+        return true;
+    }
+    auto root_s2c_message = RiftForged::Networking::UDP::S2C::GetRoot_S2C_UDP_Message(app_payload_ptr);
+    if (root_s2c_message && root_s2c_message->payload_type() == RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_NONE) {
+        RF_CORE_TRACE("Client: Received S2C Root message with explicit NONE payload. Likely an ACK with no app data.");
+        return false;
+    }
+    if (!root_s2c_message) {
+        RF_CORE_ERROR("Client: Failed to get Root_S2C_UDP_Message from payload. AppPayloadSize: {}", app_payload_size);
+        g_last_server_event_for_display = "ERROR: S2C Root Message Null";
+        return true;
+    }
+
+    RF_CORE_DEBUG("Client: Reliability approved S2C FB payload. FB_Type: {}, AppPayloadSize: {}",
+        RiftForged::Networking::UDP::S2C::EnumNameS2C_UDP_Payload(root_s2c_message->payload_type()), app_payload_size);
+    switch (root_s2c_message->payload_type()) {
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_S2C_JoinSuccessMsg:
+        ParseJoinSuccessPacket(app_payload_ptr, app_payload_size);
+        break;
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_S2C_JoinFailedMsg:
+        ParseJoinFailedPacket(app_payload_ptr, app_payload_size);
+        break;
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_Pong:
+        ParsePongPacket(app_payload_ptr, app_payload_size);
+        break;
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_EntityStateUpdate:
+        ParseEntityStateUpdatePacket(app_payload_ptr, app_payload_size);
+        break;
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_RiftStepInitiated:
+        ParseRiftStepInitiatedPacket(app_payload_ptr, app_payload_size);
+        break;
+    case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_CombatEvent:
+        ParseCombatEventPacket(app_payload_ptr, app_payload_size);
+        break;
+        // Add cases for S2C_SpawnProjectileMsg etc. if they are defined
+    default:
+        g_last_server_event_for_display = "S2C Unhandled FB Payload (Type: " +
+            std::string(RiftForged::Networking::UDP::S2C::EnumNameS2C_UDP_Payload(root_s2c_message->payload_type())) + ")";
+        RF_CORE_WARN("Client: {}", g_last_server_event_for_display);
+        return false;
+    }
+    return true; // Assume any valid message might change display state
+}
+
 void DisplayClientState() {
 #ifdef _WIN32
     system("cls");
@@ -548,6 +600,23 @@ int main() {
         int bytesReceived = recvfrom(clientSocket, recvBuffer, sizeof(recvBuffer), 0, (sockaddr*)&fromAddr, &fromAddrLen);
         bool state_changed_by_receive_this_loop = false;
 
+        // The server answers anything sent before we echo its cookie with a challenge, our join request
+        // included; echo it and send the join request again.
+        RiftForged::Networking::PacketBuffer cookie_echo;
+        if (bytesReceived > 0 && RiftForged::Networking::PrepareConnectionCookieEcho(reinterpret_cast<const uint8_t*>(recvBuffer),
+            static_cast<size_t>(bytesReceived), cookie_echo)) {
+            RF_CORE_INFO("Client: Echoing the server's connection cookie.");
+            sendto(clientSocket, reinterpret_cast<const char*>(cookie_echo.Data()), static_cast<int>(cookie_echo.Size()), 0,
+                (sockaddr*)&serverAddr, sizeof(serverAddr));
+            if (g_join_state == ClientJoinState::AttemptingJoin) {
+                uint64_t join_ts = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+                std::vector<char> join_packet = BuildJoinShardRequestPacket(join_ts, g_character_id_to_load);
+                sendto(clientSocket, join_packet.data(), static_cast<int>(join_packet.size()), 0,
+                    (sockaddr*)&serverAddr, sizeof(serverAddr));
+            }
+            bytesReceived = 0;
+        }
+
         if (bytesReceived >= static_cast<int>(RiftForged::Networking::GetGamePacketHeaderSize())) {
             RiftForged::Networking::GamePacketHeader s2c_header;
             memcpy(&s2c_header, recvBuffer, RiftForged::Networking::GetGamePacketHeaderSize());
@@ -561,57 +630,44 @@ int main() {
                     g_clientToServerState, s2c_header, s2c_full_payload_ptr, s2c_full_payload_len,
                     &app_payload_to_process_ptr, &app_payload_size);
 
-                if (should_process_app_payload && app_payload_to_process_ptr && app_payload_size > 0) {
-                    flatbuffers::Verifier verifier(app_payload_to_process_ptr, static_cast<size_t>(app_payload_size));
-                    if (!RiftForged::Networking::UDP::S2C::VerifyRoot_S2C_UDP_MessageBuffer(verifier)) {
-                        RF_CORE_ERROR("Client: S2C Root FlatBuffer verification failed. Size: {}", app_payload_size);
-                        g_last_server_event_for_display = "S2C Root Verification Failed";
-                        state_changed_by_receive_this_loop = true;
+                // A message larger than one datagram arrives as fragments; it is handled once all have arrived.
+                RiftForged::Networking::PacketBuffer reassembled_message;
+                if (should_process_app_payload && app_payload_to_process_ptr && app_payload_size > 0 &&
+                    RiftForged::Networking::IsFragment(s2c_header.flags)) {
+                    should_process_app_payload = RiftForged::Networking::ProcessIncomingFragment(g_clientToServerState, s2c_header,
+                        app_payload_to_process_ptr, app_payload_size, reassembled_message) == RiftForged::Networking::FragmentReassemblyResult::Complete;
+                    if (should_process_app_payload && reassembled_message.Size() > UINT16_MAX) {
+                        RF_CORE_WARN("Client: Reassembled S2C message of {} bytes is too large. Discarding.", reassembled_message.Size());
+                        should_process_app_payload = false;
                     }
-                    else {
-                        auto root_s2c_message = RiftForged::Networking::UDP::S2C::GetRoot_S2C_UDP_Message(app_payload_to_process_ptr);
-                        if (root_s2c_message && root_s2c_message->payload_type() != RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_NONE) {
-                            RF_CORE_DEBUG("Client: Reliability approved S2C FB payload. FB_Type: {}, AppPayloadSize: {}",
-                                RiftForged::Networking::UDP::S2C::EnumNameS2C_UDP_Payload(root_s2c_message->payload_type()), app_payload_size);
-                            state_changed_by_receive_this_loop = true; // Assume any valid message might change display state
-                            switch (root_s2c_message->payload_type()) {
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_S2C_JoinSuccessMsg:
-                                ParseJoinSuccessPacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_S2C_JoinFailedMsg:
-                                ParseJoinFailedPacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_Pong:
-                                ParsePongPacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_EntityStateUpdate:
-                                ParseEntityStateUpdatePacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_RiftStepInitiated:
-                                ParseRiftStepInitiatedPacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                            case RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_CombatEvent:
-                                ParseCombatEventPacket(app_payload_to_process_ptr, app_payload_size);
-                                break;
-                                // Add cases for S2C_SpawnProjectileMsg etc. if they are defined
-                            default:
-                                g_last_server_event_for_display = "S2C Unhandled FB Payload (Type: " +
-                                    std::string(RiftForged::Networking::UDP::S2C::EnumNameS2C_UDP_Payload(root_s2c_message->payload_type())) + ")";
-                                RF_CORE_WARN("Client: {}", g_last_server_event_for_display);
-                                state_changed_by_receive_this_loop = false; // Or true to show "unhandled"
-                                break;
-                            }
-                        }
-                        else if (root_s2c_message && root_s2c_message->payload_type() == RiftForged::Networking::UDP::S2C::S2C_UDP_Payload_NONE) {
-                            RF_CORE_TRACE("Client: Received S2C Root message with explicit NONE payload. Likely an ACK with no app data. Seq: {}", s2c_header.sequenceNumber);
-                            // No specific app payload to process, but reliability layer handled it.
-                        }
-                        else {
-                            RF_CORE_ERROR("Client: Failed to get Root_S2C_UDP_Message from payload, or payload_type is NONE incorrectly. AppPayloadSize: {}", app_payload_size);
-                            g_last_server_event_for_display = "ERROR: S2C Root Message Null or Invalid Payload_NONE";
+                    app_payload_to_process_ptr = reassembled_message.Data();
+                    app_payload_size = static_cast<uint16_t>(reassembled_message.Size());
+                }
+
+                if (should_process_app_payload && app_payload_to_process_ptr && app_payload_size > 0) {
+                    if (RiftForged::Networking::HasFlag(s2c_header.flags, RiftForged::Networking::GamePacketFlag::IS_AGGREGATE)) {
+                        // The server packs a tick's messages into one datagram; each passes its channel (stale
+                        // sequenced updates are dropped, early ordered ones held back), then is handled in turn.
+                        const bool from_reliable_datagram = RiftForged::Networking::HasFlag(s2c_header.flags, RiftForged::Networking::GamePacketFlag::IS_RELIABLE);
+                        if (!RiftForged::Networking::ForEachAggregatedMessage(app_payload_to_process_ptr, app_payload_size,
+                            [&](const uint8_t* message, const RiftForged::Networking::AggregatedMessageHeader& message_header) {
+                                if (RiftForged::Networking::ProcessIncomingChannelMessage(g_clientToServerState, message_header, message,
+                                    from_reliable_datagram, g_releasedMessages) == RiftForged::Networking::ChannelDeliveryResult::Deliver) {
+                                    state_changed_by_receive_this_loop = HandleS2CMessage(message, message_header.messageSize) || state_changed_by_receive_this_loop;
+                                }
+                                for (const auto& released : g_releasedMessages) {
+                                    state_changed_by_receive_this_loop = HandleS2CMessage(released.Data(), static_cast<uint16_t>(released.Size())) || state_changed_by_receive_this_loop;
+                                }
+                                g_releasedMessages.clear();
+                            })) {
+                            RF_CORE_ERROR("Client: Malformed aggregated S2C payload. Size: {}", app_payload_size);
+                            g_last_server_event_for_display = "S2C Aggregate Malformed";
                             state_changed_by_receive_this_loop = true;
                         }
                     }
+                    else {
+                        state_changed_by_receive_this_loop = HandleS2CMessage(app_payload_to_process_ptr, app_payload_size) || state_changed_by_receive_this_loop;
+                    }
                 }
                 else if (RiftForged::Networking::HasFlag(s2c_header.flags, RiftForged::Networking::GamePacketFlag::IS_ACK_ONLY) ||
                     (RiftForged::Networking::HasFlag(s2c_header.flags, RiftForged::Networking::GamePacketFlag::IS_RELIABLE) && !should_process_app_payload)) {
@@ -35,6 +35,7 @@
 #include "../FlatBuffers/V0.0.4/riftforged_s2c_udp_messages_generated.h"
 #include "../NetworkEngine/GamePacketHeader.h" // Still needed for struct def, flags, protocol ID
 #include "../NetworkEngine/UDPReliabilityProtocol.h"
+#include "../NetworkEngine/ConnectionCookie.h" // The server wants a cookie echoed before the join request
 #include "../Utils/Logger.h"
 #include <fmt/core.h> // For FMT_STRING
 
@@ -54,6 +55,7 @@ public:
     sockaddr_in serverAddr_{};
 
     std::unique_ptr<RF_Net::ReliableConnectionState> connectionState_;
+    std::vector<RF_Net::PacketBuffer> releasedMessages_; // Ordered-channel messages released by a gap filling
     flatbuffers::FlatBufferBuilder builder_;
     std::atomic_bool stop_running_ = { false };
 
@@ -61,6 +63,7 @@ public:
 
     enum class PlayerJoinState {
         NotConnected,
+        AwaitingCookie,     // Cookie request sent; the join request follows the echo
         AttemptingJoin,
         Joined,
         FailedToJoin
@@ -161,6 +164,17 @@ public:
             0, (const sockaddr*)&serverAddr_, sizeof(serverAddr_));
     }
 
+    void send_raw_datagram(const RF_Net::PacketBuffer& datagram) {
+        if (!isValid() || datagram.Empty()) return;
+        sendto(clientSocket_, reinterpret_cast<const char*>(datagram.Data()), static_cast<int>(datagram.Size()),
+            0, (const sockaddr*)&serverAddr_, sizeof(serverAddr_));
+    }
+
+    void send_cookie_request() {
+        RF_CORE_INFO(FMT_STRING("[Client {}] Sending cookie request"), clientId_);
+        send_raw_datagram(RF_Net::PrepareConnectionCookieRequest());
+    }
+
     void send_join_request() {
         builder_.Clear();
         auto charIdOffset = characterIdForJoin_.empty() ? 0 : builder_.CreateString(characterIdForJoin_);
@@ -208,6 +222,155 @@ public:
         send_packet_internal(builder_.GetBufferPointer(), builder_.GetSize(), true); // MessageType removed
     }
 
+    void process_s2c_message(const uint8_t* payload, uint16_t payload_size) {
+        flatbuffers::Verifier verifier(payload, payload_size);
+        if (!RF_S2C::VerifyRoot_S2C_UDP_MessageBuffer(verifier)) {
+            RF_CORE_WARN(FMT_STRING("[Client {}] S2C FlatBuffer verification failed. Discarding payload of size {}."), clientId_, payload_size);
+            return;
+        }
+        auto root = RF_S2C::GetRoot_S2C_UDP_Message(payload);
+        if (!root || !root->payload()) { // Also check if payload exists
+            RF_CORE_WARN(FMT_STRING("[Client {}] GetRoot_S2C_UDP_Message failed or payload is missing."), clientId_);
+            return;
+        }
+
+        // Dispatch based on FlatBuffer payload type
+        switch (root->payload_type()) {
+        case RF_S2C::S2C_UDP_Payload_S2C_JoinSuccessMsg: {
+            auto join_success_msg = root->payload_as_S2C_JoinSuccessMsg();
+            if (join_success_msg) {
+                serverAssignedPlayerId_ = join_success_msg->assigned_player_id();
+                if (joinState_ != PlayerJoinState::Joined) { // Log only on first successful join
+                    RF_CORE_INFO(FMT_STRING("[Client {} SID: {}] JOIN SUCCESSFUL. Server Tick: {}Hz. Msg: '{}'"),
+                        clientId_, serverAssignedPlayerId_,
+                        join_success_msg->server_tick_rate_hz(),
+                        (join_success_msg->welcome_message() ? join_success_msg->welcome_message()->c_str() : ""));
+                }
+                joinState_ = PlayerJoinState::Joined;
+            }
+            else {
+                RF_CORE_ERROR(FMT_STRING("[Client {}] Failed to cast S2C_JoinSuccess payload."), clientId_);
+            }
+            break;
+        }
+        case RF_S2C::S2C_UDP_Payload_S2C_JoinFailedMsg: {
+            auto join_failed_msg = root->payload_as_S2C_JoinFailedMsg();
+            std::string reason = "Unknown";
+            int16_t code = 0;
+            if (join_failed_msg) {
+                if (join_failed_msg->reason_message()) reason = join_failed_msg->reason_message()->str();
+                code = join_failed_msg->reason_code();
+            }
+            RF_CORE_ERROR(FMT_STRING("[Client {}] JOIN FAILED. Reason: {} (Code: {}). Stopping."), clientId_, reason, code);
+            joinState_ = PlayerJoinState::FailedToJoin;
+            stop_running_ = true;
+            break;
+        }
+        case RF_S2C::S2C_UDP_Payload_Pong: {
+            auto pong_msg = root->payload_as_Pong();
+            if (pong_msg) {
+                uint64_t rtt = current_timestamp_ms() - pong_msg->client_timestamp_ms();
+                RF_CORE_INFO(FMT_STRING("[Client {} SID: {}] PONG! RTT: {}ms. ServerTS: {}"), clientId_, serverAssignedPlayerId_, rtt, pong_msg->server_timestamp_ms());
+            }
+            break;
+        }
+        case RF_S2C::S2C_UDP_Payload_EntityStateUpdate:
+            // RF_CORE_INFO(FMT_STRING("[Client {}] Received EntityStateUpdate."), clientId_);
+            break;
+        case RF_S2C::S2C_UDP_Payload_RiftStepInitiated:
+            // RF_CORE_INFO(FMT_STRING("[Client {}] Received RiftStepInitiated."), clientId_);
+            break;
+            // Add other S2C message types as needed
+        default:
+            RF_CORE_WARN(FMT_STRING("[Client {}] Received unhandled S2C FlatBuffer payload type: {}"),
+                clientId_, RF_S2C::EnumNameS2C_UDP_Payload(root->payload_type()));
+            break;
+        }
+    }
+
+    // Hands a payload relayed by the reliability layer (or a reassembled message) to process_s2c_message,
+    // as the server's DeliverDatagramPayload does: an aggregate's messages each pass their channel first.
+    void deliver_s2c_payload(uint8_t header_flags, const uint8_t* payload, uint16_t payload_size) {
+        if (!RiftForged::Networking::HasFlag(header_flags, RiftForged::Networking::GamePacketFlag::IS_AGGREGATE)) {
+            process_s2c_message(payload, payload_size);
+            return;
+        }
+        // The server packs a tick's messages into one datagram; each passes its channel, then is handled in turn.
+        const bool from_reliable_datagram = RiftForged::Networking::HasFlag(header_flags, RiftForged::Networking::GamePacketFlag::IS_RELIABLE);
+        if (!RF_Net::ForEachAggregatedMessage(payload, payload_size,
+            [&](const uint8_t* message, const RF_Net::AggregatedMessageHeader& message_header) {
+                if (RF_Net::ProcessIncomingChannelMessage(*connectionState_, message_header, message, from_reliable_datagram, releasedMessages_) ==
+                    RF_Net::ChannelDeliveryResult::Deliver) {
+                    process_s2c_message(message, message_header.messageSize);
+                }
+                for (const auto& released : releasedMessages_) {
+                    process_s2c_message(released.Data(), static_cast<uint16_t>(released.Size()));
+                }
+                releasedMessages_.clear();
+            })) {
+            RF_CORE_WARN(FMT_STRING("[Client {}] Malformed aggregated S2C payload of size {}."), clientId_, payload_size);
+        }
+    }
+
+    // Runs one datagram from the server through cookie handling, the reliability layer, fragment reassembly
+    // and dispatch.
+    void handle_server_datagram(const uint8_t* data, size_t size) {
+        if (size < RF_Net::GetGamePacketHeaderSize()) {
+            RF_CORE_WARN(FMT_STRING("[Client {}] Received packet too small ({} bytes)."), clientId_, size);
+            return;
+        }
+
+        RF_Net::GamePacketHeader server_header;
+        memcpy(&server_header, data, RF_Net::GetGamePacketHeaderSize());
+        if (server_header.protocolId != RF_Net::CURRENT_PROTOCOL_ID_VERSION) {
+            RF_CORE_WARN(FMT_STRING("[Client {}] Mismatched protocol ID. Expected: 0x{:X}, Got: 0x{:X}."),
+                clientId_, RF_Net::CURRENT_PROTOCOL_ID_VERSION, server_header.protocolId);
+            return;
+        }
+
+        // The server challenges any datagram until we echo its cookie; the first echo unlocks the join.
+        RF_Net::PacketBuffer cookie_echo;
+        if (RF_Net::PrepareConnectionCookieEcho(data, size, cookie_echo)) {
+            send_raw_datagram(cookie_echo);
+            if (joinState_ == PlayerJoinState::AwaitingCookie) {
+                send_join_request();
+                joinState_ = PlayerJoinState::AttemptingJoin;
+            }
+            return;
+        }
+
+        const uint8_t* s2c_payload_after_header_ptr = data + RF_Net::GetGamePacketHeaderSize();
+        uint16_t s2c_payload_after_header_len = static_cast<uint16_t>(size - RF_Net::GetGamePacketHeaderSize());
+        const uint8_t* app_payload_to_process_ptr = nullptr;
+        uint16_t app_payload_size = 0;
+
+        bool should_process_app_payload = RF_Net::ProcessIncomingPacketHeader(
+            *connectionState_, server_header, s2c_payload_after_header_ptr, s2c_payload_after_header_len,
+            &app_payload_to_process_ptr, &app_payload_size);
+
+        if (should_process_app_payload && app_payload_to_process_ptr && app_payload_size > 0) {
+            // A message larger than one datagram arrives as fragments; it is handled once all have arrived.
+            RF_Net::PacketBuffer reassembled_message;
+            if (RF_Net::IsFragment(server_header.flags)) {
+                if (RF_Net::ProcessIncomingFragment(*connectionState_, server_header, app_payload_to_process_ptr, app_payload_size,
+                    reassembled_message) != RF_Net::FragmentReassemblyResult::Complete) {
+                    return;
+                }
+                if (reassembled_message.Size() > UINT16_MAX) {
+                    RF_CORE_WARN(FMT_STRING("[Client {}] Reassembled S2C message of {} bytes is too large. Discarding."), clientId_, reassembled_message.Size());
+                    return;
+                }
+                app_payload_to_process_ptr = reassembled_message.Data();
+                app_payload_size = static_cast<uint16_t>(reassembled_message.Size());
+            }
+            deliver_s2c_payload(server_header.flags, app_payload_to_process_ptr, app_payload_size);
+        }
+        else if (RiftForged::Networking::HasFlag(server_header.flags, RiftForged::Networking::GamePacketFlag::IS_RELIABLE) && !should_process_app_payload) {
+            RF_CORE_TRACE(FMT_STRING("[Client {}] S2C Reliability packet processed (Seq {}). No app payload for client logic (e.g. duplicate or pure ACK)."),
+                clientId_, server_header.sequenceNumber);
+        }
+    }
+
     void receive_server_packets() {
         if (!isValid() || !connectionState_) return;
         int bytes_received;
@@ -222,97 +385,7 @@ public:
                 stop_running_ = true;
                 break;
             }
-            if (bytes_received < static_cast<int>(RF_Net::GetGamePacketHeaderSize())) {
-                RF_CORE_WARN(FMT_STRING("[Client {}] Received packet too small ({} bytes)."), clientId_, bytes_received);
-                continue;
-            }
-
-            RF_Net::GamePacketHeader server_header;
-            memcpy(&server_header, recvBuffer_, RF_Net::GetGamePacketHeaderSize());
-            if (server_header.protocolId != RF_Net::CURRENT_PROTOCOL_ID_VERSION) {
-                RF_CORE_WARN(FMT_STRING("[Client {}] Mismatched protocol ID. Expected: 0x{:X}, Got: 0x{:X}."),
-                    clientId_, RF_Net::CURRENT_PROTOCOL_ID_VERSION, server_header.protocolId);
-                continue;
-            }
-
-            const uint8_t* s2c_payload_after_header_ptr = reinterpret_cast<const uint8_t*>(recvBuffer_ + RF_Net::GetGamePacketHeaderSize());
-            uint16_t s2c_payload_after_header_len = static_cast<uint16_t>(bytes_received - RF_Net::GetGamePacketHeaderSize());
-            const uint8_t* app_payload_to_process_ptr = nullptr;
-            uint16_t app_payload_size = 0;
-
-            bool should_process_app_payload = RF_Net::ProcessIncomingPacketHeader(
-                *connectionState_, server_header, s2c_payload_after_header_ptr, s2c_payload_after_header_len,
-                &app_payload_to_process_ptr, &app_payload_size);
-
-            if (should_process_app_payload && app_payload_to_process_ptr && app_payload_size > 0) {
-                flatbuffers::Verifier verifier(app_payload_to_process_ptr, app_payload_size);
-                if (!RF_S2C::VerifyRoot_S2C_UDP_MessageBuffer(verifier)) {
-                    RF_CORE_WARN(FMT_STRING("[Client {}] S2C FlatBuffer verification failed. Discarding payload of size {}."), clientId_, app_payload_size);
-                    continue;
-                }
-                auto root = RF_S2C::GetRoot_S2C_UDP_Message(app_payload_to_process_ptr);
-                if (!root || !root->payload()) { // Also check if payload exists
-                    RF_CORE_WARN(FMT_STRING("[Client {}] GetRoot_S2C_UDP_Message failed or payload is missing."), clientId_);
-                    continue;
-                }
-
-                // Dispatch based on FlatBuffer payload type
-                switch (root->payload_type()) {
-                case RF_S2C::S2C_UDP_Payload_S2C_JoinSuccessMsg: {
-                    auto join_success_msg = root->payload_as_S2C_JoinSuccessMsg();
-                    if (join_success_msg) {
-                        serverAssignedPlayerId_ = join_success_msg->assigned_player_id();
-                        if (joinState_ != PlayerJoinState::Joined) { // Log only on first successful join
-                            RF_CORE_INFO(FMT_STRING("[Client {} SID: {}] JOIN SUCCESSFUL. Server Tick: {}Hz. Msg: '{}'"),
-                                clientId_, serverAssignedPlayerId_,
-                                join_success_msg->server_tick_rate_hz(),
-                                (join_success_msg->welcome_message() ? join_success_msg->welcome_message()->c_str() : ""));
-                        }
-                        joinState_ = PlayerJoinState::Joined;
-                    }
-                    else {
-                        RF_CORE_ERROR(FMT_STRING("[Client {}] Failed to cast S2C_JoinSuccess payload."), clientId_);
-                    }
-                    break;
-                }
-                case RF_S2C::S2C_UDP_Payload_S2C_JoinFailedMsg: {
-                    auto join_failed_msg = root->payload_as_S2C_JoinFailedMsg();
-                    std::string reason = "Unknown";
-                    int16_t code = 0;
-                    if (join_failed_msg) {
-                        if (join_failed_msg->reason_message()) reason = join_failed_msg->reason_message()->str();
-                        code = join_failed_msg->reason_code();
-                    }
-                    RF_CORE_ERROR(FMT_STRING("[Client {}] JOIN FAILED. Reason: {} (Code: {}). Stopping."), clientId_, reason, code);
-                    joinState_ = PlayerJoinState::FailedToJoin;
-                    stop_running_ = true;
-                    break;
-                }
-                case RF_S2C::S2C_UDP_Payload_Pong: {
-                    auto pong_msg = root->payload_as_Pong();
-                    if (pong_msg) {
-                        uint64_t rtt = current_timestamp_ms() - pong_msg->client_timestamp_ms();
-                        RF_CORE_INFO(FMT_STRING("[Client {} SID: {}] PONG! RTT: {}ms. ServerTS: {}"), clientId_, serverAssignedPlayerId_, rtt, pong_msg->server_timestamp_ms());
-                    }
-                    break;
-                }
-                case RF_S2C::S2C_UDP_Payload_EntityStateUpdate:
-                    // RF_CORE_INFO(FMT_STRING("[Client {}] Received EntityStateUpdate."), clientId_);
-                    break;
-                case RF_S2C::S2C_UDP_Payload_RiftStepInitiated:
-                    // RF_CORE_INFO(FMT_STRING("[Client {}] Received RiftStepInitiated."), clientId_);
-                    break;
-                    // Add other S2C message types as needed
-                default:
-                    RF_CORE_WARN(FMT_STRING("[Client {}] Received unhandled S2C FlatBuffer payload type: {}"),
-                        clientId_, RF_S2C::EnumNameS2C_UDP_Payload(root->payload_type()));
-                    break;
-                }
-            }
-            else if (RiftForged::Networking::HasFlag(server_header.flags, RiftForged::Networking::GamePacketFlag::IS_RELIABLE) && !should_process_app_payload) {
-                RF_CORE_TRACE(FMT_STRING("[Client {}] S2C Reliability packet processed (Seq {}). No app payload for client logic (e.g. duplicate or pure ACK)."),
-                    clientId_, server_header.sequenceNumber);
-            }
+            handle_server_datagram(reinterpret_cast<const uint8_t*>(recvBuffer_), static_cast<size_t>(bytes_received));
         }
     }
 
@@ -356,8 +429,8 @@ public:
             return;
         }
 
-        send_join_request();
-        joinState_ = PlayerJoinState::AttemptingJoin;
+        send_cookie_request();
+        joinState_ = PlayerJoinState::AwaitingCookie;
         RF_CORE_INFO(FMT_STRING("[Client {}] Attempting to join server (Char: {})..."), clientId_, characterIdForJoin_);
 
         std::random_device rd;
@@ -394,7 +467,13 @@ public:
                 last_reliability_check_time = current_loop_time;
             }
 
-            if (joinState_ == PlayerJoinState::AttemptingJoin) {
+            if (joinState_ == PlayerJoinState::AwaitingCookie) {
+                if (std::chrono::duration_cast<std::chrono::milliseconds>(current_loop_time - last_join_resend_time).count() >= JOIN_RESEND_INTERVAL_MS) {
+                    send_cookie_request();
+                    last_join_resend_time = current_loop_time;
+                }
+            }
+            else if (joinState_ == PlayerJoinState::AttemptingJoin) {
                 if (std::chrono::duration_cast<std::chrono::milliseconds>(current_loop_time - last_join_resend_time).count() >= JOIN_RESEND_INTERVAL_MS) {
                     RF_CORE_INFO(FMT_STRING("[Client {}] Resending Join Request (Char: {})..."), clientId_, characterIdForJoin_);
                     send_join_request();
@@ -431,6 +510,45 @@ public:
     }
 }; // End of SimulatedPlayer class
 
+// End-to-end check of S2C fragmentation, run before the clients start. A JoinSuccess several datagrams long
+// is prepared the way the server sends a message too large to aggregate (framed on its channel, then
+// fragmented) and fed through a client's receive path, last fragment first. The client must reassemble,
+// verify and handle it.
+bool RunOversizedPayloadLoopbackTest() {
+    const uint64_t EXPECTED_PLAYER_ID = 424242;
+    RF_Net::ReliableConnectionState server_state;
+    SimulatedPlayer player(0, "127.0.0.1", 0); // Its socket is never used
+    player.joinState_ = SimulatedPlayer::PlayerJoinState::AttemptingJoin;
+
+    flatbuffers::FlatBufferBuilder builder(8192);
+    const std::string welcome_message(4 * server_state.maxDatagramSize, 'W');
+    auto welcome_offset = builder.CreateString(welcome_message);
+    auto join_success = RF_S2C::CreateS2C_JoinSuccessMsg(builder, EXPECTED_PLAYER_ID, welcome_offset, 30);
+    RF_S2C::Root_S2C_UDP_MessageBuilder root_builder(builder);
+    root_builder.add_payload_type(RF_S2C::S2C_UDP_Payload_S2C_JoinSuccessMsg);
+    root_builder.add_payload(join_success.Union());
+    builder.Finish(root_builder.Finish());
+
+    std::vector<RF_Net::PacketBuffer> datagrams;
+    if (!RF_Net::PrepareOutgoingChannelMessage(server_state, RF_Net::NetworkChannel::RELIABLE_UNORDERED,
+        builder.GetBufferPointer(), builder.GetSize(), datagrams) || datagrams.size() < 2) {
+        RF_CORE_CRITICAL(FMT_STRING("[StressTest] Loopback: a {} byte message was not split into fragments ({} datagrams)."),
+            builder.GetSize(), datagrams.size());
+        return false;
+    }
+    for (auto it = datagrams.rbegin(); it != datagrams.rend(); ++it) {
+        player.handle_server_datagram(it->Data(), it->Size());
+    }
+
+    if (player.joinState_ != SimulatedPlayer::PlayerJoinState::Joined || player.serverAssignedPlayerId_ != EXPECTED_PLAYER_ID) {
+        RF_CORE_CRITICAL(FMT_STRING("[StressTest] Loopback: the {} byte JoinSuccess sent in {} fragments was not reassembled and handled."),
+            builder.GetSize(), datagrams.size());
+        return false;
+    }
+    RF_CORE_INFO(FMT_STRING("[StressTest] Loopback: {} byte S2C message reassembled from {} fragments."), builder.GetSize(), datagrams.size());
+    return true;
+}
+
 int main() {
     const int NUM_CONCURRENT_CLIENTS = 50; // Keep low for initial testing after changes
     const std::string SERVER_IP = "192.168.50.186"; // Ensure this matches server config
@@ -447,6 +565,12 @@ int main() {
     }
     RF_CORE_INFO(FMT_STRING("[StressTest] WSAStartup successful."));
 
+    if (!RunOversizedPayloadLoopbackTest()) {
+        WSACleanup();
+        RiftForged::Utilities::Logger::Shutdown();
+        return 1;
+    }
+
     std::vector<std::thread> client_threads;
     std::vector<std::unique_ptr<SimulatedPlayer>> players_list;
     players_list.reserve(NUM_CONCURRENT_CLIENTS);